@@ -96,6 +96,26 @@ struct Field_Dimensions {
             _FloorWidth * scalar);
     }
 
+    bool operator==(const Field_Dimensions& other) const {
+        return _Length == other._Length && _Width == other._Width &&
+               _Border == other._Border && _LineWidth == other._LineWidth &&
+               _GoalWidth == other._GoalWidth &&
+               _GoalDepth == other._GoalDepth &&
+               _GoalHeight == other._GoalHeight &&
+               _PenaltyDist == other._PenaltyDist &&
+               _PenaltyDiam == other._PenaltyDiam &&
+               _ArcRadius == other._ArcRadius &&
+               _CenterRadius == other._CenterRadius &&
+               _CenterDiameter == other._CenterDiameter &&
+               _GoalFlat == other._GoalFlat &&
+               _FloorLength == other._FloorLength &&
+               _FloorWidth == other._FloorWidth;
+    }
+
+    bool operator!=(const Field_Dimensions& other) const {
+        return !(*this == other);
+    }
+
     void updateGeometry() {
         _CenterPoint = Geometry2d::Point(0.0, _Length / 2.0);
 
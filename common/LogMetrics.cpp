@@ -0,0 +1,120 @@
+#include "LogMetrics.hpp"
+#include "Constants.hpp"
+
+#include <QFile>
+#include <stdio.h>
+
+using namespace std;
+using namespace Packet;
+
+// A robot has the ball if it is the closest robot and within this distance of
+// the ball's center
+static const float PossessionDistance = Robot_Radius + Ball_Radius + 0.05f;
+
+LogMetrics::LogMetrics(const Field_Dimensions& dims, int framePeriod)
+    : _dims(dims) {
+    frames = 0;
+    goalsFor = 0;
+    goalsAgainst = 0;
+    ourPossession = 0;
+    theirPossession = 0;
+    planningTime = 0;
+    maxPlanningTime = 0;
+    overruns = 0;
+    _framePeriod = framePeriod;
+    _ballInGoal = 0;
+}
+
+void LogMetrics::addFrame(const LogFrame& frame) {
+    ++frames;
+
+    if (frame.has_planning_time()) {
+        planningTime += frame.planning_time();
+        maxPlanningTime = max(maxPlanningTime, (int)frame.planning_time());
+    }
+
+    if (frame.has_processing_time() &&
+        (int)frame.processing_time() > _framePeriod) {
+        ++overruns;
+    }
+
+    if (!frame.has_ball()) {
+        return;
+    }
+
+    Geometry2d::Point ball = frame.ball().pos();
+
+    // Goals are counted when the ball enters the goal
+    int inGoal = 0;
+    if (fabs(ball.x) < _dims.GoalWidth() / 2) {
+        if (ball.y > _dims.Length()) {
+            inGoal = 1;
+        } else if (ball.y < 0) {
+            inGoal = -1;
+        }
+    }
+    if (inGoal != _ballInGoal) {
+        if (inGoal == 1) {
+            ++goalsFor;
+        } else if (inGoal == -1) {
+            ++goalsAgainst;
+        }
+        _ballInGoal = inGoal;
+    }
+
+    // Possession
+    float ourDist = PossessionDistance;
+    float theirDist = PossessionDistance;
+    for (const LogFrame::Robot& r : frame.self()) {
+        ourDist = min(ourDist, ball.distTo(r.pos()));
+    }
+    for (const LogFrame::Robot& r : frame.opp()) {
+        theirDist = min(theirDist, ball.distTo(r.pos()));
+    }
+    if (ourDist < PossessionDistance && ourDist <= theirDist) {
+        ++ourPossession;
+    } else if (theirDist < PossessionDistance) {
+        ++theirPossession;
+    }
+}
+
+bool LogMetrics::readLog(const char* filename) {
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) {
+        fprintf(stderr, "Can't open %s: %s\n", filename,
+                (const char*)file.errorString().toLatin1());
+        return false;
+    }
+
+    LogFrame frame;
+    while (!file.atEnd()) {
+        uint32_t size = 0;
+        if (file.read((char*)&size, sizeof(size)) != sizeof(size)) {
+            break;
+        }
+
+        string str(size, 0);
+        if (file.read(&str[0], size) != size) {
+            break;
+        }
+
+        // Parse partial so we can recover from corrupt data
+        if (!frame.ParsePartialFromString(str)) {
+            fprintf(stderr, "%s: bad frame after %d frames\n", filename,
+                    frames);
+            return false;
+        }
+        addFrame(frame);
+    }
+
+    return true;
+}
+
+float LogMetrics::possession() const {
+    int total = ourPossession + theirPossession;
+    return total ? (float)ourPossession / total : 0;
+}
+
+float LogMetrics::meanPlanningTime() const {
+    return frames ? (float)planningTime / frames : 0;
+}
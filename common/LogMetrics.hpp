@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Field_Dimensions.hpp>
+#include <protobuf/LogFrame.pb.h>
+
+#include <stdint.h>
+
+/**
+ * @brief Match statistics computed from LogFrames
+ *
+ * @details This is used by batch-sim to summarize each run.  Positions in
+ * LogFrames are in team space, so "for", "against", "our" and "their" are from
+ * the point of view of the team that wrote the log.
+ */
+class LogMetrics {
+public:
+    /// <framePeriod> is the processing period in microseconds.  Frames that
+    /// take longer than this to process are counted as overruns.
+    LogMetrics(
+        const Field_Dimensions& dims = Field_Dimensions::Current_Dimensions,
+        int framePeriod = 1000000 / 60);
+
+    void addFrame(const Packet::LogFrame& frame);
+
+    /// Adds all frames in a log file written by Logger.
+    /// Returns false if the file can't be read.  A frame cut off at the end of
+    /// the file, as left behind by a killed soccer, is ignored.
+    bool readLog(const char* filename);
+
+    /// Fraction of the frames where a team had the ball that it was us
+    float possession() const;
+
+    /// Mean path planning time in microseconds
+    float meanPlanningTime() const;
+
+    int frames;
+    int goalsFor;
+    int goalsAgainst;
+
+    // Number of frames where each team had a robot closest to and touching
+    // distance of the ball
+    int ourPossession;
+    int theirPossession;
+
+    // Total and longest path planning time in microseconds
+    int64_t planningTime;
+    int maxPlanningTime;
+
+    // Number of frames that took longer than the frame period to process
+    int overruns;
+
+private:
+    Field_Dimensions _dims;
+    int _framePeriod;
+
+    // Goal the ball was in on the last frame it was seen: 1 for theirs, -1 for
+    // ours, 0 for neither
+    int _ballInGoal;
+};
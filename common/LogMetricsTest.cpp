@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "LogMetrics.hpp"
+#include "Constants.hpp"
+
+using namespace Packet;
+
+static const Field_Dimensions& Dims = Field_Dimensions::Single_Field_Dimensions;
+
+static void setBall(LogFrame& frame, float x, float y) {
+    frame.mutable_ball()->mutable_pos()->set_x(x);
+    frame.mutable_ball()->mutable_pos()->set_y(y);
+    frame.mutable_ball()->mutable_vel()->set_x(0);
+    frame.mutable_ball()->mutable_vel()->set_y(0);
+}
+
+static void addRobot(LogFrame::Robot* robot, float x, float y) {
+    robot->mutable_pos()->set_x(x);
+    robot->mutable_pos()->set_y(y);
+    robot->set_shell(0);
+    robot->set_angle(0);
+}
+
+TEST(LogMetrics, goals) {
+    LogMetrics metrics(Dims);
+    LogFrame frame;
+
+    // Entering their goal counts once, no matter how long the ball stays
+    setBall(frame, 0, Dims.Length() / 2);
+    metrics.addFrame(frame);
+    setBall(frame, 0, Dims.Length() + 0.05);
+    metrics.addFrame(frame);
+    metrics.addFrame(frame);
+    EXPECT_EQ(1, metrics.goalsFor);
+
+    // Frames without the ball don't reset it
+    frame.clear_ball();
+    metrics.addFrame(frame);
+    setBall(frame, 0, Dims.Length() + 0.05);
+    metrics.addFrame(frame);
+    EXPECT_EQ(1, metrics.goalsFor);
+
+    // Next to the goal
+    setBall(frame, Dims.GoalWidth(), -0.05);
+    metrics.addFrame(frame);
+    EXPECT_EQ(0, metrics.goalsAgainst);
+
+    setBall(frame, 0, -0.05);
+    metrics.addFrame(frame);
+    EXPECT_EQ(1, metrics.goalsAgainst);
+    EXPECT_EQ(1, metrics.goalsFor);
+    EXPECT_EQ(7, metrics.frames);
+}
+
+TEST(LogMetrics, possession) {
+    LogMetrics metrics(Dims);
+    LogFrame frame;
+    setBall(frame, 0, 1);
+    LogFrame::Robot* us = frame.add_self();
+    LogFrame::Robot* them = frame.add_opp();
+
+    // Ours is closer
+    addRobot(us, 0, 1 - Robot_Radius);
+    addRobot(them, 0, 1 + Robot_Radius + 0.02);
+    metrics.addFrame(frame);
+
+    // Theirs is closer
+    addRobot(us, 1, 1);
+    addRobot(them, 0, 1 + Robot_Radius);
+    metrics.addFrame(frame);
+
+    // Nobody is close enough
+    addRobot(them, 1, 2);
+    metrics.addFrame(frame);
+
+    EXPECT_EQ(1, metrics.ourPossession);
+    EXPECT_EQ(1, metrics.theirPossession);
+    EXPECT_FLOAT_EQ(0.5, metrics.possession());
+}
+
+TEST(LogMetrics, timing) {
+    LogMetrics metrics(Dims, 1000);
+    LogFrame frame;
+
+    frame.set_planning_time(100);
+    frame.set_processing_time(500);
+    metrics.addFrame(frame);
+
+    frame.set_planning_time(300);
+    frame.set_processing_time(1500);
+    metrics.addFrame(frame);
+
+    EXPECT_EQ(400, metrics.planningTime);
+    EXPECT_EQ(300, metrics.maxPlanningTime);
+    EXPECT_FLOAT_EQ(200, metrics.meanPlanningTime());
+    EXPECT_EQ(1, metrics.overruns);
+}
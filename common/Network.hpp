@@ -22,11 +22,27 @@
 //
 //    RadioTx packets go from soccer to radio.
 //    RadioRx packets go from radio to soccer.
+//    The simulator sends a single RadioRxBatch per team for all of the RadioTx
+//    packets it received since it last replied.
 //
 // The network ports are set in Processor's constructor and don't change after
 // that. They are determined by command-line options (-sim and -r). If no radio
 // channel is given on the command line, the first available one is picked based
 // on which soccer-side port can be bound.
+//
+// Shared memory:
+//    With -shm/--shm, simulated vision and radio go through rings in shared
+//    memory (see ShmRing.hpp) instead of UDP.  Each port above is replaced by
+//    the ring for a channel below, numbered like the ports (e.g. vision1 is
+//    SimVisionPort + 1) and named after the port block.  Simulator commands
+//    and the referee still use UDP.
+//
+// Port blocks:
+//    Several simulator+soccer pairs can run on one machine (see batch-sim).
+//    Each pair is given a port offset with -port-offset/--port-offset, which is
+//    added to every simulator, radio and referee port it uses.  Offsets should
+//    be multiples of PortBlockSize so the blocks don't overlap, and no more
+//    than MaxPortOffset so they don't reach the next group of fixed ports.
 
 static const char RefereeAddress[] = "224.5.23.1";
 static const char SharedVisionAddress[] = "224.5.23.2";
@@ -54,3 +70,14 @@ static const int SharedVisionPortDoubleNew = 10006;
 
 static const int RadioRxPort = 12000;
 static const int RadioTxPort = 13000;
+
+static const int PortBlockSize = 10;
+
+// Largest port offset.  The simulator and radio port groups are only about
+// 1000 apart, so a larger offset would, for example, move RadioRxPort's block
+// onto RadioTxPort.
+static const int MaxPortOffset = RadioTxPort - RadioRxPort - PortBlockSize;
+
+static const char ShmVisionChannel[] = "vision";
+static const char ShmRadioRxChannel[] = "radio-rx";
+static const char ShmRadioTxChannel[] = "radio-tx";
@@ -24,6 +24,7 @@ Pid::Pid(float p, float i, float d, unsigned int windup) : _oldErr() {
 void Pid::setWindup(unsigned int w) {
     if (w != _windup) {
         _windup = w;
+        _windupLoc = 0;
 
         if (w > 0) {
             _oldErr.resize(w);
@@ -0,0 +1,36 @@
+#include "RadioCommand.hpp"
+
+#include <algorithm>
+
+using namespace std;
+using namespace RadioProtocol;
+
+RobotCommand radioCommand(const Packet::Control& control, unsigned int shell) {
+    Velocity v = toRadio(control.xvelocity(), control.yvelocity(),
+                         control.avelocity());
+
+    RobotCommand cmd;
+    cmd.shell = shell & 0x0f;
+    cmd.bodyX = v.x;
+    cmd.bodyY = v.y;
+    cmd.bodyW = v.w;
+    cmd.dribbler =
+        max(0, min(255, static_cast<uint16_t>(control.dvelocity()) * 2));
+    cmd.kickStrength = static_cast<uint8_t>(control.kcstrength());
+    cmd.chip = control.shootmode() == Packet::Control::CHIP;
+    cmd.immediate = control.triggermode() == Packet::Control::IMMEDIATE;
+    cmd.song = control.song() == Packet::Control::FIGHT_SONG;
+    return cmd;
+}
+
+TrajectorySegment radioSegment(const Packet::Control& control,
+                               unsigned int shell) {
+    if (!control.has_segment()) {
+        return TrajectorySegment::hold(radioCommand(control, shell));
+    }
+
+    const Packet::Control::Segment& s = control.segment();
+    return toSegment(radioCommand(control, shell), s.duration(),
+                     toRadio(s.xmiddle(), s.ymiddle(), s.amiddle()),
+                     toRadio(s.xend(), s.yend(), s.aend()));
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <protobuf/Control.pb.h>
+
+#include "../firmware/common2015/utils/radio-protocol.hpp"
+
+/// Converts soccer's command for <shell> to the radio's units.  Soccer sends
+/// this to the robots, and the simulator gives the same to its robots.
+RadioProtocol::RobotCommand radioCommand(const Packet::Control& control,
+                                         unsigned int shell);
+
+/// Converts soccer's command and trajectory segment for <shell> to the
+/// radio's units.  Without a segment, the command's velocities are held.
+RadioProtocol::TrajectorySegment radioSegment(const Packet::Control& control,
+                                              unsigned int shell);
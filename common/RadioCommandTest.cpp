@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include "RadioCommand.hpp"
+
+using namespace RadioProtocol;
+
+TEST(RadioCommand, command) {
+    Packet::Control control;
+    control.set_xvelocity(0);
+    control.set_yvelocity(0);
+    control.set_avelocity(0);
+    control.set_dvelocity(100);
+    control.set_kcstrength(200);
+    control.set_shootmode(Packet::Control::CHIP);
+    control.set_triggermode(Packet::Control::IMMEDIATE);
+    control.set_song(Packet::Control::FIGHT_SONG);
+
+    RobotCommand cmd = radioCommand(control, 0x13);
+    EXPECT_EQ(3, cmd.shell);
+    EXPECT_EQ(200, cmd.dribbler);
+    EXPECT_EQ(200, cmd.kickStrength);
+    EXPECT_TRUE(cmd.chip);
+    EXPECT_TRUE(cmd.immediate);
+    EXPECT_TRUE(cmd.song);
+
+    // The dribbler speed saturates
+    control.set_dvelocity(200);
+    EXPECT_EQ(255, radioCommand(control, 3).dribbler);
+
+    // Without a segment, the command is held
+    TrajectorySegment segment = radioSegment(control, 3);
+    EXPECT_EQ(0, segment.length);
+    EXPECT_TRUE(segment.command == radioCommand(control, 3));
+}
@@ -0,0 +1,295 @@
+#include "ShmRing.hpp"
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+static const uint32_t Magic = 0x52494e47;
+
+struct ShmRing::Header {
+    // Set last when the ring is created
+    atomic<uint32_t> magic;
+    uint32_t capacity;
+
+    atomic<uint32_t> abandoned;
+
+    // Process ID of the reader or zero
+    atomic<uint32_t> reader;
+
+    // Total bytes written and read.  The position of each in the data is this
+    // modulo the capacity.
+    atomic<uint64_t> head;
+    atomic<uint64_t> tail;
+
+    // Incremented after each write.  An empty reader waits for this to change.
+    atomic<uint32_t> sequence;
+    atomic<uint32_t> waiting;
+
+    atomic<uint32_t> dropped;
+};
+
+#ifdef __linux__
+static void futexWait(atomic<uint32_t>* word, uint32_t value, int timeout) {
+    struct timespec ts;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+static void futexWake(atomic<uint32_t>* word) {
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT_MAX, nullptr, nullptr,
+            0);
+}
+#else
+// No futexes here, so readers poll
+static void futexWait(atomic<uint32_t>* word, uint32_t value, int timeout) {
+    for (int t = 0; t < timeout && word->load() == value; ++t) {
+        ::usleep(1000);
+    }
+}
+
+static void futexWake(atomic<uint32_t>* word) {}
+#endif
+
+string ShmRing::name(const char* channel, int index, int portOffset) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/robocup-%d-%s%d", portOffset, channel, index);
+    return buf;
+}
+
+ShmRing::ShmRing() {
+    _header = nullptr;
+    _data = nullptr;
+    _mappedSize = 0;
+    _owner = false;
+    _claimed = false;
+}
+
+ShmRing::~ShmRing() { close(); }
+
+bool ShmRing::create(const string& name, uint32_t capacity) {
+    close();
+
+    // A ring left behind by a crashed owner may still be open in a reader, so
+    // it is marked abandoned before it is replaced.
+    ShmRing old;
+    if (old.open(name)) {
+        old._header->abandoned = 1;
+        futexWake(&old._header->sequence);
+    }
+    old.close();
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "ShmRing: can't create %s: %m\n", name.c_str());
+        return false;
+    }
+
+    size_t size = sizeof(Header) + capacity;
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "ShmRing: can't map %s: %m\n", name.c_str());
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // The new memory is zeroed
+    _header = (Header*)p;
+    _header->capacity = capacity;
+    _header->magic.store(Magic, memory_order_release);
+
+    _data = (uint8_t*)p + sizeof(Header);
+    _mappedSize = size;
+    _name = name;
+    _owner = true;
+    return true;
+}
+
+bool ShmRing::open(const string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(Header)) {
+        p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+
+    // The owner may not have finished setting it up
+    Header* header = (Header*)p;
+    if (header->magic.load(memory_order_acquire) != Magic ||
+        sizeof(Header) + header->capacity > (size_t)st.st_size) {
+        munmap(p, st.st_size);
+        return false;
+    }
+
+    _header = header;
+    _data = (uint8_t*)p + sizeof(Header);
+    _mappedSize = st.st_size;
+    _name = name;
+    _owner = false;
+    return true;
+}
+
+void ShmRing::close() {
+    if (!_header) {
+        return;
+    }
+
+    if (_claimed) {
+        _header->reader = 0;
+        _claimed = false;
+    }
+
+    if (_owner) {
+        // Wake up a waiting reader so it notices
+        _header->abandoned = 1;
+        futexWake(&_header->sequence);
+        shm_unlink(_name.c_str());
+    }
+
+    munmap(_header, _mappedSize);
+    _header = nullptr;
+    _data = nullptr;
+    _mappedSize = 0;
+}
+
+bool ShmRing::abandoned() const { return _header && _header->abandoned; }
+
+bool ShmRing::claim() {
+    if (!_header) {
+        return false;
+    }
+
+    uint32_t pid = getpid();
+    uint32_t reader = _header->reader;
+    while (reader != pid) {
+        // Take over from a reader that died without closing the ring
+        if (reader && !(kill(reader, 0) < 0 && errno == ESRCH)) {
+            return false;
+        }
+        if (_header->reader.compare_exchange_weak(reader, pid)) {
+            break;
+        }
+    }
+
+    _claimed = true;
+    return true;
+}
+
+bool ShmRing::claimed() const { return _header && _header->reader != 0; }
+
+uint32_t ShmRing::dropped() const {
+    return _header ? _header->dropped.load() : 0;
+}
+
+void ShmRing::copyIn(uint64_t pos, const void* data, uint32_t size) {
+    uint32_t start = pos % _header->capacity;
+    uint32_t first = min(size, _header->capacity - start);
+    memcpy(_data + start, data, first);
+    memcpy(_data, (const uint8_t*)data + first, size - first);
+}
+
+void ShmRing::copyOut(uint64_t pos, void* data, uint32_t size) const {
+    uint32_t start = pos % _header->capacity;
+    uint32_t first = min(size, _header->capacity - start);
+    memcpy(data, _data + start, first);
+    memcpy((uint8_t*)data + first, _data, size - first);
+}
+
+bool ShmRing::write(const void* data, uint32_t size) {
+    if (!_header) {
+        return false;
+    }
+
+    // Only this process changes head
+    uint64_t head = _header->head.load(memory_order_relaxed);
+    uint64_t tail = _header->tail.load(memory_order_acquire);
+    uint64_t needed = sizeof(size) + size;
+    if (head - tail + needed > _header->capacity) {
+        ++_header->dropped;
+        return false;
+    }
+
+    copyIn(head, &size, sizeof(size));
+    copyIn(head + sizeof(size), data, size);
+    _header->head.store(head + needed, memory_order_release);
+
+    ++_header->sequence;
+    if (_header->waiting) {
+        futexWake(&_header->sequence);
+    }
+    return true;
+}
+
+bool ShmRing::read(string& data, int timeout) {
+    if (!_header) {
+        return false;
+    }
+
+    // Only this process changes tail
+    uint64_t tail = _header->tail.load(memory_order_relaxed);
+    while (true) {
+        // The sequence is read first so a write after the head is checked
+        // makes the futex return immediately.
+        uint32_t sequence = _header->sequence;
+        if (_header->head.load(memory_order_acquire) != tail) {
+            break;
+        }
+
+        if (timeout <= 0 || _header->abandoned) {
+            return false;
+        }
+
+        _header->waiting = 1;
+        futexWait(&_header->sequence, sequence, timeout);
+        _header->waiting = 0;
+
+        // Check once more, but don't wait again
+        timeout = 0;
+    }
+
+    uint32_t size = 0;
+    copyOut(tail, &size, sizeof(size));
+    if (size > _header->capacity - sizeof(size)) {
+        // Corrupted, so there's no way to find the next message
+        fprintf(stderr, "ShmRing: bad message size %u in %s\n", size,
+                _name.c_str());
+        _header->tail.store(_header->head, memory_order_release);
+        return false;
+    }
+
+    data.resize(size);
+    copyOut(tail + sizeof(size), &data[0], size);
+    _header->tail.store(tail + sizeof(size) + size, memory_order_release);
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief Message queue in shared memory between two processes
+ *
+ * @details This replaces UDP on localhost between the simulator and soccer
+ * when both are started with shared memory enabled (--shm and -shm).  Each
+ * ring carries variable-length messages from one writer to one reader without
+ * locks.  A reader that finds the ring empty sleeps on a futex until the
+ * writer adds a message, so messages are picked up without polling.
+ *
+ * The process that creates a ring owns it and removes it when it is closed.
+ * The other process opens it by name.  If the owner goes away, the ring is
+ * marked as abandoned so the other side knows to open the owner's new ring.
+ *
+ * Like UDP, new messages are dropped when the ring is full.
+ */
+class ShmRing {
+public:
+    static const uint32_t DefaultCapacity = 256 * 1024;
+
+    /// Name of a ring for one of the channels in Network.hpp.  <index> is
+    /// added to the channel like it is to the port the ring replaces, e.g. the
+    /// radio channel for the team.
+    static std::string name(const char* channel, int index, int portOffset);
+
+    ShmRing();
+    ~ShmRing();
+
+    /// Creates a new ring, replacing any old one with the same name.
+    /// <capacity> is in bytes and includes four bytes of overhead per message.
+    bool create(const std::string& name, uint32_t capacity = DefaultCapacity);
+
+    /// Opens a ring created by another process
+    bool open(const std::string& name);
+
+    void close();
+
+    bool isOpen() const { return _header != nullptr; }
+
+    /// True if the owner has closed the ring
+    bool abandoned() const;
+
+    /// Makes this the ring's only reader.  Returns false if another live
+    /// process has already claimed it.
+    bool claim();
+
+    /// True if a reader has claimed the ring
+    bool claimed() const;
+
+    /// Adds a message.  Returns false if it doesn't fit.
+    bool write(const void* data, uint32_t size);
+    bool write(const std::string& data) {
+        return write(data.data(), data.size());
+    }
+
+    /// Removes the oldest message and stores it in <data>, waiting up to
+    /// <timeout> milliseconds for one if the ring is empty.
+    /// Returns false if no message arrived.
+    bool read(std::string& data, int timeout = 0);
+
+    /// Number of messages that were dropped because the ring was full
+    uint32_t dropped() const;
+
+private:
+    struct Header;
+
+    void copyIn(uint64_t pos, const void* data, uint32_t size);
+    void copyOut(uint64_t pos, void* data, uint32_t size) const;
+
+    Header* _header;
+    uint8_t* _data;
+    size_t _mappedSize;
+    std::string _name;
+    bool _owner;
+    bool _claimed;
+};
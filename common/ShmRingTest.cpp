@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "ShmRing.hpp"
+
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// Each test uses its own ring so tests can run in parallel processes
+static string testName(const char* test) {
+    return ShmRing::name(test, 0, getpid());
+}
+
+TEST(ShmRing, readWrite) {
+    ShmRing owner, other;
+    ASSERT_TRUE(owner.create(testName("readWrite")));
+    ASSERT_TRUE(other.open(testName("readWrite")));
+
+    string data;
+    EXPECT_FALSE(other.read(data));
+
+    EXPECT_TRUE(owner.write(string("first")));
+    EXPECT_TRUE(owner.write(string()));
+    EXPECT_TRUE(owner.write(string("third")));
+
+    ASSERT_TRUE(other.read(data));
+    EXPECT_EQ("first", data);
+    ASSERT_TRUE(other.read(data));
+    EXPECT_EQ("", data);
+    ASSERT_TRUE(other.read(data));
+    EXPECT_EQ("third", data);
+    EXPECT_FALSE(other.read(data));
+}
+
+TEST(ShmRing, wrapAround) {
+    ShmRing owner, other;
+    ASSERT_TRUE(owner.create(testName("wrapAround"), 64));
+    ASSERT_TRUE(other.open(testName("wrapAround")));
+
+    // Messages that don't divide the capacity evenly end up split
+    string data;
+    for (int i = 0; i < 100; ++i) {
+        string msg(5 + i % 20, 'a' + i % 26);
+        ASSERT_TRUE(owner.write(msg));
+        ASSERT_TRUE(other.read(data));
+        EXPECT_EQ(msg, data);
+    }
+    EXPECT_EQ(0u, owner.dropped());
+}
+
+TEST(ShmRing, full) {
+    ShmRing owner, other;
+    ASSERT_TRUE(owner.create(testName("full"), 32));
+    ASSERT_TRUE(other.open(testName("full")));
+
+    // Each message takes 4 bytes for its size
+    string msg(12, 'x');
+    EXPECT_TRUE(owner.write(msg));
+    EXPECT_TRUE(owner.write(msg));
+    EXPECT_FALSE(owner.write(msg));
+    EXPECT_EQ(1u, owner.dropped());
+
+    // Reading makes room
+    string data;
+    EXPECT_TRUE(other.read(data));
+    EXPECT_TRUE(owner.write(msg));
+}
+
+TEST(ShmRing, claim) {
+    ShmRing owner, first, second;
+    ASSERT_TRUE(owner.create(testName("claim")));
+    ASSERT_TRUE(first.open(testName("claim")));
+    ASSERT_TRUE(second.open(testName("claim")));
+
+    EXPECT_FALSE(owner.claimed());
+    EXPECT_TRUE(first.claim());
+    EXPECT_TRUE(owner.claimed());
+
+    // Claims are made by process, so a reader in another process would be
+    // refused here.  Closing the reader releases the claim.
+    first.close();
+    EXPECT_FALSE(owner.claimed());
+    EXPECT_TRUE(second.claim());
+}
+
+TEST(ShmRing, wait) {
+    ShmRing owner, other;
+    ASSERT_TRUE(owner.create(testName("wait")));
+    ASSERT_TRUE(other.open(testName("wait")));
+
+    // Times out
+    string data;
+    EXPECT_FALSE(other.read(data, 10));
+
+    // Wakes up for a message
+    thread writer([&]() {
+        ::usleep(10 * 1000);
+        owner.write(string("hello"));
+    });
+    bool received = other.read(data, 5000);
+    writer.join();
+    ASSERT_TRUE(received);
+    EXPECT_EQ("hello", data);
+}
+
+TEST(ShmRing, abandoned) {
+    ShmRing owner, other;
+    ASSERT_TRUE(owner.create(testName("abandoned")));
+    ASSERT_TRUE(other.open(testName("abandoned")));
+    EXPECT_FALSE(other.abandoned());
+
+    owner.close();
+    EXPECT_TRUE(other.abandoned());
+
+    // A new owner's ring can be opened under the same name
+    ASSERT_TRUE(owner.create(testName("abandoned")));
+    ASSERT_TRUE(other.open(testName("abandoned")));
+    EXPECT_FALSE(other.abandoned());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * @brief Passes the latest value from one thread to another without locks
+ *
+ * @details There are three copies of the value.  The writer fills back() and
+ * publishes it, and the reader picks up the most recently published copy with
+ * update().  Neither side ever waits for the other, and the reader never sees
+ * a partly written value.  Values published while the reader isn't looking
+ * are replaced, so this is only for state where the newest value is all that
+ * matters.
+ *
+ * There must be only one writer thread and one reader thread.
+ */
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : _front(0), _middle(1), _back(2) {}
+
+    /// The copy the writer fills before calling publish()
+    T& back() { return _values[_back]; }
+
+    /// Makes back() the latest value and gives the writer a new back().
+    /// The new back() holds an old value.
+    void publish() {
+        uint8_t old =
+            _middle.exchange(_back | Fresh, std::memory_order_acq_rel);
+        _back = old & IndexMask;
+    }
+
+    /// Makes the latest published value available from front().  Returns
+    /// false if nothing was published since the last call.
+    bool update() {
+        if (!(_middle.load(std::memory_order_relaxed) & Fresh)) {
+            return false;
+        }
+        uint8_t old = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = old & IndexMask;
+        return true;
+    }
+
+    /// The value picked up by the last update()
+    const T& front() const { return _values[_front]; }
+
+private:
+    static const uint8_t IndexMask = 3;
+
+    // Set in _middle when it holds a value the reader hasn't seen
+    static const uint8_t Fresh = 4;
+
+    T _values[3];
+
+    // Only used by the reader
+    uint8_t _front;
+
+    // Index of the copy being handed over, and the Fresh flag
+    std::atomic<uint8_t> _middle;
+
+    // Only used by the writer
+    uint8_t _back;
+};
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "TripleBuffer.hpp"
+
+#include <thread>
+
+TEST(TripleBuffer, latestValue) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(2, buffer.front());
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(2, buffer.front());
+
+    buffer.back() = 3;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(3, buffer.front());
+}
+
+TEST(TripleBuffer, threads) {
+    // Each value has two copies of a counter that must always match
+    struct Value {
+        int a = 0;
+        int b = 0;
+    };
+    TripleBuffer<Value> buffer;
+
+    const int N = 100000;
+    std::thread writer([&]() {
+        for (int i = 1; i <= N; ++i) {
+            buffer.back().a = i;
+            buffer.back().b = i;
+            buffer.publish();
+        }
+    });
+
+    int last = 0;
+    while (last < N) {
+        if (buffer.update()) {
+            const Value& v = buffer.front();
+            ASSERT_EQ(v.a, v.b);
+            ASSERT_GT(v.a, last);
+            last = v.a;
+        }
+    }
+    writer.join();
+}
@@ -2,19 +2,48 @@
 
 #include <sys/time.h>
 
+#include <atomic>
+#include <stdint.h>
+
 namespace RJ {
 
 /// type for storing time in microseconds
 typedef uint64_t Time;
 
-/** returns the local system timestamp in microseconds */
-static inline Time timestamp() {
+/// Simulated time that timestamp() returns instead of the system time, or
+/// zero to use the system time.  This is shared by every file that includes
+/// this header.
+inline std::atomic<Time>& simulatedTime() {
+    static std::atomic<Time> time(0);
+    return time;
+}
+
+/// Makes timestamp() return <time>, as when running in lockstep with the
+/// simulator.  Zero goes back to the system time.
+inline void setSimulatedTime(Time time) { simulatedTime() = time; }
+
+/// Simulated time when the simulator's clock is zero.  Soccer and the
+/// simulator both use this in lockstep mode, so their timestamps agree and
+/// are the same on every run.  It is far from zero so that subtracting an
+/// interval from a simulated time doesn't wrap around.
+const Time SimulatedEpoch = 1000000000ULL * 1000000;
+
+/** returns the local system timestamp in microseconds, even while time is
+ * simulated.  Use this to measure how long something takes. */
+static inline Time systemTimestamp() {
     struct timeval time;
     gettimeofday(&time, nullptr);
 
     return (Time)time.tv_sec * 1000000 + (Time)time.tv_usec;
 }
 
+/** returns the current time in microseconds: the simulated time if it is
+ * set, otherwise the local system timestamp */
+static inline Time timestamp() {
+    Time simulated = simulatedTime().load(std::memory_order_relaxed);
+    return simulated ? simulated : systemTimestamp();
+}
+
 /// Converts a decimal number of seconds to an integer timestamp in microseconds
 static inline RJ::Time SecsToTimestamp(double secs) {
     return secs * 1000000.0f;
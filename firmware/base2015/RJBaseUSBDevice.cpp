@@ -4,6 +4,8 @@
 #include <USBDevice_Types.h>
 #include "usb-interface.hpp"
 
+#include <algorithm>
+
 bool RJBaseUSBDevice::USBCallback_setConfiguration(uint8_t configuration) {
     LOG(INIT, "RJBaseUSBDevice::USBCallback_setConfiguration() called");
 
@@ -55,6 +57,21 @@ bool RJBaseUSBDevice::USBCallback_request() {
                 if (strobeCallback) strobeCallback(transfer->setup.wIndex);
                 return true;
 
+            case Base2015ControlCommand::ReadCounters:
+                LOG(INF3, "counters request");
+                if (countersCallback) {
+                    _counters = countersCallback();
+
+                    transfer->direction = DEVICE_TO_HOST;
+                    transfer->ptr = reinterpret_cast<uint8_t*>(&_counters);
+                    transfer->remaining =
+                        std::min<uint32_t>(sizeof(_counters),
+                                           transfer->setup.wLength);
+                } else {
+                    EP0stall();
+                }
+                return true;
+
             default:
                 LOG(WARN, "Unrecognized usb VENDOR request '%d'",
                     transfer->setup.bRequest);
@@ -5,6 +5,8 @@
 #include <USBEndpoints.h>
 #include <functional>
 
+#include "radio-schedule.hpp"
+
 /** Subclass of USBDevice to customize usb descriptors and setup two bulk
  * endpoints, one IN and one OUT.
  */
@@ -24,6 +26,9 @@ public:
     std::function<void(uint8_t strobe)> strobeCallback = nullptr;
     std::function<uint8_t(uint8_t reg)> readRegisterCallback = nullptr;
 
+    /// Returns the counters for a ReadCounters request
+    std::function<RadioSchedule::Counters()> countersCallback = nullptr;
+
     /**
     * Called for control transfers.  If it's a VENDOR request, we handle it. The
     * types of requests that will come through this callback include requests to
@@ -43,4 +48,5 @@ public:
 
 private:
     uint8_t _controlTransferReplyValue;
+    RadioSchedule::Counters _counters;
 };
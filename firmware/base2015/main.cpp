@@ -6,6 +6,8 @@
 #include "CC1201Radio.hpp"
 #include "logger.hpp"
 #include "pins.hpp"
+#include "radio-protocol.hpp"
+#include "radio-schedule.hpp"
 #include "usb-interface.hpp"
 #include "watchdog.hpp"
 #include "RJBaseUSBDevice.hpp"
@@ -18,6 +20,11 @@ using namespace std;
 RJBaseUSBDevice usbLink(RJ_BASE2015_VENDOR_ID, RJ_BASE2015_PRODUCT_ID,
                         RJ_BASE2015_RELEASE);
 
+// Decides when forward and reverse packets are sent.  Reverse packets come
+// from the radio's thread, so this is locked.
+RadioSchedule::Scheduler scheduler;
+Mutex schedulerMutex;
+
 bool initRadio() {
     // setup SPI bus
     shared_ptr<SharedSPI> sharedSPI =
@@ -33,21 +40,21 @@ bool initRadio() {
 
     // Create a new physical hardware communication link
     global_radio =
-        new CC1201(sharedSPI, RJ_RADIO_nCS, RJ_RADIO_INT, preferredSettings,
-                   sizeof(preferredSettings) / sizeof(registerSetting_t));
+        new CC1201(sharedSPI, RJ_RADIO_nCS, RJ_RADIO_INT, preferredConfig);
 
     return global_radio->isConnected();
 }
 
 void radioRxHandler(rtp::packet* pkt) {
     LOG(INF3, "radioRxHandler()");
-    // write packet content out to EPBULK_IN
-    // TODO(justin): use pkt.pack() and include header info once packet
-    // structure changes
-    bool success = usbLink.writeNB(EPBULK_IN, pkt->payload.data(),
-                                   pkt->payload.size(), MAX_PACKET_SIZE_EPBULK);
 
-    if (!success) LOG(WARN, "Failed to transfer received packet over usb");
+    // The main loop sends reverse packets to soccer a few at a time
+    schedulerMutex.lock();
+    bool success = scheduler.reverse(pkt->payload.data(), pkt->payload.size(),
+                                     us_ticker_read());
+    schedulerMutex.unlock();
+
+    if (!success) LOG(WARN, "Dropped a reverse packet");
 }
 
 int main() {
@@ -86,6 +93,11 @@ int main() {
     usbLink.strobeCallback =
         [](uint8_t strobe) { global_radio->strobe(strobe); };
 
+    // This is called in an ISR, so it can't lock the scheduler.  Each counter
+    // is a word that is read at once, but they may not all be from the same
+    // moment.
+    usbLink.countersCallback = []() { return scheduler.counters(); };
+
     LOG(INIT, "Initializing USB interface...");
     usbLink.connect();  // note: this blocks until the link is connected
     LOG(INIT, "Initialized USB interface!");
@@ -99,18 +111,34 @@ int main() {
     uint8_t buf[MAX_PACKET_SIZE_EPBULK];
     uint32_t bufSize;
 
+    uint8_t forward[RadioProtocol::FullPacketSize];
+    uint8_t reverse[RadioSchedule::MaxTransferSize];
+
     while (true) {
         // make sure we can always reach back to main by renewing the watchdog
         // timer periodically
         Watchdog::Renew();
 
-        // attempt to read data from EPBULK_OUT
-        // if data is available, write it into @pkt and send it
-        if (usbLink.readEP_NB(EPBULK_OUT, buf, &bufSize, sizeof(buf))) {
+        // attempt to read data from EPBULK_OUT.  Commands wait for the next
+        // radio frame, and a newer command for a robot replaces an older one.
+        bool haveRead =
+            usbLink.readEP_NB(EPBULK_OUT, buf, &bufSize, sizeof(buf));
+        if (haveRead) {
             LOG(INF3, "Read %d bytes from BULK IN", bufSize);
-            // construct packet from buffer received over USB
+        }
+
+        schedulerMutex.lock();
+        uint32_t now = us_ticker_read();
+        if (haveRead && !scheduler.forward(buf, bufSize, now)) {
+            LOG(WARN, "Dropped a bad forward packet of %u bytes", bufSize);
+        }
+        size_t forwardSize = scheduler.nextFrame(now, forward, sizeof(forward));
+        size_t reverseSize = scheduler.takeBatch(now, reverse, sizeof(reverse));
+        schedulerMutex.unlock();
+
+        if (forwardSize) {
             rtp::packet pkt;
-            pkt.payload.insert(pkt.payload.end(), buf, &buf[bufSize]);
+            pkt.payload.assign(forward, forwardSize);
 
             // TODO(justin): remove this, the buffer should contain this
             pkt.header.port = rtp::port::CONTROL;
@@ -120,5 +148,14 @@ int main() {
             // transmit!
             CommModule::Instance->send(pkt);
         }
+
+        // write the batch of reverse packets out to EPBULK_IN
+        // TODO(justin): use pkt.pack() and include header info once packet
+        // structure changes
+        if (reverseSize &&
+            !usbLink.writeNB(EPBULK_IN, reverse, reverseSize,
+                             MAX_PACKET_SIZE_EPBULK)) {
+            LOG(WARN, "Failed to transfer received packets over usb");
+        }
     }
 }
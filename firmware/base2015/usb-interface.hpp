@@ -11,4 +11,7 @@ enum Base2015ControlCommand {
     RadioWriteRegister = 1,
     RadioReadRegister,
     RadioStrobe,
+
+    // Returns the base station's RadioSchedule::Counters
+    ReadCounters,
 };
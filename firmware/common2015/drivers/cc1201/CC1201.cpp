@@ -5,24 +5,21 @@
 
 // check that the address byte doesn't have any non-address bits set
 // see "3.2 Access Types" in User Guide
-void ASSERT_IS_ADDR(uint16_t addr) {
-    ASSERT(addr <= 0x002E || (addr >= 0x2F00 && addr <= 0x2FFF) ||
-           (addr >= 0x3E00 && addr <= 0x3EFF) || (addr == 0x003F) ||
-           (addr == 0x007F) || (addr == 0x00BF) || (addr == 0x00FF));
-}
+void ASSERT_IS_ADDR(uint16_t addr) { ASSERT(CC1201Config::isAddress(addr)); }
 
 // TODO(justin): remove this
 CC1201* global_radio = nullptr;
 
 CC1201::CC1201(shared_ptr<SharedSPI> sharedSPI, PinName nCs, PinName intPin,
-               const registerSetting_t* regs, size_t len, int rssiOffset)
+               const uint8_t* values, const CC1201Config::Burst* bursts,
+               size_t numBursts, int rssiOffset)
     : CommLink(sharedSPI, nCs, intPin) {
     reset();
     selfTest();
 
     if (_isInit) {
         // set initial configuration
-        setConfig(regs, len);
+        setConfig(values, bursts, numBursts);
 
         writeReg(CC1201_AGC_GAIN_ADJUST, twos_compliment(rssiOffset));
 
@@ -393,10 +390,11 @@ bool CC1201::isLocked() {
     return readReg(CC1201_FSCAL_CTRL) & 0x01;
 }
 
-void CC1201::setConfig(const registerSetting_t* regs, size_t len) {
-    if (!regs) return;
+void CC1201::setConfig(const uint8_t* values,
+                       const CC1201Config::Burst* bursts, size_t numBursts) {
+    if (!values || !bursts) return;
 
-    for (size_t i = 0; i < len; ++i) {
-        writeReg(regs[i].addr, regs[i].value);
+    for (size_t i = 0; i < numBursts; ++i) {
+        writeReg(bursts[i].addr, values + bursts[i].first, bursts[i].size);
     }
 }
@@ -3,15 +3,9 @@
 #include "mbed.h"
 #include "rtos.h"
 #include "CommLink.hpp"
+#include "CC1201Config.hpp"
 #include "ti/defines.hpp"
 
-// The config file exported from RF Studio contains an array consisting of these
-// structs.
-typedef struct {
-    uint16_t addr;
-    uint8_t value;
-} registerSetting_t;
-
 /**
  * @brief The CC1201 class handles wirelessly sending and receiving data using
  *     the TI CC1201 radio transceiver.
@@ -30,17 +24,19 @@ public:
      * Initialize the CC1201 with the given SPI, chip select (inverted), and
      * interrupt line pins.
      *
-     * The radio is configured by providing an array of registerSetting_t's
-     * which specify (address, value pairs) for configuration registers.
-     * Typically the register settings files are exported from TI's SmartRF
-     * Studio program.
+     * The radio is configured from an array of registerSetting_t's which
+     * specify (address, value pairs) for configuration registers, grouped
+     * into burst writes at compile time.  Typically the register settings
+     * files are exported from TI's SmartRF Studio program.
      *
-     * @param regs An array of registereSetting_t values
-     * @param len The length of the @regs array
+     * @param config The register settings made into a CC1201Config::Plan
      */
+    template <size_t N, size_t B>
     CC1201(std::shared_ptr<SharedSPI> sharedSPI, PinName nCs, PinName intPin,
-           const registerSetting_t* regs, size_t len,
-           int rssiOffset = DEFAULT_RSSI_OFFSET);
+           const CC1201Config::Plan<N, B>& config,
+           int rssiOffset = DEFAULT_RSSI_OFFSET)
+        : CC1201(sharedSPI, nCs, intPin, config.values, config.bursts, B,
+                 rssiOffset) {}
 
     /**
      * Transmit data
@@ -105,13 +101,18 @@ protected:
 
     static const int DEFAULT_RSSI_OFFSET = -81;
 
-    /// Sets the radio's register configuration to the values in the given @regs
-    /// array.  This array should be exported from SmartRf Studio.
-    /// See cfg/readme.md form more info.
+    /// Sets the radio's register configuration by writing the bursts of a
+    /// CC1201Config::Plan.  The settings should be exported from SmartRf
+    /// Studio.  See cfg/readme.md form more info.
     // TODO: return value to indicate success
-    void setConfig(const registerSetting_t* regs, size_t len);
+    void setConfig(const uint8_t* values, const CC1201Config::Burst* bursts,
+                   size_t numBursts);
 
 private:
+    CC1201(std::shared_ptr<SharedSPI> sharedSPI, PinName nCs, PinName intPin,
+           const uint8_t* values, const CC1201Config::Burst* bursts,
+           size_t numBursts, int rssiOffset);
+
     uint8_t _lqi;
     uint8_t _chip_version;
     bool _isInit;
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ti/defines.hpp"
+
+// The config file exported from RF Studio contains an array consisting of these
+// structs.
+typedef struct {
+    uint16_t addr;
+    uint8_t value;
+} registerSetting_t;
+
+/**
+ * Turns a register configuration into the fewest burst writes at compile time.
+ *
+ * Registers are written in address order, and registers at consecutive
+ * addresses in the same address space share one burst.  A burst costs one
+ * header byte in the register space or two in the extended space, so a full
+ * configuration takes a few hundred bytes on the bus in a handful of
+ * transactions instead of one transaction per register.
+ *
+ * Use it like this, so a bad configuration doesn't compile:
+ *   static constexpr auto plan =
+ *       CC1201Config::makePlan<CC1201Config::countBursts(settings)>(settings);
+ *   static_assert(CC1201Config::valid(settings), "...");
+ */
+namespace CC1201Config {
+
+/// Longest burst that CC1201::writeReg() can send
+const size_t MaxBurst = 255;
+
+/// True if <addr> is a register that can be configured
+constexpr bool isRegister(uint16_t addr) {
+    return addr <= 0x002E || (addr >= 0x2F00 && addr <= 0x2FFF);
+}
+
+/// True if <addr> can be accessed at all, including the FIFOs.  See "3.2
+/// Access Types" in the User Guide.
+constexpr bool isAddress(uint16_t addr) {
+    return isRegister(addr) || (addr >= 0x3E00 && addr <= 0x3EFF) ||
+           addr == 0x003F || addr == 0x007F || addr == 0x00BF ||
+           addr == 0x00FF;
+}
+
+/// True if every setting is for a register and no register is set twice
+template <size_t N>
+constexpr bool valid(const registerSetting_t (&regs)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        if (!isRegister(regs[i].addr)) {
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (regs[j].addr == regs[i].addr) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// True if <next> can be written in the same burst as a run of <size>
+/// registers that ends at <last>
+constexpr bool continues(uint16_t last, uint16_t next, size_t size) {
+    return next == last + 1 && (next >> 8) == (last >> 8) && size < MaxBurst;
+}
+
+/// Settings sorted by address
+template <size_t N>
+struct Sorted {
+    registerSetting_t regs[N];
+};
+
+template <size_t N>
+constexpr Sorted<N> sort(const registerSetting_t (&regs)[N]) {
+    Sorted<N> sorted{};
+    for (size_t i = 0; i < N; ++i) {
+        size_t j = i;
+        while (j > 0 && sorted.regs[j - 1].addr > regs[i].addr) {
+            sorted.regs[j] = sorted.regs[j - 1];
+            --j;
+        }
+        sorted.regs[j] = regs[i];
+    }
+    return sorted;
+}
+
+/// Number of bursts needed to write <regs>
+template <size_t N>
+constexpr size_t countBursts(const registerSetting_t (&regs)[N]) {
+    Sorted<N> sorted = sort(regs);
+    size_t count = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < N; ++i) {
+        if (i && continues(sorted.regs[i - 1].addr, sorted.regs[i].addr,
+                           size)) {
+            ++size;
+        } else {
+            ++count;
+            size = 1;
+        }
+    }
+    return count;
+}
+
+/// One burst write of <size> registers starting at <addr>, with values
+/// starting at values[first] in its Plan
+struct Burst {
+    uint16_t addr;
+    uint16_t first;
+    uint8_t size;
+};
+
+/// The values of all registers in address order, and the bursts that write
+/// them
+template <size_t N, size_t B>
+struct Plan {
+    static const size_t NumRegisters = N;
+    static const size_t NumBursts = B;
+
+    uint8_t values[N];
+    Burst bursts[B];
+};
+
+/// Groups <regs> into <B> bursts.  B must be countBursts(regs).
+template <size_t B, size_t N>
+constexpr Plan<N, B> makePlan(const registerSetting_t (&regs)[N]) {
+    static_assert(B > 0 && B <= N, "B must be countBursts(regs)");
+
+    Sorted<N> sorted = sort(regs);
+    Plan<N, B> plan{};
+    size_t b = 0;
+    for (size_t i = 0; i < N; ++i) {
+        plan.values[i] = sorted.regs[i].value;
+
+        if (i && continues(sorted.regs[i - 1].addr, sorted.regs[i].addr,
+                           plan.bursts[b].size)) {
+            ++plan.bursts[b].size;
+        } else {
+            b += i > 0;
+            plan.bursts[b].addr = sorted.regs[i].addr;
+            plan.bursts[b].first = i;
+            plan.bursts[b].size = 1;
+        }
+    }
+    return plan;
+}
+}
@@ -7,3 +7,11 @@
  * default configuration include.  See cfg/readme.md for more info.
  */
 #include "cfg/cc1101-compatible/registers.h"
+
+static_assert(CC1201Config::valid(preferredSettings),
+              "preferredSettings must set each register at most once");
+
+/// preferredSettings grouped into burst writes
+static constexpr auto preferredConfig =
+    CC1201Config::makePlan<CC1201Config::countBursts(preferredSettings)>(
+        preferredSettings);
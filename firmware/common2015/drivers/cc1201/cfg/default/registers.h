@@ -1,5 +1,5 @@
 
-static const registerSetting_t preferredSettings[] = {
+static constexpr registerSetting_t preferredSettings[] = {
     {CC1201_IOCFG3, 0x06},
     {CC1201_IOCFG2, 0x07},
     {CC1201_IOCFG1, 0x30},
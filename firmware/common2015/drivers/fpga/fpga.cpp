@@ -7,18 +7,7 @@
 
 FPGA* FPGA::Instance = nullptr;
 
-namespace {
-enum {
-    CMD_EN_DIS_MTRS = 0x30,
-    CMD_R_ENC_W_VEL = 0x80,
-    CMD_READ_ENC = 0x91,
-    CMD_READ_HALLS = 0x92,
-    CMD_READ_DUTY = 0x93,
-    CMD_READ_HASH1 = 0x94,
-    CMD_READ_HASH2 = 0x95,
-    CMD_CHECK_DRV = 0x96
-};
-}
+using namespace FpgaProtocol;
 
 FPGA::FPGA(std::shared_ptr<SharedSPI> sharedSPI, PinName nCs, PinName initB,
            PinName progB, PinName done)
@@ -143,108 +132,96 @@ bool FPGA::send_config(const std::string& filepath) {
     }
 }
 
-uint8_t FPGA::read_halls(uint8_t* halls, size_t size) {
-    uint8_t status;
+uint8_t FPGA::transaction(uint8_t command, const uint8_t* tx, uint8_t* rx,
+                          size_t size) {
+    // The command and the bytes after it are one frame
+    std::array<uint8_t, MaxFrameSize> txFrame{};
+    std::array<uint8_t, MaxFrameSize> rxFrame{};
+    size = std::min(size, MaxFrameSize - 1);
 
-    chipSelect();
-    status = _spi->write(CMD_READ_HALLS);
+    txFrame[0] = command;
+    if (tx) {
+        std::copy(tx, tx + size, txFrame.begin() + 1);
+    }
 
-    for (size_t i = 0; i < size; i++) halls[i] = _spi->write(0x00);
+    size_t frameSize = size + 1;
+    transferFrames(txFrame.data(), rxFrame.data(), &frameSize, 1);
 
-    chipDeselect();
+    std::copy(rxFrame.begin() + 1, rxFrame.begin() + frameSize, rx);
+    return rxFrame[0];
+}
 
-    return status;
+uint8_t FPGA::exchange(FpgaProtocol::Exchange& exchange) {
+    return exchange.run(*this);
 }
 
-uint8_t FPGA::read_encs(uint16_t* enc_counts, size_t size) {
-    uint8_t status;
+uint8_t FPGA::read_halls(uint8_t* halls, size_t size) {
+    return transaction(ReadHalls, nullptr, halls,
+                       std::min(size, FpgaProtocol::NumMotors));
+}
 
-    chipSelect();
-    status = _spi->write(CMD_READ_ENC);
+uint8_t FPGA::read_encs(uint16_t* enc_counts, size_t size) {
+    size = std::min(size, FpgaProtocol::NumMotors);
+    uint8_t rx[2 * FpgaProtocol::NumMotors];
+    uint8_t status = transaction(ReadEncoders, nullptr, rx, 2 * size);
 
     for (size_t i = 0; i < size; i++) {
-        enc_counts[i] = (_spi->write(0x00) << 8);
-        enc_counts[i] |= _spi->write(0x00);
+        enc_counts[i] = rx[2 * i] << 8 | rx[2 * i + 1];
     }
 
-    chipDeselect();
-
     return status;
 }
 
 uint8_t FPGA::read_duty_cycles(uint16_t* duty_cycles, size_t size) {
-    uint8_t status;
-
-    chipSelect();
-    status = _spi->write(CMD_READ_DUTY);
+    size = std::min(size, FpgaProtocol::NumMotors);
+    uint8_t rx[2 * FpgaProtocol::NumMotors];
+    uint8_t status = transaction(ReadDutyCycles, nullptr, rx, 2 * size);
 
     for (size_t i = 0; i < size; i++) {
-        duty_cycles[i] = (_spi->write(0x00) << 8);
-        duty_cycles[i] |= _spi->write(0x00);
+        duty_cycles[i] = rx[2 * i] << 8 | rx[2 * i + 1];
     }
 
-    chipDeselect();
-
     return status;
 }
 
 uint8_t FPGA::set_duty_cycles(uint16_t* duty_cycles, size_t size) {
-    uint8_t status;
-
-    // Check for valid duty cycles values
-    for (size_t i = 0; i < size; i++)
-        if (duty_cycles[i] > 0x3FF) return 0x7F;
-
-    chipSelect();
-    status = _spi->write(CMD_R_ENC_W_VEL);
-
-    for (size_t i = 0; i < size; i++) {
-        _spi->write(duty_cycles[i] & 0xFF);
-        _spi->write(duty_cycles[i] >> 8);
-    }
-
-    chipDeselect();
-
-    return status;
+    uint16_t enc_deltas[FpgaProtocol::NumMotors];
+    return set_duty_get_enc(duty_cycles, size, enc_deltas, size);
 }
 
 uint8_t FPGA::set_duty_get_enc(uint16_t* duty_cycles, size_t size_dut,
                                uint16_t* enc_deltas, size_t size_enc) {
-    uint8_t status;
-
     // Check for valid duty cycles values
     for (size_t i = 0; i < size_dut; i++)
-        if (duty_cycles[i] > 0x3FF) return 0x7F;
+        if (duty_cycles[i] > FpgaProtocol::MaxDutyCycle) return 0x7F;
+
+    size_t size = std::min(std::max(size_dut, size_enc),
+                           FpgaProtocol::NumMotors);
+    uint8_t tx[2 * FpgaProtocol::NumMotors] = {};
+    uint8_t rx[2 * FpgaProtocol::NumMotors];
+    for (size_t i = 0; i < size_dut && i < size; i++) {
+        tx[2 * i] = duty_cycles[i] & 0xFF;
+        tx[2 * i + 1] = duty_cycles[i] >> 8;
+    }
 
-    chipSelect();
-    status = _spi->write(CMD_R_ENC_W_VEL);
+    uint8_t status = transaction(UpdateMotors, tx, rx, 2 * size);
 
-    for (size_t i = 0; i < size_enc; i++) {
-        enc_deltas[i] = (_spi->write(duty_cycles[i] & 0xFF) << 8);
-        enc_deltas[i] |= _spi->write(duty_cycles[i] >> 8);
+    for (size_t i = 0; i < size_enc && i < size; i++) {
+        enc_deltas[i] = rx[2 * i] << 8 | rx[2 * i + 1];
     }
 
-    chipDeselect();
-
     return status;
 }
 
 bool FPGA::git_hash(std::vector<uint8_t>& v) {
     bool dirty_bit;
+    uint8_t rx[11];
 
-    chipSelect();
-    _spi->write(CMD_READ_HASH1);
-
-    for (size_t i = 0; i < 10; i++) v.push_back(_spi->write(0x00));
+    transaction(ReadHash1, nullptr, rx, 10);
+    v.insert(v.end(), rx, rx + 10);
 
-    chipDeselect();
-    chipSelect();
-
-    _spi->write(CMD_READ_HASH2);
-
-    for (size_t i = 0; i < 11; i++) v.push_back(_spi->write(0x00));
-
-    chipDeselect();
+    transaction(ReadHash2, nullptr, rx, 11);
+    v.insert(v.end(), rx, rx + 11);
 
     // store the dirty bit for returning
     dirty_bit = (v.back() & 0x01);
@@ -258,30 +235,19 @@ bool FPGA::git_hash(std::vector<uint8_t>& v) {
 }
 
 void FPGA::gate_drivers(std::vector<uint16_t>& v) {
-    chipSelect();
-
-    _spi->write(CMD_CHECK_DRV);
+    uint8_t rx[2 * FpgaProtocol::NumMotors];
+    transaction(ReadDriverStatus, nullptr, rx, sizeof(rx));
 
     // each halfword is structured as follows:
     // GVDD_OV | FAULT | GVDD_UV | PVDD_UV | OTSD | OTW | FETHA_OC | FETLA_OC |
     // FETHB_OC | FETLB_OC | FETHC_OC | FETLC_OC
-    for (size_t i = 0; i < 10; i++) {
-        uint16_t tmp = _spi->write(0x00);
-        tmp |= (_spi->write(0x00) << 8);
-        v.push_back(tmp);
+    for (size_t i = 0; i < FpgaProtocol::NumMotors; i++) {
+        v.push_back(rx[2 * i] | (rx[2 * i + 1] << 8));
     }
-
-    chipDeselect();
 }
 
 uint8_t FPGA::motors_en(bool state) {
-    uint8_t status;
-
-    chipSelect();
-    status = _spi->write(CMD_EN_DIS_MTRS | (state << 7));
-    chipDeselect();
-
-    return status;
+    return transaction(EnableMotors | (state << 7), nullptr, nullptr, 0);
 }
 
 uint8_t FPGA::watchdog_reset() {
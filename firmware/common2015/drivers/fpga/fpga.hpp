@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "SharedSPI.hpp"
+#include "fpga-protocol.hpp"
 
 class FPGA : public SharedSPIDevice<> {
 public:
@@ -23,6 +24,11 @@ public:
     bool configure(const std::string& filepath);
 
     bool isReady();
+
+    /// Writes the duty cycles and reads the encoders, halls and gate drivers
+    /// in one batch (see FpgaProtocol::Exchange).  Returns the status byte.
+    uint8_t exchange(FpgaProtocol::Exchange& exchange);
+
     uint8_t set_duty_get_enc(uint16_t* duty_cycles, size_t size_dut,
                              uint16_t* enc_deltas, size_t size_enc);
     uint8_t set_duty_cycles(uint16_t* duty_cycles, size_t size);
@@ -36,6 +42,15 @@ public:
     bool send_config(const std::string& filepath);
 
 private:
+    /// Largest transaction the FPGA answers, including the command
+    static const size_t MaxFrameSize = 12;
+
+    /// Runs one command, writing <size> bytes from <tx> after it (zeros if
+    /// <tx> is null) and reading the replies into <rx>.  Returns the status
+    /// byte.
+    uint8_t transaction(uint8_t command, const uint8_t* tx, uint8_t* rx,
+                        size_t size);
+
     bool _isInit = false;
 
     DigitalIn _initB;
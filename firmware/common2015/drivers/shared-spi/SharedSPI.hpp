@@ -16,6 +16,40 @@
 class SharedSPI : public mbed::SPI, public Mutex {
 public:
     SharedSPI(PinName mosi, PinName miso, PinName sck) : SPI(mosi, miso, sck) {}
+
+    /**
+     * Writes <size> bytes from <tx> while reading the same number into <rx>.
+     * The caller must hold the lock.
+     */
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t size) {
+#if defined(TARGET_LPC176X)
+        // Keep the SSP's FIFO fed so there are no gaps between bytes.  mbed's
+        // write() waits for each byte to come back before sending the next.
+        LPC_SSP_TypeDef* ssp = _spi.spi;
+        size_t sent = 0;
+        size_t received = 0;
+        while (received < size) {
+            if (sent < size && sent - received < SspFifoDepth &&
+                (ssp->SR & SspTxNotFull)) {
+                ssp->DR = tx[sent++];
+            }
+            if (ssp->SR & SspRxNotEmpty) {
+                rx[received++] = ssp->DR;
+            }
+        }
+#else
+        for (size_t i = 0; i < size; ++i) {
+            rx[i] = write(tx[i]);
+        }
+#endif
+    }
+
+private:
+#if defined(TARGET_LPC176X)
+    static const size_t SspFifoDepth = 8;
+    static const uint32_t SspTxNotFull = 1 << 1;
+    static const uint32_t SspRxNotEmpty = 1 << 2;
+#endif
 };
 
 /**
@@ -49,6 +83,31 @@ public:
         _spi->unlock();
     }
 
+    /**
+     * Runs <count> transactions back to back while holding the bus.  Their
+     * bytes are stored one after another in <tx> and <rx>, and <sizes> has the
+     * length of each.  Chip select is released between them.
+     */
+    void transferFrames(const uint8_t* tx, uint8_t* rx, const size_t* sizes,
+                        size_t count) {
+        _spi->lock();
+        _spi->frequency(_frequency);
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                // Give the device time to see chip select go high
+                wait_us(1);
+            }
+
+            _cs = _csAssertValue;
+            _spi->transfer(tx, rx, sizes[i]);
+            _cs = !_csAssertValue;
+
+            tx += sizes[i];
+            rx += sizes[i];
+        }
+        _spi->unlock();
+    }
+
     /// Set the SPI frequency for this device
     void setSPIFrequency(int hz) { _frequency = hz; }
 
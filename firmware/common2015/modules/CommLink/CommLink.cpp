@@ -33,7 +33,6 @@ void CommLink::rxThread() {
     // Set the function to call on an interrupt trigger
     _int_in.rise(this, &CommLink::ISR);
 
-    rtp::packet p;
     std::vector<uint8_t> buf;
     buf.reserve(rtp::MAX_DATA_SZ);
 
@@ -49,9 +48,17 @@ void CommLink::rxThread() {
         int32_t response = getData(&buf);
 
         if (response == COMM_SUCCESS) {
-            // Write the data to the CommModule object's rxQueue
-            p.recv(buf);
-            CommModule::Instance->receive(p);
+            // Unpack the data straight into a packet from the CommModule's
+            // pool and hand it over
+            rtp::packet* p = CommModule::Instance->allocPacket();
+            if (!p) {
+                LOG(WARN, "Dropped a packet: No free packets");
+            } else if (p->recv(buf)) {
+                CommModule::Instance->receive(p);
+            } else {
+                LOG(WARN, "Dropped a bad packet of %u bytes", buf.size());
+                CommModule::Instance->releasePacket(p);
+            }
         }
     }
 }
@@ -60,9 +67,11 @@ void CommLink::rxThread() {
 void CommLink::ready() { _rxThread.signal_set(COMM_LINK_SIGNAL_START_THREAD); }
 
 void CommLink::sendPacket(rtp::packet* p) {
-    std::vector<uint8_t> buffer;
-    p->pack(&buffer);
-    sendData(buffer.data(), buffer.size());
+    uint8_t buffer[rtp::MAX_DATA_SZ];
+    size_t size = p->pack(buffer, sizeof(buffer));
+    if (size) {
+        sendData(buffer, size);
+    }
 }
 
 void CommLink::ISR() { _rxThread.signal_set(COMM_LINK_SIGNAL_RX_TRIGGER); }
@@ -24,11 +24,7 @@ CommModule::CommModule(std::shared_ptr<FlashingTimeoutLED> rxTimeoutLED,
       _txThread(&CommModule::txThreadHelper, this, osPriorityHigh,
                 DEFAULT_STACK_SIZE / 2),
       _rxTimeoutLED(rxTimeoutLED),
-      _txTimeoutLED(txTimeoutLED) {
-    // Create the data queues.
-    _txQueue = osMailCreate(_txQueueHelper.def(), nullptr);
-    _rxQueue = osMailCreate(_rxQueueHelper.def(), nullptr);
-}
+      _txTimeoutLED(txTimeoutLED) {}
 
 void CommModule::rxThreadHelper(void const* moduleInst) {
     CommModule* module = (CommModule*)moduleInst;
@@ -44,49 +40,25 @@ void CommModule::txThread() {
     // initialized
     Thread::signal_wait(COMM_MODULE_SIGNAL_START_THREAD);
 
-    // Store our priority so we know what to reset it to if ever needed
-    const osPriority threadPriority = _txThread.get_priority();
-
     LOG(INIT,
         "TX communication module ready!\r\n    Thread ID: %u, Priority: %d",
-        ((P_TCB)_txThread.gettid())->task_id, threadPriority);
+        ((P_TCB)_txThread.gettid())->task_id, _txThread.get_priority());
 
     // Signal to the RX thread that it can begin
     _rxThread.signal_set(COMM_MODULE_SIGNAL_START_THREAD);
 
     while (true) {
-        // When a new rtp::packet is put in the TX queue, begin operations (does
-        // nothing if no new data in queue)
-        osEvent evt = osMailGet(_txQueue, osWaitForever);
-
-        if (evt.status == osEventMail) {
-            // Get a pointer to the packet's memory location
-            rtp::packet* p = (rtp::packet*)evt.value.p;
-
-            // Bump up the thread's priority
-            osStatus tState = _txThread.set_priority(osPriorityRealtime);
-            ASSERT(tState == osOK);
-
-            // Call the user callback function
-            if (_ports.find(p->port()) != _ports.end() &&
-                _ports[p->port()].txCallback() != nullptr) {
-                _ports[p->port()].txCallback()(p);
-                _ports[p->port()].txCount++;
-
-                LOG(INF2, "Transmission:\r\n    Port:\t%u\r\n", p->port());
-            }
+        // When a new rtp::packet is put in the TX queue, pass it to its
+        // port's callback and return it to the pool
+        int address;
+        if (_router.dispatchTx(osWaitForever, &address)) {
+            LOG(INF2, "Transmission:\r\n    Address:\t%u\r\n", address);
 
             // this renews a countdown for turning off the
             // strobing thread once it expires
-            if (p->address() != 127) {
+            if (address != LOOPBACK_ADDR) {
                 _txTimeoutLED->renew();
             }
-
-            // Release the allocated memory once data is sent
-            osMailFree(_txQueue, p);
-
-            tState = _txThread.set_priority(threadPriority);
-            ASSERT(tState == osOK);
         }
     }
 }
@@ -99,60 +71,37 @@ void CommModule::rxThread() {
     // set this true immediately after we are released execution
     _isReady = true;
 
-    // Store our priority so we know what to reset it to if ever needed
-    const osPriority threadPriority = _rxThread.get_priority();
-
     LOG(INIT,
         "RX communication module ready!\r\n    Thread ID: %u, Priority: %d",
-        ((P_TCB)_rxThread.gettid())->task_id, threadPriority);
+        ((P_TCB)_rxThread.gettid())->task_id, _rxThread.get_priority());
 
     while (true) {
-        // Wait until new data is placed in the class's RX queue from a CommLink
-        // class
-        osEvent evt = osMailGet(_rxQueue, osWaitForever);
-
-        if (evt.status == osEventMail) {
-            // get a pointer to where the data is stored
-            rtp::packet* p = (rtp::packet*)evt.value.p;
-
-            // Bump up the thread's priority
-            osStatus tState = _rxThread.set_priority(osPriorityRealtime);
-            ASSERT(tState == osOK);
-
-            // Call the user callback function (if set)
-            if (_ports.find(p->port()) != _ports.end() &&
-                _ports[p->port()].rxCallback() != nullptr) {
-                _ports[p->port()].rxCallback()(p);
-                _ports[p->port()].rxCount++;
-
-                LOG(INF2, "Reception:\r\n    Port:\t%u\r\n", p->port());
-            }
+        // Wait until a CommLink places a new packet in the RX queue
+        int address;
+        if (_router.dispatchRx(osWaitForever, &address)) {
+            LOG(INF2, "Reception:\r\n    Address:\t%u\r\n", address);
 
             // this renews a countdown for turning off the strobing thread once
             // it expires
-            if (p->address() != 127) {
+            if (address != LOOPBACK_ADDR) {
                 _rxTimeoutLED->renew();
             }
-
-            // free memory allocated for mail
-            osMailFree(_rxQueue, p);
-
-            tState = _rxThread.set_priority(threadPriority);
-            ASSERT(tState == osOK);
         }
     }
 }
 
 void CommModule::setRxHandler(std::function<CommCallback> callback,
                               uint8_t portNbr) {
-    _ports[portNbr].rxCallback() = std::bind(callback, std::placeholders::_1);
+    ASSERT(portNbr < PacketRouter<MbedRtos>::NUM_PORTS);
+    _router.port(portNbr).rxCallback() = callback;
 
     ready();
 }
 
 void CommModule::setTxHandler(std::function<CommCallback> callback,
                               uint8_t portNbr) {
-    _ports[portNbr].txCallback() = std::bind(callback, std::placeholders::_1);
+    ASSERT(portNbr < PacketRouter<MbedRtos>::NUM_PORTS);
+    _router.port(portNbr).txCallback() = callback;
 
     ready();
 }
@@ -165,96 +114,98 @@ void CommModule::ready() {
     _txThread.signal_set(COMM_MODULE_SIGNAL_START_THREAD);
 }
 
-void CommModule::send(const rtp::packet& packet) {
-    // Check to make sure a socket for the port exists
-    if (_ports.find(packet.port()) != _ports.end() &&
-        _ports[packet.port()].txCallback() != nullptr) {
-        // Allocate a block of memory for the data.
-        rtp::packet* p = (rtp::packet*)osMailAlloc(_txQueue, osWaitForever);
-
-        // Copy the contents into the allocated memory block
-        // TODO: use move semantics
-        *p = packet;
-
-        // Place the passed packet into the txQueue.
-        osMailPut(_txQueue, p);
-
-    } else {
+void CommModule::logFailure(PacketRouter<MbedRtos>::Result result,
+                            const char* action, int size, int port) {
+    if (result == PacketRouter<MbedRtos>::PortClosed) {
         LOG(WARN,
-            "Failed to send %u byte packet: There is no open transmitting "
-            "socket for port %u",
-            packet.payload.size(), packet.port());
+            "Failed to %s %u byte packet: There is no open socket for port %u",
+            action, size, port);
+    } else if (result == PacketRouter<MbedRtos>::QueueFull) {
+        LOG(WARN, "Failed to %s %u byte packet on port %u: Queue is full",
+            action, size, port);
     }
 }
 
+void CommModule::send(const rtp::packet& packet) {
+    logFailure(_router.send(packet), "send", packet.payload.size(),
+               packet.port());
+}
+
+void CommModule::send(rtp::packet* packet) {
+    // The router may release the packet, so get these first
+    int size = packet->payload.size();
+    int port = packet->port();
+    logFailure(_router.send(packet), "send", size, port);
+}
+
 void CommModule::receive(const rtp::packet& packet) {
-    // Check to make sure a socket for the port exists
-    if (_ports.find(packet.port()) != _ports.end() &&
-        _ports[packet.port()].rxCallback() != nullptr) {
-        // Allocate a block of memory for the data.
-        rtp::packet* p = (rtp::packet*)osMailAlloc(_rxQueue, osWaitForever);
-
-        // Copy the contents into the allocated memory block
-        // TODO: move semantics
-        *p = packet;
-
-        // Place the passed packet into the rxQueue.
-        osMailPut(_rxQueue, p);
-    } else {
-        LOG(WARN,
-            "Failed to receive %u byte packet: There is no open receiving "
-            "socket for port %u",
-            packet.payload.size(), packet.port());
-    }
+    logFailure(_router.receive(packet), "receive", packet.payload.size(),
+               packet.port());
+}
+
+void CommModule::receive(rtp::packet* packet) {
+    int size = packet->payload.size();
+    int port = packet->port();
+    logFailure(_router.receive(packet), "receive", size, port);
 }
 
 unsigned int CommModule::numRxPackets() const {
     unsigned int count = 0;
-    for (auto& kvpair : _ports) {
-        count += kvpair.second.rxCount;
+    for (size_t i = 0; i < PacketRouter<MbedRtos>::NUM_PORTS; ++i) {
+        count += _router.port(i).rx.count;
     }
     return count;
 }
 
 unsigned int CommModule::numTxPackets() const {
     unsigned int count = 0;
-    for (auto& kvpair : _ports) {
-        count += kvpair.second.txCount;
+    for (size_t i = 0; i < PacketRouter<MbedRtos>::NUM_PORTS; ++i) {
+        count += _router.port(i).tx.count;
     }
     return count;
 }
 
 void CommModule::printInfo() const {
-    printf("PORT\t\tIN\tOUT\tRX CBCK\t\tTX CBCK\r\n");
+    printf("PORT\tIN\tOUT\tIN DROP\tOUT DROP\tIN MAX us\tOUT MAX us\r\n");
 
-    for (const auto& kvpair : _ports) {
-        const CommPort_t& p = kvpair.second;
-        printf("%d\t\t%u\t%u\t%s\t\t%s\r\n", kvpair.first, p.rxCount, p.txCount,
-               p.rxCallback() ? "YES" : "NO", p.txCallback() ? "YES" : "NO");
+    for (size_t i = 0; i < PacketRouter<MbedRtos>::NUM_PORTS; ++i) {
+        const CommPort_t& p = _router.port(i);
+        if (!p.isOpen()) {
+            continue;
+        }
+        printf("%u%s%s\t%u\t%u\t%u\t%u\t\t%lu\t\t%lu\r\n", i,
+               p.rxCallback() ? " RX" : "", p.txCallback() ? " TX" : "",
+               p.rx.count, p.tx.count, p.rx.dropped, p.tx.dropped,
+               p.rx.maxLatency, p.tx.maxLatency);
     }
 
     printf(
         "==========================\r\n"
-        "Total:\t\t%u\t%u\r\n",
-        numRxPackets(), numTxPackets());
+        "Total:\t%u\t%u\r\n"
+        "Pool empty: %u\r\n",
+        numRxPackets(), numTxPackets(), _router.poolEmpty());
 
     Console::Instance()->Flush();
 }
 
 void CommModule::resetCount(unsigned int portNbr) {
-    _ports[portNbr].resetPacketCount();
+    if (portNbr < PacketRouter<MbedRtos>::NUM_PORTS) {
+        _router.port(portNbr).resetPacketCount();
+    }
 }
 
-void CommModule::close(unsigned int portNbr) { _ports.erase(portNbr); }
+void CommModule::close(unsigned int portNbr) {
+    if (portNbr < PacketRouter<MbedRtos>::NUM_PORTS) {
+        _router.port(portNbr) = CommPort_t();
+    }
+}
 
 bool CommModule::isReady() const { return _isReady; }
 
 int CommModule::numOpenSockets() const {
     size_t count = 0;
-    for (const auto& kvpair : _ports) {
-        if (kvpair.second.rxCallback() != nullptr ||
-            kvpair.second.txCallback() != nullptr)
-            count++;
+    for (size_t i = 0; i < PacketRouter<MbedRtos>::NUM_PORTS; ++i) {
+        if (_router.port(i).isOpen()) count++;
     }
 
     return count;
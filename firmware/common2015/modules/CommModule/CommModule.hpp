@@ -5,9 +5,8 @@
 
 #include "rtp.hpp"
 #include "helper-funcs.hpp"
-#include "rtos-mgmt/mail-helper.hpp"
 #include "Console.hpp"
-#include "CommPort.hpp"
+#include "PacketRouter.hpp"
 #include "TimeoutLED.hpp"
 
 #include <algorithm>
@@ -15,11 +14,24 @@
 #include <functional>
 #include <memory>
 
-/* These define the function pointer type that's used for every callback
- * function type set through the CommModule class.
- */
-typedef void(CommCallback)(rtp::packet*);
-typedef CommPort<CommCallback> CommPort_t;
+/// Gives PacketRouter the RTOS's queues and clock
+struct MbedRtos {
+    template <class T, uint32_t N>
+    class Queue {
+    public:
+        bool put(T* item) { return _queue.put(item, 0) == osOK; }
+
+        T* get(uint32_t timeout) {
+            osEvent evt = _queue.get(timeout);
+            return evt.status == osEventMessage ? (T*)evt.value.p : nullptr;
+        }
+
+    private:
+        rtos::Queue<T, N> _queue;
+    };
+
+    static uint32_t micros() { return us_ticker_read(); }
+};
 
 /**
  * @brief A high-level firmware class for packet handling & routing
@@ -30,9 +42,6 @@ typedef CommPort<CommCallback> CommPort_t;
  * hardware interface.
  */
 class CommModule {
-private:
-    std::map<uint8_t, CommPort_t> _ports;
-
 public:
     /// The constructor initializes and starts threads and mail queues
     CommModule(std::shared_ptr<FlashingTimeoutLED> rxTimeoutLED,
@@ -47,12 +56,6 @@ public:
     /// initializes and starts rx/tx threads and mail queues
     void init();
 
-    // Class constants
-    // Be careful of the queue sizes. The errors that result from
-    // over allocation are very tricky to catch.
-    static const size_t TX_QUEUE_SIZE = 3;
-    static const size_t RX_QUEUE_SIZE = 3;
-
     // Set a TX callback function on an object
     template <typename B>
     void setTxHandler(B* obj, void (B::*mptr)(rtp::packet*), uint8_t portNbr) {
@@ -69,12 +72,24 @@ public:
     void setRxHandler(std::function<CommCallback> callback, uint8_t portNbr);
     void setTxHandler(std::function<CommCallback> callback, uint8_t portNbr);
 
+    /// Gets an unused packet from the pool to fill and pass to send() or
+    /// receive() without copying it.  Returns nullptr if none are free.
+    rtp::packet* allocPacket() { return _router.alloc(); }
+
+    /// Returns a packet from allocPacket() that won't be sent or received
+    void releasePacket(rtp::packet* pkt) { _router.release(pkt); }
+
     // Send a rtp::packet. The details of exactly how the packet will be sent
     // are determined from the rtp::packet's port and subclass values
     void send(const rtp::packet& pkt);
 
+    /// Sends a packet from allocPacket().  The packet is returned to the pool
+    /// after it is sent or dropped.
+    void send(rtp::packet* pkt);
+
     /// Called by CommLink instances whenever a packet is received via radio
     void receive(const rtp::packet& pkt);
+    void receive(rtp::packet* pkt);
 
     unsigned int numRxPackets() const;
     unsigned int numTxPackets() const;
@@ -86,11 +101,6 @@ public:
     bool isReady() const;
     int numOpenSockets() const;
 
-protected:
-    // Memory Queue IDs
-    osMailQId _txQueue;
-    osMailQId _rxQueue;
-
 private:
     // The working threads for handling rx and tx data queues
     void txThread();
@@ -103,13 +113,17 @@ private:
 
     void ready();
 
+    // Logs a packet that couldn't be queued
+    void logFailure(PacketRouter<MbedRtos>::Result result, const char* action,
+                    int size, int port);
+
     bool _isReady = false;
 
-    Thread _rxThread, _txThread;
+    // Owns the packets and the port table.  This is constructed before the
+    // threads that use it.
+    PacketRouter<MbedRtos> _router;
 
-    // Mail helper objects
-    MailHelper<rtp::packet, TX_QUEUE_SIZE> _txQueueHelper;
-    MailHelper<rtp::packet, RX_QUEUE_SIZE> _rxQueueHelper;
+    Thread _rxThread, _txThread;
 
     std::shared_ptr<FlashingTimeoutLED> _rxTimeoutLED, _txTimeoutLED;
 };
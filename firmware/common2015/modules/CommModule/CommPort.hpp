@@ -1,22 +1,40 @@
 #pragma once
 
-#include <mbed.h>
-#include <rtos.h>
-#include "logger.hpp"
-
-#include <algorithm>
-#include <map>
-#include <stdexcept>
+#include <cstdint>
 #include <functional>
 
+/// Packet counters for one direction of a port
+struct CommPortStats {
+    /// Packets passed to the callback
+    unsigned int count = 0;
+
+    /// Packets dropped because the queue was full or no packets were free
+    unsigned int dropped = 0;
+
+    /// Time from queueing a packet until its callback returned, in
+    /// microseconds
+    uint32_t maxLatency = 0;
+    uint64_t totalLatency = 0;
+
+    void record(uint32_t latency) {
+        ++count;
+        totalLatency += latency;
+        if (latency > maxLatency) {
+            maxLatency = latency;
+        }
+    }
+
+    void reset() { *this = CommPortStats(); }
+};
+
 template <class T>
 class CommPort {
 public:
     CommPort(std::function<T> rxC = nullptr, std::function<T> txC = nullptr)
         : _rxCallback(rxC), _txCallback(txC){};
 
-    /// Counters for the number of packets sent/received via this port
-    unsigned int rxCount = 0, txCount = 0;
+    /// Counters for the packets sent/received via this port
+    CommPortStats rx, tx;
 
     // Set functions for each RX/TX callback.
     void setRxCallback(const std::function<T>& func) { _rxCallback = func; }
@@ -28,10 +46,13 @@ public:
     std::function<T>& txCallback() { return _txCallback; }
     const std::function<T>& txCallback() const { return _txCallback; }
 
+    /// True if either callback is set
+    bool isOpen() const { return _rxCallback || _txCallback; }
+
     // Returns the current packet counts to zero
     void resetPacketCount() {
-        rxCount = 0;
-        txCount = 0;
+        rx.reset();
+        tx.reset();
     }
 
 private:
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "CommPort.hpp"
+#include "rtp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/* These define the function pointer type that's used for every callback
+ * function type set through the CommModule class.
+ */
+typedef void(CommCallback)(rtp::packet*);
+typedef CommPort<CommCallback> CommPort_t;
+
+/**
+ * @brief Passes packets between CommLinks, the CommModule threads, and port
+ * callbacks
+ *
+ * @details Packets come from a fixed pool and are passed around by pointer,
+ * so a packet received by a CommLink reaches its callback without being
+ * copied.  Nothing here waits for a free packet or for room in a queue:
+ * packets that can't be queued are dropped and counted on their port.
+ *
+ * The RTOS parameter provides the queues and clock, so this can be tested on
+ * a computer with a fake RTOS.  It must have:
+ *   template <class T, uint32_t N> class Queue {
+ *       bool put(T* item);            // false if full, never waits
+ *       T* get(uint32_t timeout_ms);  // nullptr if nothing arrived
+ *   };
+ *   static uint32_t micros();
+ */
+template <class RTOS>
+class PacketRouter {
+public:
+    /// Ports are four bits in the packet header
+    static const size_t NUM_PORTS = 16;
+
+    static const size_t QUEUE_SIZE = 3;
+
+    /// Enough for both queues to be full while each thread handles a packet
+    static const size_t POOL_SIZE = 2 * QUEUE_SIZE + 2;
+
+    enum Result { Queued, PortClosed, QueueFull };
+
+    PacketRouter() {
+        for (Slot& s : _slots) {
+            _free.put(&s);
+        }
+    }
+
+    /// Gets an unused packet, or nullptr if they are all in use
+    rtp::packet* alloc() {
+        Slot* s = _free.get(0);
+        if (!s) {
+            ++_poolEmpty;
+            return nullptr;
+        }
+        return &s->packet;
+    }
+
+    /// Returns a packet from alloc() to the pool
+    void release(rtp::packet* p) { _free.put(slot(p)); }
+
+    /// Queues a packet from alloc() for its port's TX or RX callback.  The
+    /// router owns the packet afterwards, even if it couldn't be queued.
+    Result send(rtp::packet* p) { return enqueue(p, _txQueue, true); }
+    Result receive(rtp::packet* p) { return enqueue(p, _rxQueue, false); }
+
+    /// Copies a packet into the pool and queues it
+    Result send(const rtp::packet& p) { return copy(p, true); }
+    Result receive(const rtp::packet& p) { return copy(p, false); }
+
+    /// Waits up to <timeout> milliseconds for a queued packet and passes it to
+    /// its callback.  Returns false if no packet arrived.  If <address> isn't
+    /// null, it is set to the packet's address.
+    bool dispatchTx(uint32_t timeout, int* address = nullptr) {
+        return dispatch(_txQueue, true, timeout, address);
+    }
+    bool dispatchRx(uint32_t timeout, int* address = nullptr) {
+        return dispatch(_rxQueue, false, timeout, address);
+    }
+
+    /// <n> must be less than NUM_PORTS
+    CommPort_t& port(unsigned int n) { return _ports[n]; }
+    const CommPort_t& port(unsigned int n) const { return _ports[n]; }
+
+    /// Number of times alloc() found no free packets
+    unsigned int poolEmpty() const { return _poolEmpty; }
+
+private:
+    struct Slot {
+        // Must be first so a packet's address is its slot's
+        rtp::packet packet;
+
+        // When the packet was queued
+        uint32_t queuedAt;
+    };
+
+    typedef typename RTOS::template Queue<Slot, QUEUE_SIZE> Queue;
+
+    static Slot* slot(rtp::packet* p) { return reinterpret_cast<Slot*>(p); }
+
+    Result copy(const rtp::packet& p, bool tx) {
+        rtp::packet* copy = alloc();
+        if (!copy) {
+            CommPort_t& port = _ports[p.port()];
+            ++(tx ? port.tx : port.rx).dropped;
+            return QueueFull;
+        }
+        *copy = p;
+        return tx ? send(copy) : receive(copy);
+    }
+
+    Result enqueue(rtp::packet* p, Queue& queue, bool tx) {
+        CommPort_t& port = _ports[p->port()];
+        if (!(tx ? port.txCallback() : port.rxCallback())) {
+            release(p);
+            return PortClosed;
+        }
+
+        slot(p)->queuedAt = RTOS::micros();
+        if (!queue.put(slot(p))) {
+            ++(tx ? port.tx : port.rx).dropped;
+            release(p);
+            return QueueFull;
+        }
+        return Queued;
+    }
+
+    bool dispatch(Queue& queue, bool tx, uint32_t timeout, int* address) {
+        Slot* s = queue.get(timeout);
+        if (!s) {
+            return false;
+        }
+
+        rtp::packet* p = &s->packet;
+        CommPort_t& port = _ports[p->port()];
+
+        // The port may have been closed since the packet was queued
+        const std::function<CommCallback>& callback =
+            tx ? port.txCallback() : port.rxCallback();
+        if (callback) {
+            callback(p);
+            (tx ? port.tx : port.rx).record(RTOS::micros() - s->queuedAt);
+        }
+
+        if (address) {
+            *address = p->address();
+        }
+        release(p);
+        return true;
+    }
+
+    Slot _slots[POOL_SIZE];
+    typename RTOS::template Queue<Slot, POOL_SIZE> _free;
+    Queue _txQueue, _rxQueue;
+
+    CommPort_t _ports[NUM_PORTS];
+
+    unsigned int _poolEmpty = 0;
+};
+
+template <class RTOS>
+const size_t PacketRouter<RTOS>::NUM_PORTS;
+template <class RTOS>
+const size_t PacketRouter<RTOS>::QUEUE_SIZE;
+template <class RTOS>
+const size_t PacketRouter<RTOS>::POOL_SIZE;
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "../drivers/cc1201/CC1201Config.hpp"
+#include "../drivers/cc1201/cfg/default/registers.h"
+
+using namespace CC1201Config;
+
+namespace {
+// Made at compile time, as the firmware does
+constexpr auto plan =
+    makePlan<countBursts(preferredSettings)>(preferredSettings);
+
+static_assert(valid(preferredSettings), "The default settings are invalid");
+
+const size_t NumSettings =
+    sizeof(preferredSettings) / sizeof(preferredSettings[0]);
+
+// Bytes on the SPI bus to write a register, or a burst of <size> registers,
+// at <addr>
+size_t busBytes(uint16_t addr, size_t size) {
+    return (addr >= 0x2F00 ? 2 : 1) + size;
+}
+}
+
+TEST(CC1201Config, defaultPlan) {
+    const size_t numRegisters = plan.NumRegisters;
+    const size_t numBursts = plan.NumBursts;
+    ASSERT_EQ(NumSettings, numRegisters);
+
+    // The registers, the extended configuration registers, the extended
+    // status registers, and the FIFO pointers
+    ASSERT_EQ(4u, numBursts);
+    EXPECT_EQ(CC1201_IOCFG3, plan.bursts[0].addr);
+    EXPECT_EQ(CC1201_PKT_LEN - CC1201_IOCFG3 + 1, plan.bursts[0].size);
+    EXPECT_EQ(CC1201_IF_MIX_CFG, plan.bursts[1].addr);
+    EXPECT_EQ(CC1201_PA_CFG3 - CC1201_IF_MIX_CFG + 1, plan.bursts[1].size);
+    EXPECT_EQ(CC1201_WOR_TIME1, plan.bursts[2].addr);
+    EXPECT_EQ(CC1201_RXFIRST, plan.bursts[3].addr);
+}
+
+TEST(CC1201Config, planWritesEverySetting) {
+    // Replay the bursts into a register map
+    std::map<uint16_t, uint8_t> written;
+    size_t next = 0;
+    for (const Burst& burst : plan.bursts) {
+        EXPECT_EQ(next, burst.first);
+        for (size_t i = 0; i < burst.size; ++i) {
+            uint16_t addr = burst.addr + i;
+            EXPECT_TRUE(isRegister(addr));
+            EXPECT_EQ(0u, written.count(addr)) << std::hex << addr;
+            written[addr] = plan.values[burst.first + i];
+        }
+
+        // Bursts don't cross from one address space into the other
+        EXPECT_EQ(burst.addr >> 8, (burst.addr + burst.size - 1) >> 8);
+        next += burst.size;
+    }
+    EXPECT_EQ(NumSettings, next);
+
+    for (const registerSetting_t& setting : preferredSettings) {
+        ASSERT_EQ(1u, written.count(setting.addr)) << std::hex << setting.addr;
+        EXPECT_EQ(setting.value, written[setting.addr]) << std::hex
+                                                        << setting.addr;
+    }
+}
+
+TEST(CC1201Config, fewerBusBytes) {
+    size_t single = 0;
+    for (const registerSetting_t& setting : preferredSettings) {
+        single += busBytes(setting.addr, 1);
+    }
+
+    size_t burst = 0;
+    for (const Burst& b : plan.bursts) {
+        burst += busBytes(b.addr, b.size);
+    }
+
+    // Half the bytes, besides one transaction per burst instead of one per
+    // register
+    EXPECT_LT(burst * 2, single);
+}
+
+TEST(CC1201Config, sortsAndSplits) {
+    // Out of order, with a gap and a change of address space
+    static constexpr registerSetting_t settings[] = {
+        {CC1201_SYNC1, 3},    {0x2F01, 6},       {CC1201_IOCFG3, 1},
+        {CC1201_PKT_LEN, 4},  {CC1201_IOCFG2, 2}, {0x2F00, 5},
+    };
+    static_assert(valid(settings), "");
+    static_assert(countBursts(settings) == 4, "");
+
+    constexpr auto split = makePlan<countBursts(settings)>(settings);
+    uint8_t values[] = {1, 2, 3, 4, 5, 6};
+    for (size_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(values[i], split.values[i]);
+    }
+    EXPECT_EQ(CC1201_IOCFG3, split.bursts[0].addr);
+    EXPECT_EQ(2, split.bursts[0].size);
+    EXPECT_EQ(CC1201_SYNC1, split.bursts[1].addr);
+    EXPECT_EQ(CC1201_PKT_LEN, split.bursts[2].addr);
+    EXPECT_EQ(0x2F00, split.bursts[3].addr);
+    EXPECT_EQ(2, split.bursts[3].size);
+    EXPECT_EQ(4, split.bursts[3].first);
+}
+
+TEST(CC1201Config, invalid) {
+    // The FIFOs and strobes aren't configuration registers
+    static constexpr registerSetting_t fifo[] = {{CC1201_TXFIFO, 0}};
+    static_assert(!valid(fifo), "");
+    static constexpr registerSetting_t strobe[] = {{CC1201_STROBE_SRX, 0}};
+    static_assert(!valid(strobe), "");
+
+    static constexpr registerSetting_t twice[] = {
+        {CC1201_IOCFG3, 0}, {CC1201_IOCFG2, 0}, {CC1201_IOCFG3, 1}};
+    static_assert(!valid(twice), "");
+
+    EXPECT_TRUE(isAddress(CC1201_TXFIFO));
+    EXPECT_TRUE(isAddress(CC1201_RXFIFO));
+    EXPECT_TRUE(isAddress(0x3E10));
+    EXPECT_FALSE(isAddress(0x0030));
+    EXPECT_FALSE(isAddress(0x3000));
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../utils/logger/deferred-log.hpp"
+
+using namespace DeferredLog;
+
+namespace {
+enum Color { Red, Green };
+
+template <class... Args>
+std::string formatArgs(const char* format, Args... args) {
+    Record record;
+    record.format = format;
+    storeArgs(record, 0, args...);
+
+    char buf[128];
+    size_t len = DeferredLog::format(record, buf, sizeof(buf));
+    EXPECT_EQ(strlen(buf), len);
+    return buf;
+}
+}
+
+TEST(DeferredLog, deferrable) {
+    EXPECT_TRUE((Deferrable<>::value));
+    EXPECT_TRUE((Deferrable<int, unsigned, float, double, bool>::value));
+    EXPECT_TRUE((Deferrable<Color, int*, const void*, nullptr_t>::value));
+    EXPECT_TRUE((Deferrable<int, int, int, int, int, int>::value));
+
+    // Strings might change before they're printed
+    EXPECT_FALSE((Deferrable<const char*>::value));
+    EXPECT_FALSE((Deferrable<int, char*>::value));
+    EXPECT_FALSE((Deferrable<const uint8_t*>::value));
+    EXPECT_FALSE((Deferrable<char[4]>::value));
+
+    // Too big or too many
+    EXPECT_FALSE((Deferrable<int64_t>::value));
+    EXPECT_FALSE((Deferrable<int, int, int, int, int, int, int>::value));
+}
+
+TEST(DeferredLog, format) {
+    EXPECT_EQ("no args", formatArgs("no args"));
+    EXPECT_EQ("-5 7 100%", formatArgs("%d %u 100%%", -5, 7u));
+    EXPECT_EQ("ff 0x00ff FFFFFFFF", formatArgs("%x %#06x %X", 255, 255, -1));
+    EXPECT_EQ("  42|42  |042", formatArgs("%4ld|%-4hu|%03i", 42L, 42, 42));
+    EXPECT_EQ("1.50 2.5e+00", formatArgs("%.2f %.1e", 1.5f, 2.5));
+    EXPECT_EQ("A 1 0", formatArgs("%c %d %u", 'A', true, Red));
+
+    int x;
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%p", static_cast<void*>(&x));
+    EXPECT_EQ(expected, formatArgs("%p", &x));
+}
+
+TEST(DeferredLog, formatMismatch) {
+    EXPECT_EQ("1 (?)", formatArgs("%d %d", 1));
+    EXPECT_EQ("(?) (?)", formatArgs("%f %s", 1, 2.0));
+    EXPECT_EQ("trailing ", formatArgs("trailing %", 1));
+}
+
+TEST(DeferredLog, formatTruncates) {
+    Record record;
+    record.format = "%d and more";
+    storeArgs(record, 0, 123456);
+
+    char buf[5];
+    EXPECT_EQ(4u, DeferredLog::format(record, buf, sizeof(buf)));
+    EXPECT_STREQ("1234", buf);
+}
+
+TEST(DeferredLog, ring) {
+    Ring<4> ring;
+    Record record;
+    EXPECT_FALSE(ring.pop(record));
+
+    for (int i = 0; i < 6; ++i) {
+        bool pushed = ring.push([&](Record& r) {
+            r.line = i;
+            storeArgs(r, 0, i);
+        });
+        EXPECT_EQ(i < 4, pushed);
+    }
+    EXPECT_EQ(2u, ring.takeDropped());
+    EXPECT_EQ(0u, ring.takeDropped());
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.pop(record));
+        EXPECT_EQ(i, record.line);
+        EXPECT_EQ(i, record.args[0].i);
+    }
+    EXPECT_FALSE(ring.pop(record));
+
+    // Wraps around
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(ring.push([&](Record& r) { r.line = 100 + i; }));
+        ASSERT_TRUE(ring.pop(record));
+        EXPECT_EQ(100 + i, record.line);
+    }
+}
+
+TEST(DeferredLog, ringThreads) {
+    const int Threads = 4;
+    const int PerThread = 1000;
+    Ring<16> ring;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < Threads; ++t) {
+        producers.emplace_back([&ring, t]() {
+            for (int i = 0; i < PerThread; ++i) {
+                while (!ring.push([&](Record& r) {
+                    r.level = t;
+                    r.line = i;
+                })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Each thread's records come out in the order it pushed them
+    int next[Threads] = {};
+    int received = 0;
+    Record record;
+    while (received < Threads * PerThread) {
+        if (ring.pop(record)) {
+            ASSERT_LT(record.level, Threads);
+            EXPECT_EQ(next[record.level], record.line);
+            next[record.level] = record.line + 1;
+            ++received;
+        }
+    }
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    EXPECT_FALSE(ring.pop(record));
+}
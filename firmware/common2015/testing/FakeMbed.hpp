@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
 /**
  * This file provides some helper classes for emulating an mbed's hardware.  It
  * is useful for unit-testing code on a computer when an mbed is not available
@@ -17,4 +22,65 @@ public:
 private:
     int _value;
 };
+
+/// Stands in for the microsecond ticker and the FPGA's motor interface
+class Motors {
+public:
+    static const size_t NumMotors = 5;
+
+    uint32_t time = 0;
+
+    /// Duty cycles from the last exchange()
+    uint16_t duty[NumMotors] = {};
+
+    /// Encoder deltas that the next exchange() returns
+    int16_t deltas[NumMotors] = {};
+
+    uint32_t micros() { return time; }
+
+    void exchange(uint16_t* dutyCycles, uint16_t* encoderDeltas,
+                  size_t count) {
+        for (size_t i = 0; i < count && i < NumMotors; ++i) {
+            duty[i] = dutyCycles[i];
+            encoderDeltas[i] = deltas[i];
+        }
+    }
+};
+
+/**
+ * A device on the SPI bus that answers each transaction from a script and
+ * records what was written to it.  It has the same transferFrames() as
+ * SharedSPIDevice.
+ */
+class SPIDevice {
+public:
+    typedef std::vector<uint8_t> Frame;
+
+    /// Replies to the coming transactions, in order.  A transaction with no
+    /// reply left, or the part of one past its reply, reads 0xff as an idle
+    /// bus does.
+    std::deque<Frame> replies;
+
+    /// Bytes written in each transaction
+    std::vector<Frame> written;
+
+    void transferFrames(const uint8_t* tx, uint8_t* rx, const size_t* sizes,
+                        size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            Frame reply;
+            if (!replies.empty()) {
+                reply = replies.front();
+                replies.pop_front();
+            }
+
+            written.emplace_back(tx, tx + sizes[i]);
+            for (size_t j = 0; j < sizes[i]; ++j) {
+                rx[j] = j < reply.size() ? reply[j] : 0xff;
+            }
+
+            tx += sizes[i];
+            rx += sizes[i];
+        }
+    }
+};
 }
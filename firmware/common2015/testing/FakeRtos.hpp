@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+/**
+ * This file provides a single-threaded stand-in for the RTOS features used by
+ * PacketRouter, so packet routing can be tested on a computer.
+ */
+namespace fake_rtos {
+
+struct Rtos {
+    /// Bounded queue of pointers.  get() never waits.
+    template <class T, uint32_t N>
+    class Queue {
+    public:
+        bool put(T* item) {
+            if (_items.size() == N) {
+                return false;
+            }
+            _items.push_back(item);
+            return true;
+        }
+
+        // Tests run in one thread, so there is nothing to wait for
+        T* get(uint32_t /* timeout */) {
+            if (_items.empty()) {
+                return nullptr;
+            }
+            T* item = _items.front();
+            _items.pop_front();
+            return item;
+        }
+
+    private:
+        std::deque<T*> _items;
+    };
+
+    /// The fake clock, which tests set directly
+    static uint32_t& time() {
+        static uint32_t t = 0;
+        return t;
+    }
+
+    static uint32_t micros() { return time(); }
+};
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "../utils/fpga-protocol.hpp"
+#include "FakeMbed.hpp"
+
+using namespace FpgaProtocol;
+
+namespace {
+typedef fake_mbed::SPIDevice::Frame Frame;
+
+// What the FPGA answers for each transaction of an exchange
+void scriptReplies(fake_mbed::SPIDevice& fpga) {
+    // Encoder counts 0x0102, 0xfffe, 0, 0x7f00, then the watchdog timer
+    fpga.replies.push_back(
+        {0xa5, 0x01, 0x02, 0xff, 0xfe, 0x00, 0x00, 0x7f, 0x00, 0x12, 0x34});
+    fpga.replies.push_back({0xa5, 10, 20, 30, 40, 50});
+    fpga.replies.push_back(
+        {0xa5, 0x01, 0x00, 0x00, 0x08, 0xff, 0xff, 0x00, 0x00, 0x34, 0x02});
+}
+}
+
+TEST(FpgaProtocol, frames) {
+    Exchange exchange;
+    const size_t* sizes = Exchange::frameSizes();
+
+    size_t total = 0;
+    for (size_t i = 0; i < Exchange::NumFrames; ++i) {
+        total += sizes[i];
+    }
+    const size_t size = Exchange::Size;
+    EXPECT_EQ(size, total);
+
+    // The FPGA ignores duty cycles unless it gets all of them
+    EXPECT_EQ(1 + 2 * NumMotors, sizes[0]);
+
+    fake_mbed::SPIDevice fpga;
+    exchange.run(fpga);
+
+    ASSERT_EQ(3u, fpga.written.size());
+    EXPECT_EQ(UpdateMotors, fpga.written[0][0]);
+    EXPECT_EQ(ReadHalls, fpga.written[1][0]);
+    EXPECT_EQ(ReadDriverStatus, fpga.written[2][0]);
+
+    // Nothing is written after the commands until duty cycles are set
+    for (const Frame& frame : fpga.written) {
+        for (size_t i = 1; i < frame.size(); ++i) {
+            EXPECT_EQ(0, frame[i]);
+        }
+    }
+}
+
+TEST(FpgaProtocol, dutyCycles) {
+    Exchange exchange;
+    uint16_t duty[] = {0x3ff, 0x201, 0, 0x1ff};
+    ASSERT_TRUE(exchange.setDutyCycles(duty, 4));
+
+    fake_mbed::SPIDevice fpga;
+    exchange.run(fpga);
+
+    // Low byte first, and the dribbler is stopped
+    Frame expected = {UpdateMotors, 0xff, 0x03, 0x01, 0x02, 0x00,
+                      0x00,         0xff, 0x01, 0x00, 0x00};
+    EXPECT_EQ(expected, fpga.written[0]);
+
+    // An invalid duty cycle leaves the last ones
+    uint16_t invalid[] = {0, 0, 0x400, 0, 0};
+    EXPECT_FALSE(exchange.setDutyCycles(invalid, 5));
+    uint16_t tooMany[6] = {};
+    EXPECT_FALSE(exchange.setDutyCycles(tooMany, 6));
+
+    exchange.run(fpga);
+    EXPECT_EQ(expected, fpga.written[3]);
+}
+
+TEST(FpgaProtocol, replies) {
+    Exchange exchange;
+    fake_mbed::SPIDevice fpga;
+    scriptReplies(fpga);
+
+    EXPECT_EQ(0xa5, exchange.run(fpga));
+    EXPECT_TRUE(exchange.status() & StatusReady);
+    EXPECT_TRUE(exchange.status() & StatusMotorsEnabled);
+    EXPECT_FALSE(exchange.status() & StatusWatchdog);
+
+    EXPECT_EQ(0x0102, exchange.encoder(0));
+    EXPECT_EQ(-2, static_cast<int16_t>(exchange.encoder(1)));
+    EXPECT_EQ(0, exchange.encoder(2));
+    EXPECT_EQ(0x7f00, exchange.encoder(3));
+    EXPECT_EQ(0x1234, exchange.watchdogTimer());
+
+    for (size_t i = 0; i < NumMotors; ++i) {
+        EXPECT_EQ(10 * (i + 1), exchange.hall(i)) << i;
+    }
+
+    // Gate driver status is 12 bits, low byte first
+    EXPECT_EQ(0x001, exchange.driverStatus(0));
+    EXPECT_EQ(0x800, exchange.driverStatus(1));
+    EXPECT_EQ(0xfff, exchange.driverStatus(2));
+    EXPECT_EQ(0x000, exchange.driverStatus(3));
+    EXPECT_EQ(0x234, exchange.driverStatus(4));
+}
+
+TEST(FpgaProtocol, shortReply) {
+    // Bytes the FPGA doesn't answer read as an idle bus
+    Exchange exchange;
+    fake_mbed::SPIDevice fpga;
+    fpga.replies.push_back({0x00, 0x01});
+
+    EXPECT_EQ(0, exchange.run(fpga));
+    EXPECT_EQ(0x01ff, exchange.encoder(0));
+    EXPECT_EQ(0xffff, exchange.encoder(1));
+    EXPECT_EQ(0xff, exchange.hall(0));
+    EXPECT_EQ(0xfff, exchange.driverStatus(0));
+}
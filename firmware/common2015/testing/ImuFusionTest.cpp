@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../utils/imu-fusion.hpp"
+
+using namespace ImuFusion;
+
+namespace {
+const float Dt = 0.005f;
+
+// Vision frames come every 1/60 s, which is about every third control cycle
+const int VisionCycles = 3;
+
+// One control cycle of an IMU trace
+struct Sample {
+    // What the gyro read
+    float gyro;
+
+    // The robot's actual heading and turn rate
+    float heading;
+    float rate;
+
+    // True when the robot wasn't driving
+    bool still;
+};
+
+/**
+ * Builds traces like those recorded from the MPU6050 on its 250 deg/s range:
+ * the true rate plus a constant bias and white noise, quantized to the
+ * gyro's resolution.
+ */
+class Recorder {
+public:
+    Recorder(float bias, float noise = 0.01f) : _bias(bias), _noise(noise) {}
+
+    // Records <seconds> of turning at <rate>
+    void turn(float rate, float seconds, bool still = false) {
+        std::normal_distribution<float> noise(0, _noise);
+        for (int i = 0; i < seconds / Dt; ++i) {
+            _heading = wrapAngle(_heading + rate * Dt);
+
+            float reading = rate + _bias + noise(_random);
+            reading = roundf(reading * LsbPerRadian) / LsbPerRadian;
+            trace.push_back({reading, _heading, rate, still});
+        }
+    }
+
+    std::vector<Sample> trace;
+
+private:
+    static constexpr float LsbPerRadian = 7505.7f;
+
+    float _bias;
+    float _noise;
+    float _heading = 0;
+    std::minstd_rand _random{1};
+};
+
+// Runs a trace through <estimator>, correcting it with the true heading every
+// VisionCycles cycles if <vision> is set.  Returns the largest heading error
+// in the last <tail> samples.
+float replay(HeadingEstimator& estimator, const std::vector<Sample>& trace,
+             bool vision, size_t tail) {
+    float worst = 0;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        estimator.update(trace[i].gyro, Dt, trace[i].still);
+        if (vision && i % VisionCycles == 0) {
+            estimator.correct(trace[i].heading);
+        }
+
+        if (i + tail >= trace.size()) {
+            float error = wrapAngle(estimator.heading() - trace[i].heading);
+            worst = std::max(worst, fabsf(error));
+        }
+    }
+    return worst;
+}
+}
+
+TEST(ImuFusion, wrapAngle) {
+    EXPECT_NEAR(0, wrapAngle(0), 1e-6f);
+    EXPECT_NEAR(1, wrapAngle(1), 1e-6f);
+    EXPECT_NEAR(-3, wrapAngle(-3), 1e-6f);
+    EXPECT_NEAR(-M_PI + 0.5f, wrapAngle(M_PI + 0.5f), 1e-5f);
+    EXPECT_NEAR(M_PI - 0.5f, wrapAngle(-M_PI - 0.5f), 1e-5f);
+    EXPECT_NEAR(0.25f, wrapAngle(0.25f + 6 * M_PI), 1e-4f);
+}
+
+TEST(ImuFusion, learnsBiasWhileStill) {
+    Recorder recorder(0.03f);
+    recorder.turn(0, 3, true);
+
+    // Without knowing the robot is still, the bias looks like turning
+    HeadingEstimator naive;
+    for (const Sample& sample : recorder.trace) {
+        naive.update(sample.gyro, Dt, false);
+    }
+    EXPECT_GT(fabsf(naive.heading()), 0.05f);
+
+    HeadingEstimator estimator;
+    replay(estimator, recorder.trace, false, 0);
+    EXPECT_NEAR(0.03f, estimator.bias(), 0.003f);
+    EXPECT_NEAR(0, estimator.heading(), 0.02f);
+}
+
+TEST(ImuFusion, integratesTurns) {
+    Recorder recorder(-0.02f);
+    recorder.turn(0, 2, true);
+    recorder.turn(2.5f, 1);
+    recorder.turn(-4, 1.2f);
+    recorder.turn(0, 0.5f);
+
+    // The turns wrap around through +/- pi.  Only the gyro is used.
+    HeadingEstimator estimator;
+    float error = replay(estimator, recorder.trace, false,
+                         recorder.trace.size());
+    EXPECT_LT(error, 0.03f);
+    EXPECT_NEAR(recorder.trace.back().rate, estimator.rate(), 0.05f);
+}
+
+TEST(ImuFusion, visionCorrectsBias) {
+    // The robot never stops, so only vision can find the bias
+    Recorder recorder(0.05f);
+    for (int i = 0; i < 5; ++i) {
+        recorder.turn(1.5f, 1);
+        recorder.turn(-1, 1);
+    }
+
+    HeadingEstimator gyroOnly;
+    EXPECT_GT(replay(gyroOnly, recorder.trace, false, 200), 0.3f);
+
+    HeadingEstimator estimator;
+    float error = replay(estimator, recorder.trace, true, 200);
+    EXPECT_LT(error, 0.01f);
+    EXPECT_NEAR(0.05f, estimator.bias(), 0.01f);
+}
+
+TEST(ImuFusion, visionWraps) {
+    // A heading just past pi is close to one just before -pi
+    HeadingEstimator estimator;
+    estimator.reset(3.1f);
+    estimator.correct(-3.1f);
+    EXPECT_GT(fabsf(estimator.heading()), 3.1f);
+    EXPECT_LT(fabsf(estimator.bias()), 0.01f);
+}
+
+namespace {
+// A robot whose wheels slip, so it turns slower than they drive it
+struct SlippingRobot {
+    float traction = 0.6f;
+    float rate = 0;
+    float heading = 0;
+
+    void step(float wheelRate, float disturbance = 0) {
+        // The body catches up with the wheels over a few cycles
+        rate += (wheelRate * traction - rate) * 0.3f + disturbance * Dt;
+        heading = wrapAngle(heading + rate * Dt);
+    }
+};
+}
+
+TEST(ImuFusion, yawRateTracksCommand) {
+    SlippingRobot robot;
+    YawControl yaw;
+
+    for (int i = 0; i < 400; ++i) {
+        robot.step(yaw.update(3, robot.rate, robot.heading, Dt));
+    }
+    EXPECT_NEAR(3, robot.rate, 0.05f);
+
+    // Without the loop, the robot turns as much slower as its wheels slip
+    SlippingRobot open;
+    for (int i = 0; i < 400; ++i) {
+        open.step(3);
+    }
+    EXPECT_LT(open.rate, 2);
+}
+
+TEST(ImuFusion, holdsHeading) {
+    SlippingRobot robot;
+    YawControl yaw;
+
+    // Turn, then stop and settle
+    for (int i = 0; i < 200; ++i) {
+        robot.step(yaw.update(2, robot.rate, robot.heading, Dt));
+    }
+    for (int i = 0; i < 200; ++i) {
+        robot.step(yaw.update(0, robot.rate, robot.heading, Dt));
+    }
+    ASSERT_TRUE(yaw.holding());
+    float held = robot.heading;
+
+    // Something bumps the robot and it turns back
+    for (int i = 0; i < 20; ++i) {
+        robot.step(yaw.update(0, robot.rate, robot.heading, Dt), 100);
+    }
+    EXPECT_GT(fabsf(wrapAngle(robot.heading - held)), 0.05f);
+
+    for (int i = 0; i < 400; ++i) {
+        robot.step(yaw.update(0, robot.rate, robot.heading, Dt));
+    }
+    EXPECT_NEAR(0, wrapAngle(robot.heading - held), 0.01f);
+
+    // A new turn command lets go of the heading
+    yaw.update(1, robot.rate, robot.heading, Dt);
+    EXPECT_FALSE(yaw.holding());
+}
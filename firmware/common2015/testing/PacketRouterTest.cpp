@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../modules/CommModule/PacketRouter.hpp"
+#include "FakeRtos.hpp"
+
+typedef PacketRouter<fake_rtos::Rtos> Router;
+
+TEST(PacketRouter, zeroCopy) {
+    Router router;
+    std::vector<rtp::packet*> received;
+    router.port(rtp::port::CONTROL).rxCallback() =
+        [&](rtp::packet* p) { received.push_back(p); };
+
+    rtp::packet* p = router.alloc();
+    ASSERT_NE(nullptr, p);
+    uint8_t data[] = {1, 2, 3};
+    *p = rtp::packet(data, sizeof(data), rtp::port::CONTROL);
+
+    EXPECT_EQ(Router::Queued, router.receive(p));
+    EXPECT_TRUE(router.dispatchRx(0));
+    EXPECT_FALSE(router.dispatchRx(0));
+
+    // The callback got the same packet
+    ASSERT_EQ(1u, received.size());
+    EXPECT_EQ(p, received[0]);
+    EXPECT_EQ(1u, router.port(rtp::port::CONTROL).rx.count);
+    EXPECT_EQ(0u, router.port(rtp::port::CONTROL).tx.count);
+}
+
+TEST(PacketRouter, closedPort) {
+    Router router;
+    EXPECT_EQ(Router::PortClosed, router.send(rtp::packet("x", rtp::LINK)));
+    EXPECT_FALSE(router.dispatchTx(0));
+
+    // The packet went back to the pool
+    std::vector<rtp::packet*> packets;
+    while (rtp::packet* p = router.alloc()) {
+        packets.push_back(p);
+    }
+    EXPECT_EQ(Router::POOL_SIZE, packets.size());
+    EXPECT_EQ(1u, router.poolEmpty());
+}
+
+TEST(PacketRouter, queueFull) {
+    Router router;
+    int sent = 0;
+    router.port(rtp::port::LINK).txCallback() = [&](rtp::packet*) { ++sent; };
+
+    rtp::packet packet("x", rtp::LINK);
+    for (size_t i = 0; i < Router::QUEUE_SIZE; ++i) {
+        EXPECT_EQ(Router::Queued, router.send(packet));
+    }
+    EXPECT_EQ(Router::QueueFull, router.send(packet));
+    EXPECT_EQ(1u, router.port(rtp::port::LINK).tx.dropped);
+
+    while (router.dispatchTx(0)) {
+    }
+    EXPECT_EQ(int(Router::QUEUE_SIZE), sent);
+    EXPECT_EQ(Router::QUEUE_SIZE, router.port(rtp::port::LINK).tx.count);
+
+    // Every packet was returned
+    for (size_t i = 0; i < Router::POOL_SIZE; ++i) {
+        EXPECT_NE(nullptr, router.alloc());
+    }
+}
+
+TEST(PacketRouter, latency) {
+    Router router;
+    fake_rtos::Rtos::time() = 1000;
+    router.port(rtp::port::PING).rxCallback() =
+        [](rtp::packet*) { fake_rtos::Rtos::time() += 50; };
+
+    router.receive(rtp::packet({1}, rtp::port::PING));
+    fake_rtos::Rtos::time() += 100;
+    router.dispatchRx(0);
+
+    const CommPortStats& stats = router.port(rtp::port::PING).rx;
+    EXPECT_EQ(150u, stats.maxLatency);
+    EXPECT_EQ(150u, stats.totalLatency);
+}
+
+TEST(PacketRouter, loopback) {
+    // A TX callback that receives its own packet, like the robot's loopback
+    Router router;
+    int address = -1;
+    std::vector<uint8_t> received;
+    router.port(rtp::port::LINK).txCallback() =
+        [&](rtp::packet* p) { router.receive(*p); };
+    router.port(rtp::port::LINK).rxCallback() =
+        [&](rtp::packet* p) { received.push_back(p->payload[0]); };
+
+    rtp::packet packet({42}, rtp::port::LINK);
+    packet.address(LOOPBACK_ADDR);
+    router.send(packet);
+
+    EXPECT_TRUE(router.dispatchTx(0, &address));
+    EXPECT_EQ(LOOPBACK_ADDR, address);
+    EXPECT_TRUE(router.dispatchRx(0));
+    ASSERT_EQ(1u, received.size());
+    EXPECT_EQ(42, received[0]);
+}
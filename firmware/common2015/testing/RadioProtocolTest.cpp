@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+
+#include "../utils/radio-protocol.hpp"
+
+using namespace RadioProtocol;
+
+TEST(RadioProtocol, packUnpack) {
+    ForwardPacket packet;
+    packet.sequence = 5;
+    packet.count = 2;
+
+    RobotCommand& a = packet.commands[0];
+    a.shell = 3;
+    a.bodyX = -511;
+    a.bodyY = 511;
+    a.bodyW = -1;
+    a.dribbler = 0xa0;
+    a.kickStrength = 200;
+    a.chip = true;
+
+    RobotCommand& b = packet.commands[1];
+    b.shell = 15;
+    b.bodyX = 256;
+    b.bodyY = -256;
+    b.immediate = true;
+    b.song = true;
+
+    uint8_t buf[MaxPacketSize];
+    ASSERT_EQ(HeaderSize + 2 * CommandSize, packet.pack(buf, sizeof(buf)));
+    EXPECT_TRUE(isCompact(buf, packet.size()));
+
+    ForwardPacket out;
+    ASSERT_TRUE(out.unpack(buf, packet.size()));
+    EXPECT_EQ(5, out.sequence);
+    ASSERT_EQ(2, out.count);
+    EXPECT_EQ(a, out.commands[0]);
+    EXPECT_EQ(b, out.commands[1]);
+    EXPECT_EQ(-511, out.commands[0].bodyX);
+    EXPECT_EQ(-256, out.commands[1].bodyY);
+}
+
+TEST(RadioProtocol, empty) {
+    ForwardPacket packet;
+    uint8_t buf[MaxPacketSize];
+    ASSERT_EQ(HeaderSize, packet.pack(buf, sizeof(buf)));
+
+    ForwardPacket out;
+    out.count = 3;
+    ASSERT_TRUE(out.unpack(buf, HeaderSize));
+    EXPECT_EQ(0, out.count);
+}
+
+TEST(RadioProtocol, badPackets) {
+    ForwardPacket packet;
+    packet.count = 2;
+    uint8_t buf[MaxPacketSize];
+
+    // Doesn't fit
+    EXPECT_EQ(0u, packet.pack(buf, HeaderSize + CommandSize));
+    ASSERT_NE(0u, packet.pack(buf, sizeof(buf)));
+
+    // Truncated
+    ForwardPacket out;
+    EXPECT_FALSE(out.unpack(buf, packet.size() - 1));
+
+    // Old fixed-size packets start with a small sequence number
+    buf[0] = 3;
+    EXPECT_FALSE(isCompact(buf, sizeof(buf)));
+    EXPECT_FALSE(out.unpack(buf, sizeof(buf)));
+}
+
+TEST(RadioProtocol, findCommand) {
+    ForwardPacket packet;
+    packet.count = 2;
+    packet.commands[0].shell = 4;
+    packet.commands[1].shell = 9;
+    packet.commands[1].bodyX = -300;
+
+    uint8_t buf[MaxPacketSize];
+    ASSERT_NE(0u, packet.pack(buf, sizeof(buf)));
+
+    RobotCommand cmd;
+    ASSERT_TRUE(findCommand(buf, packet.size(), 9, cmd));
+    EXPECT_EQ(packet.commands[1], cmd);
+    EXPECT_FALSE(findCommand(buf, packet.size(), 5, cmd));
+}
+
+TEST(RadioProtocol, findCommandFullPacket) {
+    // Slot 1 of an old packet, as soccer's FullEncoder writes it
+    uint8_t buf[FullPacketSize] = {3};
+    for (size_t i = 0; i < FullSlots; ++i) {
+        buf[HeaderSize + i * FullSlotSize + 4] = 0x0f;
+    }
+    uint8_t* slot = buf + HeaderSize + FullSlotSize;
+    int16_t x = -2, y = 300, w = -511;
+    slot[0] = x & 0xff;
+    slot[1] = y & 0xff;
+    slot[2] = w & 0xff;
+    slot[3] = ((x & 0x300) >> 8) | ((y & 0x300) >> 6) | ((w & 0x300) >> 4);
+    slot[4] = 0xa0 | 7;
+    slot[5] = 120;
+    slot[6] = 1 | 4;
+
+    RobotCommand cmd;
+    ASSERT_TRUE(findCommand(buf, sizeof(buf), 7, cmd));
+    EXPECT_EQ(7, cmd.shell);
+    EXPECT_EQ(-2, cmd.bodyX);
+    EXPECT_EQ(300, cmd.bodyY);
+    EXPECT_EQ(-511, cmd.bodyW);
+    EXPECT_EQ(0xa0, cmd.dribbler);
+    EXPECT_EQ(120, cmd.kickStrength);
+    EXPECT_TRUE(cmd.chip);
+    EXPECT_FALSE(cmd.immediate);
+    EXPECT_TRUE(cmd.song);
+
+    EXPECT_FALSE(findCommand(buf, sizeof(buf), 2, cmd));
+    EXPECT_FALSE(findCommand(buf, sizeof(buf) - 1, 7, cmd));
+}
+
+TEST(RadioProtocol, trajectoryPackUnpack) {
+    TrajectoryPacket packet;
+    packet.sequence = 6;
+    packet.count = 2;
+
+    TrajectorySegment& a = packet.segments[0];
+    a.command.shell = 9;
+    a.command.bodyX = 100;
+    a.command.bodyW = -3;
+    a.command.kickStrength = 50;
+    a.command.immediate = true;
+    a.length = 20;
+    a.middle.x = 200;
+    a.middle.y = -511;
+    a.end.x = 300;
+    a.end.w = 511;
+
+    packet.segments[1].command.shell = 2;
+    packet.segments[1].length = 255;
+    packet.segments[1].end.y = -1;
+
+    uint8_t buf[MaxTrajectorySize];
+    ASSERT_EQ(HeaderSize + 2 * SegmentSize, packet.pack(buf, sizeof(buf)));
+    EXPECT_TRUE(isTrajectory(buf, packet.size()));
+    EXPECT_FALSE(isCompact(buf, packet.size()));
+
+    TrajectoryPacket out;
+    ASSERT_TRUE(out.unpack(buf, packet.size()));
+    EXPECT_EQ(6, out.sequence);
+    ASSERT_EQ(2, out.count);
+
+    const TrajectorySegment& b = out.segments[0];
+    EXPECT_EQ(9, b.command.shell);
+    EXPECT_EQ(100, b.command.bodyX);
+    EXPECT_EQ(-3, b.command.bodyW);
+    EXPECT_EQ(50, b.command.kickStrength);
+    EXPECT_TRUE(b.command.immediate);
+    EXPECT_EQ(20, b.length);
+    EXPECT_TRUE(a.middle == b.middle);
+    EXPECT_TRUE(a.end == b.end);
+    EXPECT_EQ(255, out.segments[1].length);
+    EXPECT_EQ(-1, out.segments[1].end.y);
+
+    // Too many segments, or too few bytes for them
+    EXPECT_FALSE(out.unpack(buf, packet.size() - 1));
+    buf[0] = TrajectoryFlag | (MaxSegments + 1);
+    EXPECT_FALSE(out.unpack(buf, sizeof(buf)));
+}
+
+TEST(RadioProtocol, interpolate) {
+    // The curve goes through all three points
+    EXPECT_EQ(10, interpolate(10, 50, -20, 0, 20));
+    EXPECT_EQ(50, interpolate(10, 50, -20, 10, 20));
+    EXPECT_EQ(-20, interpolate(10, 50, -20, 20, 20));
+
+    // A straight line when the middle is halfway
+    EXPECT_EQ(25, interpolate(0, 50, 100, 5, 20));
+    EXPECT_EQ(-25, interpolate(0, -50, -100, 5, 20));
+
+    // The end is held after the segment, and a zero length holds it too
+    EXPECT_EQ(-20, interpolate(10, 50, -20, 1000, 20));
+    EXPECT_EQ(7, interpolate(3, 5, 7, 0, 0));
+
+    // Overshoot is clamped
+    EXPECT_EQ(MaxVelocity, interpolate(500, 511, 400, 3, 8));
+}
+
+TEST(RadioProtocol, findSegment) {
+    TrajectoryPacket packet;
+    packet.count = 1;
+    packet.segments[0].command.shell = 4;
+    packet.segments[0].command.bodyY = 30;
+    packet.segments[0].length = 10;
+    packet.segments[0].end.y = 60;
+    uint8_t buf[MaxTrajectorySize];
+    size_t size = packet.pack(buf, sizeof(buf));
+
+    TrajectorySegment segment;
+    EXPECT_FALSE(findSegment(buf, size, 5, segment));
+    ASSERT_TRUE(findSegment(buf, size, 4, segment));
+    EXPECT_EQ(60, segment.at(10).y);
+
+    RobotCommand cmd;
+    ASSERT_TRUE(findCommand(buf, size, 4, cmd));
+    EXPECT_EQ(30, cmd.bodyY);
+
+    // Plain commands hold their velocities
+    ForwardPacket compact;
+    compact.count = 1;
+    compact.commands[0].shell = 4;
+    compact.commands[0].bodyX = -8;
+    size = compact.pack(buf, sizeof(buf));
+    ASSERT_TRUE(findSegment(buf, size, 4, segment));
+    EXPECT_EQ(0, segment.length);
+    EXPECT_EQ(-8, segment.at(0).x);
+    EXPECT_EQ(-8, segment.at(100).x);
+}
+
+TEST(RadioProtocol, toRadio) {
+    // One radio unit each way
+    Velocity v = toRadio(MetersPerTick * sqrtf(2) / SecondsPerCycle,
+                         -MetersPerTick * sqrtf(2) / SecondsPerCycle,
+                         RadiansPerTick / SecondsPerCycle);
+    EXPECT_EQ(1, v.x);
+    EXPECT_EQ(-1, v.y);
+    EXPECT_EQ(1, v.w);
+
+    // Too fast is clamped, and NaN stops
+    v = toRadio(100, -100, NAN);
+    EXPECT_EQ(MaxVelocity, v.x);
+    EXPECT_EQ(-MaxVelocity, v.y);
+    EXPECT_EQ(0, v.w);
+}
+
+TEST(RadioProtocol, toSegment) {
+    RobotCommand cmd;
+    cmd.shell = 2;
+    cmd.bodyX = 10;
+    Velocity middle;
+    middle.x = 20;
+    Velocity end;
+    end.x = 30;
+
+    TrajectorySegment segment = toSegment(cmd, 0.1f, middle, end);
+    EXPECT_EQ(20, segment.length);
+    EXPECT_EQ(2, segment.command.shell);
+    EXPECT_EQ(10, segment.at(0).x);
+    EXPECT_EQ(20, segment.at(10).x);
+    EXPECT_EQ(30, segment.at(20).x);
+
+    // Lengths are clamped to what fits in a byte
+    EXPECT_EQ(255, toSegment(cmd, 10, middle, end).length);
+    EXPECT_EQ(0, toSegment(cmd, -1, middle, end).length);
+    EXPECT_EQ(0, toSegment(cmd, NAN, middle, end).length);
+}
@@ -0,0 +1,275 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../utils/radio-schedule.hpp"
+
+using namespace RadioSchedule;
+using namespace RadioProtocol;
+
+namespace {
+// A compact packet from soccer with commands for <shells>
+std::vector<uint8_t> commands(std::vector<uint8_t> shells, int16_t bodyX = 0) {
+    ForwardPacket packet;
+    for (uint8_t shell : shells) {
+        RobotCommand& cmd = packet.commands[packet.count++];
+        cmd.shell = shell;
+        cmd.bodyX = bodyX;
+    }
+
+    std::vector<uint8_t> buf(MaxPacketSize);
+    buf.resize(packet.pack(buf.data(), buf.size()));
+    return buf;
+}
+
+// A reply from <shell>
+std::vector<uint8_t> reply(uint8_t shell) {
+    std::vector<uint8_t> buf(ReversePacketSize, 0);
+    buf[0] = shell;
+    return buf;
+}
+
+// Sends the frame that is due at <now> and reads it back
+bool takeFrame(Scheduler& scheduler, uint32_t now, ForwardPacket& packet) {
+    uint8_t buf[FullPacketSize];
+    size_t size = scheduler.nextFrame(now, buf, sizeof(buf));
+    return size && packet.unpack(buf, size);
+}
+}
+
+TEST(RadioSchedule, aggregatesCommands) {
+    Scheduler scheduler;
+
+    // Three USB reads before the frame, one updating robot 2
+    ASSERT_TRUE(scheduler.forward(commands({2, 5}).data(), 15, 0));
+    ASSERT_TRUE(scheduler.forward(commands({7}).data(), 8, 100));
+    ASSERT_TRUE(scheduler.forward(commands({2}, 40).data(), 8, 200));
+    EXPECT_EQ(3u, scheduler.waiting());
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 300, packet));
+    ASSERT_EQ(3, packet.count);
+    EXPECT_EQ(2, packet.commands[0].shell);
+    EXPECT_EQ(40, packet.commands[0].bodyX);
+    EXPECT_EQ(5, packet.commands[1].shell);
+    EXPECT_EQ(7, packet.commands[2].shell);
+
+    const Counters& counters = scheduler.counters();
+    EXPECT_EQ(3u, counters.usbReads);
+    EXPECT_EQ(4u, counters.commands);
+    EXPECT_EQ(1u, counters.replaced);
+    EXPECT_EQ(1u, counters.frames);
+
+    // The oldest command waited since the first read
+    EXPECT_EQ(300u, counters.lastForwardLatency);
+    EXPECT_EQ(0u, scheduler.waiting());
+}
+
+TEST(RadioSchedule, keepsKicks) {
+    Scheduler scheduler;
+
+    ForwardPacket kick;
+    kick.count = 1;
+    kick.commands[0].shell = 3;
+    kick.commands[0].immediate = true;
+    kick.commands[0].kickStrength = 200;
+    uint8_t buf[MaxPacketSize];
+    scheduler.forward(buf, kick.pack(buf, sizeof(buf)), 0);
+    scheduler.forward(commands({3}, 10).data(), 8, 10);
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 20, packet));
+    ASSERT_EQ(1, packet.count);
+    EXPECT_EQ(10, packet.commands[0].bodyX);
+    EXPECT_TRUE(packet.commands[0].immediate);
+    EXPECT_EQ(200, packet.commands[0].kickStrength);
+}
+
+TEST(RadioSchedule, framesWaitForReplies) {
+    Scheduler scheduler;
+    scheduler.forward(commands({1, 2}).data(), 15, 0);
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 0, packet));
+    uint8_t first = packet.sequence;
+
+    // Nothing is sent until both reply slots are over
+    scheduler.forward(commands({1}).data(), 8, 10);
+    EXPECT_FALSE(takeFrame(scheduler, slotStart(2) - 1, packet));
+    EXPECT_TRUE(scheduler.inFrame());
+
+    ASSERT_TRUE(takeFrame(scheduler, slotStart(2), packet));
+    EXPECT_EQ((first + 1) & 7, packet.sequence);
+
+    // Neither robot replied
+    EXPECT_EQ(2u, scheduler.counters().missedSlots);
+
+    // No frame is sent without commands
+    EXPECT_FALSE(takeFrame(scheduler, 10 * slotStart(2), packet));
+}
+
+TEST(RadioSchedule, oldestFirst) {
+    Scheduler scheduler;
+    for (uint8_t shell = 0; shell < 8; ++shell) {
+        scheduler.forward(commands({uint8_t(15 - shell)}).data(), 8, shell);
+    }
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 100, packet));
+    ASSERT_EQ(MaxCommands, packet.count);
+    EXPECT_EQ(15, packet.commands[0].shell);
+    EXPECT_EQ(10, packet.commands[5].shell);
+
+    // The rest go in the next frame
+    ASSERT_TRUE(takeFrame(scheduler, 100 + slotStart(MaxCommands), packet));
+    ASSERT_EQ(2, packet.count);
+    EXPECT_EQ(9, packet.commands[0].shell);
+    EXPECT_EQ(8, packet.commands[1].shell);
+}
+
+TEST(RadioSchedule, replySlots) {
+    Scheduler scheduler;
+    scheduler.forward(commands({4, 9, 1}).data(), 22, 0);
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 1000, packet));
+
+    // Robot 9 replies in the second slot and robot 1 in the first slot,
+    // which is the wrong one.  Robot 4 doesn't reply.
+    EXPECT_TRUE(scheduler.reverse(reply(9).data(), ReversePacketSize,
+                                  1000 + slotStart(1) + 10));
+    EXPECT_TRUE(scheduler.reverse(reply(1).data(), ReversePacketSize,
+                                  1000 + slotStart(0) + 10));
+
+    // Wrong sizes are dropped
+    EXPECT_FALSE(scheduler.reverse(reply(1).data(), 5, 1000));
+
+    uint8_t buf[MaxTransferSize];
+    EXPECT_EQ(0u, scheduler.takeBatch(1000 + slotStart(2), buf, sizeof(buf)));
+    EXPECT_EQ(2 * ReversePacketSize,
+              scheduler.takeBatch(1000 + slotStart(3), buf, sizeof(buf)));
+    EXPECT_EQ(9, buf[0]);
+    EXPECT_EQ(1, buf[ReversePacketSize]);
+
+    const Counters& counters = scheduler.counters();
+    EXPECT_EQ(2u, counters.reversePackets);
+    EXPECT_EQ(1u, counters.droppedReverse);
+    EXPECT_EQ(1u, counters.lateReplies);
+    EXPECT_EQ(2u, counters.missedSlots);
+    EXPECT_EQ(1u, counters.usbWrites);
+    EXPECT_EQ(slotStart(3) - slotStart(1) - 10, counters.maxReverseLatency);
+}
+
+TEST(RadioSchedule, batches) {
+    Scheduler scheduler;
+    uint8_t buf[MaxTransferSize];
+
+    // Without a frame, packets are sent as soon as they're taken
+    scheduler.reverse(reply(0).data(), ReversePacketSize, 0);
+    EXPECT_EQ(ReversePacketSize, scheduler.takeBatch(0, buf, sizeof(buf)));
+
+    // During a long frame, a full batch is sent at once
+    uint8_t shells[MaxCommands] = {0, 1, 2, 3, 4, 5};
+    scheduler.forward(
+        commands(std::vector<uint8_t>(shells, shells + MaxCommands)).data(),
+        MaxPacketSize, 0);
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, 0, packet));
+
+    for (size_t i = 0; i < MaxBatch; ++i) {
+        scheduler.reverse(reply(i % NumShells).data(), ReversePacketSize, 1);
+        if (i + 1 < MaxBatch) {
+            EXPECT_EQ(0u, scheduler.takeBatch(2, buf, sizeof(buf)));
+        }
+    }
+    EXPECT_EQ(MaxBatch * ReversePacketSize,
+              scheduler.takeBatch(2, buf, sizeof(buf)));
+
+    // One packet doesn't wait longer than MaxBatchDelay
+    scheduler.reverse(reply(0).data(), ReversePacketSize, 10);
+    EXPECT_EQ(0u, scheduler.takeBatch(9 + MaxBatchDelay, buf, sizeof(buf)));
+    EXPECT_EQ(ReversePacketSize,
+              scheduler.takeBatch(10 + MaxBatchDelay, buf, sizeof(buf)));
+}
+
+TEST(RadioSchedule, fullPackets) {
+    Scheduler scheduler;
+
+    // Old fixed-size packets are sent as they are, with a slot for each robot
+    uint8_t full[FullPacketSize] = {};
+    for (size_t i = 0; i < FullSlots; ++i) {
+        full[HeaderSize + i * FullSlotSize + 4] = 10 + i;
+    }
+    ASSERT_TRUE(scheduler.forward(full, sizeof(full), 0));
+    EXPECT_FALSE(scheduler.forward(full, sizeof(full) - 1, 0));
+    EXPECT_EQ(1u, scheduler.counters().badPackets);
+
+    uint8_t buf[FullPacketSize];
+    ASSERT_EQ(FullPacketSize, scheduler.nextFrame(5, buf, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(full, buf, sizeof(full)));
+
+    uint8_t shells[MaxSlots];
+    ASSERT_EQ(FullSlots, slotShells(buf, sizeof(buf), shells));
+    EXPECT_EQ(15, shells[5]);
+
+    // Robot 15 replies in the last slot
+    scheduler.reverse(reply(15).data(), ReversePacketSize, 5 + slotStart(5));
+    EXPECT_EQ(0u, scheduler.counters().lateReplies);
+}
+
+TEST(RadioSchedule, wraps) {
+    // The microsecond counter wraps every 71 minutes
+    Scheduler scheduler;
+    uint32_t start = 0xffffff00;
+    scheduler.forward(commands({1}).data(), 8, start);
+
+    ForwardPacket packet;
+    ASSERT_TRUE(takeFrame(scheduler, start, packet));
+    scheduler.forward(commands({2}).data(), 8, start);
+    EXPECT_FALSE(takeFrame(scheduler, start + slotStart(0), packet));
+    EXPECT_TRUE(takeFrame(scheduler, start + slotStart(1), packet));
+}
+
+TEST(RadioSchedule, trajectories) {
+    Scheduler scheduler;
+
+    // Trajectory segments for four robots, and a command for another
+    TrajectoryPacket segments;
+    segments.count = MaxSegments;
+    for (size_t i = 0; i < MaxSegments; ++i) {
+        segments.segments[i].command.shell = 1 + i;
+        segments.segments[i].length = 20;
+    }
+    uint8_t buf[FullPacketSize];
+    scheduler.forward(buf, segments.pack(buf, sizeof(buf)), 0);
+    scheduler.forward(commands({8}).data(), 8, 10);
+    segments.count = 1;
+    segments.segments[0].command.shell = 12;
+    scheduler.forward(buf, segments.pack(buf, sizeof(buf)), 20);
+    EXPECT_EQ(5u, scheduler.waiting());
+
+    // The oldest three segments go first, with a slot for each
+    size_t size = scheduler.nextFrame(30, buf, sizeof(buf));
+    TrajectoryPacket packet;
+    ASSERT_TRUE(packet.unpack(buf, size));
+    size_t count = MaxSegments;
+    ASSERT_EQ(count, packet.count);
+    EXPECT_EQ(1, packet.segments[0].command.shell);
+    EXPECT_EQ(20, packet.segments[0].length);
+
+    uint8_t shells[MaxSlots];
+    ASSERT_EQ(count, slotShells(buf, size, shells));
+    EXPECT_EQ(3, shells[2]);
+
+    // Then the command, which waited longer than the last segment
+    ForwardPacket compact;
+    ASSERT_TRUE(takeFrame(scheduler, 30 + slotStart(MaxSegments), compact));
+    ASSERT_EQ(1, compact.count);
+    EXPECT_EQ(8, compact.commands[0].shell);
+
+    size = scheduler.nextFrame(30 + slotStart(MaxSegments) + slotStart(1),
+                               buf, sizeof(buf));
+    ASSERT_TRUE(packet.unpack(buf, size));
+    ASSERT_EQ(1, packet.count);
+    EXPECT_EQ(12, packet.segments[0].command.shell);
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include "../../robot2015/src-ctrl/modules/robot-control.hpp"
+#include "FakeMbed.hpp"
+
+using namespace RadioProtocol;
+
+namespace {
+size_t packCommand(uint8_t* buf, uint8_t shell, int x, int y, int w,
+                   uint8_t dribbler = 0) {
+    ForwardPacket packet;
+    packet.count = 1;
+    packet.commands[0].shell = shell;
+    packet.commands[0].bodyX = x;
+    packet.commands[0].bodyY = y;
+    packet.commands[0].bodyW = w;
+    packet.commands[0].dribbler = dribbler;
+    return packet.pack(buf, MaxPacketSize);
+}
+}
+
+TEST(RobotControl, receive) {
+    fake_mbed::Motors motors;
+    RobotControl<fake_mbed::Motors> control(motors);
+
+    uint8_t buf[MaxPacketSize];
+    size_t size = packCommand(buf, 3, -40, 25, 10, 0x80);
+    EXPECT_FALSE(control.receive(buf, size, 4));
+    ASSERT_TRUE(control.receive(buf, size, 3));
+
+    control.step();
+    int expected[WheelControl::NumWheels];
+    WheelControl::wheelVelocities(-40, 25, 10, expected);
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        EXPECT_EQ(expected[i], control.controller().target(i)) << i;
+    }
+    EXPECT_EQ(0x80 << 1, control.dutyCycles()[4]);
+}
+
+TEST(RobotControl, exchangesDutyCycles) {
+    fake_mbed::Motors motors;
+    RobotControl<fake_mbed::Motors> control(motors);
+
+    uint8_t buf[MaxPacketSize];
+    control.receive(buf, packCommand(buf, 0, 0, 0, 20), 0);
+
+    // The first exchange writes zeros since nothing was computed yet
+    control.step();
+    for (uint16_t duty : motors.duty) {
+        EXPECT_EQ(0, duty);
+    }
+
+    // The wheels are too slow, so the next duty cycles are forward
+    for (int16_t& delta : motors.deltas) {
+        delta = 5;
+    }
+    control.step();
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        EXPECT_GT(motors.duty[i], 0) << i;
+        EXPECT_FALSE(motors.duty[i] & WheelControl::DutyReverse) << i;
+    }
+
+    // Too fast backwards reads as a negative delta
+    for (int16_t& delta : motors.deltas) {
+        delta = -100;
+    }
+    control.step();
+    control.step();
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        EXPECT_FALSE(motors.duty[i] & WheelControl::DutyReverse) << i;
+    }
+}
+
+TEST(RobotControl, timeout) {
+    fake_mbed::Motors motors;
+    RobotControl<fake_mbed::Motors> control(motors);
+
+    uint8_t buf[MaxPacketSize];
+    control.receive(buf, packCommand(buf, 1, 100, 0, 0, 0xf0), 1);
+
+    motors.time = RobotControl<fake_mbed::Motors>::CommandTimeout - 1;
+    control.step();
+    EXPECT_NE(0, control.controller().target(0));
+
+    motors.time += 1;
+    control.step();
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        EXPECT_EQ(0, control.controller().target(i)) << i;
+    }
+    EXPECT_EQ(0, control.dutyCycles()[4]);
+}
+
+TEST(RobotControl, imuCorrectsTurning) {
+    fake_mbed::Motors motors;
+    RobotControl<fake_mbed::Motors> control(motors);
+    EXPECT_TRUE(control.stopped());
+
+    uint8_t buf[MaxPacketSize];
+    control.receive(buf, packCommand(buf, 0, 0, 0, 40), 0);
+
+    // Without the IMU the wheels turn at the command
+    control.step();
+    EXPECT_EQ(40, control.controller().target(0));
+    EXPECT_FALSE(control.stopped());
+
+    // The gyro says the robot turns at half the command, so the wheels are
+    // driven faster
+    float commanded = 40 * RadiansPerTick / SecondsPerCycle;
+    control.imu(commanded / 2, 0);
+    control.step();
+    EXPECT_GT(control.controller().target(0), 40);
+
+    // Each reading is only used once
+    control.step();
+    EXPECT_EQ(40, control.controller().target(0));
+
+    // Stopped needs both no command and still wheels
+    control.receive(buf, packCommand(buf, 0, 0, 0, 0), 0);
+    motors.deltas[2] = 1;
+    control.step();
+    EXPECT_FALSE(control.stopped());
+    motors.deltas[2] = 0;
+    control.step();
+    EXPECT_TRUE(control.stopped());
+}
+
+TEST(RobotControl, followsSegments) {
+    fake_mbed::Motors motors;
+    RobotControl<fake_mbed::Motors> control(motors);
+    const uint32_t cycle = RobotControl<fake_mbed::Motors>::CycleTime;
+    const uint32_t timeout = RobotControl<fake_mbed::Motors>::CommandTimeout;
+
+    // Speed up from 0 to 100 over 80 cycles, which is longer than the
+    // timeout
+    TrajectoryPacket packet;
+    packet.count = 1;
+    TrajectorySegment& segment = packet.segments[0];
+    segment.command.shell = 2;
+    segment.length = 80;
+    segment.middle.x = 50;
+    segment.end.x = 100;
+    uint8_t buf[MaxTrajectorySize];
+    ASSERT_TRUE(control.receive(buf, packet.pack(buf, sizeof(buf)), 2));
+
+    int expected[WheelControl::NumWheels];
+    for (uint32_t i : {0u, 20u, 40u, 79u}) {
+        motors.time = i * cycle;
+        control.step();
+        WheelControl::wheelVelocities(segment.at(i).x, 0, 0, expected);
+        EXPECT_EQ(expected[0], control.controller().target(0)) << i;
+    }
+    EXPECT_GT(timeout, 40 * cycle);
+
+    // No more packets come, so the robot stops when the segment ends
+    motors.time = 80 * cycle;
+    control.step();
+    EXPECT_EQ(0, control.controller().target(0));
+
+    // A new segment starts when it arrives
+    motors.time = 1000 * cycle;
+    segment.command.bodyX = 30;
+    control.receive(buf, packet.pack(buf, sizeof(buf)), 2);
+    control.step();
+    WheelControl::wheelVelocities(30, 0, 0, expected);
+    EXPECT_EQ(expected[0], control.controller().target(0));
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <type_traits>
+
+#include "../utils/rtp.hpp"
+
+// Packets are copied into RTOS mail slots without running constructors or
+// destructors
+static_assert(std::is_trivially_copyable<rtp::packet>::value,
+              "rtp::packet must be trivially copyable");
+
+TEST(Rtp, packUnpack) {
+    rtp::packet packet({1, 2, 3, 250}, rtp::port::CONTROL);
+    packet.address(BASE_STATION_ADDR);
+    packet.header.type = rtp::header_data::Tuning;
+
+    uint8_t buf[rtp::MAX_DATA_SZ];
+    size_t size = packet.pack(buf, sizeof(buf));
+    ASSERT_EQ(1 + rtp::header_data::SIZE + 4, size);
+    EXPECT_EQ(size - 1, buf[0]);
+
+    rtp::packet out;
+    ASSERT_TRUE(out.recv(buf, size));
+    EXPECT_EQ(rtp::port::CONTROL, out.port());
+    EXPECT_EQ(BASE_STATION_ADDR, out.address());
+    EXPECT_EQ(rtp::header_data::Tuning, out.header.type);
+    ASSERT_EQ(4u, out.payload.size());
+    EXPECT_EQ(250, out.payload[3]);
+
+    // Receiving again replaces the old payload
+    rtp::packet empty;
+    size = empty.pack(buf, sizeof(buf));
+    ASSERT_TRUE(out.recv(buf, size));
+    EXPECT_TRUE(out.payload.empty());
+}
+
+TEST(Rtp, string) {
+    rtp::packet packet("hi");
+    ASSERT_EQ(3u, packet.payload.size());
+    EXPECT_EQ('h', packet.payload[0]);
+    EXPECT_EQ('\0', packet.payload[2]);
+    EXPECT_EQ(rtp::port::SINK, packet.port());
+}
+
+TEST(Rtp, capacity) {
+    uint8_t data[rtp::MAX_DATA_SZ] = {};
+    rtp::packet packet;
+    EXPECT_TRUE(packet.payload.assign(data, rtp::payload_buffer::CAPACITY));
+    EXPECT_FALSE(packet.payload.push_back(0));
+
+    // The largest packet fills the radio's buffer
+    uint8_t buf[rtp::MAX_DATA_SZ];
+    EXPECT_EQ(sizeof(buf), packet.pack(buf, sizeof(buf)));
+    EXPECT_EQ(0u, packet.pack(buf, sizeof(buf) - 1));
+
+    // Too much data is truncated
+    EXPECT_FALSE(packet.payload.assign(data, sizeof(data)));
+    EXPECT_EQ(packet.payload.capacity(), packet.payload.size());
+}
+
+TEST(Rtp, badPackets) {
+    uint8_t buf[rtp::MAX_DATA_SZ + 8] = {};
+    rtp::packet packet;
+    EXPECT_FALSE(packet.recv(buf, rtp::header_data::SIZE));
+    EXPECT_FALSE(packet.recv(buf, sizeof(buf)));
+}
+
+TEST(Rtp, copy) {
+    rtp::packet a({7, 8, 9}, rtp::port::PING);
+    rtp::packet b;
+    b = a;
+    a.payload[0] = 1;
+    EXPECT_EQ(7, b.payload[0]);
+    EXPECT_EQ(3u, b.payload.size());
+    EXPECT_EQ(rtp::port::PING, b.port());
+}
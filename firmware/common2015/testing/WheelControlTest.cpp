@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "../utils/wheel-control.hpp"
+
+using namespace WheelControl;
+
+namespace {
+// A first-order model of a motor and wheel.  Each cycle the speed moves part
+// of the way toward the speed the duty cycle would hold, less any load.
+struct Motor {
+    float ticksPerDuty = 0.25f;
+    float response = 0.3f;
+    float load = 0;
+    float speed = 0;
+
+    int16_t step(int duty) {
+        speed += (duty * ticksPerDuty - load - speed) * response;
+        return static_cast<int16_t>(roundf(speed));
+    }
+};
+
+// Runs the controller against a motor on each wheel for <cycles> cycles
+void run(Controller& controller, Motor motors[NumWheels], int cycles,
+         int duty[NumWheels]) {
+    int16_t measured[NumWheels] = {};
+    for (int c = 0; c < cycles; ++c) {
+        controller.update(measured, duty);
+        for (size_t i = 0; i < NumWheels; ++i) {
+            measured[i] = motors[i].step(duty[i]);
+        }
+    }
+}
+}
+
+TEST(WheelControl, kinematics) {
+    int wheels[NumWheels];
+
+    // Spinning turns every wheel the same way
+    wheelVelocities(0, 0, 20, wheels);
+    for (int v : wheels) {
+        EXPECT_EQ(20, v);
+    }
+
+    // Driving forward turns the left and right wheels opposite ways, and the
+    // 55 degree wheels faster
+    wheelVelocities(100, 0, 0, wheels);
+    EXPECT_EQ(-116, wheels[0]);
+    EXPECT_EQ(-100, wheels[1]);
+    EXPECT_EQ(116, wheels[2]);
+    EXPECT_EQ(100, wheels[3]);
+
+    wheelVelocities(0, -100, 0, wheels);
+    EXPECT_EQ(81, wheels[0]);
+    EXPECT_EQ(-100, wheels[1]);
+    EXPECT_EQ(-81, wheels[2]);
+    EXPECT_EQ(100, wheels[3]);
+
+    // Rounding is symmetric
+    int reversed[NumWheels];
+    wheelVelocities(37, -11, 0, wheels);
+    wheelVelocities(-37, 11, 0, reversed);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_EQ(-wheels[i], reversed[i]);
+    }
+}
+
+TEST(WheelControl, dutyCycle) {
+    EXPECT_EQ(0, dutyCycle(0));
+    EXPECT_EQ(100, dutyCycle(100));
+    EXPECT_EQ(100 | DutyReverse, dutyCycle(-100));
+    EXPECT_EQ(MaxDuty, dutyCycle(1000));
+    EXPECT_EQ(MaxDuty | DutyReverse, dutyCycle(-1000));
+}
+
+TEST(WheelControl, tracksTarget) {
+    Controller controller;
+    Motor motors[NumWheels];
+    int duty[NumWheels];
+
+    controller.setTarget(40, -20, 10);
+    run(controller, motors, 100, duty);
+
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_NEAR(controller.target(i), motors[i].speed, 0.5f) << i;
+    }
+
+    controller.setTarget(0, 0, 0);
+    run(controller, motors, 100, duty);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_NEAR(0, motors[i].speed, 0.5f) << i;
+    }
+}
+
+TEST(WheelControl, integratorRemovesError) {
+    // Without the integrator, a load and a weaker motor than the feedforward
+    // expects leave the wheels short of their targets
+    Controller controller;
+    controller.gains.ki = 0;
+    Motor motors[NumWheels];
+    for (Motor& motor : motors) {
+        motor.ticksPerDuty = 0.2f;
+        motor.load = 5;
+    }
+
+    int duty[NumWheels];
+    controller.setTarget(30, 30, 0);
+    run(controller, motors, 200, duty);
+    EXPECT_GT(fabsf(controller.target(1) - motors[1].speed), 2);
+
+    controller.gains = Controller::Gains();
+    run(controller, motors, 200, duty);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_NEAR(controller.target(i), motors[i].speed, 0.5f) << i;
+    }
+}
+
+TEST(WheelControl, saturationDoesntWindUp) {
+    Controller controller;
+    Motor motors[NumWheels];
+    int duty[NumWheels];
+
+    // Ask for more than the motors can do
+    controller.setTarget(0, 0, 400);
+    run(controller, motors, 200, duty);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_EQ(MaxDuty, duty[i]);
+    }
+
+    // Once the target is reachable, the wheels settle quickly instead of
+    // waiting for the integrators to unwind
+    controller.setTarget(0, 0, 50);
+    run(controller, motors, 30, duty);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_NEAR(50, motors[i].speed, 1) << i;
+    }
+}
+
+TEST(WheelControl, reset) {
+    Controller controller;
+    Motor motors[NumWheels];
+    for (Motor& motor : motors) {
+        motor.load = 10;
+    }
+
+    int duty[NumWheels];
+    controller.setTarget(20, 0, 0);
+    run(controller, motors, 50, duty);
+
+    controller.reset();
+    int16_t stopped[NumWheels] = {};
+    controller.update(stopped, duty);
+    for (size_t i = 0; i < NumWheels; ++i) {
+        EXPECT_EQ(0, controller.target(i));
+        EXPECT_EQ(0, duty[i]);
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The FPGA's SPI commands (see robocup.v in src-fpga).
+ *
+ * Each transaction is one command, framed by chip select.  The first byte
+ * written is the command and the first byte read back is the status byte:
+ *
+ *   byte 0     rwmhhhhh  r: ready, w: watchdog expired, m: motors enabled,
+ *                        h: which motors have their halls connected
+ *
+ * Read commands have the top bit set.  Multi-byte values are read high byte
+ * first, except the gate driver status, and duty cycles are written low byte
+ * first.
+ */
+namespace FpgaProtocol {
+
+enum Command : uint8_t {
+    EnableMotors = 0x30,
+    UpdateMotors = 0x80,
+    ReadEncoders = 0x91,
+    ReadHalls = 0x92,
+    ReadDutyCycles = 0x93,
+    ReadHash1 = 0x94,
+    ReadHash2 = 0x95,
+    ReadDriverStatus = 0x96
+};
+
+const uint8_t StatusReady = 0x80;
+const uint8_t StatusWatchdog = 0x40;
+const uint8_t StatusMotorsEnabled = 0x20;
+const uint8_t StatusHallsConnected = 0x1f;
+
+/// Four wheels and the dribbler
+const size_t NumMotors = 5;
+
+/// The dribbler has no encoder
+const size_t NumEncoders = NumMotors - 1;
+
+const uint16_t MaxDutyCycle = 0x3ff;
+
+/**
+ * One control cycle's worth of FPGA transactions, run back to back while
+ * holding the bus: write the duty cycles while reading the encoders, then
+ * read the hall counts and the gate drivers' status.
+ *
+ * The frames are stored one after another in a single buffer for each
+ * direction, so the whole exchange is one block transfer.
+ */
+class Exchange {
+public:
+    static const size_t UpdateSize = 1 + 2 * NumMotors;
+    static const size_t HallsSize = 1 + NumMotors;
+    static const size_t DriversSize = 1 + 2 * NumMotors;
+
+    static const size_t NumFrames = 3;
+    static const size_t Size = UpdateSize + HallsSize + DriversSize;
+
+    Exchange() {
+        _tx[0] = UpdateMotors;
+        _tx[UpdateSize] = ReadHalls;
+        _tx[UpdateSize + HallsSize] = ReadDriverStatus;
+    }
+
+    /// Sizes of the frames in the buffers
+    static const size_t* frameSizes() {
+        static const size_t sizes[NumFrames] = {UpdateSize, HallsSize,
+                                                DriversSize};
+        return sizes;
+    }
+
+    /// Sets the duty cycles that the next run() writes.  Motors past <count>
+    /// are stopped.  Returns false and changes nothing if any is out of range.
+    bool setDutyCycles(const uint16_t* duty, size_t count) {
+        if (count > NumMotors) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (duty[i] > MaxDutyCycle) {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < NumMotors; ++i) {
+            uint16_t value = i < count ? duty[i] : 0;
+            _tx[1 + 2 * i] = value & 0xff;
+            _tx[2 + 2 * i] = value >> 8;
+        }
+        return true;
+    }
+
+    /**
+     * Runs the transactions.  <device> must have:
+     *   // Runs <count> transactions whose bytes are stored one after
+     *   // another in <tx> and <rx>
+     *   void transferFrames(const uint8_t* tx, uint8_t* rx,
+     *                       const size_t* sizes, size_t count);
+     *
+     * Returns the status byte.
+     */
+    template <class Device>
+    uint8_t run(Device& device) {
+        device.transferFrames(_tx.data(), _rx.data(), frameSizes(), NumFrames);
+        return status();
+    }
+
+    /// The status byte at the start of the exchange
+    uint8_t status() const { return _rx[0]; }
+
+    /// Encoder count for a wheel
+    uint16_t encoder(size_t i) const { return readHigh(1 + 2 * i); }
+
+    /// Watchdog timer when the encoders were read
+    uint16_t watchdogTimer() const { return readHigh(1 + 2 * NumEncoders); }
+
+    uint8_t hall(size_t i) const { return _rx[UpdateSize + 1 + i]; }
+
+    uint16_t driverStatus(size_t i) const {
+        size_t offset = UpdateSize + HallsSize + 1 + 2 * i;
+        return _rx[offset] | (_rx[offset + 1] & 0x0f) << 8;
+    }
+
+    const uint8_t* tx() const { return _tx.data(); }
+    const uint8_t* rx() const { return _rx.data(); }
+
+private:
+    uint16_t readHigh(size_t offset) const {
+        return _rx[offset] << 8 | _rx[offset + 1];
+    }
+
+    std::array<uint8_t, Size> _tx{};
+    std::array<uint8_t, Size> _rx{};
+};
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Heading estimation from the IMU's gyro, and a yaw rate loop that uses it to
+ * turn the robot at the commanded rate and hold its heading when it isn't
+ * turning.
+ *
+ * Rates are in rad/s, counterclockwise seen from above, and angles are in
+ * radians.
+ */
+namespace ImuFusion {
+
+/// Wraps an angle into [-pi, pi)
+inline float wrapAngle(float angle) {
+    const float Pi = 3.14159265f;
+    angle = fmodf(angle + Pi, 2 * Pi);
+    if (angle < 0) {
+        angle += 2 * Pi;
+    }
+    return angle - Pi;
+}
+
+/**
+ * Integrates the gyro's yaw rate into a heading.
+ *
+ * The gyro's bias is learned while the robot is still, and when an absolute
+ * heading is available (from vision) the error corrects both the heading and
+ * the bias, like a complementary filter.
+ */
+class HeadingEstimator {
+public:
+    struct Gains {
+        /// Time constant in seconds of the bias following the gyro while
+        /// the robot is still
+        float stillTime = 0.5f;
+
+        /// Fraction of an absolute heading's error that is corrected at once
+        float heading = 0.1f;
+
+        /// Change in the bias, in rad/s, per radian of an absolute heading's
+        /// error
+        float bias = 0.05f;
+    };
+
+    Gains gains;
+
+    /**
+     * Takes a gyro reading <dt> seconds after the last one.  <still> says
+     * whether the robot is known not to be turning, so anything the gyro
+     * reads is bias.
+     */
+    void update(float gyro, float dt, bool still) {
+        if (still) {
+            float alpha = std::min(1.0f, dt / gains.stillTime);
+            _bias += (gyro - _bias) * alpha;
+        }
+
+        _rate = gyro - _bias;
+        _heading = wrapAngle(_heading + _rate * dt);
+    }
+
+    /// Corrects the estimate with a measured heading
+    void correct(float heading) {
+        float error = wrapAngle(heading - _heading);
+        _heading = wrapAngle(_heading + error * gains.heading);
+
+        // A heading that keeps falling behind means the bias is too high
+        _bias -= error * gains.bias;
+    }
+
+    /// Sets the heading, as when the robot is placed on the field
+    void reset(float heading) { _heading = wrapAngle(heading); }
+
+    float heading() const { return _heading; }
+
+    /// The yaw rate with the bias removed
+    float rate() const { return _rate; }
+
+    float bias() const { return _bias; }
+
+private:
+    float _heading = 0;
+    float _rate = 0;
+    float _bias = 0;
+};
+
+/**
+ * Corrects the turn rate asked of the wheels so the robot turns at the
+ * commanded rate as the gyro sees it, in spite of slipping wheels.  When the
+ * command is not to turn, this holds the heading the robot settles at.
+ */
+class YawControl {
+public:
+    struct Gains {
+        /// Correction per rad/s of rate error
+        float kp = 0.5f;
+
+        /// Correction per second, per rad/s of rate error
+        float ki = 4.0f;
+
+        /// Turn rate per radian of heading error when holding a heading
+        float heading = 6.0f;
+
+        /// The heading is held once the robot turns slower than this
+        float settleRate = 0.2f;
+
+        /// Largest correction
+        float maxCorrection = 4.0f;
+    };
+
+    Gains gains;
+
+    /**
+     * Returns the turn rate to drive the wheels at for the next <dt> seconds.
+     * <target> is the commanded rate, and <rate> and <heading> are from the
+     * IMU.
+     */
+    float update(float target, float rate, float heading, float dt) {
+        if (target == 0) {
+            if (_turning) {
+                // What made up for slipping while turning doesn't apply to
+                // stopping
+                _turning = false;
+                _integral = 0;
+            }
+            if (!_holding && fabsf(rate) < gains.settleRate) {
+                _holding = true;
+                _holdHeading = heading;
+            }
+            if (_holding) {
+                target = gains.heading * wrapAngle(_holdHeading - heading);
+            }
+        } else {
+            _turning = true;
+            _holding = false;
+        }
+
+        float error = target - rate;
+        float limit = gains.maxCorrection;
+        _integral = clamp(_integral + gains.ki * error * dt, limit);
+        return target + clamp(gains.kp * error + _integral, limit);
+    }
+
+    /// Forgets the held heading and the integrator, as when the robot stops
+    void reset() {
+        _turning = false;
+        _holding = false;
+        _integral = 0;
+    }
+
+    bool holding() const { return _holding; }
+
+private:
+    static float clamp(float value, float limit) {
+        return std::max(-limit, std::min(limit, value));
+    }
+
+    bool _turning = false;
+    bool _holding = false;
+    float _holdHeading = 0;
+    float _integral = 0;
+};
+}
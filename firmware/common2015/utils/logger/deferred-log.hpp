@@ -0,0 +1,346 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Deferred logging keeps the work of a log call out of the thread that
+ * made it.  The call stores a Record holding its format pointer and raw
+ * arguments in a lock-free Ring, and a low-priority thread formats and prints
+ * the records later.
+ *
+ * Only arguments that can be copied by value are deferred: integers up to 32
+ * bits, enums, floating point numbers and pointers other than strings.  A
+ * string could be changed or freed before it is printed, so log calls with
+ * string arguments are printed right away like before.  Format strings must be
+ * literals for the same reason, which the LOG macro already expects.
+ *
+ * Nothing here needs mbed, so the same code is tested on the host.
+ */
+namespace DeferredLog {
+
+/// Most arguments a deferred log call can have
+const size_t MaxArgs = 6;
+
+enum ArgType : uint8_t { Signed, Unsigned, Double, Pointer };
+
+union Arg {
+    int32_t i;
+    uint32_t u;
+    double d;
+    const void* p;
+};
+
+struct Record {
+    /// Microseconds since startup
+    uint32_t time;
+
+    const char* format;
+    const char* source;
+    const char* func;
+    uint16_t line;
+    uint8_t level;
+
+    uint8_t numArgs;
+    ArgType types[MaxArgs];
+    Arg args[MaxArgs];
+};
+
+/// True for pointers to characters, which are printed as strings
+template <class T>
+struct IsString
+    : std::integral_constant<
+          bool,
+          std::is_pointer<T>::value &&
+              (std::is_same<typename std::remove_cv<
+                                typename std::remove_pointer<T>::type>::type,
+                            char>::value ||
+               std::is_same<typename std::remove_cv<
+                                typename std::remove_pointer<T>::type>::type,
+                            signed char>::value ||
+               std::is_same<typename std::remove_cv<
+                                typename std::remove_pointer<T>::type>::type,
+                            unsigned char>::value)> {};
+
+/// True if a value of type T can be stored in a Record
+template <class T, class U = typename std::decay<T>::type>
+struct IsDeferrable
+    : std::integral_constant<
+          bool, ((std::is_integral<U>::value || std::is_enum<U>::value) &&
+                 sizeof(U) <= 4) ||
+                    std::is_floating_point<U>::value ||
+                    std::is_null_pointer<U>::value ||
+                    (std::is_pointer<U>::value && !IsString<U>::value)> {};
+
+/// True if a log call with these arguments can be deferred
+template <class... Args>
+struct Deferrable : std::true_type {};
+
+template <class T, class... Rest>
+struct Deferrable<T, Rest...>
+    : std::integral_constant<bool, IsDeferrable<T>::value &&
+                                       Deferrable<Rest...>::value &&
+                                       sizeof...(Rest) < MaxArgs> {};
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_signed<T>::value>::type
+store(Record& record, size_t i, T value) {
+    record.types[i] = Signed;
+    record.args[i].i = value;
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        !std::is_signed<T>::value>::type
+store(Record& record, size_t i, T value) {
+    record.types[i] = Unsigned;
+    record.args[i].u = value;
+}
+
+template <class T>
+typename std::enable_if<std::is_enum<T>::value>::type store(Record& record,
+                                                            size_t i,
+                                                            T value) {
+    record.types[i] = Signed;
+    record.args[i].i = static_cast<int32_t>(value);
+}
+
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value>::type store(
+    Record& record, size_t i, T value) {
+    record.types[i] = Double;
+    record.args[i].d = value;
+}
+
+template <class T>
+typename std::enable_if<std::is_pointer<T>::value ||
+                        std::is_null_pointer<T>::value>::type
+store(Record& record, size_t i, T value) {
+    record.types[i] = Pointer;
+    record.args[i].p = value;
+}
+
+inline void storeArgs(Record& record, size_t i) { record.numArgs = i; }
+
+template <class T, class... Rest>
+void storeArgs(Record& record, size_t i, T first, Rest... rest) {
+    store(record, i, first);
+    storeArgs(record, i + 1, rest...);
+}
+
+/**
+ * A bounded queue of records that any number of threads or interrupts can add
+ * to and one thread takes from, without locks.  When it's full, new records
+ * are dropped and counted.
+ *
+ * Each cell has a sequence number that says whether it's free for the writer
+ * at a position or holds a record for the reader (see Dmitry Vyukov's bounded
+ * MPMC queue).
+ */
+template <size_t N>
+class Ring {
+    static_assert(N >= 2 && (N & (N - 1)) == 0,
+                  "Ring size must be a power of two");
+
+public:
+    Ring() {
+        for (size_t i = 0; i < N; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Claims a cell and calls fill(Record&) to write it.  Returns false if
+    /// the ring is full.
+    template <class Fill>
+    bool push(Fill fill) {
+        uint32_t pos = _write.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & (N - 1)];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = static_cast<int32_t>(seq - pos);
+            if (diff == 0) {
+                if (_write.compare_exchange_weak(pos, pos + 1,
+                                                 std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _write.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->record);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Takes the oldest record.  Returns false if there are none.  Only one
+    /// thread may call this.
+    bool pop(Record& record) {
+        Cell& cell = _cells[_read & (N - 1)];
+        uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(seq - (_read + 1)) < 0) {
+            return false;
+        }
+
+        record = cell.record;
+        cell.sequence.store(_read + N, std::memory_order_release);
+        ++_read;
+        return true;
+    }
+
+    /// Returns the number of records dropped since the last call
+    uint32_t takeDropped() {
+        return _dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        Record record;
+    };
+
+    Cell _cells[N];
+    std::atomic<uint32_t> _write{0};
+    std::atomic<uint32_t> _dropped{0};
+    uint32_t _read = 0;
+};
+
+/**
+ * Writes the message of <record> to <buf> as printf would have with the
+ * original arguments.  The result is cut short if it doesn't fit.  An
+ * argument that is missing or doesn't match its conversion is written as
+ * "(?)".  Returns the length of the message.
+ */
+inline size_t format(const Record& record, char* buf, size_t size) {
+    if (!size) {
+        return 0;
+    }
+
+    size_t len = 0;
+    size_t argIndex = 0;
+
+    auto append = [&](int n) {
+        if (n > 0) {
+            len += std::min(static_cast<size_t>(n), size - 1 - len);
+        }
+    };
+
+    const char* f = record.format;
+    while (*f && len + 1 < size) {
+        if (*f != '%') {
+            buf[len++] = *f++;
+            continue;
+        }
+
+        if (f[1] == '%') {
+            buf[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy the flags, width and precision.  Length modifiers are dropped
+        // since every argument was widened when it was stored.
+        char spec[16];
+        size_t specLen = 0;
+        spec[specLen++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) &&
+               specLen < sizeof(spec) - 3) {
+            spec[specLen++] = *f++;
+        }
+        while (*f && strchr("hlLqjzt", *f)) {
+            ++f;
+        }
+
+        char conv = *f;
+        if (!conv) {
+            break;
+        }
+        ++f;
+
+        if (argIndex >= record.numArgs) {
+            append(snprintf(buf + len, size - len, "(?)"));
+            continue;
+        }
+        ArgType type = record.types[argIndex];
+        const Arg& arg = record.args[argIndex];
+        ++argIndex;
+
+        bool integer = type == Signed || type == Unsigned;
+        int n = -1;
+        switch (conv) {
+            case 'd':
+            case 'i':
+                if (integer) {
+                    spec[specLen++] = 'l';
+                    spec[specLen++] = conv;
+                    spec[specLen] = 0;
+                    n = snprintf(buf + len, size - len, spec,
+                                 static_cast<long>(arg.i));
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if (integer) {
+                    spec[specLen++] = 'l';
+                    spec[specLen++] = conv;
+                    spec[specLen] = 0;
+                    n = snprintf(buf + len, size - len, spec,
+                                 static_cast<unsigned long>(arg.u));
+                }
+                break;
+            case 'c':
+                if (integer) {
+                    spec[specLen++] = conv;
+                    spec[specLen] = 0;
+                    n = snprintf(buf + len, size - len, spec,
+                                 static_cast<int>(arg.i));
+                }
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (type == Double) {
+                    spec[specLen++] = conv;
+                    spec[specLen] = 0;
+                    n = snprintf(buf + len, size - len, spec, arg.d);
+                }
+                break;
+            case 'p':
+                if (type == Pointer) {
+                    spec[specLen++] = conv;
+                    spec[specLen] = 0;
+                    n = snprintf(buf + len, size - len, spec, arg.p);
+                }
+                break;
+        }
+
+        if (n < 0) {
+            n = snprintf(buf + len, size - len, "(?)");
+        }
+        append(n);
+    }
+
+    buf[len] = 0;
+    return len;
+}
+
+}  // namespace DeferredLog
@@ -5,6 +5,7 @@
 
 #include <mbed.h>
 #include <rtos.h>
+#include <us_ticker_api.h>
 
 const char* LOG_LEVEL_STRING[] = {FOREACH_LEVEL(GENERATE_STRING)};
 
@@ -15,8 +16,57 @@ bool isLogging;  // = RJ_LOGGING_EN;
 
 uint8_t rjLogLevel;
 
+bool isLogDeferred;
+
+DeferredLog::Ring<LOG_RING_SIZE> logRing;
+
 Mutex log_mutex;
 
+namespace {
+Thread* logThread = nullptr;
+
+// Prints deferred log messages.  This runs at low priority, so the threads
+// that logged them only pay for storing a record.
+void Task_Logging(void const* args) {
+    char msg[160];
+    DeferredLog::Record record;
+
+    while (true) {
+        while (logRing.pop(record)) {
+            DeferredLog::format(record, msg, sizeof(msg));
+
+            log_mutex.lock();
+            printf("%lu.%03lu [%s] [%s:%d] <%s>\r\n  %s\r\n\r\n",
+                   record.time / 1000000, record.time / 1000 % 1000,
+                   LOG_LEVEL_STRING[record.level], record.source, record.line,
+                   record.func, msg);
+            fflush(stdout);
+            log_mutex.unlock();
+        }
+
+        uint32_t dropped = logRing.takeDropped();
+        if (dropped) {
+            log_mutex.lock();
+            printf("[%lu log messages dropped]\r\n\r\n", dropped);
+            fflush(stdout);
+            log_mutex.unlock();
+        }
+
+        Thread::wait(5);
+    }
+}
+}
+
+uint32_t logTimestamp() { return us_ticker_read(); }
+
+void deferLogging(bool defer) {
+    if (defer && !logThread) {
+        logThread = new Thread(Task_Logging, nullptr, osPriorityLow);
+    }
+
+    isLogDeferred = defer;
+}
+
 LogHelper::LogHelper(uint8_t logLevel, const char* source, int line,
                      const char* func) {
     _logLevel = logLevel;
@@ -30,14 +80,13 @@ LogHelper::~LogHelper() {
 }
 
 /**
- * The system-wide logging interface function. All log messages go through
- * this.
+ * Prints a log message right away, in the calling thread.
  * @param logLevel The "importance level" of the called log message.
  * @param source   The source of the message.
  * @param format   The string format for displaying the log message.
  */
-void log(uint8_t logLevel, const char* source, int line, const char* func,
-         const char* format, ...) {
+void logNow(uint8_t logLevel, const char* source, int line, const char* func,
+            const char* format, ...) {
     if (isLogging && logLevel <= rjLogLevel) {
         log_mutex.lock();
 
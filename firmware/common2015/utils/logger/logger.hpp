@@ -3,8 +3,10 @@
 #include <cstdarg>
 #include <string>
 #include <sstream>
+#include <type_traits>
 
 #include "rj-macros.hpp"
+#include "deferred-log.hpp"
 
 // Do weird macro things for logging the filename and line for every call.
 // Also allows for disabling all logging through macros so all log calls can be
@@ -85,6 +87,70 @@ private:
     const char* _func;
 };
 
+/**
+ * Prints a log message right away, in the calling thread.
+ * @param logLevel The "importance level" of the called log message.
+ * @param source   The source of the message.
+ * @param format   The string format for displaying the log message.
+ */
+void logNow(uint8_t logLevel, const char* source, int line, const char* func,
+            const char* format, ...);
+
+/**
+ * Number of log messages that can wait to be printed in deferred mode.
+ */
+const size_t LOG_RING_SIZE = 32;
+
+/**
+ * Log messages waiting to be printed by the logging thread.
+ */
+extern DeferredLog::Ring<LOG_RING_SIZE> logRing;
+
+/**
+ * Active deferred logging, see deferLogging().
+ */
+extern bool isLogDeferred;
+
+/**
+ * Microseconds since startup, for timestamping deferred log messages.
+ */
+uint32_t logTimestamp();
+
+/**
+ * Turns deferred logging on or off.  When it's on, log messages whose
+ * arguments can be copied are stored and printed later by a low-priority
+ * thread, which is started the first time this is called.
+ */
+void deferLogging(bool defer);
+
+template <class... Args>
+void logDispatch(std::true_type, uint8_t logLevel, const char* source,
+                 int line, const char* func, const char* format,
+                 Args... args) {
+    if (!isLogDeferred) {
+        logNow(logLevel, source, line, func, format, args...);
+        return;
+    }
+
+    uint32_t time = logTimestamp();
+    logRing.push([&](DeferredLog::Record& record) {
+        record.time = time;
+        record.format = format;
+        record.source = source;
+        record.func = func;
+        record.line = line;
+        record.level = logLevel;
+        DeferredLog::storeArgs(record, 0, args...);
+    });
+}
+
+template <class... Args>
+void logDispatch(std::false_type, uint8_t logLevel, const char* source,
+                 int line, const char* func, const char* format,
+                 Args... args) {
+    logNow(logLevel, source, line, func, format, args...);
+}
+
 /**
  * The system-wide logging interface function. All log messages go through
  * this.
@@ -92,7 +158,13 @@ private:
  * @param source   The source of the message.
  * @param format   The string format for displaying the log message.
  */
+template <class... Args>
 void log(uint8_t logLevel, const char* source, int line, const char* func,
-         const char* format, ...);
+         const char* format, Args... args) {
+    if (isLogging && logLevel <= rjLogLevel) {
+        logDispatch(DeferredLog::Deferrable<Args...>(), logLevel, source, line,
+                    func, format, args...);
+    }
+}
 
 int logLvlChange(const std::string& s);
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compact forward packets from soccer to the robots, passed through the base
+ * station.
+ *
+ * Only robots whose commands changed are sent, so a packet holds from zero to
+ * MaxCommands commands:
+ *
+ *   byte 0     1sssnnnn  s: sequence number, n: number of commands
+ *
+ *   Seven bytes per command:
+ *   byte 0-2   low 8 bits of the body X, Y and W velocities
+ *   byte 3     CTwwyyxx  high 2 bits of each velocity, T: trigger
+ *                        immediately, C: chip instead of kick
+ *   byte 4     ddddrrrr  d: top 4 bits of the dribbler speed, r: shell
+ *   byte 5     kick strength
+ *   byte 6     0000000s  s: play a song
+ *
+ * Velocities are 10-bit two's complement in the units of the old fixed-size
+ * packets.  The first byte of those is a 3-bit sequence number, so the top
+ * bit tells the two formats apart.  Trajectory packets (see TrajectoryPacket)
+ * start with 01 instead.
+ */
+namespace RadioProtocol {
+
+const uint8_t CompactFlag = 0x80;
+
+const size_t HeaderSize = 1;
+const size_t CommandSize = 7;
+
+/// Robots that can be commanded in one packet.  This keeps compact packets no
+/// larger than the old six-robot packets.
+const size_t MaxCommands = 6;
+
+const size_t MaxPacketSize = HeaderSize + MaxCommands * CommandSize;
+
+/// Largest magnitude of a velocity
+const int MaxVelocity = 511;
+
+/// Velocities are in encoder ticks per control cycle.  X and Y are for a wheel
+/// at 45 degrees, so a body velocity of v m/s is
+/// v * SecondsPerCycle / MetersPerTick / sqrt(2) units, and w rad/s is
+/// w * SecondsPerCycle / RadiansPerTick units.
+const float SecondsPerCycle = 0.005f;
+const float MetersPerTick = 0.026f * 2 * 3.141592653589793 / 6480.0f;
+const float RadiansPerTick = 0.026f * 3.141592653589793 / (0.0812f * 3240.0f);
+
+struct RobotCommand {
+    uint8_t shell = 0;
+    int16_t bodyX = 0;
+    int16_t bodyY = 0;
+    int16_t bodyW = 0;
+
+    /// Only the top 4 bits are sent
+    uint8_t dribbler = 0;
+
+    uint8_t kickStrength = 0;
+    bool chip = false;
+    bool immediate = false;
+    bool song = false;
+
+    bool operator==(const RobotCommand& other) const {
+        return shell == other.shell && bodyX == other.bodyX &&
+               bodyY == other.bodyY && bodyW == other.bodyW &&
+               (dribbler & 0xf0) == (other.dribbler & 0xf0) &&
+               kickStrength == other.kickStrength && chip == other.chip &&
+               immediate == other.immediate && song == other.song;
+    }
+
+    bool operator!=(const RobotCommand& other) const {
+        return !(*this == other);
+    }
+};
+
+/// Sign-extends a 10-bit velocity from its low byte and the two bits above it
+inline int16_t extend(uint8_t low, uint8_t high) {
+    int16_t value = low | (high & 3) << 8;
+    if (high & 2) {
+        value |= 0xfc00;
+    }
+    return value;
+}
+
+/// True if <buf> holds a compact packet instead of an old fixed-size one
+inline bool isCompact(const uint8_t* buf, size_t size) {
+    return size >= HeaderSize && (buf[0] & CompactFlag);
+}
+
+/// Writes a command's CommandSize bytes
+inline void packCommand(const RobotCommand& cmd, uint8_t* buf) {
+    buf[0] = cmd.bodyX & 0xff;
+    buf[1] = cmd.bodyY & 0xff;
+    buf[2] = cmd.bodyW & 0xff;
+    buf[3] = ((cmd.bodyX & 0x300) >> 8) | ((cmd.bodyY & 0x300) >> 6) |
+             ((cmd.bodyW & 0x300) >> 4) | (cmd.immediate << 6) |
+             (cmd.chip << 7);
+    buf[4] = (cmd.dribbler & 0xf0) | (cmd.shell & 0x0f);
+    buf[5] = cmd.kickStrength;
+    buf[6] = cmd.song;
+}
+
+/// Reads a command written by packCommand()
+inline void unpackCommand(const uint8_t* buf, RobotCommand& cmd) {
+    cmd.bodyX = extend(buf[0], buf[3]);
+    cmd.bodyY = extend(buf[1], buf[3] >> 2);
+    cmd.bodyW = extend(buf[2], buf[3] >> 4);
+    cmd.immediate = buf[3] & (1 << 6);
+    cmd.chip = buf[3] & (1 << 7);
+    cmd.dribbler = buf[4] & 0xf0;
+    cmd.shell = buf[4] & 0x0f;
+    cmd.kickStrength = buf[5];
+    cmd.song = buf[6] & 1;
+}
+
+struct ForwardPacket {
+    uint8_t sequence = 0;
+    uint8_t count = 0;
+    RobotCommand commands[MaxCommands];
+
+    size_t size() const { return HeaderSize + count * CommandSize; }
+
+    /// Writes the packet to <buf> and returns its size, or zero if it doesn't
+    /// fit
+    size_t pack(uint8_t* buf, size_t bufSize) const {
+        if (count > MaxCommands || size() > bufSize) {
+            return 0;
+        }
+
+        *buf++ = CompactFlag | (sequence & 7) << 4 | count;
+        for (size_t i = 0; i < count; ++i) {
+            packCommand(commands[i], buf);
+            buf += CommandSize;
+        }
+
+        return size();
+    }
+
+    /// Reads a packet written by pack().  Returns false if <buf> doesn't hold
+    /// a whole compact packet.
+    bool unpack(const uint8_t* buf, size_t bufSize) {
+        if (!isCompact(buf, bufSize)) {
+            return false;
+        }
+
+        uint8_t n = buf[0] & 0x0f;
+        if (n > MaxCommands || bufSize < HeaderSize + n * CommandSize) {
+            return false;
+        }
+
+        sequence = (buf[0] >> 4) & 7;
+        count = n;
+        ++buf;
+        for (size_t i = 0; i < count; ++i) {
+            unpackCommand(buf, commands[i]);
+            buf += CommandSize;
+        }
+
+        return true;
+    }
+};
+
+/// Old fixed-size packets have a sequence number and a 9-byte slot for each
+/// of six robots
+const size_t FullSlotSize = 9;
+const size_t FullSlots = 6;
+const size_t FullPacketSize = HeaderSize + FullSlots * FullSlotSize;
+
+const uint8_t TrajectoryMask = 0xc0;
+const uint8_t TrajectoryFlag = 0x40;
+
+const size_t SegmentSize = 16;
+
+/// Robots that can be sent in one trajectory packet.  This keeps trajectory
+/// packets no larger than the old six-robot packets.
+const size_t MaxSegments = 3;
+
+const size_t MaxTrajectorySize = HeaderSize + MaxSegments * SegmentSize;
+
+/// True if <buf> holds a trajectory packet
+inline bool isTrajectory(const uint8_t* buf, size_t size) {
+    return size >= HeaderSize && (buf[0] & TrajectoryMask) == TrajectoryFlag;
+}
+
+/// Body velocities in radio units
+struct Velocity {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t w = 0;
+
+    bool operator==(const Velocity& other) const {
+        return x == other.x && y == other.y && w == other.w;
+    }
+};
+
+/// Rounds a velocity in radio units and clamps it to MaxVelocity.  NaN
+/// becomes zero.
+inline int16_t roundVelocity(float value) {
+    if (std::isnan(value)) {
+        return 0;
+    }
+    value = roundf(value);
+    if (value > MaxVelocity) {
+        return MaxVelocity;
+    }
+    if (value < -MaxVelocity) {
+        return -MaxVelocity;
+    }
+    return value;
+}
+
+/// Converts body velocities in m/s and rad/s, as soccer commands them, to
+/// radio units
+inline Velocity toRadio(float x, float y, float w) {
+    Velocity v;
+    v.x = roundVelocity(x * SecondsPerCycle / MetersPerTick / sqrtf(2));
+    v.y = roundVelocity(y * SecondsPerCycle / MetersPerTick / sqrtf(2));
+    v.w = roundVelocity(w * SecondsPerCycle / RadiansPerTick);
+    return v;
+}
+
+/**
+ * Returns the value <cycle> control cycles into a segment <length> cycles
+ * long, on the quadratic through <start>, <middle> and <end> at its start,
+ * halfway through, and at its end.  After the end, this is <end>.
+ *
+ * This is all integer math so the robot, the simulator, and soccer get the
+ * same answer.
+ */
+inline int16_t interpolate(int start, int middle, int end, uint32_t cycle,
+                           uint8_t length) {
+    if (cycle >= length) {
+        return end;
+    }
+
+    // Lagrange form, scaled by length^2
+    int32_t c = cycle;
+    int32_t t = length;
+    int32_t num = start * (t - c) * (t - 2 * c) + 4 * middle * c * (t - c) +
+                  end * c * (2 * c - t);
+    int32_t den = t * t;
+    int32_t value = num >= 0 ? (num + den / 2) / den : -((den / 2 - num) / den);
+
+    // The curve can overshoot its points
+    if (value > MaxVelocity) {
+        return MaxVelocity;
+    }
+    if (value < -MaxVelocity) {
+        return -MaxVelocity;
+    }
+    return value;
+}
+
+/**
+ * A piece of a robot's planned motion.  It starts when the robot receives
+ * it, and the robot drives along it until the next one arrives, so lost
+ * packets don't stop the robot and soccer doesn't need to send every frame.
+ */
+struct TrajectorySegment {
+    /// The command, with the velocities at the start of the segment
+    RobotCommand command;
+
+    /// Length in control cycles.  Zero holds the command's velocities.
+    uint8_t length = 0;
+
+    /// Velocities halfway through and at the end
+    Velocity middle;
+    Velocity end;
+
+    /// A segment that holds a command's velocities
+    static TrajectorySegment hold(const RobotCommand& cmd) {
+        TrajectorySegment segment;
+        segment.command = cmd;
+        segment.middle = segment.start();
+        segment.end = segment.start();
+        return segment;
+    }
+
+    Velocity start() const {
+        Velocity v;
+        v.x = command.bodyX;
+        v.y = command.bodyY;
+        v.w = command.bodyW;
+        return v;
+    }
+
+    /// Velocities <cycle> control cycles after the segment starts
+    Velocity at(uint32_t cycle) const {
+        Velocity v;
+        v.x = interpolate(command.bodyX, middle.x, end.x, cycle, length);
+        v.y = interpolate(command.bodyY, middle.y, end.y, cycle, length);
+        v.w = interpolate(command.bodyW, middle.w, end.w, cycle, length);
+        return v;
+    }
+};
+
+/// Builds the segment from <cmd>'s velocities through <middle> to <end> over
+/// <duration> seconds, as soccer plans it.  The length is rounded to whole
+/// control cycles and clamped to what fits in a segment.
+inline TrajectorySegment toSegment(const RobotCommand& cmd, float duration,
+                                   const Velocity& middle,
+                                   const Velocity& end) {
+    TrajectorySegment segment;
+    segment.command = cmd;
+    segment.middle = middle;
+    segment.end = end;
+
+    float cycles = roundf(duration / SecondsPerCycle);
+    if (std::isnan(cycles) || cycles <= 0) {
+        segment.length = 0;
+    } else if (cycles >= 255) {
+        segment.length = 255;
+    } else {
+        segment.length = cycles;
+    }
+    return segment;
+}
+
+/**
+ * Trajectory packets send a TrajectorySegment for each robot instead of one
+ * velocity:
+ *
+ *   byte 0     01sssnnn  s: sequence number, n: number of segments
+ *
+ *   Sixteen bytes per segment:
+ *   byte 0-6   the command, as in compact packets, with the velocities at
+ *              the start of the segment
+ *   byte 7     length of the segment in control cycles
+ *   byte 8-10  low 8 bits of the X, Y and W velocities halfway through
+ *   byte 11    00wwyyxx  high 2 bits of those velocities
+ *   byte 12-15 the velocities at the end, in the same way
+ */
+struct TrajectoryPacket {
+    uint8_t sequence = 0;
+    uint8_t count = 0;
+    TrajectorySegment segments[MaxSegments];
+
+    size_t size() const { return HeaderSize + count * SegmentSize; }
+
+    /// Writes the packet to <buf> and returns its size, or zero if it doesn't
+    /// fit
+    size_t pack(uint8_t* buf, size_t bufSize) const {
+        if (count > MaxSegments || size() > bufSize) {
+            return 0;
+        }
+
+        *buf++ = TrajectoryFlag | (sequence & 7) << 3 | count;
+        for (size_t i = 0; i < count; ++i) {
+            const TrajectorySegment& segment = segments[i];
+            packCommand(segment.command, buf);
+            buf[7] = segment.length;
+            packVelocity(segment.middle, buf + 8);
+            packVelocity(segment.end, buf + 12);
+            buf += SegmentSize;
+        }
+
+        return size();
+    }
+
+    /// Reads a packet written by pack().  Returns false if <buf> doesn't hold
+    /// a whole trajectory packet.
+    bool unpack(const uint8_t* buf, size_t bufSize) {
+        if (!isTrajectory(buf, bufSize)) {
+            return false;
+        }
+
+        uint8_t n = buf[0] & 7;
+        if (n > MaxSegments || bufSize < HeaderSize + n * SegmentSize) {
+            return false;
+        }
+
+        sequence = (buf[0] >> 3) & 7;
+        count = n;
+        ++buf;
+        for (size_t i = 0; i < count; ++i) {
+            TrajectorySegment& segment = segments[i];
+            unpackCommand(buf, segment.command);
+            segment.length = buf[7];
+            unpackVelocity(buf + 8, segment.middle);
+            unpackVelocity(buf + 12, segment.end);
+            buf += SegmentSize;
+        }
+
+        return true;
+    }
+
+private:
+    static void packVelocity(const Velocity& v, uint8_t* buf) {
+        buf[0] = v.x & 0xff;
+        buf[1] = v.y & 0xff;
+        buf[2] = v.w & 0xff;
+        buf[3] = ((v.x & 0x300) >> 8) | ((v.y & 0x300) >> 6) |
+                 ((v.w & 0x300) >> 4);
+    }
+
+    static void unpackVelocity(const uint8_t* buf, Velocity& v) {
+        v.x = extend(buf[0], buf[3]);
+        v.y = extend(buf[1], buf[3] >> 2);
+        v.w = extend(buf[2], buf[3] >> 4);
+    }
+};
+
+/// Finds the command for <shell> in a forward packet of any format.  Returns
+/// false if the packet doesn't have one.
+inline bool findCommand(const uint8_t* buf, size_t size, uint8_t shell,
+                        RobotCommand& cmd) {
+    if (isTrajectory(buf, size)) {
+        TrajectoryPacket packet;
+        if (!packet.unpack(buf, size)) {
+            return false;
+        }
+        for (size_t i = 0; i < packet.count; ++i) {
+            if (packet.segments[i].command.shell == shell) {
+                cmd = packet.segments[i].command;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (isCompact(buf, size)) {
+        ForwardPacket packet;
+        if (!packet.unpack(buf, size)) {
+            return false;
+        }
+        for (size_t i = 0; i < packet.count; ++i) {
+            if (packet.commands[i].shell == shell) {
+                cmd = packet.commands[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (size < FullPacketSize) {
+        return false;
+    }
+    for (size_t i = 0; i < FullSlots; ++i) {
+        const uint8_t* slot = buf + HeaderSize + i * FullSlotSize;
+        if ((slot[4] & 0x0f) != shell) {
+            continue;
+        }
+
+        cmd.shell = shell;
+        cmd.bodyX = extend(slot[0], slot[3]);
+        cmd.bodyY = extend(slot[1], slot[3] >> 2);
+        cmd.bodyW = extend(slot[2], slot[3] >> 4);
+        cmd.dribbler = slot[4] & 0xf0;
+        cmd.kickStrength = slot[5];
+        cmd.chip = slot[6] & 1;
+        cmd.immediate = slot[6] & 2;
+        cmd.song = slot[6] & 4;
+        return true;
+    }
+    return false;
+}
+
+/// Finds the segment for <shell> in a forward packet of any format.  Packets
+/// without trajectories hold the command's velocities.  Returns false if the
+/// packet doesn't have anything for <shell>.
+inline bool findSegment(const uint8_t* buf, size_t size, uint8_t shell,
+                        TrajectorySegment& segment) {
+    if (!isTrajectory(buf, size)) {
+        RobotCommand cmd;
+        if (!findCommand(buf, size, shell, cmd)) {
+            return false;
+        }
+        segment = TrajectorySegment::hold(cmd);
+        return true;
+    }
+
+    TrajectoryPacket packet;
+    if (!packet.unpack(buf, size)) {
+        return false;
+    }
+    for (size_t i = 0; i < packet.count; ++i) {
+        if (packet.segments[i].command.shell == shell) {
+            segment = packet.segments[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace RadioProtocol
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "radio-protocol.hpp"
+
+/**
+ * How the base station shares the radio between soccer's commands and the
+ * robots' replies.
+ *
+ * Time is divided into frames.  A frame starts with one forward packet that
+ * carries the newest command or trajectory segment for up to MaxCommands or
+ * MaxSegments robots.  Each robot in the packet then has its own slot to reply
+ * in, in the order of its command, so replies don't collide.  Reverse packets
+ * are passed to soccer several at a time instead of in one USB transfer each.
+ *
+ * Times are in microseconds from a free-running counter like us_ticker_read()
+ * and may wrap around.
+ */
+namespace RadioSchedule {
+
+/// Time to send a forward packet and for the robots to decode it
+const uint32_t ForwardTime = 1500;
+
+/// Length of each robot's reply slot
+const uint32_t SlotTime = 1000;
+
+/// Size of the reverse packets passed to soccer
+const size_t ReversePacketSize = 9;
+
+/// Largest USB bulk transfer (MAX_PACKET_SIZE_EPBULK).  Soccer reads reverse
+/// packets one after another from a transfer of up to this size.
+const size_t MaxTransferSize = 64;
+
+const size_t MaxBatch = MaxTransferSize / ReversePacketSize;
+
+/// Longest a reverse packet waits for others to be sent with it
+const uint32_t MaxBatchDelay = 5000;
+
+const size_t NumShells = 16;
+
+/// Slots in a frame
+const size_t MaxSlots = RadioProtocol::MaxCommands > RadioProtocol::FullSlots
+                            ? RadioProtocol::MaxCommands
+                            : RadioProtocol::FullSlots;
+
+/// Start of a reply slot after the start of its frame
+inline uint32_t slotStart(size_t slot) { return ForwardTime + slot * SlotTime; }
+
+/**
+ * Lists the shells a forward packet of any format has commands for, in the
+ * order of their reply slots.  Returns how many were written to <shells>,
+ * which has room for MaxSlots.
+ */
+inline size_t slotShells(const uint8_t* buf, size_t size, uint8_t* shells) {
+    using namespace RadioProtocol;
+
+    if (isTrajectory(buf, size)) {
+        TrajectoryPacket packet;
+        if (!packet.unpack(buf, size)) {
+            return 0;
+        }
+        for (size_t i = 0; i < packet.count; ++i) {
+            shells[i] = packet.segments[i].command.shell;
+        }
+        return packet.count;
+    }
+
+    if (isCompact(buf, size)) {
+        ForwardPacket packet;
+        if (!packet.unpack(buf, size)) {
+            return 0;
+        }
+        for (size_t i = 0; i < packet.count; ++i) {
+            shells[i] = packet.commands[i].shell;
+        }
+        return packet.count;
+    }
+
+    if (size < FullPacketSize) {
+        return 0;
+    }
+    for (size_t i = 0; i < FullSlots; ++i) {
+        shells[i] = buf[HeaderSize + i * FullSlotSize + 4] & 0x0f;
+    }
+    return FullSlots;
+}
+
+/**
+ * What the base station has done since it started, returned for the
+ * ReadCounters USB request.  Both ends are little-endian, so this is sent as
+ * it is in memory.
+ */
+struct Counters {
+    /// Forward packets from soccer, and those that were malformed
+    uint32_t usbReads = 0;
+    uint32_t badPackets = 0;
+
+    /// Robot commands in compact and trajectory packets, and those replaced
+    /// by a newer command for the same robot before they were sent
+    uint32_t commands = 0;
+    uint32_t replaced = 0;
+
+    /// Forward packets sent over the radio
+    uint32_t frames = 0;
+
+    /// Reverse packets from the radio, and those dropped because they were
+    /// the wrong size or there was no room for them
+    uint32_t reversePackets = 0;
+    uint32_t droppedReverse = 0;
+
+    /// Replies that came outside their robot's slot
+    uint32_t lateReplies = 0;
+
+    /// Slots that ended without a reply
+    uint32_t missedSlots = 0;
+
+    /// Bulk transfers of reverse packets to soccer
+    uint32_t usbWrites = 0;
+
+    /// Time from a command arriving over USB until it was sent over the
+    /// radio, in microseconds
+    uint32_t lastForwardLatency = 0;
+    uint32_t maxForwardLatency = 0;
+
+    /// Longest a reverse packet waited to be sent to soccer, in microseconds
+    uint32_t maxReverseLatency = 0;
+};
+
+static_assert(sizeof(Counters) == 13 * sizeof(uint32_t),
+              "Counters must not be padded");
+
+/**
+ * Decides what the base station sends and when.
+ *
+ * Commands from soccer wait for the next frame, and a newer command for the
+ * same robot replaces an older one.  A frame starts once the last frame's
+ * reply slots are over, with the robots that have waited longest.  Each frame
+ * has one format, so commands and trajectory segments are sent in separate
+ * frames.  Old fixed-size packets already hold every robot, so they are sent
+ * as they are in a frame of their own.
+ */
+class Scheduler {
+public:
+    /// Takes a forward packet read from USB.  Returns false if it was
+    /// malformed and dropped.
+    bool forward(const uint8_t* buf, size_t size, uint32_t now) {
+        using namespace RadioProtocol;
+
+        ++_counters.usbReads;
+
+        if (isTrajectory(buf, size)) {
+            TrajectoryPacket packet;
+            if (!packet.unpack(buf, size)) {
+                ++_counters.badPackets;
+                return false;
+            }
+            for (size_t i = 0; i < packet.count; ++i) {
+                queue(packet.segments[i], true, now);
+            }
+            return true;
+        }
+
+        if (!isCompact(buf, size)) {
+            if (size != FullPacketSize) {
+                ++_counters.badPackets;
+                return false;
+            }
+            memcpy(_full, buf, size);
+            if (!_hasFull) {
+                _hasFull = true;
+                _fullTime = now;
+            }
+            return true;
+        }
+
+        ForwardPacket packet;
+        if (!packet.unpack(buf, size)) {
+            ++_counters.badPackets;
+            return false;
+        }
+
+        for (size_t i = 0; i < packet.count; ++i) {
+            queue(TrajectorySegment::hold(packet.commands[i]), false, now);
+        }
+        return true;
+    }
+
+    /**
+     * If a frame is due, writes its forward packet to <buf> and returns its
+     * size.  Otherwise returns zero.  <bufSize> must be at least
+     * FullPacketSize.
+     */
+    size_t nextFrame(uint32_t now, uint8_t* buf, size_t bufSize) {
+        using namespace RadioProtocol;
+
+        endFrame(now);
+        if (_inFrame || bufSize < FullPacketSize) {
+            return 0;
+        }
+
+        size_t size;
+        uint32_t arrived;
+        if (_hasFull) {
+            memcpy(buf, _full, FullPacketSize);
+            size = FullPacketSize;
+            arrived = _fullTime;
+            _hasFull = false;
+        } else {
+            // The frame has the format of the command that waited longest
+            Pending* first = oldest(now, nullptr);
+            if (!first) {
+                return 0;
+            }
+            arrived = first->time;
+            bool trajectory = first->trajectory;
+
+            if (trajectory) {
+                TrajectoryPacket packet;
+                packet.sequence = _sequence++;
+                while (packet.count < MaxSegments) {
+                    Pending* next = oldest(now, &trajectory);
+                    if (!next) {
+                        break;
+                    }
+                    packet.segments[packet.count++] = next->segment;
+                    next->waiting = false;
+                }
+                size = packet.pack(buf, bufSize);
+            } else {
+                ForwardPacket packet;
+                packet.sequence = _sequence++;
+                while (packet.count < MaxCommands) {
+                    Pending* next = oldest(now, &trajectory);
+                    if (!next) {
+                        break;
+                    }
+                    packet.commands[packet.count++] = next->segment.command;
+                    next->waiting = false;
+                }
+                size = packet.pack(buf, bufSize);
+            }
+        }
+
+        _inFrame = true;
+        _frameStart = now;
+        _frameSlots = slotShells(buf, size, _frameShells);
+        for (bool& replied : _replied) {
+            replied = false;
+        }
+
+        ++_counters.frames;
+        _counters.lastForwardLatency = now - arrived;
+        if (_counters.lastForwardLatency > _counters.maxForwardLatency) {
+            _counters.maxForwardLatency = _counters.lastForwardLatency;
+        }
+        return size;
+    }
+
+    /// Takes a reverse packet received over the radio.  Returns false if it
+    /// was dropped.
+    bool reverse(const uint8_t* buf, size_t size, uint32_t now) {
+        if (size != ReversePacketSize || _batchCount == MaxBatch) {
+            ++_counters.droppedReverse;
+            return false;
+        }
+        ++_counters.reversePackets;
+
+        // The reply should be in its robot's slot of this frame
+        uint8_t shell = buf[0] & 0x0f;
+        bool inSlot = false;
+        if (_inFrame) {
+            uint32_t elapsed = now - _frameStart;
+            for (size_t i = 0; i < _frameSlots; ++i) {
+                if (_frameShells[i] == shell && !_replied[i] &&
+                    elapsed >= slotStart(i) && elapsed < slotStart(i + 1)) {
+                    _replied[i] = true;
+                    inSlot = true;
+                    break;
+                }
+            }
+        }
+        if (!inSlot) {
+            ++_counters.lateReplies;
+        }
+
+        if (!_batchCount) {
+            _batchTime = now;
+        }
+        memcpy(_batch + _batchCount * ReversePacketSize, buf, size);
+        ++_batchCount;
+        return true;
+    }
+
+    /**
+     * If reverse packets should be sent to soccer now, writes them to <buf>
+     * and returns their total size.  Otherwise returns zero.  They are sent
+     * once the transfer is full, the frame's replies are over, or the oldest
+     * has waited MaxBatchDelay.  <bufSize> must be at least MaxTransferSize.
+     */
+    size_t takeBatch(uint32_t now, uint8_t* buf, size_t bufSize) {
+        endFrame(now);
+
+        if (!_batchCount || bufSize < MaxTransferSize) {
+            return 0;
+        }
+        uint32_t waited = now - _batchTime;
+        if (_batchCount < MaxBatch && _inFrame && waited < MaxBatchDelay) {
+            return 0;
+        }
+
+        size_t size = _batchCount * ReversePacketSize;
+        memcpy(buf, _batch, size);
+        _batchCount = 0;
+
+        ++_counters.usbWrites;
+        if (waited > _counters.maxReverseLatency) {
+            _counters.maxReverseLatency = waited;
+        }
+        return size;
+    }
+
+    /// True while the current frame's reply slots aren't over
+    bool inFrame() const { return _inFrame; }
+
+    /// Robots whose commands are waiting for a frame
+    size_t waiting() const {
+        size_t count = 0;
+        for (const Pending& pending : _pending) {
+            count += pending.waiting;
+        }
+        return count;
+    }
+
+    const Counters& counters() const { return _counters; }
+
+private:
+    struct Pending {
+        bool waiting = false;
+
+        // A plain command is a segment that holds its velocities
+        RadioProtocol::TrajectorySegment segment;
+        bool trajectory = false;
+
+        // When the first command that hasn't been sent arrived
+        uint32_t time = 0;
+    };
+
+    // Makes <segment> the next thing sent to its robot
+    void queue(RadioProtocol::TrajectorySegment segment, bool trajectory,
+               uint32_t now) {
+        using namespace RadioProtocol;
+
+        RobotCommand& cmd = segment.command;
+        Pending& pending = _pending[cmd.shell];
+        ++_counters.commands;
+
+        if (pending.waiting) {
+            ++_counters.replaced;
+
+            // A kick or song that hasn't gone out yet isn't lost
+            const RobotCommand& old = pending.segment.command;
+            if (old.immediate && !cmd.immediate) {
+                cmd.immediate = true;
+                cmd.chip = old.chip;
+                cmd.kickStrength = old.kickStrength;
+            }
+            cmd.song = cmd.song || old.song;
+        } else {
+            pending.waiting = true;
+            pending.time = now;
+        }
+        pending.segment = segment;
+        pending.trajectory = trajectory;
+    }
+
+    // The command that has waited longest, of any format or only those
+    // with the same <trajectory>
+    Pending* oldest(uint32_t now, const bool* trajectory) {
+        Pending* oldest = nullptr;
+        for (Pending& pending : _pending) {
+            if (pending.waiting &&
+                (!trajectory || pending.trajectory == *trajectory) &&
+                (!oldest || now - pending.time > now - oldest->time)) {
+                oldest = &pending;
+            }
+        }
+        return oldest;
+    }
+
+    // Ends the frame once its reply slots are over
+    void endFrame(uint32_t now) {
+        if (!_inFrame || now - _frameStart < slotStart(_frameSlots)) {
+            return;
+        }
+
+        _inFrame = false;
+        for (size_t i = 0; i < _frameSlots; ++i) {
+            _counters.missedSlots += !_replied[i];
+        }
+    }
+
+    Pending _pending[NumShells];
+
+    // An old fixed-size packet waiting to be sent
+    uint8_t _full[RadioProtocol::FullPacketSize];
+    bool _hasFull = false;
+    uint32_t _fullTime = 0;
+
+    uint8_t _sequence = 0;
+
+    bool _inFrame = false;
+    uint32_t _frameStart = 0;
+    uint8_t _frameShells[MaxSlots];
+    bool _replied[MaxSlots];
+    size_t _frameSlots = 0;
+
+    uint8_t _batch[MaxBatch * ReversePacketSize];
+    size_t _batchCount = 0;
+    uint32_t _batchTime = 0;
+
+    Counters _counters;
+};
+}
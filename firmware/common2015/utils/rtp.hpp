@@ -1,15 +1,18 @@
 #pragma once
 
 #include <cstdint>
-#include <vector>
+#include <cstring>
+#include <initializer_list>
 #include <string>
+#include <vector>
 
 #define BASE_STATION_ADDR (1)
 #define LOOPBACK_ADDR (127)
 
 namespace rtp {
 
-/// Max packet size.  This is limited by the CC1201 buffer size.
+/// Max packet size, including the size byte and header.  This is limited by
+/// the CC1201 buffer size.
 static const unsigned int MAX_DATA_SZ = 120;
 
 const uint8_t BROADCAST_ADDRESS = 0;
@@ -40,15 +43,17 @@ struct header_data {
     Type type : 4;
 
     /// "packed" size (in bytes) of header data
-    size_t size() const { return 2; }
-
-    void pack(std::vector<uint8_t>* buf) const {
-        buf->push_back(address);
-        buf->push_back(port << 4 | type);
+    static const size_t SIZE = 2;
+    size_t size() const { return SIZE; }
+
+    /// Writes the header to <buf> and returns the byte after it
+    uint8_t* pack(uint8_t* buf) const {
+        *buf++ = address;
+        *buf++ = port << 4 | type;
+        return buf;
     }
 
-    void unpack(const std::vector<uint8_t>& buf) { unpack(buf.data()); }
-
+    /// Reads the header from a packed packet, which starts with the size byte
     void unpack(const uint8_t* buf) {
         address = buf[1];
         port = buf[2] >> 4;
@@ -56,18 +61,89 @@ struct header_data {
     }
 };
 
+/**
+ * @brief Payload of a packet, stored inline
+ *
+ * @details This has the parts of std::vector's interface that packets need,
+ * but never allocates, so packets can be copied into mail slots and ISR-side
+ * buffers.  Data that doesn't fit is dropped and reported by the return
+ * value.
+ */
+class payload_buffer {
+public:
+    /// Room for the payload after the size byte and header
+    static const size_t CAPACITY = MAX_DATA_SZ - 1 - header_data::SIZE;
+
+    payload_buffer() : _size(0) {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    static size_t capacity() { return CAPACITY; }
+
+    uint8_t* data() { return _data; }
+    const uint8_t* data() const { return _data; }
+
+    uint8_t* begin() { return _data; }
+    uint8_t* end() { return _data + _size; }
+    const uint8_t* begin() const { return _data; }
+    const uint8_t* end() const { return _data + _size; }
+
+    uint8_t& operator[](size_t i) { return _data[i]; }
+    const uint8_t& operator[](size_t i) const { return _data[i]; }
+
+    void clear() { _size = 0; }
+
+    /// Sets the size after writing to data().  Returns false if <n> is more
+    /// than the capacity, in which case the size is the capacity.
+    bool resize(size_t n) {
+        _size = n < CAPACITY ? n : CAPACITY;
+        return n <= CAPACITY;
+    }
+
+    bool push_back(uint8_t value) {
+        if (_size == CAPACITY) {
+            return false;
+        }
+        _data[_size++] = value;
+        return true;
+    }
+
+    /// Replaces the contents with <n> bytes from <src>
+    bool assign(const uint8_t* src, size_t n) {
+        bool fits = resize(n);
+        memcpy(_data, src, _size);
+        return fits;
+    }
+
+private:
+    uint8_t _size;
+    uint8_t _data[CAPACITY];
+};
+
 /**
  * @brief Real-Time packet definition
+ *
+ * @details Packets have a fixed size and are trivially copyable, so they can
+ * be constructed in place in RTOS mail slots.
  */
 class packet {
 public:
     rtp::header_data header;
-    std::vector<uint8_t> payload;
+    payload_buffer payload;
 
     packet(){};
     packet(const std::string& s, uint8_t p = SINK) : header(p) {
-        for (char c : s) payload.push_back(c);
-        payload.push_back('\0');
+        payload.assign(reinterpret_cast<const uint8_t*>(s.c_str()),
+                       s.size() + 1);
+    }
+
+    packet(const uint8_t* data, size_t size, uint8_t p = SINK) : header(p) {
+        payload.assign(data, size);
+    }
+
+    packet(std::initializer_list<uint8_t> data, uint8_t p = SINK)
+        : header(p) {
+        payload.assign(data.begin(), data.size());
     }
 
     template <class T>
@@ -88,32 +164,40 @@ public:
     void address(int a) { header.address = static_cast<unsigned int>(a); }
 
     template <class T>
-    void recv(const std::vector<T>& v) {
-        recv(v.data(), v.size());
+    bool recv(const std::vector<T>& v) {
+        return recv(v.data(), v.size());
     }
 
-    void recv(const uint8_t* buffer, size_t size) {
+    /// Reads a packet written by pack().  Returns false if <buffer> is too
+    /// short to hold a header or the payload doesn't fit.
+    bool recv(const uint8_t* buffer, size_t size) {
         // note: header ignores the first byte since it's the size byte
+        if (size < header.size() + 1) {
+            payload.clear();
+            return false;
+        }
         header.unpack(buffer);
 
         // Everything after the header is payload data
-        payload.clear();
-        for (size_t i = header.size() + 1; i < size; i++) {
-            payload.push_back(buffer[i]);
-        }
+        const size_t start = header.size() + 1;
+        return payload.assign(buffer + start, size - start);
     }
 
-    void pack(std::vector<uint8_t>* buffer) const {
+    /// Writes the size byte, header, and payload to <buffer>.  Returns the
+    /// number of bytes written, or zero if they don't fit in <bufferSize>.
+    size_t pack(uint8_t* buffer, size_t bufferSize) const {
         // first byte is total size (excluding the size byte)
-        const uint8_t total_size = payload.size() + header.size();
-        buffer->reserve(total_size + 1);
-
-        buffer->push_back(total_size);
+        const size_t total_size = payload.size() + header.size();
+        if (total_size + 1 > bufferSize) {
+            return 0;
+        }
 
-        header.pack(buffer);
+        *buffer++ = total_size;
+        buffer = header.pack(buffer);
 
         // payload
-        buffer->insert(buffer->end(), payload.begin(), payload.end());
+        memcpy(buffer, payload.data(), payload.size());
+        return total_size + 1;
     }
 };
 }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Closed-loop wheel velocity control for the 2015 robots, in fixed point.
+ *
+ * Velocities are in the units of the radio protocol (see radio-protocol.hpp),
+ * which are encoder ticks per control cycle for a wheel at 45 degrees.  Body
+ * velocities are converted to wheel velocities with the wheel layout in
+ * doc/wheel_layout.txt:
+ *
+ *   /0   1\
+ *     x > >
+ *   \3   2/
+ *
+ * Each wheel then has a PI controller with feedforward from its target
+ * velocity.  The output is a signed duty cycle, which dutyCycle() converts to
+ * the FPGA's format.
+ *
+ * Nothing here needs mbed, so the controller is tested on the host.
+ */
+namespace WheelControl {
+
+const size_t NumWheels = 4;
+
+/// Fixed point scale of the gains and the integrators
+const int Scale = 256;
+
+/// Largest magnitude of a duty cycle
+const int MaxDuty = 511;
+
+/// Bit in an FPGA duty cycle that reverses the motor
+const uint16_t DutyReverse = 1 << 9;
+
+/// Coefficients of the body X and Y velocities in each wheel's velocity,
+/// scaled by 4096.  They are sqrt(2) * sin and sqrt(2) * cos of each axle's
+/// angle from the X axis, so a 45 degree wheel has coefficients of one, and
+/// the signs come from each wheel's position.  The angles are 55, 45, 55 and
+/// 45 degrees for wheels 0 to 3.
+const int32_t WheelX[NumWheels] = {-4745, -4096, 4745, 4096};
+const int32_t WheelY[NumWheels] = {-3323, 4096, 3323, -4096};
+
+/// Converts a body velocity to the velocity of each wheel
+inline void wheelVelocities(int bodyX, int bodyY, int bodyW,
+                            int wheels[NumWheels]) {
+    for (size_t i = 0; i < NumWheels; ++i) {
+        int32_t v = WheelX[i] * bodyX + WheelY[i] * bodyY;
+        // Round to the nearest tick
+        v += v >= 0 ? 2048 : -2048;
+        wheels[i] = v / 4096 + bodyW;
+    }
+}
+
+/// Converts a signed duty cycle to the FPGA's format: the magnitude in the
+/// low 9 bits and the direction in bit 9
+inline uint16_t dutyCycle(int duty) {
+    if (duty < 0) {
+        duty = duty < -MaxDuty ? MaxDuty : -duty;
+        return duty | DutyReverse;
+    }
+    return duty > MaxDuty ? MaxDuty : duty;
+}
+
+class Controller {
+public:
+    struct Gains {
+        /// Duty cycle per tick of velocity error, times Scale
+        int32_t kp = 2 * Scale;
+
+        /// Duty cycle per tick of velocity error added to the output each
+        /// cycle, times Scale
+        int32_t ki = Scale / 2;
+
+        /// Duty cycle per tick of target velocity, times Scale.  This should
+        /// be about the duty cycle that holds a wheel at one tick per cycle.
+        int32_t kf = 4 * Scale;
+    };
+
+    Gains gains;
+
+    /// Sets the body velocity to drive at
+    void setTarget(int bodyX, int bodyY, int bodyW) {
+        wheelVelocities(bodyX, bodyY, bodyW, _target);
+    }
+
+    /// Target velocity of a wheel
+    int target(size_t wheel) const { return _target[wheel]; }
+
+    /// Stops and forgets the integrators
+    void reset() {
+        for (size_t i = 0; i < NumWheels; ++i) {
+            _target[i] = 0;
+            _integral[i] = 0;
+        }
+    }
+
+    /**
+     * Runs one control cycle.
+     * @param measured Ticks each wheel turned since the last cycle
+     * @param duty     Signed duty cycle for each wheel
+     */
+    void update(const int16_t measured[NumWheels], int duty[NumWheels]) {
+        const int32_t limit = MaxDuty * Scale;
+
+        for (size_t i = 0; i < NumWheels; ++i) {
+            int32_t error = _target[i] - measured[i];
+            int32_t out =
+                gains.kf * _target[i] + gains.kp * error + _integral[i];
+
+            // Don't integrate further into saturation, so the integrator
+            // doesn't wind up while the motor can't keep up
+            bool saturated =
+                (out >= limit && error > 0) || (out <= -limit && error < 0);
+            if (!saturated) {
+                _integral[i] = clamp(_integral[i] + gains.ki * error, limit);
+                out = gains.kf * _target[i] + gains.kp * error + _integral[i];
+            }
+
+            out = clamp(out, limit);
+            duty[i] = (out + (out >= 0 ? Scale / 2 : -Scale / 2)) / Scale;
+        }
+    }
+
+private:
+    static int32_t clamp(int32_t value, int32_t limit) {
+        return value > limit ? limit : (value < -limit ? -limit : value);
+    }
+
+    int _target[NumWheels] = {};
+    int32_t _integral[NumWheels] = {};
+};
+
+}  // namespace WheelControl
@@ -162,7 +162,7 @@ int main() {
     Thread::signal_wait(MAIN_TASK_CONTINUE, osWaitForever);
 
     // Initialize the CommModule and CC1201 radio
-    InitializeCommModule(sharedSPI);
+    InitializeCommModule(sharedSPI, rotarySelector.read());
 
     // Make sure all of the motors are enabled
     motors_Init();
@@ -174,6 +174,10 @@ int main() {
     controller_task.signal_set(SUB_TASK_CONTINUE);
     console_task.signal_set(SUB_TASK_CONTINUE);
 
+    // Keep log calls in the radio and control paths from printing in their
+    // own threads now that startup is done
+    deferLogging(true);
+
     osStatus tState = osThreadSetPriority(mainID, osPriorityNormal);
     ASSERT(tState == osOK);
 
@@ -18,6 +18,9 @@
 
 using namespace std;
 
+// Defined in ControllerTaskThread.cpp
+void Task_Controller_Receive(const uint8_t* buf, size_t size, uint8_t shell);
+
 /*
  * Information about the radio protocol can be found at:
  * https://www.overleaf.com/2187548nsfdps
@@ -67,7 +70,7 @@ void loopback_tx_cb(rtp::packet* p) {
     CommModule::Instance->receive(*p);
 }
 
-void InitializeCommModule(shared_ptr<SharedSPI> sharedSPI) {
+void InitializeCommModule(shared_ptr<SharedSPI> sharedSPI, uint8_t shellID) {
     // leds that flash if tx/rx have happened recently
     auto rxTimeoutLED =
         make_shared<FlashingTimeoutLED>(DigitalOut(RJ_RX_LED, OpenDrain));
@@ -81,8 +84,7 @@ void InitializeCommModule(shared_ptr<SharedSPI> sharedSPI) {
     // TODO(justin): make this non-global
     // Create a new physical hardware communication link
     global_radio =
-        new CC1201(sharedSPI, RJ_RADIO_nCS, RJ_RADIO_INT, preferredSettings,
-                   sizeof(preferredSettings) / sizeof(registerSetting_t));
+        new CC1201(sharedSPI, RJ_RADIO_nCS, RJ_RADIO_INT, preferredConfig);
 
     // Open a socket for running tests across the link layer
     // The LINK port handlers are always active, regardless of whether or not a
@@ -108,6 +110,14 @@ void InitializeCommModule(shared_ptr<SharedSPI> sharedSPI) {
         commModule->setTxHandler((CommLink*)global_radio, &CommLink::sendPacket,
                                  rtp::port::LOGGER);
 
+        // Commands from soccer, passed on to the control loop
+        commModule->setRxHandler(
+            [shellID](rtp::packet* p) {
+                Task_Controller_Receive(p->payload.data(), p->payload.size(),
+                                        shellID);
+            },
+            rtp::port::CONTROL);
+
         // Legacy port
         commModule->setTxHandler((CommLink*)global_radio, &CommLink::sendPacket,
                                  rtp::port::LEGACY);
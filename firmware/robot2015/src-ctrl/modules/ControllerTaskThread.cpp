@@ -1,5 +1,6 @@
 #include <rtos.h>
 #include <RPCVariable.h>
+#include <us_ticker_api.h>
 
 #include <Console.hpp>
 #include <logger.hpp>
@@ -11,6 +12,7 @@
 #include "fpga.hpp"
 #include "mpu-6050.hpp"
 #include "io-expander.hpp"
+#include "robot-control.hpp"
 
 // Keep this pretty high for now. Ideally, drop it down to ~3 for production
 // builds. Hopefully that'll be possible without the console
@@ -35,6 +37,36 @@ float accelVals[3] = {0};
 // Making a temporary variable to test out the writing side of RPC variables
 // int testVar;
 // RPCVariable<int> test_var(&testVar, "var1");
+
+// The FPGA as seen by RobotControl
+struct FpgaHardware {
+    // The last batch of FPGA transactions, which also has the halls and the
+    // gate drivers' status
+    FpgaProtocol::Exchange fpga;
+
+    uint32_t micros() { return us_ticker_read(); }
+
+    void exchange(uint16_t* duty, uint16_t* encoderDeltas, size_t count) {
+        fpga.setDutyCycles(duty, count);
+        FPGA::Instance->exchange(fpga);
+
+        for (size_t i = 0; i < count; ++i) {
+            encoderDeltas[i] =
+                i < FpgaProtocol::NumEncoders ? fpga.encoder(i) : 0;
+        }
+    }
+};
+
+FpgaHardware fpgaHardware;
+RobotControl<FpgaHardware> robotControl(fpgaHardware);
+}
+
+/**
+ * Takes this robot's command from a forward packet for the control loop.
+ * This is called by the radio's receive thread.
+ */
+void Task_Controller_Receive(const uint8_t* buf, size_t size, uint8_t shell) {
+    robotControl.receive(buf, size, shell);
 }
 
 /**
@@ -87,12 +119,21 @@ void Task_Controller(void const* args) {
     osSignalSet(mainID, MAIN_TASK_CONTINUE);
     Thread::signal_wait(SUB_TASK_CONTINUE, osWaitForever);
 
-    std::vector<uint16_t> duty_cycles;
-    duty_cycles.assign(5, 150);
+    // The gyro's Z axis points up, so it reads counterclockwise turns as
+    // positive like the radio's body W
+    ImuFusion::HeadingEstimator heading;
+    uint32_t lastTime = us_ticker_read();
+
     while (true) {
         imu.getGyro(gyroVals);
         imu.getAccelero(accelVals);
 
+        uint32_t now = us_ticker_read();
+        heading.update(gyroVals[2], (now - lastTime) / 1000000.0f,
+                       robotControl.stopped());
+        lastTime = now;
+        robotControl.imu(heading.rate(), heading.heading());
+
         // printf(
         //     "\r\n\033[K"
         //     "\t(% 1.2f, % 1.2f, % 1.2f)\ r\n"
@@ -102,8 +143,7 @@ void Task_Controller(void const* args) {
         //     accelVals[2]);
         // Console::Flush();
 
-        // write all duty cycles
-        FPGA::Instance->set_duty_cycles(duty_cycles.data(), duty_cycles.size());
+        robotControl.step();
 
         Thread::wait(CONTROL_LOOP_WAIT_MS);
 
@@ -156,8 +196,10 @@ void Task_Controller_Sensorless(const osThreadId mainID) {
     osSignalSet(mainID, MAIN_TASK_CONTINUE);
     Thread::signal_wait(SUB_TASK_CONTINUE, osWaitForever);
 
+    // The wheels don't need the IMU
     while (true) {
+        robotControl.step();
+
         Thread::wait(CONTROL_LOOP_WAIT_MS);
-        Thread::yield();
     }
 }
@@ -119,8 +119,9 @@ static const vector<command_t> commands = {
     {{"loglvl", "loglevel"},
      false,
      cmd_log_level,
-     "set the console's log level.",
-     "loglvl {+,-}..."},
+     "set the console's log level, or print log messages from a "
+     "low-priority thread (defer) or right away (sync).",
+     "loglvl {+,-,on,off,defer,sync}..."},
 
     {{"ls", "l"}, false, cmd_ls, "List contents of current directory", "ls"},
 
@@ -685,6 +686,12 @@ int cmd_log_level(cmd_args_t& args) {
         } else if (args[0] == "off" || args[0] == "disable") {
             isLogging = false;
             printf("Logging disabled.\r\n");
+        } else if (args[0] == "defer") {
+            deferLogging(true);
+            printf("Deferred logging enabled.\r\n");
+        } else if (args[0] == "sync") {
+            deferLogging(false);
+            printf("Deferred logging disabled.\r\n");
         } else {
             // this will return a signed int, so the level
             // could increase or decrease...or stay the same.
@@ -12,7 +12,8 @@
 
 // forward declaration of tasks
 void Task_SerialConsole(void const* args);
-void InitializeCommModule(std::shared_ptr<SharedSPI> sharedSPI);
+void InitializeCommModule(std::shared_ptr<SharedSPI> sharedSPI,
+                          uint8_t shellID);
 
 /**
  * Max number of command aliases.
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "imu-fusion.hpp"
+#include "radio-protocol.hpp"
+#include "wheel-control.hpp"
+
+/**
+ * The robot's control loop: takes commands from the radio and drives the
+ * wheels at them with a WheelControl::Controller.  When the IMU is available,
+ * turning is corrected by an ImuFusion::YawControl.
+ *
+ * A command can be a RadioProtocol::TrajectorySegment, which the robot
+ * follows from when it arrives, so it keeps driving along its path between
+ * packets.
+ *
+ * The hardware is a template parameter so the same code runs on the robot
+ * and in the simulator.  It must have:
+ *   uint32_t micros();
+ *   // Writes duty cycles for the four wheels and the dribbler and reads how
+ *   // far each turned since the last call
+ *   void exchange(uint16_t* duty, uint16_t* encoderDeltas, size_t count);
+ */
+template <class Hardware>
+class RobotControl {
+public:
+    /// Motors driven by the FPGA: four wheels and the dribbler
+    static const size_t NumMotors = 5;
+
+    /// The robot stops if it doesn't get a command for this long, or for the
+    /// length of its trajectory segment if that is longer
+    static const uint32_t CommandTimeout = 250 * 1000;
+
+    /// Length of a control cycle in microseconds
+    static const uint32_t CycleTime = 5000;
+
+    RobotControl(Hardware& hardware) : _hardware(hardware) {}
+
+    /// Takes the command for <shell> from a forward packet.  Returns false if
+    /// the packet doesn't have one.  This may be called from another thread
+    /// than step().
+    bool receive(const uint8_t* buf, size_t size, uint8_t shell) {
+        RadioProtocol::TrajectorySegment segment;
+        if (!RadioProtocol::findSegment(buf, size, shell, segment)) {
+            return false;
+        }
+        follow(segment);
+        return true;
+    }
+
+    /// Sets the command to drive at
+    void command(const RadioProtocol::RobotCommand& cmd) {
+        follow(RadioProtocol::TrajectorySegment::hold(cmd));
+    }
+
+    /// Drives along <segment>, starting now
+    void follow(const RadioProtocol::TrajectorySegment& segment) {
+        uint32_t now = _hardware.micros();
+
+        // An odd version tells step() this is half written
+        ++_version;
+        _start = pack(segment.start());
+        _middle = pack(segment.middle);
+        _end = pack(segment.end);
+        _length = segment.length;
+        _dribbler = segment.command.dribbler;
+        _commandTime = now;
+        _haveCommand = true;
+        ++_version;
+    }
+
+    /// Gives the next step() the robot's turn rate and heading from the IMU
+    /// (see ImuFusion::HeadingEstimator).  Without them, turning is left to
+    /// the wheels alone.
+    void imu(float rate, float heading) {
+        _imuRate = rate;
+        _imuHeading = heading;
+        _haveImu = true;
+    }
+
+    /// True if the last step() had nothing to drive at and the wheels didn't
+    /// turn, so the robot is still
+    bool stopped() const { return _stopped; }
+
+    /**
+     * Runs one control cycle.  The duty cycles found last cycle are written in
+     * the same exchange that reads how far the wheels turned since then.
+     */
+    void step() {
+        loadCommand();
+
+        uint32_t elapsed = _hardware.micros() - _command.time;
+        uint32_t timeout = _command.length * CycleTime;
+        if (timeout < CommandTimeout) {
+            timeout = CommandTimeout;
+        }
+        bool fresh = _command.valid && elapsed < timeout;
+
+        uint32_t cycle = elapsed / CycleTime;
+        int x = interpolate(0, cycle);
+        int y = interpolate(10, cycle);
+        int w = interpolate(20, cycle);
+        bool idle = !fresh || (x == 0 && y == 0 && w == 0);
+        if (fresh) {
+            if (_haveImu) {
+                w = turnRate(w);
+            } else {
+                _yaw.reset();
+            }
+            _controller.setTarget(x, y, w);
+        } else {
+            _controller.reset();
+            _yaw.reset();
+        }
+        _haveImu = false;
+
+        std::array<uint16_t, NumMotors> encoderDeltas;
+        _hardware.exchange(_dutyCycles.data(), encoderDeltas.data(),
+                           NumMotors);
+
+        int16_t measured[WheelControl::NumWheels];
+        _stopped = idle;
+        for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+            measured[i] = static_cast<int16_t>(encoderDeltas[i]);
+            _stopped = _stopped && measured[i] == 0;
+        }
+
+        int duty[WheelControl::NumWheels];
+        _controller.update(measured, duty);
+        for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+            _dutyCycles[i] = WheelControl::dutyCycle(duty[i]);
+        }
+
+        // The dribbler runs open loop
+        _dutyCycles[NumMotors - 1] = fresh ? _command.dribbler << 1 : 0;
+    }
+
+    WheelControl::Controller& controller() { return _controller; }
+
+    ImuFusion::YawControl& yawControl() { return _yaw; }
+
+    /// Duty cycles that the next step() writes, in the FPGA's format
+    const std::array<uint16_t, NumMotors>& dutyCycles() const {
+        return _dutyCycles;
+    }
+
+private:
+    // The body velocities are packed into one word each
+    static uint32_t pack(const RadioProtocol::Velocity& v) {
+        return (v.x & 0x3ff) | (v.y & 0x3ff) << 10 | (v.w & 0x3ff) << 20;
+    }
+
+    static int unpack(uint32_t packed, int shift) {
+        return RadioProtocol::extend(packed >> shift, packed >> (shift + 8));
+    }
+
+    // Copies the command written by follow(), unless it is being written.
+    // Then the last copy is used for another cycle instead of waiting for
+    // the radio thread, which step() may have interrupted.
+    void loadCommand() {
+        uint32_t version = _version;
+        if (version & 1) {
+            return;
+        }
+
+        Command command;
+        command.start = _start;
+        command.middle = _middle;
+        command.end = _end;
+        command.length = _length;
+        command.dribbler = _dribbler;
+        command.time = _commandTime;
+        command.valid = _haveCommand;
+        if (_version == version) {
+            _command = command;
+        }
+    }
+
+    // One body velocity from the command, <cycle> cycles after it arrived
+    int interpolate(int shift, uint32_t cycle) const {
+        return RadioProtocol::interpolate(
+            unpack(_command.start, shift), unpack(_command.middle, shift),
+            unpack(_command.end, shift), cycle, _command.length);
+    }
+
+    // Corrects the commanded turn rate, in radio units, with the IMU
+    int turnRate(int w) {
+        using namespace RadioProtocol;
+        const float unitsPerRadian = SecondsPerCycle / RadiansPerTick;
+
+        float rate = _yaw.update(w / unitsPerRadian, _imuRate, _imuHeading,
+                                 SecondsPerCycle);
+        int corrected = lroundf(rate * unitsPerRadian);
+        return std::max(-MaxVelocity, std::min(MaxVelocity, corrected));
+    }
+
+    Hardware& _hardware;
+    WheelControl::Controller _controller;
+    std::array<uint16_t, NumMotors> _dutyCycles{};
+
+    ImuFusion::YawControl _yaw;
+    float _imuRate = 0;
+    float _imuHeading = 0;
+    bool _haveImu = false;
+    bool _stopped = true;
+
+    // The command as step() last read it
+    struct Command {
+        uint32_t start = 0;
+        uint32_t middle = 0;
+        uint32_t end = 0;
+        uint8_t length = 0;
+        uint8_t dribbler = 0;
+        uint32_t time = 0;
+        bool valid = false;
+    };
+    Command _command;
+
+    // The command as follow() writes it
+    std::atomic<uint32_t> _version{0};
+    std::atomic<uint32_t> _start{0};
+    std::atomic<uint32_t> _middle{0};
+    std::atomic<uint32_t> _end{0};
+    std::atomic<uint8_t> _length{0};
+    std::atomic<uint8_t> _dribbler{0};
+    std::atomic<uint32_t> _commandTime{0};
+    std::atomic<bool> _haveCommand{false};
+};
@@ -102,7 +102,10 @@ void SimulatorGLUTThread::run() {
     } else {
         while (true) {
             if (_stopped) return;
-            stepSimulation();
+            // In lockstep mode the environment steps the physics itself
+            if (!_env->lockstep()) {
+                stepSimulation();
+            }
             usleep(16667);  // wait 1/60 seconds
         }
     }
@@ -0,0 +1,389 @@
+// Runs scenarios on several simulator+soccer pairs at once and summarizes
+// each run.  See simulator/README.md for the scenario file format.
+
+#include <LogMetrics.hpp>
+#include <Network.hpp>
+#include <Utils.hpp>
+#include <protobuf/SimCommand.pb.h>
+
+#include <google/protobuf/text_format.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QThread>
+#include <QUdpSocket>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace Packet;
+
+static QHostAddress LocalAddress(QHostAddress::LocalHost);
+
+// How long to wait for a new simulator to answer
+static const int SimulatorStartTimeout = 10000;
+
+struct Run {
+    QString name;
+    SimScenario scenario;
+    uint32_t seed;
+
+    bool ok = false;
+    float wallTime = 0;
+    std::unique_ptr<LogMetrics> metrics;
+};
+
+void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [options...] <scenario>...\n", prog);
+    fprintf(stderr,
+            "\t-j <n>:      number of simulator+soccer pairs to run at once "
+            "(default: number of cores)\n");
+    fprintf(stderr,
+            "\t-r <n>:      run each scenario n times with different seeds\n");
+    fprintf(stderr, "\t-o <dir>:    directory for logs and the summary\n");
+    exit(1);
+}
+
+static bool loadScenario(const QString& filename, SimScenario& scenario) {
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) {
+        fprintf(stderr, "Can't open %s: %s\n",
+                (const char*)filename.toLatin1(),
+                (const char*)file.errorString().toLatin1());
+        return false;
+    }
+
+    QByteArray text = file.readAll();
+    if (!google::protobuf::TextFormat::ParseFromString(text.toStdString(),
+                                                        &scenario)) {
+        fprintf(stderr, "Can't parse %s\n", (const char*)filename.toLatin1());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Runs scenarios one at a time on its own port block until there are none
+ * left.
+ */
+class Worker : public QThread {
+public:
+    Worker(vector<Run>& runs, int& nextRun, QMutex& mutex, int portOffset,
+           const QDir& outputDir)
+        : _runs(runs),
+          _nextRun(nextRun),
+          _mutex(mutex),
+          _portOffset(portOffset),
+          _outputDir(outputDir) {}
+
+protected:
+    void run() override {
+        while (true) {
+            Run* run;
+            {
+                QMutexLocker locker(&_mutex);
+                if (_nextRun >= (int)_runs.size()) {
+                    return;
+                }
+                run = &_runs[_nextRun++];
+            }
+
+            printf("%s: starting on port offset %d\n",
+                   (const char*)run->name.toLatin1(), _portOffset);
+            QDateTime start = QDateTime::currentDateTime();
+            runScenario(*run);
+            run->wallTime =
+                start.msecsTo(QDateTime::currentDateTime()) / 1000.0;
+            printf("%s: %s after %.1f s\n", (const char*)run->name.toLatin1(),
+                   run->ok ? "done" : "failed", run->wallTime);
+        }
+    }
+
+private:
+    void runScenario(Run& run) {
+        QDir runDir(_outputDir.filePath(run.name));
+        runDir.mkpath("logs");
+
+        const SimScenario& scenario = run.scenario;
+        bool smallField = false;
+
+        QStringList simArgs;
+        simArgs << "--headless"
+                << "--lockstep"
+                << "--shm"
+                << "--seed" << QString::number(run.seed) << "--port-offset"
+                << QString::number(_portOffset);
+        for (const string& arg : scenario.simulator_args()) {
+            simArgs << QString::fromStdString(arg);
+            if (arg == "--smallfield") {
+                smallField = true;
+            }
+        }
+
+        QProcess simulator;
+        simulator.setWorkingDirectory(runDir.path());
+        simulator.setStandardOutputFile(runDir.filePath("simulator.txt"));
+        simulator.setProcessChannelMode(QProcess::MergedChannels);
+        simulator.start(ApplicationRunDirectory().filePath("simulator"),
+                        simArgs);
+        if (!simulator.waitForStarted()) {
+            fprintf(stderr, "%s: can't start the simulator\n",
+                    (const char*)run.name.toLatin1());
+            return;
+        }
+
+        // Runs are numbered from one, since a setup_id of zero is ignored
+        uint32_t runId = &run - _runs.data() + 1;
+        if (!sendSetup(scenario.setup(), runId)) {
+            fprintf(stderr, "%s: no reply from the simulator\n",
+                    (const char*)run.name.toLatin1());
+            simulator.kill();
+            simulator.waitForFinished();
+            return;
+        }
+
+        // Each frame steps the simulator by 1/60 s
+        int frames = scenario.duration() * 60;
+
+        QStringList soccerArgs;
+        soccerArgs << "-sim"
+                   << "-lockstep"
+                   << "-shm"
+                   << "-port-offset" << QString::number(_portOffset)
+                   << "-frames" << QString::number(frames) << "-s"
+                   << QString::number(run.seed, 16);
+        for (const string& arg : scenario.soccer_args()) {
+            soccerArgs << QString::fromStdString(arg);
+        }
+
+        // Soccer writes its log to logs/ in its working directory
+        QProcess soccer;
+        soccer.setWorkingDirectory(runDir.path());
+        soccer.setStandardOutputFile(runDir.filePath("soccer.txt"));
+        soccer.setProcessChannelMode(QProcess::MergedChannels);
+        soccer.start(ApplicationRunDirectory().filePath("soccer"), soccerArgs);
+
+        // Give up on runs that are much slower than real time
+        int timeout = (scenario.duration() * 10 + 60) * 1000;
+        bool finished =
+            soccer.waitForStarted() && soccer.waitForFinished(timeout);
+        if (!finished) {
+            fprintf(stderr, "%s: soccer didn't finish\n",
+                    (const char*)run.name.toLatin1());
+            soccer.kill();
+            soccer.waitForFinished();
+        }
+
+        simulator.terminate();
+        if (!simulator.waitForFinished(5000)) {
+            simulator.kill();
+            simulator.waitForFinished();
+        }
+
+        QDir logDir(runDir.filePath("logs"));
+        QStringList logs = logDir.entryList(QStringList("*.log"), QDir::Files,
+                                            QDir::Name);
+        if (logs.isEmpty()) {
+            fprintf(stderr, "%s: soccer didn't write a log\n",
+                    (const char*)run.name.toLatin1());
+            return;
+        }
+
+        run.metrics.reset(new LogMetrics(
+            smallField ? Field_Dimensions::Single_Field_Dimensions
+                       : Field_Dimensions::Double_Field_Dimensions));
+        QString log = logDir.filePath(logs.back());
+        run.ok = run.metrics->readLog((const char*)log.toLatin1()) &&
+                 finished && soccer.exitCode() == 0;
+    }
+
+    // Sends the scenario's setup to the simulator.  This also waits for the
+    // simulator to start listening, so it is retried until it is answered.
+    // The simulator only applies it once for each <runId>.
+    bool sendSetup(const SimCommand& setup, uint32_t runId) {
+        QUdpSocket socket;
+        if (!socket.bind(LocalAddress, 0)) {
+            return false;
+        }
+
+        // A step of zero only asks for a reply
+        SimCommand cmd = setup;
+        cmd.set_step(0);
+        cmd.set_step_id(1);
+        cmd.set_setup_id(runId);
+        string out;
+        cmd.SerializeToString(&out);
+
+        for (int t = 0; t < SimulatorStartTimeout; t += 100) {
+            socket.writeDatagram(&out[0], out.size(), LocalAddress,
+                                 SimCommandPort + _portOffset);
+            if (socket.waitForReadyRead(100)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    vector<Run>& _runs;
+    int& _nextRun;
+    QMutex& _mutex;
+    int _portOffset;
+    QDir _outputDir;
+};
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    // Port block zero is left for interactive use, and the rest must stay
+    // clear of the other fixed ports
+    const int MaxJobs = MaxPortOffset / PortBlockSize;
+
+    int jobs = min(QThread::idealThreadCount(), MaxJobs);
+    int repeats = 1;
+    QString outputDir;
+    QStringList scenarioFiles;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* var = argv[i];
+
+        if (strcmp(var, "--help") == 0) {
+            usage(argv[0]);
+        } else if (strcmp(var, "-j") == 0) {
+            if (i + 1 >= argc) {
+                printf("no count specified after -j\n");
+                usage(argv[0]);
+            }
+
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(var, "-r") == 0) {
+            if (i + 1 >= argc) {
+                printf("no count specified after -r\n");
+                usage(argv[0]);
+            }
+
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(var, "-o") == 0) {
+            if (i + 1 >= argc) {
+                printf("no directory specified after -o\n");
+                usage(argv[0]);
+            }
+
+            outputDir = argv[++i];
+        } else if (var[0] == '-') {
+            printf("Not a valid flag: %s\n", var);
+            usage(argv[0]);
+        } else {
+            scenarioFiles << var;
+        }
+    }
+
+    if (scenarioFiles.isEmpty() || jobs < 1 || repeats < 1) {
+        usage(argv[0]);
+    }
+
+    if (jobs > MaxJobs) {
+        fprintf(stderr,
+                "At most %d jobs can run at once without their ports "
+                "overlapping\n",
+                MaxJobs);
+        return 1;
+    }
+
+    if (outputDir.isNull()) {
+        outputDir = QString("batch-") +
+                    QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+    }
+    QDir output(outputDir);
+    if (!output.mkpath(".")) {
+        fprintf(stderr, "Can't create %s\n", (const char*)outputDir.toLatin1());
+        return 1;
+    }
+
+    vector<Run> runs(scenarioFiles.size() * repeats);
+    for (int s = 0; s < scenarioFiles.size(); ++s) {
+        SimScenario scenario;
+        if (!loadScenario(scenarioFiles[s], scenario)) {
+            return 1;
+        }
+
+        QString base = QFileInfo(scenarioFiles[s]).completeBaseName();
+        for (int r = 0; r < repeats; ++r) {
+            Run& run = runs[s * repeats + r];
+            run.name = QString("%1-%2").arg(base).arg(r);
+            run.scenario = scenario;
+            run.seed = r + 1;
+        }
+    }
+
+    // Neither program needs a display here
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QMutex mutex;
+    int nextRun = 0;
+    vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < min(jobs, (int)runs.size()); ++i) {
+        // Port block zero is left for interactive use
+        workers.emplace_back(new Worker(runs, nextRun, mutex,
+                                        (i + 1) * PortBlockSize, output));
+        workers.back()->start();
+    }
+    for (auto& worker : workers) {
+        worker->wait();
+    }
+
+    // Summary
+    QFile summary(output.filePath("summary.csv"));
+    if (!summary.open(QFile::WriteOnly)) {
+        fprintf(stderr, "Can't write %s\n",
+                (const char*)summary.fileName().toLatin1());
+        return 1;
+    }
+    summary.write(
+        "run,ok,seed,frames,goals_for,goals_against,possession,"
+        "mean_planning_us,max_planning_us,overruns,wall_s\n");
+
+    printf("\n%-24s %6s %5s %5s %6s %10s %8s %8s\n", "run", "frames", "for",
+           "agst", "poss", "plan us", "overrun", "wall s");
+    int failed = 0;
+    for (const Run& run : runs) {
+        LogMetrics empty;
+        const LogMetrics& m = run.metrics ? *run.metrics : empty;
+        if (!run.ok) {
+            ++failed;
+        }
+
+        QString line = QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11\n")
+                           .arg(run.name)
+                           .arg(run.ok ? 1 : 0)
+                           .arg(run.seed)
+                           .arg(m.frames)
+                           .arg(m.goalsFor)
+                           .arg(m.goalsAgainst)
+                           .arg(m.possession())
+                           .arg(m.meanPlanningTime())
+                           .arg(m.maxPlanningTime)
+                           .arg(m.overruns)
+                           .arg(run.wallTime);
+        summary.write(line.toLatin1());
+
+        printf("%-24s %6d %5d %5d %6.2f %10.0f %8d %8.1f%s\n",
+               (const char*)run.name.toLatin1(), m.frames, m.goalsFor,
+               m.goalsAgainst, m.possession(), m.meanPlanningTime(),
+               m.overruns, run.wallTime, run.ok ? "" : "  FAILED");
+    }
+
+    printf("\nWrote %s\n", (const char*)summary.fileName().toLatin1());
+    return failed ? 1 : 0;
+}
@@ -5,11 +5,13 @@
 #include "Robot.hpp"
 #include <Constants.hpp>
 #include <Network.hpp>
+#include <time.hpp>
 #include <Geometry2d/Util.hpp>
 
 #include <protobuf/messages_robocup_ssl_detection.pb.h>
 #include <protobuf/messages_robocup_ssl_geometry.pb.h>
 #include <protobuf/messages_robocup_ssl_wrapper.pb.h>
+#include <protobuf/referee.pb.h>
 
 #include <QDomDocument>
 #include <QDomAttr>
@@ -17,6 +19,8 @@
 #include <QFile>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <string.h>
 #include <sys/time.h>
 
 using namespace std;
@@ -27,6 +31,13 @@ static const QHostAddress MulticastAddress(SharedVisionAddress);
 
 const int Oversample = 1;
 
+// Length of each physics step in lockstep mode
+static const float LockstepPeriod = 1.0f / 60.0f;
+static const uint64_t LockstepPeriodMicroseconds = 1000000 / 60;
+
+// Simulated seconds between printing the firmware's measurements
+static const float FirmwareStatsPeriod = 10;
+
 Environment::Environment(const QString& configFile, bool sendShared_,
                          SimEngine* engine)
     : _dropFrame(false),
@@ -34,8 +45,20 @@ Environment::Environment(const QString& configFile, bool sendShared_,
       _frameNumber(0),
       _stepCount(0),
       _simEngine(engine),
+      _lockstep(false),
+      _simTime(0),
+      _setupId(0),
+      _portOffset(0),
+      _sharedMemory(false),
+      _refereeNext(0),
+      _refereeStart(0),
+      _refereeCounter(0),
+      _firmware(false),
+      _firmwareStatsTime(0),
       sendShared(sendShared_),
       ballVisibility(100) {
+    memset(_shells, 0, sizeof(_shells));
+
     // NOTE: does not start simulation/thread until triggered
     _field = new Field(this);
     _field->initPhysics();
@@ -46,19 +69,54 @@ Environment::~Environment() { delete _field; }
 
 void Environment::connectSockets() {
     // Bind sockets
-    bool success = (_visionSocket.bind(SimCommandPort) &&
-                    _radioSocketYellow.bind(RadioTxPort) &&
-                    _radioSocketBlue.bind(RadioTxPort + 1));
+    bool success =
+        (_visionSocket.bind(SimCommandPort + _portOffset) &&
+         _radioSocketYellow.bind(RadioTxPort + _portOffset) &&
+         _radioSocketBlue.bind(RadioTxPort + _portOffset + 1));
     if (!success) {
         throw std::runtime_error(
             "Unable to bind sockets.  Is there another instance of simulator "
             "already running?");
     }
 
+    if (_sharedMemory) {
+        for (int i = 0; i < 2; ++i) {
+            success = success &&
+                      _visionRings[i].create(ShmRing::name(
+                          ShmVisionChannel, i, _portOffset)) &&
+                      _radioTxRings[i].create(ShmRing::name(
+                          ShmRadioTxChannel, i, _portOffset)) &&
+                      _radioRxRings[i].create(ShmRing::name(
+                          ShmRadioRxChannel, i, _portOffset));
+        }
+
+        if (!success) {
+            throw std::runtime_error("Unable to create shared memory rings");
+        }
+    }
+
     gettimeofday(&_lastStepTime, nullptr);
 
-    connect(&_timer, SIGNAL(timeout()), SLOT(step()));
-    _timer.start(16 / Oversample);
+    if (_lockstep) {
+        // Packets are stamped with simulated time, as soccer sees it
+        RJ::setSimulatedTime(RJ::SimulatedEpoch + _simTime);
+
+        // Only step when commanded to
+        connect(&_visionSocket, SIGNAL(readyRead()), SLOT(step()));
+    } else {
+        connect(&_timer, SIGNAL(timeout()), SLOT(step()));
+        _timer.start(16 / Oversample);
+    }
+}
+
+void Environment::firmware(bool value) {
+    _firmware = value;
+    for (Robot* robot : _yellow) {
+        robot->firmware(value);
+    }
+    for (Robot* robot : _blue) {
+        robot->firmware(value);
+    }
 }
 
 void Environment::preStep(float deltaTime) {
@@ -69,30 +127,51 @@ void Environment::preStep(float deltaTime) {
     for (::Robot* robot : _blue) {
         robot->applyEngineForces(deltaTime);
     }
+
+    if (_firmware) {
+        _firmwareStatsTime += deltaTime;
+        if (_firmwareStatsTime >= FirmwareStatsPeriod) {
+            _firmwareStatsTime = 0;
+            for (::Robot* robot : _yellow) {
+                robot->printFirmwareStats("Yellow");
+            }
+            for (::Robot* robot : _blue) {
+                robot->printFirmwareStats("Blue");
+            }
+        }
+    }
 }
 
 void Environment::step() {
     // Check for SimCommands
     while (_visionSocket.hasPendingDatagrams()) {
         Packet::SimCommand cmd;
-        if (!loadPacket<Packet::SimCommand>(_visionSocket, cmd)) continue;
-        handleSimCommand(cmd);
+        QHostAddress host;
+        quint16 port = 0;
+        if (!loadPacket<Packet::SimCommand>(_visionSocket, cmd, &host, &port))
+            continue;
+        if (!cmd.setup_id() || cmd.setup_id() != _setupId) {
+            _setupId = cmd.setup_id();
+            handleSimCommand(cmd);
+        }
+
+        if (cmd.has_step()) {
+            if (_lockstep) {
+                runSteps(cmd, host, port);
+            } else {
+                printf("Ignoring step command: not in lockstep mode\n");
+            }
+        }
     }
 
-    // Check for RadioTx packets from blue team
-    while (_radioSocketBlue.hasPendingDatagrams()) {
-        Packet::RadioTx tx;
-        if (!loadPacket<Packet::RadioTx>(_radioSocketBlue, tx)) continue;
+    receiveRadio();
 
-        handleRadioTx(true, tx);
+    if (_lockstep) {
+        // Vision is only sent in reply to step commands
+        return;
     }
 
-    // Check for RadioTx packets from yellow team
-    while (_radioSocketYellow.hasPendingDatagrams()) {
-        Packet::RadioTx tx;
-        if (!loadPacket<Packet::RadioTx>(_radioSocketYellow, tx)) continue;
-        handleRadioTx(false, tx);
-    }
+    sendReferee();
 
     // timing
     struct timeval tv;
@@ -115,6 +194,76 @@ void Environment::step() {
     }
 }
 
+void Environment::receiveRadio() {
+    // Channel 0 is yellow and 1 is blue
+    Packet::RadioRxBatch replies[2];
+
+    // Check for RadioTx packets from blue team
+    while (_radioSocketBlue.hasPendingDatagrams()) {
+        Packet::RadioTx tx;
+        if (!loadPacket<Packet::RadioTx>(_radioSocketBlue, tx)) continue;
+
+        handleRadioTx(true, tx, replies[1]);
+    }
+
+    // Check for RadioTx packets from yellow team
+    while (_radioSocketYellow.hasPendingDatagrams()) {
+        Packet::RadioTx tx;
+        if (!loadPacket<Packet::RadioTx>(_radioSocketYellow, tx)) continue;
+        handleRadioTx(false, tx, replies[0]);
+    }
+
+    std::string buf;
+    for (int i = 0; i < 2; ++i) {
+        while (_radioTxRings[i].read(buf)) {
+            Packet::RadioTx tx;
+            if (!tx.ParseFromString(buf)) {
+                printf("Bad packet of %d bytes\n", (int)buf.size());
+                continue;
+            }
+            handleRadioTx(i == 1, tx, replies[i]);
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (replies[i].packets_size()) {
+            sendRadioRx(i == 1, replies[i]);
+        }
+    }
+}
+
+void Environment::runSteps(const Packet::SimCommand& cmd,
+                           const QHostAddress& host, quint16 port) {
+    // Radio packets sent before this command must be applied first.  On the
+    // loopback interface they are already queued by the time this command is
+    // read.
+    receiveRadio();
+
+    for (unsigned int i = 0; i < cmd.step(); ++i) {
+        preStep(LockstepPeriod);
+        _simEngine->stepSimulation(LockstepPeriod);
+        _simTime += LockstepPeriodMicroseconds;
+    }
+    RJ::setSimulatedTime(RJ::SimulatedEpoch + _simTime);
+
+    // Send referee commands before the reply so soccer sees them on the
+    // frame they were scheduled for
+    sendReferee();
+
+    Packet::SimStepAck ack;
+    ack.set_step_id(cmd.step_id());
+    ack.set_sim_time(_simTime);
+    if (_dropFrame) {
+        _dropFrame = false;
+    } else {
+        fillVision(*ack.mutable_vision(), _simTime * 1.0e-6);
+    }
+
+    std::string buf;
+    ack.SerializeToString(&buf);
+    _visionSocket.writeDatagram(&buf[0], buf.size(), host, port);
+}
+
 void Environment::handleSimCommand(const Packet::SimCommand& cmd) {
     if (!_balls.empty()) {
         if (cmd.has_ball_vel()) {
@@ -177,28 +326,110 @@ void Environment::handleSimCommand(const Packet::SimCommand& cmd) {
     if (cmd.has_reset() && cmd.reset()) {
         resetScene();
     }
+
+    if (cmd.referee_size()) {
+        _refereeEvents.assign(cmd.referee().begin(), cmd.referee().end());
+        std::stable_sort(_refereeEvents.begin(), _refereeEvents.end(),
+                         [](const Packet::SimCommand::RefereeEvent& a,
+                            const Packet::SimCommand::RefereeEvent& b) {
+                             return a.time() < b.time();
+                         });
+        _refereeNext = 0;
+        _refereeStart = currentTime();
+    }
+}
+
+uint64_t Environment::currentTime() const {
+    if (_lockstep) {
+        return _simTime;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void fillTeamInfo(SSL_Referee::TeamInfo* info, const char* name) {
+    info->set_name(name);
+    info->set_score(0);
+    info->set_red_cards(0);
+    info->set_yellow_cards(0);
+    info->set_timeouts(4);
+    info->set_timeout_time(5 * 60 * 1000000);
+    info->set_goalie(0);
+}
+
+void Environment::sendReferee() {
+    uint64_t elapsed = currentTime() - _refereeStart;
+    while (_refereeNext < _refereeEvents.size() &&
+           _refereeEvents[_refereeNext].time() * 1.0e6 <= elapsed) {
+        const Packet::SimCommand::RefereeEvent& event =
+            _refereeEvents[_refereeNext++];
+
+        // Soccer compares these against its own clock, which follows
+        // simulated time in lockstep mode
+        uint64_t now = RJ::timestamp();
+
+        SSL_Referee packet;
+        packet.set_packet_timestamp(now);
+        packet.set_stage(event.stage());
+        packet.set_command(event.command());
+        packet.set_command_counter(++_refereeCounter);
+        packet.set_command_timestamp(now);
+        fillTeamInfo(packet.mutable_yellow(), "Yellow");
+        fillTeamInfo(packet.mutable_blue(), "Blue");
+
+        std::string buf;
+        packet.SerializeToString(&buf);
+        _visionSocket.writeDatagram(&buf[0], buf.size(), LocalAddress,
+                                    ProtobufRefereePort + _portOffset);
+    }
 }
 
 void Environment::sendVision() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
     SSL_WrapperPacket wrapper;
+    fillVision(wrapper, tv.tv_sec + (double)tv.tv_usec * 1.0e-6);
+
+    std::string buf;
+    wrapper.SerializeToString(&buf);
+
+    if (sendShared) {
+        _visionSocket.writeDatagram(&buf[0], buf.size(), MulticastAddress,
+                                    SharedVisionPort);
+    } else if (_sharedMemory) {
+        // Nobody reads a ring until soccer claims it
+        for (ShmRing& ring : _visionRings) {
+            if (ring.claimed()) {
+                ring.write(buf);
+            }
+        }
+    } else {
+        _visionSocket.writeDatagram(&buf[0], buf.size(), LocalAddress,
+                                    SimVisionPort + _portOffset);
+        _visionSocket.writeDatagram(&buf[0], buf.size(), LocalAddress,
+                                    SimVisionPort + _portOffset + 1);
+    }
+}
+
+void Environment::fillVision(SSL_WrapperPacket& wrapper, double time) {
     SSL_DetectionFrame* det = wrapper.mutable_detection();
     det->set_frame_number(_frameNumber++);
     det->set_camera_id(0);
-
-    struct timeval tv;
-    gettimeofday(&tv, nullptr);
-    det->set_t_capture(tv.tv_sec + (double)tv.tv_usec * 1.0e-6);
+    det->set_t_capture(time);
     det->set_t_sent(det->t_capture());
 
     for (Robot* robot : _yellow) {
-        if ((rand() % 100) < robot->visibility) {
+        if ((int)(_random() % 100) < robot->visibility) {
             SSL_DetectionRobot* out = det->add_robots_yellow();
             convert_robot(robot, out);
         }
     }
 
     for (Robot* robot : _blue) {
-        if ((rand() % 100) < robot->visibility) {
+        if ((int)(_random() % 100) < robot->visibility) {
             SSL_DetectionRobot* out = det->add_robots_blue();
             convert_robot(robot, out);
         }
@@ -215,7 +446,7 @@ void Environment::sendVision() {
         // 	occ = occluded(ballPos, cam1);
         // }
 
-        if ((rand() % 100) < ballVisibility) {
+        if ((int)(_random() % 100) < ballVisibility) {
             SSL_DetectionBall* out = det->add_balls();
             out->set_confidence(1);
             out->set_x(ballPos.x * 1000);
@@ -224,19 +455,6 @@ void Environment::sendVision() {
             out->set_pixel_y(ballPos.y * 1000);
         }
     }
-
-    std::string buf;
-    wrapper.SerializeToString(&buf);
-
-    if (sendShared) {
-        _visionSocket.writeDatagram(&buf[0], buf.size(), MulticastAddress,
-                                    SharedVisionPort);
-    } else {
-        _visionSocket.writeDatagram(&buf[0], buf.size(), LocalAddress,
-                                    SimVisionPort);
-        _visionSocket.writeDatagram(&buf[0], buf.size(), LocalAddress,
-                                    SimVisionPort + 1);
-    }
 }
 
 void Environment::convert_robot(const Robot* robot, SSL_DetectionRobot* out) {
@@ -264,12 +482,16 @@ void Environment::addRobot(bool blue, int id, Geometry2d::Point pos,
                            Robot::RobotRevision rev) {
     Robot* r = new Robot(this, id, rev, pos);
     r->initPhysics(blue);
+    r->firmware(_firmware);
 
     if (blue) {
         _blue.insert(id, r);
     } else {
         _yellow.insert(id, r);
     }
+    if (id >= 0 && id < (int)Num_Shells) {
+        _shells[blue][id] = r;
+    }
 
     Geometry2d::Point actPos = r->getPosition();
 
@@ -291,6 +513,9 @@ void Environment::removeRobot(bool blue, int id) {
     } else {
         _yellow.remove(id);
     }
+    if (id >= 0 && id < (int)Num_Shells) {
+        _shells[blue][id] = nullptr;
+    }
 }
 
 Geometry2d::Point gaussianPoint(int n, float scale) {
@@ -344,51 +569,42 @@ Robot* Environment::robot(bool blue, int board_id) const {
     }
 }
 
-void Environment::handleRadioTx(bool blue, const Packet::RadioTx& tx) {
-    for (int i = 0; i < tx.robots_size(); ++i) {
-        const Packet::Robot& cmd = tx.robots(i);
+void Environment::sendRadioRx(bool blue, const Packet::RadioRxBatch& batch) {
+    std::string out;
+    batch.SerializeToString(&out);
 
-        Robot* r = robot(blue, cmd.uid());
-        if (r) {
-            // run controls update
-            r->radioTx(&cmd.control());
+    if (_sharedMemory) {
+        ShmRing& ring = _radioRxRings[blue ? 1 : 0];
+        if (ring.claimed()) {
+            ring.write(out);
+        }
+    } else if (blue) {
+        _radioSocketBlue.writeDatagram(&out[0], out.size(), LocalAddress,
+                                       RadioRxPort + _portOffset + 1);
+    } else {
+        _radioSocketYellow.writeDatagram(&out[0], out.size(), LocalAddress,
+                                         RadioRxPort + _portOffset);
+    }
+}
 
-            // trigger signals to update visualization
-            Geometry2d::Point pos2 = r->getPosition();
-            QVector3D pos3(pos2.x, pos2.y, 0.0);
-            QVector3D axis(0.0, 0.0, 1.0);
-        } else {
+void Environment::handleRadioTx(bool blue, const Packet::RadioTx& tx,
+                                Packet::RadioRxBatch& replies) {
+    Robot* const* shells = _shells[blue];
+    for (const Packet::Robot& cmd : tx.robots()) {
+        Robot* r = cmd.uid() < Num_Shells ? shells[cmd.uid()] : nullptr;
+        if (!r) {
             printf("Commanding nonexistent robot %s:%d\n",
                    blue ? "Blue" : "Yellow", cmd.uid());
+            continue;
         }
 
-        Packet::RadioRx rx = r->radioRx();
-        rx.set_robot_id(r->shell);
-
-        // Send the RX packet
-        std::string out;
-        rx.SerializeToString(&out);
-        if (blue)
-            _radioSocketBlue.writeDatagram(&out[0], out.size(), LocalAddress,
-                                           RadioRxPort + 1);
-        else
-            _radioSocketYellow.writeDatagram(&out[0], out.size(), LocalAddress,
-                                             RadioRxPort);
-    }
-
-    // FIXME: the interface changed for this part
-    // Robot *rev = robot(blue, tx.robot_id());
-    // if (rev)
-    // {
-    // 	Packet::RadioRx rx = rev->radioRx();
-    // 	rx.set_robot_id(tx.robot_id());
-    //
-    // 	// Send the RX packet
-    // 	std::string out;
-    // 	rx.SerializeToString(&out);
-    // 	_radioSocket[ch].writeDatagram(&out[0], out.size(), LocalAddress,
-    // RadioRxPort + ch);
-    // }
+        // run controls update
+        r->radioTx(&cmd.control());
+
+        Packet::RadioRx* rx = replies.add_packets();
+        r->radioRx(rx);
+        rx->set_robot_id(r->shell);
+    }
 }
 
 void Environment::renderScene(GL_ShapeDrawer* shapeDrawer,
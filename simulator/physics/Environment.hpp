@@ -9,9 +9,15 @@
 #include <QDomElement>
 #include <QString>
 #include <sys/time.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
 
+#include <Constants.hpp>
 #include <Geometry2d/Point.hpp>
+#include <ShmRing.hpp>
 
+#include <protobuf/RadioRx.pb.h>
 #include <protobuf/SimCommand.pb.h>
 
 #include "Ball.hpp"
@@ -22,6 +28,7 @@
 #include "GL_ShapeDrawer.h"
 
 class SSL_DetectionRobot;
+class SSL_WrapperPacket;
 
 class Environment : public QObject {
     Q_OBJECT;
@@ -36,6 +43,10 @@ private:
 
     RobotMap _blue;
     RobotMap _yellow;
+
+    // Robots by team (0 is yellow, 1 is blue) and shell for handling radio
+    // packets without searching the maps.  Unused shells are null.
+    Robot* _shells[2][Num_Shells];
     QVector<Ball*> _balls;
 
     QString _configFile;  //< filename for the config file
@@ -60,6 +71,45 @@ private:
 
     Field* _field;
 
+    // If true, the simulation only advances when a SimCommand asks it to
+    bool _lockstep;
+
+    // Simulated time in lockstep mode, in microseconds
+    uint64_t _simTime;
+
+    // setup_id of the last SimCommand applied, so resent setups are ignored
+    uint32_t _setupId;
+
+    // Decides which objects are visible in each vision frame.  This is seeded
+    // so runs can be repeated exactly.
+    std::mt19937 _random;
+
+    // Added to every port we use (see Network.hpp)
+    int _portOffset;
+
+    // If true, vision and radio go through these rings instead of UDP.
+    // Each is indexed like the ports it replaces.
+    bool _sharedMemory;
+    ShmRing _visionRings[2];
+    ShmRing _radioTxRings[2];
+    ShmRing _radioRxRings[2];
+
+    // Referee script from the last SimCommand that had one, sorted by time.
+    // Events before _refereeNext have been sent.
+    std::vector<Packet::SimCommand::RefereeEvent> _refereeEvents;
+    size_t _refereeNext;
+
+    // currentTime() when the referee script was received
+    uint64_t _refereeStart;
+
+    uint32_t _refereeCounter;
+
+    // If true, robots are driven by the firmware's control code
+    bool _firmware;
+
+    // Simulated seconds since the firmware's measurements were last printed
+    float _firmwareStatsTime;
+
 public:
     // If true, send data to the shared vision multicast address.
     // If false, send data to the two simulated vision addresses.
@@ -74,6 +124,33 @@ public:
     /** initializes the timer, connects sockets */
     void connectSockets();
 
+    /**
+     * In lockstep mode the environment is not stepped by a timer.  Instead,
+     * each SimCommand with step set runs a fixed number of physics steps and
+     * is answered with the resulting vision frame.
+     *
+     * This must be set before connectSockets() is called.
+     */
+    void lockstep(bool value) { _lockstep = value; }
+    bool lockstep() const { return _lockstep; }
+
+    void seed(uint32_t value) { _random.seed(value); }
+
+    /// Offset added to all ports so several simulators can run at once.
+    /// This must be set before connectSockets() is called.
+    void portOffset(int value) { _portOffset = value; }
+    int portOffset() const { return _portOffset; }
+
+    /// Sends simulated vision and radio through shared memory instead of UDP
+    /// (see ShmRing).  This must be set before connectSockets() is called.
+    void sharedMemory(bool value) { _sharedMemory = value; }
+    bool sharedMemory() const { return _sharedMemory; }
+
+    /// Runs the robot firmware's radio and control code for every robot (see
+    /// FirmwareRobot) and periodically prints how it performs
+    void firmware(bool value);
+    bool firmware() const { return _firmware; }
+
     void dropFrame() { _dropFrame = true; }
 
     const QVector<Ball*>& balls() const { return _balls; }
@@ -122,19 +199,44 @@ public:
 
 private:
     static void convert_robot(const Robot* robot, SSL_DetectionRobot* out);
-    void handleRadioTx(bool blue, const Packet::RadioTx& data);
+    // Applies a RadioTx and adds the robots' replies to <replies>
+    void handleRadioTx(bool blue, const Packet::RadioTx& data,
+                       Packet::RadioRxBatch& replies);
 
     void handleSimCommand(const Packet::SimCommand& cmd);
 
+    // Reads and applies all pending RadioTx packets and replies to each team
+    // that sent any
+    void receiveRadio();
+
+    // Sends RadioRx packets to the team's soccer
+    void sendRadioRx(bool blue, const Packet::RadioRxBatch& batch);
+
+    // Runs the physics steps requested by cmd and replies to the sender
+    void runSteps(const Packet::SimCommand& cmd, const QHostAddress& host,
+                  quint16 port);
+
     void sendVision();
 
+    // Sends the referee events that are due
+    void sendReferee();
+
+    // Simulated time in lockstep mode, otherwise wall clock time, in
+    // microseconds
+    uint64_t currentTime() const;
+
+    // Fills in a vision frame for the current state captured at <time>
+    // seconds
+    void fillVision(SSL_WrapperPacket& wrapper, double time);
+
     // Packet handling
     template <class PACKET>
-    bool loadPacket(QUdpSocket& socket, PACKET& packet) {
+    bool loadPacket(QUdpSocket& socket, PACKET& packet,
+                    QHostAddress* host = nullptr, quint16* port = nullptr) {
         std::string buf;
         unsigned int n = socket.pendingDatagramSize();
         buf.resize(n);
-        socket.readDatagram(&buf[0], n);
+        socket.readDatagram(&buf[0], n, host, port);
 
         if (!packet.ParseFromString(buf)) {
             printf("Bad packet of %d bytes\n", n);
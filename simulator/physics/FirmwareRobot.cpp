@@ -0,0 +1,230 @@
+#include "FirmwareRobot.hpp"
+
+#include <RadioCommand.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+
+using namespace std;
+using namespace RadioProtocol;
+
+// Length of a firmware control cycle in microseconds
+static const uint32_t CyclePeriod = SecondsPerCycle * 1000000;
+
+// Wheel speed, in ticks per cycle, that a motor reaches at one unit of duty
+// cycle with no load
+static const float TicksPerDuty = 0.25f;
+
+// Fraction of the way a motor gets to its new speed each cycle
+static const float MotorResponse = 0.3f;
+
+// Fraction of the way the wheels are pulled toward the speeds that match the
+// body's motion each physics step, for collisions and slipping
+static const float BodyCoupling = 0.5f;
+
+// A change in a wheel's target of at least this many ticks per cycle is timed
+static const int ResponseThreshold = 5;
+
+FirmwareRobot::FirmwareRobot(unsigned int shell)
+    : _shell(shell), _control(_motors) {
+    _router.port(rtp::port::CONTROL).rxCallback() = [this](rtp::packet* p) {
+        _control.receive(p->payload.data(), p->payload.size(), _shell);
+    };
+}
+
+void FirmwareRobot::velocity(const Velocity& v, Geometry2d::Point& velocity,
+                             float& angularVelocity) {
+    velocity.x = v.x * sqrtf(2) * MetersPerTick / SecondsPerCycle;
+    velocity.y = v.y * sqrtf(2) * MetersPerTick / SecondsPerCycle;
+    angularVelocity = v.w * RadiansPerTick / SecondsPerCycle;
+}
+
+void FirmwareRobot::radioTx(const Packet::Control& control) {
+    rtp::packet packet;
+    packet.port(rtp::port::CONTROL);
+
+    TrajectorySegment s = radioSegment(control, _shell);
+    if (control.has_segment()) {
+        TrajectoryPacket forward;
+        forward.count = 1;
+        forward.segments[0] = s;
+        packet.payload.resize(
+            forward.pack(packet.payload.data(), MaxTrajectorySize));
+    } else {
+        ForwardPacket forward;
+        forward.count = 1;
+        forward.commands[0] = s.command;
+        packet.payload.resize(
+            forward.pack(packet.payload.data(), MaxPacketSize));
+    }
+
+    fake_rtos::Rtos::time() = _motors.time;
+    _router.receive(packet);
+}
+
+void FirmwareRobot::step(float dt, Geometry2d::Point velocity,
+                         float angularVelocity,
+                         Geometry2d::Point& wheelVelocity,
+                         float& wheelAngularVelocity) {
+    // Body velocity in radio units
+    float x = velocity.x * SecondsPerCycle / MetersPerTick / sqrtf(2);
+    float y = velocity.y * SecondsPerCycle / MetersPerTick / sqrtf(2);
+    float w = angularVelocity * SecondsPerCycle / RadiansPerTick;
+
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        float body = (WheelControl::WheelX[i] * x +
+                      WheelControl::WheelY[i] * y) / 4096.0f + w;
+        _motors.speed[i] += (body - _motors.speed[i]) * BodyCoupling;
+    }
+
+    _pending += dt * 1000000;
+    while (_pending >= CyclePeriod) {
+        _pending -= CyclePeriod;
+        _motors.run();
+        _motors.time += CyclePeriod;
+
+        // This is the work of the radio and control threads for one cycle
+        auto start = chrono::steady_clock::now();
+        fake_rtos::Rtos::time() = _motors.time;
+        while (_router.dispatchRx(0)) {
+        }
+        _heading.update(angularVelocity, SecondsPerCycle, _control.stopped());
+        _control.imu(_heading.rate(), _heading.heading());
+        _control.step();
+        uint64_t cpu = chrono::duration_cast<chrono::nanoseconds>(
+                           chrono::steady_clock::now() - start)
+                           .count();
+
+        ++_cycles;
+        _cpuTotal += cpu;
+        _cpuMax = max(_cpuMax, cpu);
+
+        checkResponse();
+    }
+
+    // Find the body velocity that best matches the wheel speeds.  The rows of
+    // the kinematics matrix J are (WheelX, WheelY, 1) for each wheel, and this
+    // solves J^T J v = J^T speed.
+    float a[3][3] = {};
+    float b[3] = {};
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        float row[3] = {WheelControl::WheelX[i] / 4096.0f,
+                        WheelControl::WheelY[i] / 4096.0f, 1};
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                a[r][c] += row[r] * row[c];
+            }
+            b[r] += row[r] * _motors.speed[i];
+        }
+    }
+
+    auto det = [](float m[3][3]) {
+        return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    };
+
+    // Cramer's rule
+    float d = det(a);
+    float v[3];
+    for (int c = 0; c < 3; ++c) {
+        float m[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int k = 0; k < 3; ++k) {
+                m[r][k] = k == c ? b[r] : a[r][k];
+            }
+        }
+        v[c] = det(m) / d;
+    }
+
+    wheelVelocity.x = v[0] * sqrtf(2) * MetersPerTick / SecondsPerCycle;
+    wheelVelocity.y = v[1] * sqrtf(2) * MetersPerTick / SecondsPerCycle;
+    wheelAngularVelocity = v[2] * RadiansPerTick / SecondsPerCycle;
+}
+
+void FirmwareRobot::checkResponse() {
+    const WheelControl::Controller& controller = _control.controller();
+
+    // A new command starts a measurement
+    int step = 0;
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        step = max(step, abs(controller.target(i) - _lastTarget[i]));
+        _lastTarget[i] = controller.target(i);
+    }
+    if (step >= ResponseThreshold) {
+        _responding = true;
+        _responseStart = _motors.time;
+        _responseStep = step;
+    }
+
+    if (!_responding) {
+        return;
+    }
+
+    // Done when every wheel is within 10% of the change
+    float tolerance = max(2.0f, _responseStep * 0.1f);
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        if (fabsf(controller.target(i) - _motors.speed[i]) > tolerance) {
+            return;
+        }
+    }
+
+    uint32_t latency = _motors.time - _responseStart;
+    _responding = false;
+    ++_responses;
+    _responseTotal += latency;
+    _responseMax = max(_responseMax, latency);
+}
+
+void FirmwareRobot::printStats(const char* name) {
+    if (_cycles) {
+        printf("%s: firmware %.1f us/cycle (max %.1f), ", name,
+               _cpuTotal / 1000.0 / _cycles, _cpuMax / 1000.0);
+    } else {
+        printf("%s: firmware not run, ", name);
+    }
+
+    if (_responses) {
+        printf("wheels respond in %.1f ms (max %.1f) over %u commands\n",
+               _responseTotal / 1000.0 / _responses, _responseMax / 1000.0,
+               _responses);
+    } else {
+        printf("no commands timed\n");
+    }
+
+    _cycles = 0;
+    _cpuTotal = 0;
+    _cpuMax = 0;
+    _responses = 0;
+    _responseTotal = 0;
+    _responseMax = 0;
+}
+
+void FirmwareRobot::Motors::exchange(uint16_t* dutyCycles,
+                                     uint16_t* encoderDeltas, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        duty[i] = dutyCycles[i];
+
+        if (i < WheelControl::NumWheels) {
+            // Fractions of a tick are left for the next exchange
+            float ticks = truncf(turned[i]);
+            turned[i] -= ticks;
+            encoderDeltas[i] = static_cast<int16_t>(ticks);
+        } else {
+            encoderDeltas[i] = 0;
+        }
+    }
+}
+
+void FirmwareRobot::Motors::run() {
+    for (size_t i = 0; i < WheelControl::NumWheels; ++i) {
+        int magnitude = duty[i] & WheelControl::MaxDuty;
+        int signedDuty =
+            (duty[i] & WheelControl::DutyReverse) ? -magnitude : magnitude;
+
+        speed[i] += (signedDuty * TicksPerDuty - speed[i]) * MotorResponse;
+        turned[i] += speed[i];
+    }
+}
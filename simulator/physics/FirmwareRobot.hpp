@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Geometry2d/Point.hpp>
+#include <protobuf/Control.pb.h>
+
+#include <PacketRouter.hpp>
+#include <FakeRtos.hpp>
+#include <robot-control.hpp>
+
+#include <stdint.h>
+
+/**
+ * @brief Runs the robot firmware's radio and control code for a simulated
+ * robot
+ *
+ * @details Commands are packed as soccer packs them, as trajectory packets
+ * when they have a segment.  They go through the
+ * firmware's PacketRouter and RobotControl, which drive a model of the wheel
+ * motors every firmware control cycle.  The robot's body is then driven at
+ * the velocity that the wheels turn at, instead of the commanded velocity.
+ *
+ * The IMU is modeled as a perfect gyro.
+ *
+ * This also measures how long the firmware takes per control cycle on this
+ * computer, and how long the wheels take to reach a new command.
+ */
+class FirmwareRobot {
+public:
+    FirmwareRobot(unsigned int shell);
+
+    /// Sends a command to the firmware as the radio would
+    void radioTx(const Packet::Control& control);
+
+    /// Converts velocities in the radio's units to m/s and rad/s
+    static void velocity(const RadioProtocol::Velocity& v,
+                         Geometry2d::Point& velocity, float& angularVelocity);
+
+    /**
+     * Runs the firmware for <dt> seconds.
+     * @param velocity The robot's body velocity in m/s and rad/s
+     * @param wheelVelocity Set to the body velocity that the wheels drive at
+     */
+    void step(float dt, Geometry2d::Point velocity, float angularVelocity,
+              Geometry2d::Point& wheelVelocity, float& wheelAngularVelocity);
+
+    /// Prints the timing measurements and starts new ones
+    void printStats(const char* name);
+
+private:
+    // The wheel motors and encoders as seen by RobotControl
+    struct Motors {
+        uint32_t time = 0;
+
+        // Wheel speeds in encoder ticks per cycle
+        float speed[WheelControl::NumWheels] = {};
+
+        // Ticks turned since the last exchange, including fractions
+        float turned[WheelControl::NumWheels] = {};
+
+        // Duty cycles of the wheels and the dribbler
+        uint16_t duty[WheelControl::NumWheels + 1] = {};
+
+        uint32_t micros() { return time; }
+        void exchange(uint16_t* dutyCycles, uint16_t* encoderDeltas,
+                      size_t count);
+
+        // Advances the motors by one control cycle
+        void run();
+    };
+
+    // Checks if the wheels have reached a new command
+    void checkResponse();
+
+    unsigned int _shell;
+    Motors _motors;
+    RobotControl<Motors> _control;
+
+    // The gyro reads the body's turn rate exactly
+    ImuFusion::HeadingEstimator _heading;
+    PacketRouter<fake_rtos::Rtos> _router;
+
+    // Microseconds of simulated time not yet run
+    float _pending = 0;
+
+    // Wheel targets before the last cycle
+    int _lastTarget[WheelControl::NumWheels] = {};
+
+    // When the wheels started changing speed, and how far they need to go
+    bool _responding = false;
+    uint32_t _responseStart = 0;
+    int _responseStep = 0;
+
+    // Measurements since the last printStats()
+    unsigned int _cycles = 0;
+    uint64_t _cpuTotal = 0;
+    uint64_t _cpuMax = 0;
+    unsigned int _responses = 0;
+    uint64_t _responseTotal = 0;
+    uint32_t _responseMax = 0;
+};
@@ -1,10 +1,12 @@
 #include "Robot.hpp"
 #include "Ball.hpp"
 #include "Environment.hpp"
+#include "FirmwareRobot.hpp"
 #include "GL_ShapeDrawer.h"
 #include "RobotMotionState.hpp"
 #include "RobotBallController.hpp"
 
+#include <RadioCommand.hpp>
 #include <Utils.hpp>
 #include <stdio.h>
 #include <cmath>
@@ -50,6 +52,7 @@ Robot::~Robot() {
     delete _robotVehicle;
     delete _wheelShape;
     delete _controller;
+    delete _firmware;
 }
 
 void Robot::initPhysics(const bool& blue) {
@@ -245,8 +248,34 @@ void Robot::getWorldTransform(btTransform& chassisWorldTrans) const {
     _robotChassis->getMotionState()->getWorldTransform(chassisWorldTrans);
 }
 
+void Robot::firmware(bool enable) {
+    if (enable && !_firmware) {
+        _firmware = new FirmwareRobot(shell);
+    } else if (!enable) {
+        delete _firmware;
+        _firmware = nullptr;
+    }
+}
+
+void Robot::printFirmwareStats(const char* team) const {
+    if (_firmware) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s %u", team, shell);
+        _firmware->printStats(name);
+    }
+}
+
 void Robot::radioTx(const Packet::Control* data) {
-    velocity(data->xvelocity(), data->yvelocity(), data->avelocity());
+    if (_firmware) {
+        // The velocity is set from the wheels each step
+        _firmware->radioTx(*data);
+    } else {
+        velocity(data->xvelocity(), data->yvelocity(), data->avelocity());
+
+        // Followed in applyEngineForces() as the firmware would
+        _segment = radioSegment(*data, shell);
+        _segmentTime = 0;
+    }
     _controller->prepareKick(data->triggermode() != Packet::Control::STAND_DOWN
                                  ? data->kcstrength()
                                  : 0,
@@ -254,35 +283,31 @@ void Robot::radioTx(const Packet::Control* data) {
     _controller->prepareDribbler(data->dvelocity());
 }
 
-Packet::RadioRx Robot::radioRx() const {
-    Packet::RadioRx packet;
-
-    packet.set_timestamp(RJ::timestamp());
-    packet.set_battery(15.0f);
-    packet.set_rssi(1.0f);
-    packet.set_kicker_status(_controller->getKickerStatus());
+void Robot::radioRx(Packet::RadioRx* packet) const {
+    packet->set_timestamp(RJ::timestamp());
+    packet->set_battery(15.0f);
+    packet->set_rssi(1.0f);
+    packet->set_kicker_status(_controller->getKickerStatus());
 
     // FIXME: No.
-    packet.set_ball_sense_status(
+    packet->set_ball_sense_status(
         (_controller->hasBall() || !_controller->ballSensorWorks)
             ? Packet::HasBall
             : Packet::NoBall);
 
     // assume all motors working
     for (size_t i = 0; i < 5; ++i) {
-        packet.add_motor_status(Packet::Good);
+        packet->add_motor_status(Packet::Good);
     }
 
     if (_rev == rev2008) {
-        packet.set_hardware_version(Packet::RJ2008);
+        packet->set_hardware_version(Packet::RJ2008);
     } else if (_rev == rev2011)  // FIXME: change to actual 2011
     {
-        packet.set_hardware_version(Packet::RJ2011);
+        packet->set_hardware_version(Packet::RJ2011);
     } else {
-        packet.set_hardware_version(Packet::Unknown);
+        packet->set_hardware_version(Packet::Unknown);
     }
-
-    return packet;
 }
 
 void Robot::applyEngineForces() {
@@ -293,6 +318,30 @@ void Robot::applyEngineForces() {
 }
 
 void Robot::applyEngineForces(float deltaTime) {
+    if (_firmware) {
+        // Drive the body at the speed the firmware turns the wheels
+        btQuaternion worldRot = _robotChassis->getOrientation();
+        btVector3 robotVel = _robotChassis->getLinearVelocity();
+        robotVel.setY(0);
+        robotVel = robotVel.rotate(worldRot.getAxis(), -worldRot.getAngle());
+
+        Geometry2d::Point wheelVel;
+        float wheelRot;
+        _firmware->step(deltaTime,
+                        Geometry2d::Point(robotVel.z(), robotVel.x()) / scaling,
+                        _robotChassis->getAngularVelocity().getY(), wheelVel,
+                        wheelRot);
+        velocity(wheelVel.x, wheelVel.y, wheelRot);
+    } else if (_segment.length) {
+        _segmentTime += deltaTime;
+        uint32_t cycle = _segmentTime / RadioProtocol::SecondsPerCycle;
+
+        Geometry2d::Point vel;
+        float rot;
+        FirmwareRobot::velocity(_segment.at(cycle), vel, rot);
+        velocity(vel.x, vel.y, rot);
+    }
+
     if (_targetVel.length() < SIMD_EPSILON && _targetRot == 0) {
         for (int i = 0; i < 4; i++) {
             _engineForce[i] = 0;
@@ -7,7 +7,10 @@
 #include <protobuf/Control.pb.h>
 #include <protobuf/RadioRx.pb.h>
 
+#include <radio-protocol.hpp>
+
 class Ball;
+class FirmwareRobot;
 class RobotBallController;
 class GL_ShapeDrawer;
 
@@ -39,6 +42,9 @@ protected:
 
     RobotBallController* _controller;
 
+    // Runs the robot's firmware when set
+    FirmwareRobot* _firmware = nullptr;
+
     // control inputs
     float _engineForce[4];
     float _brakingForce;
@@ -46,6 +52,11 @@ protected:
     btVector3 _targetVel;
     btScalar _targetRot;
 
+    // The trajectory segment being followed without the firmware, and the
+    // seconds since it was received
+    RadioProtocol::TrajectorySegment _segment;
+    float _segmentTime = 0;
+
     // state info
     btTransform _startTransform;
 
@@ -124,11 +135,20 @@ public:
 
     void setBrakingForce(float val) { _brakingForce = val; }
 
+    /** drive through the robot firmware's control code instead of directly
+     * at commanded velocities */
+    void firmware(bool enable);
+
+    bool firmware() const { return _firmware != nullptr; }
+
+    /** print and reset the firmware's timing measurements */
+    void printFirmwareStats(const char* team) const;
+
     /** set control data */
     void radioTx(const Packet::Control* data);
 
     /** get robot information data */
-    Packet::RadioRx radioRx() const;
+    void radioRx(Packet::RadioRx* packet) const;
 
     void renderWheels(GL_ShapeDrawer* shapeDrawer,
                       const btVector3& worldBoundsMin,
@@ -173,6 +173,13 @@ void SimEngine::stepSimulation() {
     }
 }
 
+void SimEngine::stepSimulation(btScalar dt) {
+    if (_dynamicsWorld) {
+        // No substeps: one internal step of exactly dt
+        _dynamicsWorld->stepSimulation(dt, 0);
+    }
+}
+
 void SimEngine::debugDrawWorld() {
     if (_dynamicsWorld) _dynamicsWorld->debugDrawWorld();
 }
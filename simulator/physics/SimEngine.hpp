@@ -71,6 +71,13 @@ public:
     /** Key function for advancing the simulation forward in time */
     void stepSimulation();
 
+    /**
+     * Advances the simulation by exactly dt seconds, regardless of how much
+     * wall clock time has passed.  The same sequence of steps always gives
+     * the same results.
+     */
+    void stepSimulation(btScalar dt);
+
     btClock* getClock();
 
     void debugDrawWorld();
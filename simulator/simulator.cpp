@@ -8,6 +8,7 @@
 #include <QThread>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <signal.h>
 
 using namespace std;
@@ -26,6 +27,20 @@ void usage(const char* prog) {
         "\t--headless   Run the simulator in headless mode (without a GUI)\n");
     fprintf(stderr,
             "\t--smallfield Run the simulator with the small/single field.\n");
+    fprintf(stderr,
+            "\t--lockstep   Only advance when soccer sends a step command "
+            "(requires --headless)\n");
+    fprintf(stderr,
+            "\t--seed <n>   Seed for simulated vision noise (default 1)\n");
+    fprintf(stderr,
+            "\t--port-offset <n> Add n to all ports so several simulators "
+            "can run at once\n");
+    fprintf(stderr,
+            "\t--shm        Send vision and radio to soccer through shared "
+            "memory (soccer needs -shm)\n");
+    fprintf(stderr,
+            "\t--firmware   Drive robots through the robot firmware's control "
+            "code\n");
 }
 
 int main(int argc, char* argv[]) {
@@ -39,6 +54,11 @@ int main(int argc, char* argv[]) {
 
     bool sendShared = false;
     bool headless = false;
+    bool lockstep = false;
+    uint32_t seed = 1;
+    int portOffset = 0;
+    bool sharedMemory = false;
+    bool firmware = false;
 
     // loop arguments and look for config file
     for (int i = 1; i < argc; ++i) {
@@ -61,6 +81,28 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (strcmp(argv[i], "--headless") == 0) {
             headless = true;
+        } else if (strcmp(argv[i], "--lockstep") == 0) {
+            lockstep = true;
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            ++i;
+            if (i < argc) {
+                seed = strtoul(argv[i], nullptr, 10);
+            } else {
+                printf("Expected seed after --seed parameter\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--port-offset") == 0) {
+            ++i;
+            if (i < argc) {
+                portOffset = atoi(argv[i]);
+            } else {
+                printf("Expected offset after --port-offset parameter\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--shm") == 0) {
+            sharedMemory = true;
+        } else if (strcmp(argv[i], "--firmware") == 0) {
+            firmware = true;
         } else if (strcmp(argv[i], "--smallfield") == 0) {
             Field_Dimensions::Current_Dimensions =
                 Field_Dimensions::Single_Field_Dimensions * scaling;
@@ -70,6 +112,11 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (lockstep && !headless) {
+        printf("--lockstep requires --headless\n");
+        return 1;
+    }
+
     // create the thread for simulation
     SimulatorGLUTThread sim_thread(argc, argv, configFile, sendShared,
                                    !headless);
@@ -85,6 +132,12 @@ int main(int argc, char* argv[]) {
         win.show();
     }
 
+    sim_thread.env()->seed(seed);
+    sim_thread.env()->lockstep(lockstep);
+    sim_thread.env()->portOffset(portOffset);
+    sim_thread.env()->sharedMemory(sharedMemory);
+    sim_thread.env()->firmware(firmware);
+
     // initialize socket connections separately
     sim_thread.env()->connectSockets();
 
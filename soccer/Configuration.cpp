@@ -8,6 +8,8 @@
 
 std::list<Configurable*>* Configurable::_configurables;
 
+std::atomic<uint32_t> Configuration::_generation(1);
+
 // Role for tree column zero for storing ConfigItem pointers.
 static const int ConfigItemRole = Qt::UserRole;
 
@@ -37,6 +39,8 @@ void ConfigItem::valueChanged(const QString& str) {
 
 void ConfigItem::setupItem() { _treeItem->setText(1, toString()); }
 
+void ConfigItem::treeEdited() { setValue(_treeItem->text(1)); }
+
 ////////
 
 ConfigBool::ConfigBool(Configuration* tree, QString name, bool value,
@@ -46,14 +50,7 @@ ConfigBool::ConfigBool(Configuration* tree, QString name, bool value,
     addItem();
 }
 
-QString ConfigBool::toString() { return _value ? "true" : "false"; }
-
-bool ConfigBool::value() {
-    if (_treeItem) {
-        _value = _treeItem->checkState(1) == Qt::Checked;
-    }
-    return _value;
-}
+QString ConfigBool::toString() { return value() ? "true" : "false"; }
 
 void ConfigBool::setValue(const QString& str) {
     if (str == "true") {
@@ -65,9 +62,16 @@ void ConfigBool::setValue(const QString& str) {
         // clicked on it
         _value = (_treeItem->checkState(1) == Qt::Checked);
     }
+    changed();
     setupItem();
 }
 
+void ConfigBool::treeEdited() {
+    // The checkbox holds the value, not the text
+    _value = _treeItem->checkState(1) == Qt::Checked;
+    changed();
+}
+
 void ConfigBool::setupItem() {
     if (_treeItem) {
         _treeItem->setCheckState(1, _value ? Qt::Checked : Qt::Unchecked);
@@ -85,9 +89,12 @@ ConfigInt::ConfigInt(Configuration* config, QString name, int value,
     addItem();
 }
 
-QString ConfigInt::toString() { return QString::number(_value); }
+QString ConfigInt::toString() { return QString::number(value()); }
 
-void ConfigInt::setValue(const QString& str) { _value = str.toInt(); }
+void ConfigInt::setValue(const QString& str) {
+    _value = str.toInt();
+    changed();
+}
 
 ////////
 
@@ -98,9 +105,12 @@ ConfigDouble::ConfigDouble(Configuration* config, QString name, double value,
     addItem();
 }
 
-QString ConfigDouble::toString() { return QString::number(_value); }
+QString ConfigDouble::toString() { return QString::number(value()); }
 
-void ConfigDouble::setValue(const QString& str) { _value = str.toDouble(); }
+void ConfigDouble::setValue(const QString& str) {
+    _value = str.toDouble();
+    changed();
+}
 
 Configuration::Configuration() {
     _tree = nullptr;
@@ -185,7 +195,7 @@ void Configuration::itemChanged(QTreeWidgetItem* item, int column) {
     if (column == 1) {
         ConfigItem* ci = configItem(item);
         if (ci) {
-            ci->setValue(item->text(1));
+            ci->treeEdited();
         }
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <QDomDocument>
 #include <QFile>
@@ -33,6 +34,13 @@ public:
     bool load(const QString& filename, QString& error);
     bool save(const QString& filename, QString& error);
 
+    /// Incremented whenever the value of any item changes.  Code that runs
+    /// every frame can keep values computed from configuration items and only
+    /// recompute them when this changes.  Never zero.
+    static uint32_t generation() {
+        return _generation.load(std::memory_order_acquire);
+    }
+
 protected Q_SLOTS:
     void itemChanged(QTreeWidgetItem* item, int column);
 
@@ -51,12 +59,17 @@ protected:
     ConfigItem* configItem(QTreeWidgetItem* ti);
 
     QDomDocument _doc;
+
+    static std::atomic<uint32_t> _generation;
 };
 
 /**
  * Base class for items in configuration: this is constructed through
  * functions in the Configuration class which ensure new items are added
  * to the tree properly
+ *
+ * Values are changed by the GUI thread and read by the processing thread, so
+ * they are stored in atomics.  Reading a value never touches the tree.
  */
 class ConfigItem {
 protected:
@@ -75,6 +88,9 @@ public:
     // Called by Configuration when the user changes the value
     virtual void setValue(const QString& str) = 0;
 
+    // Called by Configuration when the item is edited in the tree
+    virtual void treeEdited();
+
 protected:
     friend class Configuration;
 
@@ -86,6 +102,11 @@ protected:
     // Called by subclasses to update item text
     void valueChanged(const QString& str);
 
+    // Called by subclasses after storing a new value
+    static void changed() {
+        Configuration::_generation.fetch_add(1, std::memory_order_release);
+    }
+
     QStringList _path;
     Configuration* _config;
     QTreeWidgetItem* _treeItem;
@@ -97,24 +118,26 @@ public:
     ConfigBool(Configuration* tree, QString name, bool value = false,
                std::string description = "");
 
-    bool value();
+    bool value() const { return _value.load(std::memory_order_relaxed); }
 
-    operator bool() { return value(); }
+    operator bool() const { return value(); }
 
     bool operator=(bool x) {
         _value = x;
+        changed();
         setupItem();
         return x;
     }
 
     virtual QString toString() override;
     virtual void setValue(const QString& str) override;
+    virtual void treeEdited() override;
 
 protected:
     friend class Configuration;
     virtual void setupItem() override;
 
-    bool _value;
+    std::atomic<bool> _value;
 };
 
 class ConfigInt : public ConfigItem {
@@ -125,23 +148,24 @@ public:
     virtual QString toString() override;
     virtual void setValue(const QString& str) override;
 
-    operator int() const { return _value; }
+    operator int() const { return value(); }
 
     int operator=(int x) {
         value(x);
         return x;
     }
 
-    int value() const { return _value; }
+    int value() const { return _value.load(std::memory_order_relaxed); }
 
     void value(int v) {
         _value = v;
+        changed();
         valueChanged(QString::number(v));
     }
 
 protected:
     friend class Configuration;
-    int _value;
+    std::atomic<int> _value;
 };
 
 class ConfigDouble : public ConfigItem {
@@ -152,23 +176,24 @@ public:
     virtual QString toString() override;
     virtual void setValue(const QString& str) override;
 
-    operator double() const { return _value; }
+    operator double() const { return value(); }
 
     double operator=(double x) {
         value(x);
         return x;
     }
 
-    double value() const { return _value; }
+    double value() const { return _value.load(std::memory_order_relaxed); }
 
     void value(double v) {
         _value = v;
+        changed();
         valueChanged(QString::number(v));
     }
 
 protected:
     friend class Configuration;
-    double _value;
+    std::atomic<double> _value;
 };
 
 #define REGISTER_CONFIGURABLE(x) static ConfigurableImpl<x> x##__configurable;
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+#include "Configuration.hpp"
+
+TEST(Configuration, generation) {
+    Configuration config;
+    ConfigDouble d(&config, "Test/Double", 1.5);
+    ConfigInt i(&config, "Test/Int", 2);
+    ConfigBool b(&config, "Test/Bool", false);
+
+    uint32_t generation = Configuration::generation();
+    EXPECT_NE(0u, generation);
+    EXPECT_EQ(1.5, (double)d);
+    EXPECT_EQ(generation, Configuration::generation());
+
+    d.setValue("2.5");
+    EXPECT_EQ(2.5, d.value());
+    EXPECT_NE(generation, Configuration::generation());
+
+    generation = Configuration::generation();
+    i = 7;
+    EXPECT_EQ(7, (int)i);
+    EXPECT_NE(generation, Configuration::generation());
+
+    generation = Configuration::generation();
+    b.setValue("true");
+    EXPECT_TRUE(b.value());
+    EXPECT_NE(generation, Configuration::generation());
+}
@@ -45,8 +45,21 @@ FieldView::FieldView(QWidget* parent) : QWidget(parent) {
     showCoords = false;
     showDotPatterns = false;
     showTeamNames = false;
+    showFrameTime = false;
     _rotate = 1;
     _history = nullptr;
+    _frameTime = 0;
+
+    // Nothing is cached yet, so the first paint computes everything
+    _transformRotate = -1;
+    _transformDefendPlusX = false;
+    _transformGeneration = 0;
+    _fieldGeneration = -1;
+    _fieldFlip = false;
+    _frameNumber = -1;
+    _layerFrameNumber = -1;
+    _layerTimestamp = 0;
+    _layerGeneration = -1;
 
     // Green background
     QPalette p = palette();
@@ -97,6 +110,9 @@ void FieldView::rotate(int value) {
 }
 
 void FieldView::paintEvent(QPaintEvent* e) {
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
     QPainter p(this);
 
     // antialiasing drastically improves rendering quality
@@ -108,12 +124,15 @@ void FieldView::paintEvent(QPaintEvent* e) {
         p.drawRect(rect());
     }
 
+    // Get the latest LogFrame
+    const std::shared_ptr<LogFrame> frame = currentFrame();
+
+    // Make coordinate transformations.  Until there is a frame, keep whichever
+    // side we were last defending.
+    updateTransforms(frame ? frame->defend_plus_x() : _transformDefendPlusX);
+
     // Set up world space
-    p.translate(width() / 2.0, height() / 2.0);
-    p.scale(width(), -height());
-    p.rotate(_rotate * 90);
-    p.scale(1.0 / Field_Dimensions::Current_Dimensions.FloorLength(),
-            1.0 / Field_Dimensions::Current_Dimensions.FloorWidth());
+    p.setTransform(_worldTransform);
 
     // Set text rotation for world space
     _textRotation = -_rotate * 90;
@@ -122,19 +141,78 @@ void FieldView::paintEvent(QPaintEvent* e) {
         drawCoords(p);
     }
 
-    // Get the latest LogFrame
-    const std::shared_ptr<LogFrame> frame = currentFrame();
-
     if (!frame) {
         // No data available yet
         return;
     }
 
-    // Make coordinate transformations
+    // The field markings only need to be drawn again when the view or the
+    // team colors change
+    bool flip = frame->blue_team() ^ frame->defend_plus_x();
+    if (_fieldGeneration != _transformGeneration || _fieldFlip != flip) {
+        _fieldPixmap = createPixmap();
+        QPainter fieldPainter(&_fieldPixmap);
+        fieldPainter.setRenderHint(QPainter::Antialiasing);
+        fieldPainter.setTransform(_worldTransform);
+        drawField(fieldPainter, frame.get());
+
+        _fieldGeneration = _transformGeneration;
+        _fieldFlip = flip;
+    }
+    p.resetTransform();
+    p.drawPixmap(0, 0, _fieldPixmap);
+    p.setTransform(_worldTransform);
+
+    // Draw world-space graphics
+    drawWorldSpace(p);
+
+    // Everything after this point is drawn in team space.
+    // Transform that into world space depending on defending goal.
+    p.setTransform(_teamTransform);
+
+    // Text has to be rotated so it is always upright on screen
+    _textRotation = -_rotate * 90 + (frame->defend_plus_x() ? -90 : 90);
+
+    drawTeamSpace(p);
+
+    // Smooth the paint time so the number is readable
+    float ms = paintTimer.nsecsElapsed() / 1e6f;
+    _frameTime = _frameTime * 0.9f + ms * 0.1f;
+
+    if (showFrameTime) {
+        p.resetTransform();
+        p.setPen(whitePen);
+        p.drawText(QPointF(6, height() - 6),
+                   QString("Paint: %1 ms").arg(_frameTime, 0, 'f', 1));
+    }
+}
+
+void FieldView::updateTransforms(bool defendPlusX) {
+    const Field_Dimensions& dims = Field_Dimensions::Current_Dimensions;
+    if (size() == _transformSize && _rotate == _transformRotate &&
+        defendPlusX == _transformDefendPlusX && dims == _transformDimensions) {
+        return;
+    }
+
+    _transformSize = size();
+    _transformRotate = _rotate;
+    _transformDefendPlusX = defendPlusX;
+    _transformDimensions = dims;
+    ++_transformGeneration;
+
+    _worldTransform = QTransform();
+    _worldTransform.translate(width() / 2.0, height() / 2.0);
+    _worldTransform.scale(width(), -height());
+    _worldTransform.rotate(_rotate * 90);
+    _worldTransform.scale(1.0 / dims.FloorLength(), 1.0 / dims.FloorWidth());
+
+    _teamTransform = _worldTransform;
+    _teamTransform.rotate(defendPlusX ? 90 : -90);
+    _teamTransform.translate(0, -dims.Length() / 2.0f);
+
     _screenToWorld = Geometry2d::TransformMatrix();
-    _screenToWorld *= Geometry2d::TransformMatrix::scale(
-        Field_Dimensions::Current_Dimensions.FloorLength(),
-        Field_Dimensions::Current_Dimensions.FloorWidth());
+    _screenToWorld *= Geometry2d::TransformMatrix::scale(dims.FloorLength(),
+                                                         dims.FloorWidth());
     _screenToWorld *=
         Geometry2d::TransformMatrix::rotate(-_rotate * M_PI / 2.0);
     _screenToWorld *=
@@ -143,48 +221,36 @@ void FieldView::paintEvent(QPaintEvent* e) {
         Geometry2d::TransformMatrix::translate(-width() / 2.0, -height() / 2.0);
 
     _worldToTeam = Geometry2d::TransformMatrix();
-    _worldToTeam *= Geometry2d::TransformMatrix::translate(
-        0, Field_Dimensions::Current_Dimensions.Length() / 2.0f);
-    if (frame->defend_plus_x()) {
+    _worldToTeam *=
+        Geometry2d::TransformMatrix::translate(0, dims.Length() / 2.0f);
+    if (defendPlusX) {
         _worldToTeam *= Geometry2d::TransformMatrix::rotate(-M_PI / 2.0);
     } else {
         _worldToTeam *= Geometry2d::TransformMatrix::rotate(M_PI / 2.0);
     }
 
     _teamToWorld = Geometry2d::TransformMatrix();
-    if (frame->defend_plus_x()) {
+    if (defendPlusX) {
         _teamToWorld *= Geometry2d::TransformMatrix::rotate(M_PI / 2.0);
     } else {
         _teamToWorld *= Geometry2d::TransformMatrix::rotate(-M_PI / 2.0);
     }
-    _teamToWorld *= Geometry2d::TransformMatrix::translate(
-        0, -Field_Dimensions::Current_Dimensions.Length() / 2.0f);
-
-    // Draw world-space graphics
-    drawWorldSpace(p);
-
-    // Everything after this point is drawn in team space.
-    // Transform that into world space depending on defending goal.
-    if (frame->defend_plus_x()) {
-        p.rotate(90);
-    } else {
-        p.rotate(-90);
-    }
-    p.translate(0, -Field_Dimensions::Current_Dimensions.Length() / 2.0f);
-
-    // Text has to be rotated so it is always upright on screen
-    _textRotation = -_rotate * 90 + (frame->defend_plus_x() ? -90 : 90);
+    _teamToWorld *=
+        Geometry2d::TransformMatrix::translate(0, -dims.Length() / 2.0f);
+}
 
-    drawTeamSpace(p);
+QPixmap FieldView::createPixmap() const {
+    // Match the screen resolution so cached drawing isn't blurry
+    QPixmap pixmap(size() * devicePixelRatio());
+    pixmap.setDevicePixelRatio(devicePixelRatio());
+    pixmap.fill(Qt::transparent);
+    return pixmap;
 }
 
 void FieldView::drawWorldSpace(QPainter& p) {
     // Get the latest LogFrame
     const LogFrame* frame = _history->at(0).get();
 
-    // Draw the field
-    drawField(p, frame);
-
     // Raw vision
     if (showRawBalls || showRawRobots) {
         tempPen.setColor(QColor(0xcc, 0xcc, 0xcc));
@@ -283,112 +349,7 @@ void FieldView::drawTeamSpace(QPainter& p) {
     p.setPen(ballTrailPen);
     p.drawPath(ballTrail);
 
-    // Debug lines
-    for (const DebugPath& path : frame->debug_paths()) {
-        if (path.layer() < 0 || layerVisible(path.layer())) {
-            tempPen.setColor(qcolor(path.color()));
-            p.setPen(tempPen);
-            std::vector<QPointF> pts;
-            for (int i = 0; i < path.points_size(); ++i) {
-                pts.push_back(qpointf(path.points(i)));
-            }
-            p.drawPolyline(pts.data(), pts.size());
-        }
-    }
-
-    for (const DebugRobotPath& path : frame->debug_robot_paths()) {
-        if (path.layer() < 0 || layerVisible(path.layer())) {
-            for (int i = 0; i < path.points_size() - 1; ++i) {
-                const DebugRobotPath::DebugRobotPathPoint& from =
-                    path.points(i);
-                const DebugRobotPath::DebugRobotPathPoint& to =
-                    path.points(i + 1);
-
-                Geometry2d::Point avgVel =
-                    (Geometry2d::Point(path.points(i).vel()) +
-                     Geometry2d::Point(path.points(i + 1).vel())) /
-                    2;
-                float pcntMaxSpd =
-                    avgVel.mag() / MotionConstraints::defaultMaxSpeed();
-                QColor mixedColor(
-                    std::max(0, std::min((int)(255 * pcntMaxSpd), 255)), 0,
-                    std::max(0, std::min((int)(255 * (1 - pcntMaxSpd)), 255)));
-                QPen pen(mixedColor);
-                pen.setCapStyle(Qt::RoundCap);
-                pen.setWidthF(0.03);
-                p.setPen(pen);
-
-                const Geometry2d::Point fromPos = Geometry2d::Point(from.pos());
-                const Geometry2d::Point toPos = Geometry2d::Point(to.pos());
-                p.drawLine(fromPos.toQPointF(), toPos.toQPointF());
-            }
-        }
-    }
-
-    // Debug circles
-    for (const DebugCircle& c : frame->debug_circles()) {
-        if (c.layer() < 0 || layerVisible(c.layer())) {
-            tempPen.setColor(c.color());
-            p.setPen(tempPen);
-            p.drawEllipse(qpointf(c.center()), c.radius(), c.radius());
-        }
-    }
-
-    // Debug arcs
-    for (const DebugArc& a : frame->debug_arcs()) {
-        if (a.layer() < 0 || layerVisible(a.layer())) {
-            tempPen.setColor(a.color());
-            p.setPen(tempPen);
-
-            auto c = a.center();
-            auto t1 = a.start();
-            auto t2 = a.end();
-            auto R = a.radius();
-
-            QRectF rect;
-            rect.setX(-R + c.x());
-            rect.setY(-R + c.y());
-            rect.setWidth(R * 2);
-            rect.setHeight(R * 2);
-
-            t1 *= -(180 / M_PI) * 16;
-            t2 *= -(180 / M_PI) * 16;
-
-            p.drawArc(rect, t1, t2 - t1);
-        }
-    }
-
-    // Debug text
-    for (const DebugText& text : frame->debug_texts()) {
-        if (text.layer() < 0 || layerVisible(text.layer())) {
-            tempPen.setColor(text.color());
-            p.setPen(tempPen);
-            drawText(p, qpointf(text.pos()),
-                     QString::fromStdString(text.text()), text.center());
-        }
-    }
-
-    // Debug polygons
-    p.setPen(Qt::NoPen);
-    for (const DebugPath& path : frame->debug_polygons()) {
-        if (path.layer() < 0 || layerVisible(path.layer())) {
-            if (path.points_size() < 3) {
-                fprintf(stderr, "Ignoring DebugPolygon with %d points\n",
-                        path.points_size());
-                continue;
-            }
-
-            QColor color = qcolor(path.color());
-            color.setAlpha(64);
-            p.setBrush(color);
-            std::vector<QPointF> pts;
-            for (int i = 0; i < path.points_size(); ++i) {
-                pts.push_back(qpointf(path.points(i)));
-            }
-            p.drawConvexPolygon(pts.data(), pts.size());
-        }
-    }
-    p.setBrush(Qt::NoBrush);
+    drawDebugLayers(p, frame);
 
     // maps robots to their comet trails, so we can draw a path of where each
     // robot has been over the past X frames the pair used as a key is of the
@@ -509,6 +470,148 @@ void FieldView::drawTeamSpace(QPainter& p) {
     }
 }
 
+void FieldView::drawDebugLayers(QPainter& p, const LogFrame* frame) {
+    // Debug items change nearly every frame, so a new frame is drawn straight
+    // to the screen.  Only a frame that is painted again, as when playback is
+    // paused, is kept in a pixmap.
+    bool sameFrame = _frameNumber >= 0 && _layerFrameNumber == _frameNumber &&
+                     _layerTimestamp == frame->timestamp() &&
+                     _layerGeneration == _transformGeneration &&
+                     _layerPixmapVisible == _layerVisible;
+    if (!sameFrame) {
+        _layerFrameNumber = _frameNumber;
+        _layerTimestamp = frame->timestamp();
+        _layerGeneration = _transformGeneration;
+        _layerPixmapVisible = _layerVisible;
+        _layerPixmap = QPixmap();
+        drawDebugItems(p, frame);
+        return;
+    }
+
+    if (_layerPixmap.isNull()) {
+        _layerPixmap = createPixmap();
+        QPainter layerPainter(&_layerPixmap);
+        layerPainter.setRenderHint(QPainter::Antialiasing);
+        layerPainter.setFont(p.font());
+        layerPainter.setTransform(_teamTransform);
+        drawDebugItems(layerPainter, frame);
+    }
+
+    p.save();
+    p.resetTransform();
+    p.drawPixmap(0, 0, _layerPixmap);
+    p.restore();
+}
+
+void FieldView::drawDebugItems(QPainter& p, const LogFrame* frame) {
+    // Debug lines
+    for (const DebugPath& path : frame->debug_paths()) {
+        if (path.layer() < 0 || layerVisible(path.layer())) {
+            tempPen.setColor(qcolor(path.color()));
+            p.setPen(tempPen);
+            std::vector<QPointF> pts;
+            for (int i = 0; i < path.points_size(); ++i) {
+                pts.push_back(qpointf(path.points(i)));
+            }
+            p.drawPolyline(pts.data(), pts.size());
+        }
+    }
+
+    for (const DebugRobotPath& path : frame->debug_robot_paths()) {
+        if (path.layer() < 0 || layerVisible(path.layer())) {
+            for (int i = 0; i < path.points_size() - 1; ++i) {
+                const DebugRobotPath::DebugRobotPathPoint& from =
+                    path.points(i);
+                const DebugRobotPath::DebugRobotPathPoint& to =
+                    path.points(i + 1);
+
+                Geometry2d::Point avgVel =
+                    (Geometry2d::Point(path.points(i).vel()) +
+                     Geometry2d::Point(path.points(i + 1).vel())) /
+                    2;
+                float pcntMaxSpd =
+                    avgVel.mag() / MotionConstraints::defaultMaxSpeed();
+                QColor mixedColor(
+                    std::max(0, std::min((int)(255 * pcntMaxSpd), 255)), 0,
+                    std::max(0, std::min((int)(255 * (1 - pcntMaxSpd)), 255)));
+                QPen pen(mixedColor);
+                pen.setCapStyle(Qt::RoundCap);
+                pen.setWidthF(0.03);
+                p.setPen(pen);
+
+                const Geometry2d::Point fromPos = Geometry2d::Point(from.pos());
+                const Geometry2d::Point toPos = Geometry2d::Point(to.pos());
+                p.drawLine(fromPos.toQPointF(), toPos.toQPointF());
+            }
+        }
+    }
+
+    // Debug circles
+    for (const DebugCircle& c : frame->debug_circles()) {
+        if (c.layer() < 0 || layerVisible(c.layer())) {
+            tempPen.setColor(c.color());
+            p.setPen(tempPen);
+            p.drawEllipse(qpointf(c.center()), c.radius(), c.radius());
+        }
+    }
+
+    // Debug arcs
+    for (const DebugArc& a : frame->debug_arcs()) {
+        if (a.layer() < 0 || layerVisible(a.layer())) {
+            tempPen.setColor(a.color());
+            p.setPen(tempPen);
+
+            auto c = a.center();
+            auto t1 = a.start();
+            auto t2 = a.end();
+            auto R = a.radius();
+
+            QRectF rect;
+            rect.setX(-R + c.x());
+            rect.setY(-R + c.y());
+            rect.setWidth(R * 2);
+            rect.setHeight(R * 2);
+
+            t1 *= -(180 / M_PI) * 16;
+            t2 *= -(180 / M_PI) * 16;
+
+            p.drawArc(rect, t1, t2 - t1);
+        }
+    }
+
+    // Debug text
+    for (const DebugText& text : frame->debug_texts()) {
+        if (text.layer() < 0 || layerVisible(text.layer())) {
+            tempPen.setColor(text.color());
+            p.setPen(tempPen);
+            drawText(p, qpointf(text.pos()),
+                     QString::fromStdString(text.text()), text.center());
+        }
+    }
+
+    // Debug polygons
+    p.setPen(Qt::NoPen);
+    for (const DebugPath& path : frame->debug_polygons()) {
+        if (path.layer() < 0 || layerVisible(path.layer())) {
+            if (path.points_size() < 3) {
+                fprintf(stderr, "Ignoring DebugPolygon with %d points\n",
+                        path.points_size());
+                continue;
+            }
+
+            QColor color = qcolor(path.color());
+            color.setAlpha(64);
+            p.setBrush(color);
+            std::vector<QPointF> pts;
+            for (int i = 0; i < path.points_size(); ++i) {
+                pts.push_back(qpointf(path.points(i)));
+            }
+            p.drawConvexPolygon(pts.data(), pts.size());
+        }
+    }
+    p.setBrush(Qt::NoBrush);
+}
+
 void FieldView::drawText(QPainter& p, QPointF pos, QString text, bool center) {
     p.save();
     p.translate(pos);
@@ -5,15 +5,26 @@
 
 #include <Geometry2d/Point.hpp>
 #include <Geometry2d/TransformMatrix.hpp>
+#include <Field_Dimensions.hpp>
 #include <protobuf/LogFrame.pb.h>
 
 #include <set>
 #include <memory>
 #include <QLabel>
+#include <QPixmap>
+#include <QTransform>
 
 class Logger;
 
-/** class that performs drawing of log data onto the field */
+/**
+ * class that performs drawing of log data onto the field
+ *
+ * The field markings only change with the widget size, rotation, field
+ * dimensions, and team/side, so they are rendered once into a pixmap and
+ * reused.  Debug layers change nearly every frame, so they are drawn directly
+ * and only kept in a pixmap while the same frame is repainted.  Robots, the
+ * ball, and trails are drawn directly on every paint.
+ */
 class FieldView : public QWidget {
 public:
     FieldView(QWidget* parent = nullptr);
@@ -39,6 +50,10 @@ public:
         _history = value;
     }
 
+    // Sets the number of the frame at the front of the history.  Cached
+    // drawing of a frame is only reused while this stays the same.
+    void frameNumber(int value) { _frameNumber = value; }
+
     void rotate(int value);
 
     const Geometry2d::TransformMatrix& getTeamToWorld() const {
@@ -55,6 +70,9 @@ public:
     bool showDotPatterns;
     bool showTeamNames;
 
+    // Shows how long painting takes in the corner of the view
+    bool showFrameTime;
+
 protected:
     virtual void paintEvent(QPaintEvent* e) override;
     virtual void resizeEvent(QResizeEvent* e) override;
@@ -71,15 +89,60 @@ protected:
                    float theta, bool hasBall = false, bool faulty = false);
     void drawCoords(QPainter& p);
 
+    // Draws all visible debug layers of a frame in team space
+    void drawDebugLayers(QPainter& p, const Packet::LogFrame* frame);
+
+    // Draws the debug items on visible layers in team space
+    void drawDebugItems(QPainter& p, const Packet::LogFrame* frame);
+
 protected:
     // Returns a pointer to the most recent frame, or null if none is available.
     std::shared_ptr<Packet::LogFrame> currentFrame();
 
+    // Recomputes the coordinate transformations if anything they depend on
+    // has changed.  This also invalidates the cached pixmaps.
+    void updateTransforms(bool defendPlusX);
+
+    // Returns a transparent pixmap the size of the widget
+    QPixmap createPixmap() const;
+
     // Coordinate transformations
     Geometry2d::TransformMatrix _screenToWorld;
     Geometry2d::TransformMatrix _worldToTeam;
     Geometry2d::TransformMatrix _teamToWorld;
 
+    // Painter transformations from world and team space to the screen
+    QTransform _worldTransform;
+    QTransform _teamTransform;
+
+    // What the transformations were computed for
+    QSize _transformSize;
+    int _transformRotate;
+    bool _transformDefendPlusX;
+    Field_Dimensions _transformDimensions;
+
+    // Incremented whenever the transformations change
+    int _transformGeneration;
+
+    // Field markings, drawn in world space
+    QPixmap _fieldPixmap;
+    int _fieldGeneration;
+    bool _fieldFlip;
+
+    // Number of the frame at the front of the history, or -1 if unknown
+    int _frameNumber;
+
+    // Visible debug layers of the frame that was last painted, once it is
+    // painted a second time, and what they were drawn for
+    QPixmap _layerPixmap;
+    int _layerFrameNumber;
+    uint64_t _layerTimestamp;
+    int _layerGeneration;
+    QVector<bool> _layerPixmapVisible;
+
+    // Smoothed time taken by paintEvent in milliseconds
+    float _frameTime;
+
     // Label used to display current coordinates of mouse
     QLabel* _posLabel;
 
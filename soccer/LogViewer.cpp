@@ -128,6 +128,7 @@ void LogViewer::updateViews() {
     for (int i = n; i < (int)_history.size(); ++i) {
         _history[i].reset();
     }
+    ui.fieldView->frameNumber(f);
 
     // Update non-message tree items
     _frameNumberItem->setData(ProtobufTree::Column_Value, Qt::DisplayRole,
@@ -9,11 +9,25 @@ using namespace std;
 using namespace Packet;
 using namespace google::protobuf::io;
 
-Logger::Logger() {
+// Maximum number of evicted frames kept around for reuse
+static const size_t MaxFreeFrames = 8;
+
+// zlib compression level for serialized history.  Higher levels barely shrink
+// LogFrames further and take much longer.
+static const int CompressionLevel = 1;
+
+// Frames between measurements of how much more memory a decoded frame takes
+// than its serialized size
+static const int SpaceSamplePeriod = 60;
+
+Logger::Logger(size_t maxSpace, int decodedFrames) {
     _fd = -1;
-    _history.resize(100000);
     _nextFrameNumber = 0;
-    _spaceUsed = sizeof(_history[0]) * _history.size();
+    _spaceUsed = 0;
+    _maxSpace = maxSpace;
+    _decodedFrames = max(1, decodedFrames);
+    _compress = true;
+    _spaceRatio = 1;
 }
 
 Logger::~Logger() { close(); }
@@ -45,13 +59,48 @@ void Logger::close() {
     }
 }
 
+shared_ptr<LogFrame> Logger::createFrame() {
+    shared_ptr<LogFrame> frame;
+    {
+        QMutexLocker locker(&_mutex);
+        if (!_freeFrames.empty()) {
+            frame = std::move(_freeFrames.back());
+            _freeFrames.pop_back();
+        }
+    }
+
+    if (frame) {
+        // Clear() keeps the memory for repeated and sub-messages, so filling
+        // this frame in mostly doesn't allocate.
+        frame->Clear();
+    } else {
+        frame = make_shared<LogFrame>();
+    }
+
+    return frame;
+}
+
 void Logger::addFrame(shared_ptr<LogFrame> frame) {
+    storeFrame(std::move(frame));
+    encodeHistory();
+}
+
+void Logger::storeFrame(shared_ptr<LogFrame> frame) {
+    // A decoded frame takes more memory than its serialized size.
+    // SpaceUsed() measures that, but it walks every message, so it is only
+    // sampled and the ratio is applied to the other frames.
+    int frameSize = frame->ByteSize();
+    if (_nextFrameNumber % SpaceSamplePeriod == 0 && frameSize > 0) {
+        _spaceRatio = (float)frame->SpaceUsed() / frameSize;
+    }
+    size_t frameSpace = frameSize * _spaceRatio;
+
     QMutexLocker locker(&_mutex);
 
     // Write this from to the file
     if (_fd >= 0) {
         if (frame->IsInitialized()) {
-            uint32_t size = frame->ByteSize();
+            uint32_t size = frameSize;
             if (write(_fd, &size, sizeof(size)) != sizeof(size)) {
                 printf("Logger: Failed to write size, closing log: %m\n");
                 close();
@@ -65,36 +114,104 @@ void Logger::addFrame(shared_ptr<LogFrame> frame) {
         }
     }
 
-    // Get the place in the circular buffer where we will store this frame
-    int i = _nextFrameNumber % _history.size();
+    // Store the new LogFrame
+    _history.emplace_back();
+    Entry& entry = _history.back();
+    entry.frame = std::move(frame);
+    entry.size = sizeof(Entry) + frameSpace;
+    _spaceUsed += entry.size;
+
+    // Go to the next frame
+    ++_nextFrameNumber;
+
+    dropOldest();
+}
 
-    if (_history[i]) {
-        // Remove the space used by the old data
-        _spaceUsed -= _history[i]->SpaceUsed();
+void Logger::encodeHistory() {
+    bool compress;
+    {
+        QMutexLocker locker(&_mutex);
+        compress = _compress;
     }
 
-    // Create a new LogFrame
-    _history[i] = frame;
+    // Serialize the frames that have left the decoded part of the history,
+    // newest first.  Only this thread changes _history, so this is done
+    // without the lock to keep the GUI from waiting on it.  Frames may be
+    // missing required fields, so partial serialization is used.
+    for (int i = (int)_history.size() - 1 - _decodedFrames;
+         i >= 0 && _history[i].frame; --i) {
+        const LogFrame& old = *_history[i].frame;
+        QByteArray data;
+        data.resize(old.ByteSize());
+        old.SerializePartialToArray(data.data(), data.size());
+        if (compress) {
+            data = qCompress(data, CompressionLevel);
+        }
 
-    // Add space used by the new data
-    _spaceUsed += _history[i]->SpaceUsed();
+        QMutexLocker locker(&_mutex);
+        Entry& entry = _history[i];
+        _spaceUsed -= entry.size;
+        recycle(entry.frame);
+        entry.data = data;
+        entry.compressed = compress;
+        entry.size = sizeof(Entry) + data.size();
+        _spaceUsed += entry.size;
+    }
 
-    // Go to the next frame
-    ++_nextFrameNumber;
+    QMutexLocker locker(&_mutex);
+    dropOldest();
+}
+
+void Logger::dropOldest() {
+    // The most recent frame is always kept
+    while (_spaceUsed > _maxSpace && _history.size() > 1) {
+        Entry& oldest = _history.front();
+        _spaceUsed -= oldest.size;
+        recycle(oldest.frame);
+        _history.pop_front();
+    }
+}
+
+void Logger::recycle(shared_ptr<LogFrame>& frame) {
+    // If no one else is looking at the frame, keep it for reuse.
+    // Other threads can only get a new reference while _mutex is held.
+    if (frame && frame.use_count() == 1 && _freeFrames.size() < MaxFreeFrames) {
+        _freeFrames.push_back(std::move(frame));
+    }
+    frame.reset();
+}
+
+shared_ptr<LogFrame> Logger::decode(const QByteArray& data, bool compressed) {
+    QByteArray raw = compressed ? qUncompress(data) : data;
+
+    shared_ptr<LogFrame> frame = make_shared<LogFrame>();
+    if (!frame->ParsePartialFromArray(raw.constData(), raw.size())) {
+        return nullptr;
+    }
+
+    return frame;
 }
 
 shared_ptr<LogFrame> Logger::lastFrame() const {
     QMutexLocker locker(&_mutex);
-    return _history[(_nextFrameNumber - 1) % _history.size()];
+    if (_history.empty()) {
+        return nullptr;
+    }
+    return _history.back().frame;
 }
 
 int Logger::getFrames(int start, vector<shared_ptr<LogFrame> >& frames) const {
+    // Serialized frames that need to be decoded
+    struct Pending {
+        int index;
+        QByteArray data;
+        bool compressed;
+    };
+    vector<Pending> pending;
+
     QMutexLocker locker(&_mutex);
 
     int minFrame = _nextFrameNumber - (int)_history.size();
-    if (minFrame < 0) {
-        minFrame = 0;
-    }
 
     if (start < minFrame || start >= _nextFrameNumber) {
         return 0;
@@ -107,12 +224,42 @@ int Logger::getFrames(int start, vector<shared_ptr<LogFrame> >& frames) const {
 
     int n = start - end + 1;
     for (int i = 0; i < n; ++i) {
-        frames[i] = _history[(start - i) % _history.size()];
+        const Entry& entry = _history[start - i - minFrame];
+        if (entry.frame) {
+            frames[i] = entry.frame;
+        } else {
+            frames[i] = entry.decoded.lock();
+            if (!frames[i]) {
+                // QByteArray is implicitly shared, so this doesn't copy
+                pending.push_back(Pending{i, entry.data, entry.compressed});
+            }
+        }
     }
 
     for (int i = n; i < (int)frames.size(); ++i) {
         frames[i].reset();
     }
 
+    if (pending.empty()) {
+        return n;
+    }
+
+    // Decode without holding the lock so the processor isn't held up
+    locker.unlock();
+    for (Pending& p : pending) {
+        frames[p.index] = decode(p.data, p.compressed);
+    }
+    locker.relock();
+
+    // Remember the decoded frames.  Old frames may have been dropped while
+    // we were decoding, so look them up again.
+    minFrame = _nextFrameNumber - (int)_history.size();
+    for (const Pending& p : pending) {
+        int index = start - p.index - minFrame;
+        if (index >= 0 && frames[p.index]) {
+            _history[index].decoded = frames[p.index];
+        }
+    }
+
     return n;
 }
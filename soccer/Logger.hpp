@@ -7,10 +7,7 @@
  * debug information about the current play. See the LogFrame.proto file for a
  * full list of what is stored in the log.
  *
- * This logger implements a circular buffer for recent history and writes all
- * frames to disk.
- *
- * _history is a circular buffer.
+ * This logger keeps recent history in memory and writes all frames to disk.
  *
  * Consider a sequence number for each frame, where the first frame passed
  * to addFrame() has a sequence number of zero and the sequence number is one
@@ -19,31 +16,48 @@
  * _nextFrameNumber is the sequence number of the next frame to be stored by
  * addFrame().
  *
- * lastFrame() returns the sequence number of the latest available frame.
+ * lastFrameNumber() returns the sequence number of the latest available frame.
  * It returns -1 if no frames have been stored.
  *
- * You can get a copy of a frame by passing its sequence number to getFrame().
- * If the frame is too old to be in the circular buffer (or the sequence number
- * is beyond the most recent available) then getFrame() will return false.
+ * You can get copies of frames by passing a sequence number to getFrames().
+ * Frames that are too old to be in the history (or sequence numbers beyond the
+ * most recent available) are returned as null pointers.
+ *
+ * History is limited by memory rather than by a number of frames.  The most
+ * recent frames are kept as LogFrame objects.  Older frames are serialized
+ * (and optionally compressed), which is several times smaller, and are decoded
+ * again when getFrames() asks for them.  Once the history uses more than
+ * maxSpace() bytes the oldest frames are dropped.
  *
- * Frames are allocated as they are first needed.  The size of the circular
- * buffer limits total memory usage.
+ * New frames should be obtained from createFrame().  Frames that are
+ * serialized or dropped from the history and that nobody else holds are
+ * cleared and handed out again, so the protobuf submessages they contain are
+ * reused instead of being reallocated every frame.
  */
 
 #pragma once
 
 #include <protobuf/LogFrame.pb.h>
 
+#include <QByteArray>
 #include <QString>
 #include <QMutexLocker>
 #include <QMutex>
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <memory>
 
 class Logger {
 public:
-    Logger();
+    /// Default memory limit for the history in bytes
+    static const size_t DefaultMaxSpace = 1024 * 1024 * 1024;
+
+    /// Default number of recent frames kept decoded (ten seconds)
+    static const int DefaultDecodedFrames = 10 * 60;
+
+    Logger(size_t maxSpace = DefaultMaxSpace,
+           int decodedFrames = DefaultDecodedFrames);
     ~Logger();
 
     bool open(QString filename);
@@ -51,12 +65,6 @@ public:
 
     // Returns the number of available frames
     int numFrames() const {
-        QMutexLocker locker(&_mutex);
-        return std::min(_nextFrameNumber, (int)_history.size());
-    }
-
-    // Returns the size of the circular buffer
-    int maxFrames() const {
         QMutexLocker locker(&_mutex);
         return _history.size();
     }
@@ -68,7 +76,7 @@ public:
         if (_nextFrameNumber == 0) {
             return -1;
         } else {
-            return std::max(0, _nextFrameNumber - (int)_history.size());
+            return _nextFrameNumber - (int)_history.size();
         }
     }
 
@@ -81,8 +89,23 @@ public:
 
     std::shared_ptr<Packet::LogFrame> lastFrame() const;
 
+    // Returns an empty LogFrame, recycled from the history if possible.
+    // This is only meant to be called from the thread that adds frames.
+    std::shared_ptr<Packet::LogFrame> createFrame();
+
+    // Stores a frame and writes it to the log file, then encodes the history
+    // as encodeHistory() does.
     void addFrame(std::shared_ptr<Packet::LogFrame> frame);
 
+    // Stores a frame and writes it to the log file.  Serializing the frame
+    // updates its cached sizes, so no other thread may be reading it yet.
+    void storeFrame(std::shared_ptr<Packet::LogFrame> frame);
+
+    // Serializes and compresses the frames that have left the decoded part
+    // of the history.  This takes a while, so it shouldn't be called while
+    // holding locks that other threads wait on.
+    void encodeHistory();
+
     // Gets frames.size() frames starting at <i> and working backwards.
     // Clears any frames that couldn't be populated.
     // Returns the number of frames copied.
@@ -90,12 +113,37 @@ public:
         int start,
         std::vector<std::shared_ptr<Packet::LogFrame> >& frames) const;
 
-    // Returns the amount of memory used by all LogFrames in the history.
-    int spaceUsed() const {
+    // Returns the approximate amount of memory used by the history.
+    // Decoded frames are counted by their serialized size times the ratio of
+    // SpaceUsed() to serialized size in a recently sampled frame.
+    size_t spaceUsed() const {
         QMutexLocker locker(&_mutex);
         return _spaceUsed;
     }
 
+    // Memory limit for the history in bytes
+    size_t maxSpace() const {
+        QMutexLocker locker(&_mutex);
+        return _maxSpace;
+    }
+
+    void maxSpace(size_t bytes) {
+        QMutexLocker locker(&_mutex);
+        _maxSpace = bytes;
+    }
+
+    // If true, serialized frames are also compressed.  This only affects
+    // frames that are serialized after it is changed.
+    bool compress() const {
+        QMutexLocker locker(&_mutex);
+        return _compress;
+    }
+
+    void compress(bool value) {
+        QMutexLocker locker(&_mutex);
+        _compress = value;
+    }
+
     bool recording() const {
         QMutexLocker locker(&_mutex);
         return _fd >= 0;
@@ -107,25 +155,71 @@ public:
     }
 
 private:
+    /// One frame of history.  Exactly one of frame and data is set, except
+    /// that a serialized frame may also have a cached decoded copy.
+    struct Entry {
+        std::shared_ptr<Packet::LogFrame> frame;
+
+        /// Serialized frame, compressed if compressed is set
+        QByteArray data;
+        bool compressed = false;
+
+        /// Frame most recently decoded from data.  This is only valid while
+        /// someone (usually the GUI's copy of recent history) still holds it,
+        /// so scrubbing back and forth doesn't decode the same frames
+        /// repeatedly.
+        mutable std::weak_ptr<Packet::LogFrame> decoded;
+
+        /// Number of bytes this entry is counted as in _spaceUsed
+        size_t size = 0;
+    };
+
+    /// Decodes a serialized entry.  Returns null if the data is corrupt.
+    static std::shared_ptr<Packet::LogFrame> decode(const QByteArray& data,
+                                                    bool compressed);
+
+    /// Keeps a frame that is leaving the history for reuse if no one else
+    /// refers to it.  _mutex must be locked.
+    void recycle(std::shared_ptr<Packet::LogFrame>& frame);
+
+    /// Drops the oldest frames until the history fits in _maxSpace.  _mutex
+    /// must be locked.
+    void dropOldest();
+
     mutable QMutex _mutex;
 
     QString _filename;
 
     /**
      * Frame history.
-     * Increasing indices correspond to earlier times.
-     * This must only be accessed while _mutex is locked.
+     * The front is the oldest frame and the back is the most recent.
+     * This must only be accessed while _mutex is locked.  Only addFrame()
+     * changes it, so the thread that adds frames can read it without the lock.
      *
      * It is not safe to modify a single std::shared_ptr from multiple threads,
      * but after it is copied the copies can be used and destroyed freely in
      * different threads.
      */
-    std::vector<std::shared_ptr<Packet::LogFrame> > _history;
+    std::deque<Entry> _history;
+
+    // Frames evicted from _history that can be reused by createFrame().
+    // They are cleared when they are handed out, not while _mutex is held.
+    std::vector<std::shared_ptr<Packet::LogFrame> > _freeFrames;
 
     // Sequence number of the next frame to be written
     int _nextFrameNumber;
 
-    int _spaceUsed;
+    size_t _spaceUsed;
+    size_t _maxSpace;
+
+    // Memory a decoded frame takes per byte of its serialized size, as last
+    // sampled.  Only the thread that adds frames uses this.
+    float _spaceRatio;
+
+    // Number of recent frames kept as LogFrame objects
+    int _decodedFrames;
+
+    bool _compress;
 
     // File descriptor for log file
     int _fd;
@@ -0,0 +1,186 @@
+/**
+ * Measures the cost of producing and storing LogFrames the way Processor does.
+ *
+ * Two strategies are compared:
+ * - fresh: a new LogFrame is allocated every frame and its memory is measured
+ *   with SpaceUsed() when it is added and again when it is evicted (the old
+ *   Logger behavior)
+ * - pooled: frames come from Logger::createFrame() and are stored with
+ *   Logger::addFrame(), which also serializes and compresses the frame that
+ *   leaves the decoded part of the history
+ *
+ * For each strategy this prints the number of heap allocations per frame and
+ * the time spent storing each frame.
+ */
+
+#include <Logger.hpp>
+#include <protobuf/messages_robocup_ssl_wrapper.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using namespace Packet;
+
+static atomic<long> allocationCount(0);
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    void* p = malloc(size);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Fills a frame with roughly what a frame during a match contains
+static void fillFrame(LogFrame* frame, int n) {
+    frame->set_timestamp(n);
+    frame->set_command_time(n);
+    frame->set_blue_team(true);
+
+    for (int cam = 0; cam < 2; ++cam) {
+        SSL_DetectionFrame* det = frame->add_raw_vision()->mutable_detection();
+        det->set_frame_number(n);
+        det->set_t_capture(n);
+        det->set_t_sent(n);
+        det->set_camera_id(cam);
+        SSL_DetectionBall* ball = det->add_balls();
+        ball->set_confidence(1);
+        ball->set_x(0);
+        ball->set_y(0);
+        ball->set_pixel_x(0);
+        ball->set_pixel_y(0);
+        for (int i = 0; i < 12; ++i) {
+            SSL_DetectionRobot* robot = (i < 6) ? det->add_robots_blue()
+                                                : det->add_robots_yellow();
+            robot->set_confidence(1);
+            robot->set_robot_id(i % 6);
+            robot->set_x(i);
+            robot->set_y(i);
+            robot->set_orientation(0);
+            robot->set_pixel_x(i);
+            robot->set_pixel_y(i);
+        }
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        LogFrame::Robot* robot = frame->add_self();
+        robot->set_shell(i);
+        robot->set_angle(0);
+        robot->mutable_pos()->set_x(i);
+        robot->mutable_pos()->set_y(i);
+        robot->mutable_world_vel()->set_x(0);
+        robot->mutable_world_vel()->set_y(0);
+
+        DebugRobotPath* path = frame->add_debug_robot_paths();
+        path->set_layer(0);
+        for (int j = 0; j < 20; ++j) {
+            DebugRobotPath::DebugRobotPathPoint* pt = path->add_points();
+            pt->mutable_pos()->set_x(j);
+            pt->mutable_pos()->set_y(j);
+        }
+
+        Packet::Robot* tx = frame->mutable_radio_tx()->add_robots();
+        tx->set_uid(i);
+        tx->mutable_control()->set_xvelocity(1);
+        tx->mutable_control()->set_yvelocity(1);
+        tx->mutable_control()->set_avelocity(1);
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        DebugCircle* circle = frame->add_debug_circles();
+        circle->set_layer(1);
+        circle->mutable_center()->set_x(i);
+        circle->mutable_center()->set_y(i);
+        circle->set_radius(0.1);
+        circle->set_color(0);
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        DebugText* text = frame->add_debug_texts();
+        text->set_layer(2);
+        text->set_text("Benchmark text");
+        text->set_color(0);
+    }
+
+    frame->add_debug_layers("Debug");
+    frame->add_debug_layers("Planning");
+    frame->add_debug_layers("Text");
+}
+
+struct Result {
+    double allocationsPerFrame;
+    double storeMicroseconds;
+};
+
+static Result runFresh(int historySize, int frames) {
+    vector<shared_ptr<LogFrame> > history(historySize);
+    long allocations = 0;
+    chrono::nanoseconds storeTime(0);
+
+    for (int n = 0; n < frames; ++n) {
+        long before = allocationCount;
+        shared_ptr<LogFrame> frame = make_shared<LogFrame>();
+        fillFrame(frame.get(), n);
+        allocations += allocationCount - before;
+
+        auto start = chrono::steady_clock::now();
+        int space = frame->SpaceUsed();
+        shared_ptr<LogFrame>& slot = history[n % historySize];
+        if (slot) {
+            space -= slot->SpaceUsed();
+        }
+        slot = frame;
+        storeTime += chrono::steady_clock::now() - start;
+        (void)space;
+    }
+
+    return Result{(double)allocations / frames,
+                  storeTime.count() / 1000.0 / frames};
+}
+
+static Result runPooled(int historySize, int frames) {
+    Logger logger(Logger::DefaultMaxSpace, historySize);
+    long allocations = 0;
+    chrono::nanoseconds storeTime(0);
+
+    for (int n = 0; n < frames; ++n) {
+        long before = allocationCount;
+        shared_ptr<LogFrame> frame = logger.createFrame();
+        fillFrame(frame.get(), n);
+        allocations += allocationCount - before;
+
+        auto start = chrono::steady_clock::now();
+        logger.addFrame(move(frame));
+        storeTime += chrono::steady_clock::now() - start;
+    }
+
+    return Result{(double)allocations / frames,
+                  storeTime.count() / 1000.0 / frames};
+}
+
+int main(int argc, char* argv[]) {
+    // Small enough that most frames evict or serialize an old one
+    int historySize = 600;
+    int frames = 20000;
+    if (argc > 1) {
+        frames = atoi(argv[1]);
+    }
+
+    Result fresh = runFresh(historySize, frames);
+    Result pooled = runPooled(historySize, frames);
+
+    printf("%d frames, history of %d\n", frames, historySize);
+    printf("%-8s %16s %16s\n", "", "allocs/frame", "store us/frame");
+    printf("%-8s %16.1f %16.2f\n", "fresh", fresh.allocationsPerFrame,
+           fresh.storeMicroseconds);
+    printf("%-8s %16.1f %16.2f\n", "pooled", pooled.allocationsPerFrame,
+           pooled.storeMicroseconds);
+
+    return 0;
+}
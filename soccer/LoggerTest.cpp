@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "Logger.hpp"
+
+using namespace std;
+using namespace Packet;
+
+static shared_ptr<LogFrame> addFrame(Logger& logger, int64_t timestamp) {
+    shared_ptr<LogFrame> frame = logger.createFrame();
+    frame->set_timestamp(timestamp);
+    frame->add_debug_layers("Debug");
+    logger.addFrame(frame);
+    return frame;
+}
+
+TEST(Logger, getFrames) {
+    Logger logger(Logger::DefaultMaxSpace, 2);
+    for (int i = 0; i < 6; ++i) {
+        addFrame(logger, i);
+    }
+
+    EXPECT_EQ(6, logger.numFrames());
+    EXPECT_EQ(0, logger.firstFrameNumber());
+    EXPECT_EQ(5, logger.lastFrameNumber());
+    EXPECT_EQ(5, logger.lastFrame()->timestamp());
+
+    // This covers both decoded and serialized frames
+    vector<shared_ptr<LogFrame> > frames(4);
+    EXPECT_EQ(4, logger.getFrames(5, frames));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(frames[i] != nullptr);
+        EXPECT_EQ(5 - i, frames[i]->timestamp());
+        EXPECT_EQ("Debug", frames[i]->debug_layers(0));
+    }
+
+    // Frames before the start of the history are cleared
+    EXPECT_EQ(2, logger.getFrames(1, frames));
+    EXPECT_EQ(0, frames[1]->timestamp());
+    EXPECT_TRUE(frames[2] == nullptr);
+}
+
+TEST(Logger, uncompressed) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    logger.compress(false);
+    for (int i = 0; i < 3; ++i) {
+        addFrame(logger, i);
+    }
+
+    vector<shared_ptr<LogFrame> > frames(3);
+    EXPECT_EQ(3, logger.getFrames(2, frames));
+    EXPECT_EQ(1, frames[1]->timestamp());
+    EXPECT_EQ(0, frames[2]->timestamp());
+}
+
+TEST(Logger, reusesDecodedFrames) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    addFrame(logger, 0);
+    addFrame(logger, 1);
+
+    vector<shared_ptr<LogFrame> > a(2), b(2);
+    logger.getFrames(1, a);
+    logger.getFrames(1, b);
+
+    // The serialized frame is only decoded again once no one holds it
+    EXPECT_EQ(a[1], b[1]);
+}
+
+TEST(Logger, memoryLimit) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    addFrame(logger, 0);
+    addFrame(logger, 1);
+    addFrame(logger, 2);
+    EXPECT_EQ(3, logger.numFrames());
+
+    // Shrinking the limit drops the oldest frames when the next one is added,
+    // but always keeps the most recent one.
+    logger.maxSpace(1);
+    addFrame(logger, 3);
+    EXPECT_EQ(1, logger.numFrames());
+    EXPECT_EQ(3, logger.firstFrameNumber());
+    EXPECT_EQ(3, logger.lastFrame()->timestamp());
+}
+
+TEST(Logger, spaceUsed) {
+    Logger logger(Logger::DefaultMaxSpace, 2);
+    EXPECT_EQ(0u, logger.spaceUsed());
+
+    addFrame(logger, 0);
+    const size_t one = logger.spaceUsed();
+    EXPECT_GT(one, 0u);
+
+    addFrame(logger, 1);
+    EXPECT_EQ(2 * one, logger.spaceUsed());
+}
+
+TEST(Logger, recyclesSerializedFrames) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    LogFrame* first = addFrame(logger, 0).get();
+
+    // This serializes the first frame, which nothing else refers to
+    addFrame(logger, 1);
+
+    shared_ptr<LogFrame> recycled = logger.createFrame();
+    EXPECT_EQ(first, recycled.get());
+    EXPECT_FALSE(recycled->has_timestamp());
+    EXPECT_EQ(0, recycled->debug_layers_size());
+}
+
+TEST(Logger, keepsFramesInUse) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    shared_ptr<LogFrame> held = addFrame(logger, 0);
+    addFrame(logger, 1);
+
+    // The serialized frame is still held here, so it must not be reused
+    shared_ptr<LogFrame> frame = logger.createFrame();
+    EXPECT_NE(held.get(), frame.get());
+    EXPECT_EQ(0, held->timestamp());
+}
+
+TEST(Logger, encodesHistorySeparately) {
+    Logger logger(Logger::DefaultMaxSpace, 1);
+    shared_ptr<LogFrame> first = logger.createFrame();
+    first->set_timestamp(0);
+    logger.storeFrame(first);
+    LogFrame* firstPtr = first.get();
+    first.reset();
+
+    shared_ptr<LogFrame> second = logger.createFrame();
+    second->set_timestamp(1);
+    logger.storeFrame(second);
+
+    // The first frame is still decoded, so it can't be reused yet
+    EXPECT_NE(firstPtr, logger.createFrame().get());
+
+    logger.encodeHistory();
+    EXPECT_EQ(firstPtr, logger.createFrame().get());
+
+    vector<shared_ptr<LogFrame> > frames(2);
+    ASSERT_EQ(2, logger.getFrames(1, frames));
+    EXPECT_EQ(1, frames[0]->timestamp());
+    EXPECT_EQ(0, frames[1]->timestamp());
+}
@@ -55,7 +55,7 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     _autoExternalReferee = true;
     _doubleFrameNumber = -1;
 
-    _lastUpdateTime = RJ::timestamp();
+    _lastUpdateTime = RJ::systemTimestamp();
     _history.resize(2 * 60);
 
     _ui.setupUi(this);
@@ -98,7 +98,7 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     _logMemory->setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
     _logMemory->setToolTip("Log Memory Usage");
     _logMemory->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    calcMinimumWidth(_logMemory, "Log: 000000/000000 000000 kiB");
+    calcMinimumWidth(_logMemory, "Log: 000000 frames 00000/00000 MiB");
     statusBar()->addPermanentWidget(_logMemory);
 
     _frameNumberItem = new QTreeWidgetItem(_ui.logTree);
@@ -159,6 +159,8 @@ void MainWindow::processor(Processor* value) {
 
     _processor = value;
 
+    _ui.fieldView->portOffset(_processor->portOffset());
+
     // External referee
     // on_externalReferee_toggled(_ui.externalReferee->isChecked());
 
@@ -169,7 +171,6 @@ void MainWindow::processor(Processor* value) {
         _ui.actionTeamYellow->trigger();
     }
 
-    _ui.logHistoryLocation->setMaximum(_processor->logger().maxFrames());
     _ui.logHistoryLocation->setTickInterval(60 * 60);  // interval is ~ 1 minute
 
     if (_processor->logger().recording()) {
@@ -246,7 +247,7 @@ void MainWindow::updateViews() {
     }
 
     // Time since last update
-    RJ::Time time = RJ::timestamp();
+    RJ::Time time = RJ::systemTimestamp();
     int delta_us = time - _lastUpdateTime;
     _lastUpdateTime = time;
     double framerate = 1000000.0 / delta_us;
@@ -259,12 +260,13 @@ void MainWindow::updateViews() {
         _procFPS->setText(
             QString("Proc: %1 fps").arg(_processor->framerate(), 0, 'f', 1));
 
+        const size_t MiB = 1024 * 1024;
         _logMemory->setText(
-            QString("Log: %1/%2 %3 kiB")
+            QString("Log: %1 frames %2/%3 MiB")
                 .arg(QString::number(_processor->logger().numFrames()),
-                     QString::number(_processor->logger().maxFrames()),
-                     QString::number((_processor->logger().spaceUsed() + 512) /
-                                     1024)));
+                     QString::number(
+                         (_processor->logger().spaceUsed() + MiB / 2) / MiB),
+                     QString::number(_processor->logger().maxSpace() / MiB)));
     }
 
     // Advance log history
@@ -285,6 +287,10 @@ void MainWindow::updateViews() {
     }
 
     // update history slider in ui
+    // The number of frames in the history depends on how large they are, so
+    // the range changes as frames are added.
+    _ui.logHistoryLocation->setMaximum(
+        max(0, _processor->logger().numFrames() - 1));
     emit historyLocationChanged(_doubleFrameNumber -
                                 _processor->logger().firstFrameNumber());
 
@@ -292,6 +298,7 @@ void MainWindow::updateViews() {
     _processor->logger().getFrames(frameNumber(), _history);
 
     // Update field view
+    _ui.fieldView->frameNumber(frameNumber());
     _ui.fieldView->update();
 
     // enable playback buttons based on playback rate
@@ -701,6 +708,38 @@ void MainWindow::updateStatus() {
     Processor::Status ps = _processor->status();
     RJ::Time curTime = RJ::timestamp();
 
+    if (!sim) {
+        QString tip =
+            QString("Sent %1, dropped %2, failed %3, reconnects %4\n"
+                    "Latency %5 ms, max %6 ms")
+                .arg(ps.radio.sent)
+                .arg(ps.radio.dropped)
+                .arg(ps.radio.failed)
+                .arg(ps.radio.reconnects)
+                .arg(ps.radio.lastLatency / 1000.0, 0, 'f', 1)
+                .arg(ps.radio.maxLatency / 1000.0, 0, 'f', 1);
+
+        if (ps.radio.hasBase) {
+            const RadioSchedule::Counters& base = ps.radio.base;
+            tip += QString("\nBase: %1 frames, %2 commands (%3 replaced), "
+                           "%4 bad packets\n"
+                           "Replies %5, late %6, missed slots %7, "
+                           "USB writes %8\n"
+                           "Base latency %9 ms, max %10 ms")
+                       .arg(base.frames)
+                       .arg(base.commands)
+                       .arg(base.replaced)
+                       .arg(base.badPackets)
+                       .arg(base.reversePackets)
+                       .arg(base.lateReplies)
+                       .arg(base.missedSlots)
+                       .arg(base.usbWrites)
+                       .arg(base.lastForwardLatency / 1000.0, 0, 'f', 1)
+                       .arg(base.maxForwardLatency / 1000.0, 0, 'f', 1);
+        }
+        _ui.radioBaseStatus->setToolTip(tip);
+    }
+
     // Determine if we are receiving packets from an external referee
     bool haveExternalReferee = (curTime - ps.lastRefereeTime) < 500 * 1000;
 
@@ -840,6 +879,11 @@ void MainWindow::on_actionTeam_Names_toggled(bool state) {
     _ui.fieldView->update();
 }
 
+void MainWindow::on_actionFrameTime_toggled(bool state) {
+    _ui.fieldView->showFrameTime = state;
+    _ui.fieldView->update();
+}
+
 void MainWindow::on_actionDefendMinusX_triggered() {
     _processor->defendPlusX(false);
 }
@@ -1183,7 +1227,12 @@ void MainWindow::on_debugLayers_customContextMenuRequested(const QPoint& pos) {
 void MainWindow::on_debugLayers_itemChanged(QListWidgetItem* item) {
     int layer = item->data(Qt::UserRole).toInt();
     if (layer >= 0) {
-        _ui.fieldView->layerVisible(layer, item->checkState() == Qt::Checked);
+        bool visible = item->checkState() == Qt::Checked;
+        _ui.fieldView->layerVisible(layer, visible);
+
+        // Hidden layers aren't recorded by the processor at all
+        QMutexLocker lock(&_processor->loopMutex());
+        _processor->state()->setDebugLayerEnabled(layer, visible);
     }
     _ui.fieldView->update();
 }
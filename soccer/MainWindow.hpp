@@ -67,6 +67,7 @@ private Q_SLOTS:
     void on_actionCoords_toggled(bool state);
     void on_actionDotPatterns_toggled(bool state);
     void on_actionTeam_Names_toggled(bool state);
+    void on_actionFrameTime_toggled(bool state);
     void on_actionTeamYellow_triggered();
     void on_actionTeamBlue_triggered();
     void on_manualID_currentIndexChanged(int value);
@@ -4,7 +4,6 @@
 #include <multicast.hpp>
 #include <Utils.hpp>
 #include <unistd.h>
-#include <QMutexLocker>
 #include <QUdpSocket>
 #include <stdexcept>
 
@@ -95,11 +94,12 @@ static const float KickThreshold = 0.150f;
 /// as having been kicked.
 static const int KickVerifyTime_ms = 250;
 
-NewRefereeModule::NewRefereeModule(SystemState& state)
+NewRefereeModule::NewRefereeModule(SystemState& state, int port)
     : stage(NORMAL_FIRST_HALF_PRE),
       command(HALT),
       _running(false),
-      _state(state) {}
+      _state(state),
+      _port(port) {}
 
 NewRefereeModule::~NewRefereeModule() { this->stop(); }
 
@@ -108,70 +108,84 @@ void NewRefereeModule::stop() {
     wait();
 }
 
-void NewRefereeModule::getPackets(std::vector<NewRefereePacket*>& packets) {
-    _mutex.lock();
-    packets = _packets;
-    _packets.clear();
-    _mutex.unlock();
-}
-
 void NewRefereeModule::run() {
     QUdpSocket socket;
 
-    if (!socket.bind(ProtobufRefereePort, QUdpSocket::ShareAddress)) {
+    if (!socket.bind(_port, QUdpSocket::ShareAddress)) {
         throw runtime_error("Can't bind to shared referee port");
     }
 
     multicast_add(&socket, RefereeAddress);
 
-    _packets.reserve(4);
-
     _running = true;
     while (_running) {
-        if (!_useExternalRef) continue;
-
         char buf[65536];
 
         if (!socket.waitForReadyRead(500)) {
             continue;
         }
 
-        QHostAddress host;
-        quint16 port = 0;
-        qint64 size = socket.readDatagram(buf, sizeof(buf), &host, &port);
-        if (size < 1) {
-            fprintf(stderr, "NewRefereeModule: %s/n",
-                    (const char*)socket.errorString().toLatin1());
-            ::usleep(100000);
-            continue;
-        }
+        // Read everything that arrived.  Each packet holds the whole referee
+        // state, so only the last one matters.
+        while (socket.hasPendingDatagrams()) {
+            QHostAddress host;
+            quint16 port = 0;
+            qint64 size = socket.readDatagram(buf, sizeof(buf), &host, &port);
+            if (size < 1) {
+                fprintf(stderr, "NewRefereeModule: %s\n",
+                        (const char*)socket.errorString().toLatin1());
+                ::usleep(100000);
+                break;
+            }
 
-        NewRefereePacket* packet = new NewRefereePacket;
-        packet->receivedTime = RJ::timestamp();
-        this->received_time = packet->receivedTime;
-        if (!packet->wrapper.ParseFromArray(buf, size)) {
-            fprintf(stderr,
+            NewRefereePacket& packet = _latest.back();
+            packet.receivedTime = RJ::timestamp();
+            if (!packet.wrapper.ParseFromArray(buf, size)) {
+                fprintf(
+                    stderr,
                     "NewRefereeModule: got bad packet of %d bytes from %s:%d\n",
                     (int)size, (const char*)host.toString().toLatin1(), port);
-            fprintf(stderr, "Packet: %s\n", buf);
-            fprintf(stderr, "Address: %s\n", RefereeAddress);
-            continue;
+                continue;
+            }
+            _latest.publish();
         }
+    }
+}
 
-        _mutex.lock();
-        _packets.push_back(packet);
+void NewRefereeModule::apply(const NewRefereePacket& packet) {
+    const SSL_Referee& wrapper = packet.wrapper;
 
-        stage = (Stage)packet->wrapper.stage();
-        command = (Command)packet->wrapper.command();
-        sent_time = packet->wrapper.packet_timestamp();
-        stage_time_left = packet->wrapper.stage_time_left();
-        command_counter = packet->wrapper.command_counter();
-        command_timestamp = packet->wrapper.command_timestamp();
-        yellow_info.ParseRefboxPacket(packet->wrapper.yellow());
-        blue_info.ParseRefboxPacket(packet->wrapper.blue());
+    received_time = packet.receivedTime;
+    stage = (Stage)wrapper.stage();
+    sent_time = wrapper.packet_timestamp();
+    stage_time_left = wrapper.stage_time_left();
+    command_timestamp = wrapper.command_timestamp();
+    yellow_info.ParseRefboxPacket(wrapper.yellow());
+    blue_info.ParseRefboxPacket(wrapper.blue());
+
+    if (!_haveCommand || wrapper.command_counter() != command_counter) {
+        _haveCommand = true;
+        _reactionPending = true;
+        _appliedTime = RJ::timestamp();
+    }
+    command = (Command)wrapper.command();
+    command_counter = wrapper.command_counter();
+}
 
-        _mutex.unlock();
+bool NewRefereeModule::commandSent(RJ::Time now,
+                                   Packet::RefereeLatency* latency) {
+    if (!_reactionPending) {
+        return false;
     }
+    _reactionPending = false;
+
+    latency->set_command(command);
+    latency->set_command_counter(command_counter);
+    latency->set_command_timestamp(command_timestamp);
+    latency->set_received_time(received_time);
+    latency->set_applied_time(_appliedTime);
+    latency->set_reaction_time(now);
+    return true;
 }
 
 void NewRefereeModule::spinKickWatcher() {
@@ -217,6 +231,12 @@ void NewRefereeModule::spinKickWatcher() {
 }
 
 void NewRefereeModule::updateGameState(bool blueTeam) {
+    // Packets are still received while the external referee is off so they
+    // don't pile up, but they are ignored.
+    if (_latest.update() && _useExternalRef) {
+        apply(_latest.front());
+    }
+
     _state.gameState.ourScore = blueTeam ? blue_info.score : yellow_info.score;
     _state.gameState.theirScore =
         blueTeam ? yellow_info.score : blue_info.score;
@@ -1,13 +1,15 @@
 #pragma once
 
+#include <protobuf/LogFrame.pb.h>
 #include <protobuf/referee.pb.h>
 #include "TeamInfo.hpp"
 #include "GameState.hpp"
 #include "SystemState.hpp"
 #include <Utils.hpp>
+#include <Network.hpp>
+#include <TripleBuffer.hpp>
 
 #include <QThread>
-#include <QMutex>
 #include <QTime>
 #include <vector>
 #include <stdint.h>
@@ -124,18 +126,17 @@ public:
  * but the packets contains info about which stage of the game it is, team
  * scores, yellow/red cards, etc.
  *
- * Each time a new packet arrives, the ref module updates the GameState object
- * with the new information.
+ * The receive thread publishes the latest packet without locking, and the
+ * processing thread picks it up in updateGameState() and updates the
+ * GameState object with the new information.
  */
 class NewRefereeModule : public QThread {
 public:
-    NewRefereeModule(SystemState& state);
+    NewRefereeModule(SystemState& state, int port = ProtobufRefereePort);
     ~NewRefereeModule();
 
     void stop();
 
-    void getPackets(std::vector<NewRefereePacket*>& packets);
-
     bool kicked() { return _kickDetectState == Kicked; }
 
     void useExternalReferee(bool value) { _useExternalRef = value; }
@@ -175,10 +176,17 @@ public:
     TeamInfo yellow_info;
     TeamInfo blue_info;
 
+    /// Applies the latest referee packet, if there is a new one, and updates
+    /// the game state.  Called by the processing thread.
     void updateGameState(bool blueTeam);
 
     void spinKickWatcher();
 
+    /// Called by the processing thread after robot commands were sent at
+    /// <now>.  The first time after a new referee command was applied, fills
+    /// in <latency> and returns true.
+    bool commandSent(RJ::Time now, Packet::RefereeLatency* latency);
+
 protected:
     virtual void run() override;
 
@@ -186,6 +194,9 @@ protected:
 
     void ready();
 
+    // Copies a referee packet to the public members
+    void apply(const NewRefereePacket& packet);
+
     typedef enum {
         WaitForReady,
         CapturePosition,
@@ -200,12 +211,22 @@ protected:
     // Time the ball was first beyond KickThreshold from its original position
     QTime _kickTime;
 
-    QMutex _mutex;
-    std::vector<NewRefereePacket*> _packets;
+    // Latest packet from the receive thread
+    TripleBuffer<NewRefereePacket> _latest;
+
     SystemState& _state;
 
     NewRefereeModuleEnums::Command prev_command;
     NewRefereeModuleEnums::Stage prev_stage;
 
     bool _useExternalRef = true;
+
+    // Set when a new command is applied and cleared when robot commands have
+    // been sent for it
+    bool _reactionPending = false;
+    bool _haveCommand = false;
+    RJ::Time _appliedTime = 0;
+
+    // UDP port to receive referee packets on
+    int _port;
 };
@@ -4,10 +4,14 @@
 
 #include <gameplay/GameplayModule.hpp>
 #include "Processor.hpp"
+#include "radio/ChannelRadio.hpp"
+#include "radio/ShmRadio.hpp"
 #include "radio/SimRadio.hpp"
 #include "radio/USBRadio.hpp"
+#include "SimStepper.hpp"
 #include "modeling/BallTracker.hpp"
 #include <multicast.hpp>
+#include <Network.hpp>
 #include <Constants.hpp>
 #include <Utils.hpp>
 #include <joystick/Joystick.hpp>
@@ -51,7 +55,8 @@ void Processor::createConfiguration(Configuration* cfg) {
     }
 }
 
-Processor::Processor(bool sim) : _loopMutex(QMutex::Recursive) {
+Processor::Processor(bool sim, int portOffset)
+    : _loopMutex(QMutex::Recursive) {
     _running = true;
     _framePeriod = 1000000 / 60;
     _manualID = -1;
@@ -64,6 +69,10 @@ Processor::Processor(bool sim) : _loopMutex(QMutex::Recursive) {
     _initialized = false;
 
     _simulation = sim;
+    _lockstep = false;
+    _sharedMemory = false;
+    _portOffset = portOffset;
+    _frameLimit = 0;
     _radio = nullptr;
 
     // joysticks
@@ -78,12 +87,17 @@ Processor::Processor(bool sim) : _loopMutex(QMutex::Recursive) {
     QMetaObject::connectSlotsByName(this);
 
     _ballTracker = std::make_shared<BallTracker>();
-    _refereeModule = std::make_shared<NewRefereeModule>(_state);
+    _refereeModule = std::make_shared<NewRefereeModule>(
+        _state, ProtobufRefereePort + _portOffset);
     _refereeModule->start();
     _gameplayModule = std::make_shared<Gameplay::GameplayModule>(&_state);
     _pathPlanner = std::unique_ptr<Planning::MultiRobotPathPlanner>(
         new Planning::IndependentMultiRobotPathPlanner());
     vision.simulation = _simulation;
+    vision.portOffset = _portOffset;
+
+    _localObstaclesLayer = _state.findDebugLayer("LocalObstacles");
+    _globalObstaclesLayer = _state.findDebugLayer("Global Obstacles");
 }
 
 Processor::~Processor() {
@@ -218,20 +232,47 @@ void Processor::runModels(
  * program loop
  */
 void Processor::run() {
-    vision.start();
+    // In lockstep mode vision comes in the simulator's replies to step
+    // commands instead of from the vision ports
+    std::unique_ptr<SimStepper> stepper;
+    if (_simulation && _lockstep) {
+        stepper.reset(new SimStepper(_portOffset));
+    } else {
+        vision.sharedMemory = _sharedMemory;
+        vision.start();
+    }
 
-    // Create radio socket
-    _radio = _simulation ? static_cast<Radio*>(new SimRadio(_blueTeam))
-                         : static_cast<Radio*>(new USBRadio());
+    // Create radio socket.  Simulated radios go through a model of the radio
+    // link's loss and latency.
+    ChannelRadio* channelRadio = nullptr;
+    if (!_simulation) {
+        _radio = new USBRadio();
+    } else {
+        Radio* sim;
+        if (_sharedMemory) {
+            sim = new ShmRadio(_blueTeam, _portOffset);
+        } else {
+            sim = new SimRadio(_blueTeam, _portOffset);
+        }
+        channelRadio = new ChannelRadio(sim, lrand48());
+        _radio = channelRadio;
+    }
 
     Status curStatus;
 
     bool first = true;
+    int frameCount = 0;
+    RJ::Time lastProcessingStart = 0;
     // main loop
     while (_running) {
+        // In lockstep mode this is the simulator's time (see SimStepper), so
+        // it advances by one frame period per frame however long processing
+        // takes.  Processing itself is timed with the system clock.
         RJ::Time startTime = RJ::timestamp();
-        int delta_us = startTime - curStatus.lastLoopTime;
+        RJ::Time processingStart = RJ::systemTimestamp();
+        int delta_us = processingStart - lastProcessingStart;
         _framerate = 1000000.0 / delta_us;
+        lastProcessingStart = processingStart;
         curStatus.lastLoopTime = startTime;
         _state.timestamp = startTime;
 
@@ -243,7 +284,7 @@ void Processor::run() {
         // Reset
 
         // Make a new log frame
-        _state.logFrame = std::make_shared<Packet::LogFrame>();
+        _state.logFrame = _logger.createFrame();
         _state.logFrame->set_timestamp(RJ::timestamp());
         _state.logFrame->set_command_time(startTime + Command_Latency);
         _state.logFrame->set_use_our_half(_useOurHalf);
@@ -252,6 +293,9 @@ void Processor::run() {
         _state.logFrame->set_blue_team(_blueTeam);
         _state.logFrame->set_defend_plus_x(_defendPlusX);
 
+        // Everything goes into log files, even layers that aren't shown
+        _state.recordAllDebugLayers(_logger.recording());
+
         if (first) {
             first = false;
 
@@ -290,7 +334,11 @@ void Processor::run() {
         // Read vision packets
         vector<const SSL_DetectionFrame*> detectionFrames;
         vector<VisionPacket*> visionPackets;
-        vision.getPackets(visionPackets);
+        if (stepper) {
+            stepper->getPackets(visionPackets);
+        } else {
+            vision.getPackets(visionPackets);
+        }
         for (VisionPacket* packet : visionPackets) {
             SSL_WrapperPacket* log = _state.logFrame->add_raw_vision();
             log->CopyFrom(packet->wrapper);
@@ -348,8 +396,18 @@ void Processor::run() {
             }
         }
 
+        if (channelRadio) {
+            channelRadio->time(startTime);
+        }
+
         // Read radio reverse packets
         _radio->receive();
+        if (channelRadio) {
+            _state.logFrame->mutable_radio_forward()->CopyFrom(
+                channelRadio->forward().stats());
+            _state.logFrame->mutable_radio_reverse()->CopyFrom(
+                channelRadio->reverse().stats());
+        }
         for (const Packet::RadioRx& rx : _radio->reversePackets()) {
             _state.logFrame->add_radio_rx()->CopyFrom(rx);
 
@@ -366,6 +424,7 @@ void Processor::run() {
             }
         }
         _radio->clear();
+        curStatus.radio = _radio->stats();
 
         _loopMutex.lock();
 
@@ -422,7 +481,7 @@ void Processor::run() {
 
                 // Visualize local obstacles
                 for (auto& shape : r->localObstacles().shapes()) {
-                    _state.drawShape(shape, Qt::black, "LocalObstacles");
+                    _state.drawShape(shape, Qt::black, _localObstaclesLayer);
                 }
 
                 auto& globalObstaclesForBot =
@@ -444,7 +503,9 @@ void Processor::run() {
         }
 
         // Run path planner and set the path for each robot that was planned for
+        RJ::Time planningStart = RJ::timestamp();
         auto pathsById = _pathPlanner->run(std::move(requests));
+        _state.logFrame->set_planning_time(RJ::timestamp() - planningStart);
         for (auto& entry : pathsById) {
             OurRobot* r = _state.self[entry.first];
             auto& path = entry.second;
@@ -457,7 +518,7 @@ void Processor::run() {
 
         // Visualize obstacles
         for (auto& shape : globalObstacles.shapes()) {
-            _state.drawShape(shape, Qt::black, "Global Obstacles");
+            _state.drawShape(shape, Qt::black, _globalObstaclesLayer);
         }
 
         // Run velocity controllers
@@ -475,7 +536,8 @@ void Processor::run() {
         ////////////////
         // Store logging information
 
-        // Debug layers
+        // Debug drawings and layers
+        _state.flushDebugDrawing(_state.logFrame.get());
         const QStringList& layers = _state.debugLayers();
         for (const QString& str : layers) {
             _state.logFrame->add_debug_layers(str.toStdString());
@@ -558,11 +620,24 @@ void Processor::run() {
         // Send motion commands to the robots
         sendRadioData();
 
-        // Write to the log
-        _logger.addFrame(_state.logFrame);
+        // Measure how long it took to act on a new referee command
+        Packet::RefereeLatency refereeLatency;
+        if (_refereeModule->commandSent(RJ::timestamp(), &refereeLatency)) {
+            _state.logFrame->mutable_referee_latency()->Swap(&refereeLatency);
+        }
+
+        _state.logFrame->set_processing_time(RJ::systemTimestamp() -
+                                             processingStart);
+
+        // Write to the log.  The GUI reads the frame through _state, so it is
+        // serialized while the lock is held, but compressing old frames
+        // shouldn't hold up the GUI.
+        _logger.storeFrame(_state.logFrame);
 
         _loopMutex.unlock();
 
+        _logger.encodeHistory();
+
         // Store processing loop status
         _statusMutex.lock();
         _status = curStatus;
@@ -571,12 +646,22 @@ void Processor::run() {
         // Processor Initialization Completed
         _initialized = true;
 
+        if (_frameLimit && ++frameCount >= _frameLimit) {
+            break;
+        }
+
         ////////////////
         // Timing
 
-        RJ::Time endTime = RJ::timestamp();
-        int lastFrameTime = endTime - startTime;
-        if (lastFrameTime < _framePeriod) {
+        RJ::Time endTime = RJ::systemTimestamp();
+        int lastFrameTime = endTime - processingStart;
+        if (stepper) {
+            // Advance the simulator by one frame instead of waiting, so
+            // frames go as fast as both programs can run them
+            if (!stepper->step()) {
+                fprintf(stderr, "Processor: no reply to lockstep command\n");
+            }
+        } else if (lastFrameTime < _framePeriod) {
             // Use system usleep, not QThread::usleep.
             //
             // QThread::usleep uses pthread_cond_wait which sometimes fails to
@@ -607,6 +692,7 @@ void Processor::sendRadioData() {
             control->set_shootmode(Packet::Control::KICK);
             control->set_triggermode(Packet::Control::STAND_DOWN);
             control->set_song(Packet::Control::STOP);
+            control->clear_segment();
         }
     }
 
@@ -655,6 +741,9 @@ void Processor::applyJoystickControls(const JoystickControlValues& controlVals,
     // rotation
     tx->set_avelocity(controlVals.rotation);
 
+    // the joystick can change at any time, so there's nothing to follow
+    tx->clear_segment();
+
     // kick/chip
     bool kick = controlVals.kick || controlVals.chip;
     tx->set_triggermode(kick ? Packet::Control::IMMEDIATE
@@ -15,12 +15,12 @@
 #include <modeling/RobotFilter.hpp>
 #include <NewRefereeModule.hpp>
 #include "VisionReceiver.hpp"
+#include "radio/Radio.hpp"
 
 class Configuration;
 class RobotStatus;
 class Joystick;
 struct JoystickControlValues;
-class Radio;
 class BallTracker;
 
 namespace Gameplay {
@@ -86,11 +86,14 @@ public:
         RJ::Time lastVisionTime;
         RJ::Time lastRefereeTime;
         RJ::Time lastRadioRxTime;
+
+        /// Counters from the radio's background transfers
+        Radio::Stats radio;
     };
 
     static void createConfiguration(Configuration* cfg);
 
-    Processor(bool sim);
+    Processor(bool sim, int portOffset = 0);
     virtual ~Processor();
 
     void stop();
@@ -147,6 +150,22 @@ public:
 
     bool simulation() const { return _simulation; }
 
+    /// If true, the simulator is advanced by one step per frame instead of
+    /// running in real time.  This must be set before the thread is started.
+    void lockstep(bool value) { _lockstep = value; }
+    bool lockstep() const { return _lockstep; }
+
+    /// If true, simulated vision and radio go through shared memory instead of
+    /// UDP.  This must be set before the thread is started.
+    void sharedMemory(bool value) { _sharedMemory = value; }
+    bool sharedMemory() const { return _sharedMemory; }
+
+    /// Offset added to the simulator and referee ports (see Network.hpp)
+    int portOffset() const { return _portOffset; }
+
+    /// If nonzero, the processing loop stops after this many frames
+    void frameLimit(int value) { _frameLimit = value; }
+
     void defendPlusX(bool value);
 
     Status status() {
@@ -162,6 +181,9 @@ public:
 
     void closeLog() { _logger.close(); }
 
+    /// Sets the amount of memory the log history may use, in bytes
+    void logMemoryLimit(size_t bytes) { _logger.maxSpace(bytes); }
+
     // Use all/part of the field
     void useOurHalf(bool value) { _useOurHalf = value; }
 
@@ -220,6 +242,17 @@ private:
     // This changes network communications.
     bool _simulation;
 
+    // True if the simulator only advances when we tell it to
+    bool _lockstep;
+
+    // True if the simulator's vision and radio are in shared memory
+    bool _sharedMemory;
+
+    int _portOffset;
+
+    // Number of frames to run or zero to run until stopped
+    int _frameLimit;
+
     // True if we are blue.
     // False if we are yellow.
     bool _blueTeam;
@@ -279,4 +312,8 @@ private:
     VisionReceiver vision;
 
     bool _initialized;
+
+    // Debug layers drawn on every frame
+    int _localObstaclesLayer;
+    int _globalObstaclesLayer;
 };
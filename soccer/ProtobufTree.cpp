@@ -26,11 +26,62 @@ enum {
                          // applicable
 };
 
+// Item for a field or an element of a repeated field
+class FieldItem : public QTreeWidgetItem {
+public:
+    FieldItem(QTreeWidgetItem* parent) : QTreeWidgetItem(parent) {
+        valid = false;
+    }
+
+    // Serialized message this item's children were last updated from
+    string contents;
+
+    // False if the children need to be updated even if the message hasn't
+    // changed
+    bool valid;
+};
+
 ProtobufTree::ProtobufTree(QWidget* parent) : QTreeWidget(parent) {
     _first = true;
     _history = nullptr;
     mainWindow = nullptr;
     updateTimer = nullptr;
+
+    connect(this, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+            SLOT(invalidateItem(QTreeWidgetItem*)));
+}
+
+void ProtobufTree::invalidateItem(QTreeWidgetItem* item) {
+    // Everything above the item must be walked again to reach it
+    for (; item; item = item->parent()) {
+        FieldItem* fieldItem = dynamic_cast<FieldItem*>(item);
+        if (fieldItem) {
+            fieldItem->valid = false;
+        }
+    }
+}
+
+bool ProtobufTree::updateMessage(QTreeWidgetItem* item, const Message& msg) {
+    if (!item->isExpanded()) {
+        // Filled in when it is expanded
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+        return false;
+    }
+
+    // Comparing the serialized messages is much cheaper than walking them
+    // with reflection and updating every item.
+    FieldItem* fieldItem = dynamic_cast<FieldItem*>(item);
+    if (fieldItem) {
+        string contents;
+        msg.SerializePartialToString(&contents);
+        if (fieldItem->valid && contents == fieldItem->contents) {
+            return false;
+        }
+        fieldItem->contents.swap(contents);
+        fieldItem->valid = true;
+    }
+
+    return addTreeData(item, msg);
 }
 
 bool ProtobufTree::message(const google::protobuf::Message& msg) {
@@ -88,6 +139,11 @@ bool ProtobufTree::addTreeData(QTreeWidgetItem* parent,
                     delete child;
                 }
             }
+
+            if (!hasData) {
+                item->setChildIndicatorPolicy(
+                    QTreeWidgetItem::DontShowIndicatorWhenChildless);
+            }
         } else {
             hasData = ref->HasField(msg, field);
         }
@@ -107,7 +163,7 @@ bool ProtobufTree::addTreeData(QTreeWidgetItem* parent,
             item = *fieldIter;
         } else {
             // New field
-            item = new QTreeWidgetItem(parent);
+            item = new FieldItem(parent);
             fieldMap.insert(field->number(), item);
 
             item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
@@ -134,12 +190,20 @@ bool ProtobufTree::addTreeData(QTreeWidgetItem* parent,
             // Show the number of elements as the value for the field itself
             item->setData(Column_Value, Qt::DisplayRole, n);
 
+            // Elements are only created and updated while the field is
+            // expanded.  Large fields like raw vision and debug drawing are
+            // usually collapsed, so this skips most of the frame.
+            item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+            if (!item->isExpanded()) {
+                continue;
+            }
+
             // Make sure we have enough children
             int children = item->childCount();
             if (children < n) {
                 // Add children
                 for (int i = children; i < n; ++i) {
-                    QTreeWidgetItem* child = new QTreeWidgetItem(item);
+                    QTreeWidgetItem* child = new FieldItem(item);
                     child->setText(Column_Field, QString("[%1]").arg(i));
 
                     child->setData(Column_Tag, FieldDescriptorRole, field);
@@ -232,7 +296,7 @@ bool ProtobufTree::addTreeData(QTreeWidgetItem* parent,
 
                     case FieldDescriptor::TYPE_MESSAGE:
                         child->setData(Column_Tag, IsMessageRole, true);
-                        newFields |= addTreeData(
+                        newFields |= updateMessage(
                             child, ref->GetRepeatedMessage(msg, field, i));
                         break;
 
@@ -305,7 +369,8 @@ bool ProtobufTree::addTreeData(QTreeWidgetItem* parent,
 
                 case FieldDescriptor::TYPE_MESSAGE:
                     item->setData(Column_Tag, IsMessageRole, true);
-                    newFields |= addTreeData(item, ref->GetMessage(msg, field));
+                    newFields |=
+                        updateMessage(item, ref->GetMessage(msg, field));
                     break;
 
                 case FieldDescriptor::TYPE_BYTES:
@@ -326,6 +391,14 @@ void ProtobufTree::addBytes(QTreeWidgetItem* parent, const std::string& bytes) {
     int n = bytes.size();
     parent->setText(Column_Value, QString("%1 bytes").arg(n));
 
+    // Individual bytes are only shown while expanded
+    parent->setChildIndicatorPolicy(
+        n ? QTreeWidgetItem::ShowIndicator
+          : QTreeWidgetItem::DontShowIndicatorWhenChildless);
+    if (!parent->isExpanded()) {
+        return;
+    }
+
     int children = parent->childCount();
     if (children < n) {
         // Add children
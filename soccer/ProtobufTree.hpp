@@ -26,6 +26,11 @@ public:
     //
     // Items will only be removed from the tree when the number of elements
     // in a repeated field is reduced.  Fields are never removed.
+    //
+    // Only expanded items are updated.  The children of a collapsed message
+    // or repeated field are created or brought up to date when it is
+    // expanded, and an expanded submessage that is the same as in the
+    // previous call is skipped.
     bool message(const google::protobuf::Message& msg);
 
     void expandMessages(QTreeWidgetItem* item = nullptr);
@@ -50,10 +55,20 @@ protected:
     bool addTreeData(QTreeWidgetItem* parent,
                      const google::protobuf::Message& msg);
 
+    // Updates the children of an item for a message if it is expanded and the
+    // message has changed since the last update.
+    bool updateMessage(QTreeWidgetItem* item,
+                       const google::protobuf::Message& msg);
+
     void addBytes(QTreeWidgetItem* parent, const std::string& bytes);
 
     virtual void contextMenuEvent(QContextMenuEvent* e) override;
 
+private Q_SLOTS:
+    // Makes sure an expanded item is filled in on the next update
+    void invalidateItem(QTreeWidgetItem* item);
+
+protected:
     bool _first;
     const std::vector<std::shared_ptr<Packet::LogFrame> >* _history;
 };
@@ -90,9 +90,12 @@ void OurRobot::addStatusText() {
 
 void OurRobot::addText(const QString& text, const QColor& qc,
                        const QString& layerPrefix) {
-    Packet::DebugText* dbg = new Packet::DebugText;
     QString layer = layerPrefix + QString::number(shell());
-    dbg->set_layer(_state->findDebugLayer(layer));
+    int layerID = _state->findDebugLayer(layer);
+    if (!_state->debugLayerEnabled(layerID)) return;
+
+    Packet::DebugText* dbg = new Packet::DebugText;
+    dbg->set_layer(layerID);
     dbg->set_text(text.toStdString());
     dbg->set_color(color(qc));
     robotText.push_back(dbg);
@@ -17,6 +17,7 @@ SimFieldView::SimFieldView(QWidget* parent) : FieldView(parent) {
     _dragMode = DRAG_NONE;
     _dragRobot = -1;
     _dragRobotBlue = false;
+    _portOffset = 0;
 }
 
 void SimFieldView::mousePressEvent(QMouseEvent* me) {
@@ -121,7 +122,7 @@ void SimFieldView::sendSimCommand(const Packet::SimCommand& cmd) {
     cmd.SerializeToString(&out);
     _simCommandSocket.writeDatagram(&out[0], out.size(),
                                     QHostAddress(QHostAddress::LocalHost),
-                                    SimCommandPort);
+                                    SimCommandPort + _portOffset);
 }
 
 void SimFieldView::drawTeamSpace(QPainter& p) {
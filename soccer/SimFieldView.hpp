@@ -15,6 +15,9 @@ public:
 
     void sendSimCommand(const Packet::SimCommand& cmd);
 
+    /// Selects the simulator's port block (see Network.hpp)
+    void portOffset(int value) { _portOffset = value; }
+
 Q_SIGNALS:
     // Emitted when the user selects a robot.
     // The robot is identified by shell number.
@@ -33,6 +36,7 @@ private:
     void placeBall(QPointF pos);
 
     QUdpSocket _simCommandSocket;
+    int _portOffset;
 
     // True while a line is being dragged from the ball
     enum { DRAG_NONE = 0, DRAG_PLACE, DRAG_SHOOT } _dragMode;
@@ -0,0 +1,80 @@
+#include "SimStepper.hpp"
+
+#include <Network.hpp>
+#include <protobuf/SimCommand.pb.h>
+#include <stdexcept>
+
+using namespace std;
+using namespace Packet;
+
+static QHostAddress LocalAddress(QHostAddress::LocalHost);
+
+SimStepper::SimStepper(int portOffset) {
+    _portOffset = portOffset;
+    _stepID = 0;
+    _simTime = 0;
+    RJ::setSimulatedTime(RJ::SimulatedEpoch);
+
+    // Any port will do.  The simulator replies to whoever sent the command.
+    if (!_socket.bind(LocalAddress, 0)) {
+        throw runtime_error("Can't bind the lockstep socket");
+    }
+}
+
+SimStepper::~SimStepper() {
+    RJ::setSimulatedTime(0);
+
+    for (VisionPacket* packet : _packets) {
+        delete packet;
+    }
+}
+
+bool SimStepper::step(int steps, int timeout) {
+    SimCommand cmd;
+    cmd.set_step(steps);
+    cmd.set_step_id(++_stepID);
+
+    string out;
+    cmd.SerializeToString(&out);
+    _socket.writeDatagram(&out[0], out.size(), LocalAddress,
+                          SimCommandPort + _portOffset);
+
+    while (true) {
+        while (_socket.hasPendingDatagrams()) {
+            unsigned int n = _socket.pendingDatagramSize();
+            string buf;
+            buf.resize(n);
+            _socket.readDatagram(&buf[0], n);
+
+            SimStepAck ack;
+            if (!ack.ParseFromString(buf)) {
+                printf("Bad step reply of %d bytes\n", n);
+                continue;
+            }
+
+            // Late replies to steps that timed out are dropped
+            if (ack.step_id() != _stepID) {
+                continue;
+            }
+
+            _simTime = ack.sim_time();
+            RJ::setSimulatedTime(RJ::SimulatedEpoch + _simTime);
+            if (ack.has_vision()) {
+                VisionPacket* packet = new VisionPacket;
+                packet->receivedTime = RJ::timestamp();
+                packet->wrapper.Swap(ack.mutable_vision());
+                _packets.push_back(packet);
+            }
+            return true;
+        }
+
+        if (!_socket.waitForReadyRead(timeout)) {
+            return false;
+        }
+    }
+}
+
+void SimStepper::getPackets(vector<VisionPacket*>& packets) {
+    packets.insert(packets.end(), _packets.begin(), _packets.end());
+    _packets.clear();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QUdpSocket>
+
+#include "VisionReceiver.hpp"
+
+#include <time.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Drives a simulator running in lockstep mode
+ *
+ * @details Each call to step() asks the simulator to advance and waits for
+ * its SimStepAck.  The vision frame in the reply is made available through
+ * getPackets() in the same form VisionReceiver provides it, so the rest of
+ * the processing loop doesn't care where vision came from.
+ *
+ * While this exists, RJ::timestamp() follows the simulator's clock, starting
+ * at RJ::SimulatedEpoch.  Frames, planning, and motion control then see the
+ * same times on every run, however long each frame takes to process, and the
+ * simulator stamps its radio and referee packets with the same clock.
+ *
+ * This must be created and used in the same thread.
+ */
+class SimStepper {
+public:
+    /// <portOffset> selects the simulator's port block (see Network.hpp)
+    SimStepper(int portOffset = 0);
+    ~SimStepper();
+
+    /// Asks the simulator to run <steps> physics steps and waits up to
+    /// <timeout> milliseconds for the reply.
+    /// Returns false if no reply arrived in time.
+    bool step(int steps = 1, int timeout = 1000);
+
+    /// Appends the vision packets received since the last call to <packets>.
+    /// The caller is responsible for freeing them.
+    void getPackets(std::vector<VisionPacket*>& packets);
+
+    /// Simulated time of the last reply in microseconds
+    uint64_t simTime() const { return _simTime; }
+
+private:
+    QUdpSocket _socket;
+
+    int _portOffset;
+    uint32_t _stepID;
+    uint64_t _simTime;
+    std::vector<VisionPacket*> _packets;
+};
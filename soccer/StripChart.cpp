@@ -58,6 +58,35 @@ int StripChart::indexAtPoint(const QPoint& point) {
     return (width() - point.x()) * _history->size() / width();
 }
 
+void StripChart::evaluate(int f, vector<Sample>& samples) {
+    const Chart::Function* function = _functions[f];
+    QHash<const LogFrame*, Sample>& last = _samples[f];
+    QHash<const LogFrame*, Sample> current;
+
+    samples.resize(_history->size());
+    for (unsigned int i = 0; i < _history->size(); ++i) {
+        const LogFrame* frame = _history->at(i).get();
+        Sample& sample = samples[i];
+        if (!frame) {
+            sample.valid = false;
+            continue;
+        }
+
+        auto iter = last.constFind(frame);
+        if (iter != last.constEnd() && iter->timestamp == frame->timestamp()) {
+            sample = *iter;
+        } else {
+            sample.timestamp = frame->timestamp();
+            sample.value = 0;
+            sample.valid = function->value(*frame, sample.value);
+        }
+        current.insert(frame, sample);
+    }
+
+    // Only keep frames that are still in the history
+    last.swap(current);
+}
+
 void StripChart::paintEvent(QPaintEvent* e) {
     if (!_history || _history->empty() || _functions.isEmpty()) {
         return;
@@ -79,8 +108,10 @@ void StripChart::paintEvent(QPaintEvent* e) {
     QPointF x = dataPoint(0, 0);
     p.drawLine(x, QPointF(0, x.y()));
 
+    _samples.resize(_functions.size());
+    vector<Sample> samples;
     for (unsigned int x = 0; x < _functions.size(); x++) {
-        auto function = _functions[x];
+        evaluate(x, samples);
 
         bool haveLast = false;
         QPointF last;
@@ -89,9 +120,9 @@ void StripChart::paintEvent(QPaintEvent* e) {
         } else {
             p.setPen(Qt::red);
         }
-        for (unsigned int i = 0; i < _history->size(); ++i) {
-            float v = 0;
-            if (_history->at(i) && function->value(*_history->at(i).get(), v)) {
+        for (unsigned int i = 0; i < samples.size(); ++i) {
+            if (samples[i].valid) {
+                float v = samples[i].value;
                 if (autoRange) {
                     newMin = min(newMin, v);
                     newMax = max(newMax, v);
@@ -106,17 +137,16 @@ void StripChart::paintEvent(QPaintEvent* e) {
                         mappedCursorPos + QPointF(15, 0 + fontHeight * 2 * x),
                         ("V: " + std::to_string(v)).c_str());
 
-                    if (i > 0 && i < _history->size() - 1) {
-                        float v1, v2;
-
-                        function->value(*_history->at(i - 1).get(), v1);
-                        function->value(*_history->at(i + 1).get(), v2);
+                    if (i > 0 && i < samples.size() - 1 &&
+                        samples[i - 1].valid && samples[i + 1].valid) {
+                        float v1 = samples[i - 1].value;
+                        float v2 = samples[i + 1].value;
 
                         double t1 = 0.0;
-                        t1 += _history->at(i - 1)->timestamp();
+                        t1 += samples[i - 1].timestamp;
                         t1 = RJ::TimestampToSecs(t1);
                         double t2 = 0.0;
-                        t2 += _history->at(i + 1)->timestamp();
+                        t2 += samples[i + 1].timestamp;
                         t2 = RJ::TimestampToSecs(t2);
 
                         auto derivative = (v2 - v1) / (t2 - t1);
@@ -148,46 +178,104 @@ void StripChart::paintEvent(QPaintEvent* e) {
 
 ////////
 
-bool Chart::PointMagnitude::value(const Packet::LogFrame& frame,
-                                  float& v) const {
-    const Message* msg = &frame;
+// Follows one step of a path from msg.
+// Returns null if the field or item is missing.
+static const Message* followStep(const Message* msg,
+                                 const FieldDescriptor* field, int index) {
+    const Reflection* ref = msg->GetReflection();
+    if (index >= 0) {
+        if (ref->FieldSize(*msg, field) <= index) {
+            // Not enough items
+            return nullptr;
+        }
+        return &ref->GetRepeatedMessage(*msg, field, index);
+    } else {
+        if (!ref->HasField(*msg, field)) {
+            // Missing field
+            return nullptr;
+        }
+        return &ref->GetMessage(*msg, field);
+    }
+}
+
+bool Chart::FieldFunction::compile(const char* name) const {
+    if (_compiled) {
+        return _valid;
+    }
+    _compiled = true;
+    _steps.clear();
+
+    const Descriptor* desc = LogFrame::descriptor();
     for (int i = 0; i < path.size(); ++i) {
-        const Reflection* ref = msg->GetReflection();
-        const Descriptor* desc = msg->GetDescriptor();
+        if (!desc) {
+            // Non-message field in the middle of a path
+            fprintf(stderr, "%s: expected a message field\n", name);
+            return false;
+        }
 
-        int tag = path[i];
-        const FieldDescriptor* fd = desc->FindFieldByNumber(tag);
-        if (fd->type() != FieldDescriptor::TYPE_MESSAGE) {
-            fprintf(stderr, "PointMagnitude: expected a message field\n");
+        const FieldDescriptor* fd = desc->FindFieldByNumber(path[i]);
+        if (!fd) {
+            fprintf(stderr, "%s: %s has no field %d\n", name,
+                    desc->name().c_str(), path[i]);
             return false;
         }
 
+        Step step = {fd, -1};
         if (fd->is_repeated()) {
             ++i;
             if (i >= path.size()) {
                 fprintf(stderr,
-                        "PointMagnitude: ends after tag for repeated field "
-                        "without giving index\n");
-                return false;
-            }
-            int j = path[i];
-            if (ref->FieldSize(*msg, fd) <= j) {
-                // Not enough items
+                        "%s: ends after tag for repeated field without giving "
+                        "index\n",
+                        name);
                 return false;
             }
-            msg = &ref->GetRepeatedMessage(*msg, fd, j);
+            step.index = path[i];
+        }
+        _steps.push_back(step);
+
+        if (fd->type() == FieldDescriptor::TYPE_MESSAGE) {
+            desc = fd->message_type();
         } else {
-            if (!ref->HasField(*msg, fd)) {
-                // Missing field
-                return false;
-            }
-            msg = &ref->GetMessage(*msg, fd);
+            desc = nullptr;
         }
     }
 
-    if (msg->GetDescriptor()->name() != "Point") {
-        fprintf(stderr,
-                "PointMagnitude: path ended in a message other than Point\n");
+    if (_steps.empty() || !validLast(_steps.back().field)) {
+        fprintf(stderr, "%s: unsupported field at the end of the path\n",
+                name);
+        return false;
+    }
+
+    _valid = true;
+    return true;
+}
+
+const Message* Chart::FieldFunction::parent(const LogFrame& frame) const {
+    const Message* msg = &frame;
+    for (unsigned int i = 0; msg && i < _steps.size() - 1; ++i) {
+        msg = followStep(msg, _steps[i].field, _steps[i].index);
+    }
+    return msg;
+}
+
+bool Chart::PointMagnitude::validLast(const FieldDescriptor* field) const {
+    return field->type() == FieldDescriptor::TYPE_MESSAGE &&
+           field->message_type() == Packet::Point::descriptor();
+}
+
+bool Chart::PointMagnitude::value(const Packet::LogFrame& frame,
+                                  float& v) const {
+    if (!compile("PointMagnitude")) {
+        return false;
+    }
+
+    const Message* msg = parent(frame);
+    if (msg) {
+        const Step& last = _steps.back();
+        msg = followStep(msg, last.field, last.index);
+    }
+    if (!msg) {
         return false;
     }
 
@@ -195,96 +283,40 @@ bool Chart::PointMagnitude::value(const Packet::LogFrame& frame,
     return true;
 }
 
+bool Chart::NumericField::validLast(const FieldDescriptor* field) const {
+    return field->type() == FieldDescriptor::TYPE_FLOAT ||
+           field->type() == FieldDescriptor::TYPE_DOUBLE;
+}
+
 bool Chart::NumericField::value(const Packet::LogFrame& frame, float& v) const {
-    const Message* msg = &frame;
-    for (int i = 0; i < path.size(); ++i) {
-        const Reflection* ref = msg->GetReflection();
-        const Descriptor* desc = msg->GetDescriptor();
-
-        int tag = path[i];
-        const FieldDescriptor* fd = desc->FindFieldByNumber(tag);
-        if (fd->type() != FieldDescriptor::TYPE_MESSAGE) {
-            if ((i == path.size() - 1 && !fd->is_repeated()) ||
-                (i == path.size() - 2 && fd->is_repeated())) {
-                // End of the path
-                if (fd->is_repeated()) {
-                    ++i;
-                    if (i >= path.size()) {
-                        fprintf(stderr,
-                                "NumericField: ends after tag for repeated "
-                                "field without giving index\n");
-                        return false;
-                    }
-                    int j = path[i];
-                    if (ref->FieldSize(*msg, fd) <= j) {
-                        // Not enough items
-                        return false;
-                    }
+    if (!compile("NumericField")) {
+        return false;
+    }
 
-                    switch (fd->type()) {
-                        case FieldDescriptor::TYPE_FLOAT:
-                            v = ref->GetRepeatedFloat(*msg, fd, j);
-                            break;
-
-                        case FieldDescriptor::TYPE_DOUBLE:
-                            v = ref->GetRepeatedDouble(*msg, fd, j);
-                            break;
-
-                        default:
-                            fprintf(stderr,
-                                    "NumericField: unsupported repeated field "
-                                    "type %d\n",
-                                    fd->type());
-                            return false;
-                    }
-                } else {
-                    switch (fd->type()) {
-                        case FieldDescriptor::TYPE_FLOAT:
-                            v = ref->GetFloat(*msg, fd);
-                            break;
-
-                        case FieldDescriptor::TYPE_DOUBLE:
-                            v = ref->GetDouble(*msg, fd);
-                            break;
-
-                        default:
-                            fprintf(stderr,
-                                    "NumericField: unsupported field type %d\n",
-                                    fd->type());
-                            return false;
-                    }
-                }
-                return true;
-            } else {
-                // Non-message field in the middle of a path
-                fprintf(stderr, "NumericField: expected a message field\n");
-                return false;
-            }
+    const Message* msg = parent(frame);
+    if (!msg) {
+        return false;
+    }
+
+    const Reflection* ref = msg->GetReflection();
+    const Step& last = _steps.back();
+    if (last.index >= 0) {
+        if (ref->FieldSize(*msg, last.field) <= last.index) {
+            // Not enough items
+            return false;
         }
 
-        if (fd->is_repeated()) {
-            ++i;
-            if (i >= path.size()) {
-                fprintf(stderr,
-                        "NumericField: ends after tag for repeated field "
-                        "without giving index\n");
-                return false;
-            }
-            int j = path[i];
-            if (ref->FieldSize(*msg, fd) <= j) {
-                // Not enough items
-                return false;
-            }
-            msg = &ref->GetRepeatedMessage(*msg, fd, j);
+        if (last.field->type() == FieldDescriptor::TYPE_FLOAT) {
+            v = ref->GetRepeatedFloat(*msg, last.field, last.index);
         } else {
-            if (!ref->HasField(*msg, fd)) {
-                // Missing field
-                return false;
-            }
-            msg = &ref->GetMessage(*msg, fd);
+            v = ref->GetRepeatedDouble(*msg, last.field, last.index);
+        }
+    } else {
+        if (last.field->type() == FieldDescriptor::TYPE_FLOAT) {
+            v = ref->GetFloat(*msg, last.field);
+        } else {
+            v = ref->GetDouble(*msg, last.field);
         }
     }
-
-    // Not reached
-    return false;
+    return true;
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <QWidget>
+#include <QHash>
 
+#include <stdint.h>
 #include <vector>
 #include <memory>
 
@@ -9,6 +11,13 @@ namespace Packet {
 class LogFrame;
 }
 
+namespace google {
+namespace protobuf {
+class FieldDescriptor;
+class Message;
+}
+}
+
 // Chart functions:
 //
 // Gets the value for a given frame.
@@ -21,22 +30,60 @@ struct Function {
     virtual bool value(const Packet::LogFrame& frame, float& v) const = 0;
 };
 
-struct PointMagnitude : public Function {
-    virtual bool value(const Packet::LogFrame& frame, float& v) const override;
-
-    // Vector of tags from LogFrame to the Point to be used.
-    // Each tag except must identify a Message.
+// A function of the field at the end of a path of tags from LogFrame.
+//
+// The path is resolved to field descriptors the first time the function is
+// evaluated, so each frame only needs to follow the resolved fields instead
+// of looking them up by number.  path must not change after that.
+struct FieldFunction : public Function {
+    // Vector of tags from LogFrame to the field to be used.
     // A repeated field's tag is followed by the index of the item.
     QVector<int> path;
+
+protected:
+    // One field along the path.  index is the item to use in a repeated
+    // field, or -1 for a singular field.
+    struct Step {
+        const google::protobuf::FieldDescriptor* field;
+        int index;
+    };
+
+    // Returns true if the path can end with this field
+    virtual bool validLast(
+        const google::protobuf::FieldDescriptor* field) const = 0;
+
+    // Resolves the path if that hasn't been done yet.
+    // Returns false if the path is invalid.  Errors are only printed once.
+    bool compile(const char* name) const;
+
+    // Returns the message containing the last field of the path, or null if
+    // a message along the way is missing.
+    const google::protobuf::Message* parent(
+        const Packet::LogFrame& frame) const;
+
+    mutable std::vector<Step> _steps;
+    mutable bool _compiled = false;
+    mutable bool _valid = false;
 };
 
-struct NumericField : public Function {
+struct PointMagnitude : public FieldFunction {
+    // path leads to a Point.
+    // Each tag must identify a Message.
     virtual bool value(const Packet::LogFrame& frame, float& v) const override;
 
-    // Vector of tags from LogFrame to the float or double field to be used.
+protected:
+    virtual bool validLast(
+        const google::protobuf::FieldDescriptor* field) const override;
+};
+
+struct NumericField : public FieldFunction {
+    // path leads to a float or double field.
     // Each tag except the last one must identify a Message.
-    // A repeated field's tag is followed by the index of the item.
-    QVector<int> path;
+    virtual bool value(const Packet::LogFrame& frame, float& v) const override;
+
+protected:
+    virtual bool validLast(
+        const google::protobuf::FieldDescriptor* field) const override;
 };
 }
 
@@ -76,9 +123,25 @@ protected:
 
     int indexAtPoint(const QPoint& point);
 
+    // Value of a function for one frame
+    struct Sample {
+        // Timestamp of the frame, to tell if the frame object has been reused
+        int64_t timestamp;
+        bool valid;
+        float value;
+    };
+
+    // Evaluates a function for every frame in the history.
+    // Frames that were already evaluated by the last paint are not evaluated
+    // again, so usually only the newest frames are.
+    void evaluate(int f, std::vector<Sample>& samples);
+
     // Chart function (see above)
     QList<Chart::Function*> _functions;
 
+    // Values of each function from the last paint, by frame
+    std::vector<QHash<const Packet::LogFrame*, Sample> > _samples;
+
     float _minValue;
     float _maxValue;
     QColor _color;
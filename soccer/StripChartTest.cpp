@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "StripChart.hpp"
+
+#include <protobuf/LogFrame.pb.h>
+
+using namespace Packet;
+
+TEST(StripChart, numericField) {
+    LogFrame frame;
+    LogFrame::Robot* robot = frame.add_self();
+    robot->mutable_pos()->set_x(1);
+    robot->mutable_pos()->set_y(2);
+
+    // self[0].pos.y
+    Chart::NumericField f;
+    f.path = {LogFrame::kSelfFieldNumber, 0, LogFrame::Robot::kPosFieldNumber,
+              Point::kYFieldNumber};
+
+    float v = 0;
+    ASSERT_TRUE(f.value(frame, v));
+    EXPECT_FLOAT_EQ(2, v);
+
+    // The path is only resolved once but must follow each frame
+    robot->mutable_pos()->set_y(3);
+    ASSERT_TRUE(f.value(frame, v));
+    EXPECT_FLOAT_EQ(3, v);
+
+    // Missing repeated items
+    frame.clear_self();
+    EXPECT_FALSE(f.value(frame, v));
+}
+
+TEST(StripChart, pointMagnitude) {
+    LogFrame frame;
+
+    // ball.vel
+    Chart::PointMagnitude f;
+    f.path = {LogFrame::kBallFieldNumber, LogFrame::Ball::kVelFieldNumber};
+
+    // Missing message
+    float v = 0;
+    EXPECT_FALSE(f.value(frame, v));
+
+    frame.mutable_ball()->mutable_vel()->set_x(3);
+    frame.mutable_ball()->mutable_vel()->set_y(4);
+    ASSERT_TRUE(f.value(frame, v));
+    EXPECT_FLOAT_EQ(5, v);
+}
+
+TEST(StripChart, invalidPaths) {
+    LogFrame frame;
+    frame.mutable_ball()->mutable_pos()->set_x(1);
+    frame.mutable_ball()->mutable_pos()->set_y(1);
+    float v = 0;
+
+    // Ends in a message
+    Chart::NumericField message;
+    message.path = {LogFrame::kBallFieldNumber,
+                    LogFrame::Ball::kPosFieldNumber};
+    EXPECT_FALSE(message.value(frame, v));
+
+    // Repeated field without an index
+    Chart::PointMagnitude noIndex;
+    noIndex.path = {LogFrame::kSelfFieldNumber};
+    EXPECT_FALSE(noIndex.value(frame, v));
+
+    // Unknown tag
+    Chart::NumericField unknown;
+    unknown.path = {LogFrame::kBallFieldNumber, 1000};
+    EXPECT_FALSE(unknown.value(frame, v));
+}
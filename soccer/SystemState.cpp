@@ -10,6 +10,8 @@ using namespace Packet;
 SystemState::SystemState() {
     timestamp = 0;
     _numDebugLayers = 0;
+    _recordAllDebugLayers = false;
+    _defaultDebugLayer = findDebugLayer("Debug");
 
     // FIXME - boost::array?
     self.resize(Num_Shells);
@@ -27,17 +29,20 @@ SystemState::~SystemState() {
     }
 }
 
-int SystemState::findDebugLayer(QString layer) {
+int SystemState::findDebugLayer(const QString& layer) {
     if (layer.isNull()) {
-        layer = "Debug";
+        return _defaultDebugLayer;
     }
 
-    QMap<QString, int>::const_iterator i = _debugLayerMap.find(layer);
-    if (i == _debugLayerMap.end()) {
+    QHash<QString, int>::const_iterator i = _debugLayerMap.constFind(layer);
+    if (i == _debugLayerMap.constEnd()) {
         // New layer
         int n = _numDebugLayers++;
         _debugLayerMap[layer] = n;
         _debugLayers.append(layer);
+        if ((int)_debugLayerEnabled.size() < _numDebugLayers) {
+            _debugLayerEnabled.resize(_numDebugLayers, true);
+        }
         return n;
     } else {
         // Existing layer
@@ -45,48 +50,69 @@ int SystemState::findDebugLayer(QString layer) {
     }
 }
 
-void SystemState::drawPolygon(const Geometry2d::Point* pts, int n,
-                              const QColor& qc, const QString& layer) {
-    DebugPath* dbg = logFrame->add_debug_polygons();
-    dbg->set_layer(findDebugLayer(layer));
-    for (int i = 0; i < n; ++i) {
-        *dbg->add_points() = pts[i];
+void SystemState::setDebugLayerEnabled(int layer, bool enabled) {
+    if (layer < 0) {
+        return;
+    }
+
+    // The GUI may know about layers from a log that this process hasn't
+    // created yet.
+    if (layer >= (int)_debugLayerEnabled.size()) {
+        _debugLayerEnabled.resize(layer + 1, true);
     }
-    dbg->set_color(color(qc));
+    _debugLayerEnabled[layer] = enabled;
 }
 
-void SystemState::drawPolygon(const std::vector<Geometry2d::Point>& pts,
-                              const QColor& qc, const QString& layer) {
-    drawPolygon(pts.data(), pts.size(), qc, layer);
+SystemState::DebugDrawCommand& SystemState::addDebugCommand(
+    DebugDrawCommand::Type type, int layer, const QColor& qc,
+    uint32_t numPoints) {
+    _debugCommands.emplace_back();
+    DebugDrawCommand& cmd = _debugCommands.back();
+    cmd.type = type;
+    cmd.layer = layer;
+    cmd.color = color(qc);
+    cmd.firstPoint = _debugPoints.size();
+    cmd.numPoints = numPoints;
+    cmd.radius = 0;
+    cmd.text = 0;
+    cmd.start = 0;
+    cmd.end = 0;
+    return cmd;
 }
 
-void SystemState::drawPolygon(const Geometry2d::Polygon& polygon,
-                              const QColor& qc, const QString& layer) {
-    this->drawPolygon(polygon.vertices, qc, layer);
+void SystemState::drawPolygon(const Geometry2d::Point* pts, int n,
+                              const QColor& qc, int layer) {
+    if (!debugLayerEnabled(layer)) return;
+
+    addDebugCommand(DebugDrawCommand::Polygon, layer, qc, n);
+    _debugPoints.insert(_debugPoints.end(), pts, pts + n);
 }
 
 void SystemState::drawCircle(Geometry2d::Point center, float radius,
-                             const QColor& qc, const QString& layer) {
-    DebugCircle* dbg = logFrame->add_debug_circles();
-    dbg->set_layer(findDebugLayer(layer));
-    *dbg->mutable_center() = center;
-    dbg->set_radius(radius);
-    dbg->set_color(color(qc));
+                             const QColor& qc, int layer) {
+    if (!debugLayerEnabled(layer)) return;
+
+    DebugDrawCommand& cmd =
+        addDebugCommand(DebugDrawCommand::Circle, layer, qc, 1);
+    cmd.radius = radius;
+    _debugPoints.push_back(center);
 }
 
 void SystemState::drawArc(const Geometry2d::Arc& arc, const QColor& qc,
-                          const QString& layer) {
-    DebugArc* dbg = logFrame->add_debug_arcs();
-    dbg->set_layer(findDebugLayer(layer));
-    *dbg->mutable_center() = arc.center();
-    dbg->set_radius(arc.radius());
-    dbg->set_start(arc.start());
-    dbg->set_end(arc.end());
-    dbg->set_color(color(qc));
+                          int layer) {
+    if (!debugLayerEnabled(layer)) return;
+
+    DebugDrawCommand& cmd = addDebugCommand(DebugDrawCommand::Arc, layer, qc, 1);
+    cmd.radius = arc.radius();
+    cmd.start = arc.start();
+    cmd.end = arc.end();
+    _debugPoints.push_back(arc.center());
 }
 
 void SystemState::drawShape(const std::shared_ptr<Geometry2d::Shape>& obs,
-                            const QColor& color, const QString& layer) {
+                            const QColor& color, int layer) {
+    if (!debugLayerEnabled(layer)) return;
+
     std::shared_ptr<Geometry2d::Circle> circObs =
         std::dynamic_pointer_cast<Geometry2d::Circle>(obs);
     std::shared_ptr<Geometry2d::Polygon> polyObs =
@@ -96,7 +122,8 @@ void SystemState::drawShape(const std::shared_ptr<Geometry2d::Shape>& obs,
     if (circObs)
         drawCircle(circObs->center, circObs->radius(), color, layer);
     else if (polyObs)
-        drawPolygon(polyObs->vertices, color, layer);
+        drawPolygon(polyObs->vertices.data(), polyObs->vertices.size(), color,
+                    layer);
     else if (compObs) {
         for (const std::shared_ptr<Geometry2d::Shape>& obs :
              compObs->subshapes())
@@ -106,39 +133,88 @@ void SystemState::drawShape(const std::shared_ptr<Geometry2d::Shape>& obs,
 
 void SystemState::drawShapeSet(const Geometry2d::ShapeSet& shapes,
                                const QColor& color, const QString& layer) {
+    int layerID = findDebugLayer(layer);
+    if (!debugLayerEnabled(layerID)) return;
+
     for (auto& shape : shapes.shapes()) {
-        drawShape(shape, color, layer);
+        drawShape(shape, color, layerID);
     }
 }
 
 void SystemState::drawLine(const Geometry2d::Segment& line, const QColor& qc,
-                           const QString& layer) {
-    DebugPath* dbg = logFrame->add_debug_paths();
-    dbg->set_layer(findDebugLayer(layer));
-    *dbg->add_points() = line.pt[0];
-    *dbg->add_points() = line.pt[1];
-    dbg->set_color(color(qc));
-}
+                           int layer) {
+    if (!debugLayerEnabled(layer)) return;
 
-void SystemState::drawLine(Geometry2d::Point p0, Geometry2d::Point p1,
-                           const QColor& color, const QString& layer) {
-    drawLine(Geometry2d::Segment(p0, p1), color, layer);
+    addDebugCommand(DebugDrawCommand::Path, layer, qc, 2);
+    _debugPoints.push_back(line.pt[0]);
+    _debugPoints.push_back(line.pt[1]);
 }
 
 void SystemState::drawText(const QString& text, Geometry2d::Point pos,
-                           const QColor& qc, const QString& layer) {
-    DebugText* dbg = logFrame->add_debug_texts();
-    dbg->set_layer(findDebugLayer(layer));
-    dbg->set_text(text.toStdString());
-    *dbg->mutable_pos() = pos;
-    dbg->set_color(color(qc));
+                           const QColor& qc, int layer) {
+    if (!debugLayerEnabled(layer)) return;
+
+    DebugDrawCommand& cmd =
+        addDebugCommand(DebugDrawCommand::Text, layer, qc, 1);
+    cmd.text = _debugTexts.size();
+    _debugTexts.push_back(text.toStdString());
+    _debugPoints.push_back(pos);
 }
 
-void SystemState::drawSegment(const Geometry2d::Segment& line, const QColor& qc,
-                              const QString& layer) {
-    DebugPath* dbg = logFrame->add_debug_paths();
-    dbg->set_layer(findDebugLayer(layer));
-    *dbg->add_points() = line.pt[0];
-    *dbg->add_points() = line.pt[1];
-    dbg->set_color(color(qc));
+void SystemState::flushDebugDrawing(LogFrame* frame) {
+    for (const DebugDrawCommand& cmd : _debugCommands) {
+        const Geometry2d::Point* pts = &_debugPoints[cmd.firstPoint];
+        switch (cmd.type) {
+            case DebugDrawCommand::Path:
+            case DebugDrawCommand::Polygon: {
+                DebugPath* dbg = (cmd.type == DebugDrawCommand::Path)
+                                     ? frame->add_debug_paths()
+                                     : frame->add_debug_polygons();
+                dbg->set_layer(cmd.layer);
+                dbg->mutable_points()->Reserve(cmd.numPoints);
+                for (uint32_t i = 0; i < cmd.numPoints; ++i) {
+                    Packet::Point* pt = dbg->add_points();
+                    pt->set_x(pts[i].x);
+                    pt->set_y(pts[i].y);
+                }
+                dbg->set_color(cmd.color);
+                break;
+            }
+
+            case DebugDrawCommand::Circle: {
+                DebugCircle* dbg = frame->add_debug_circles();
+                dbg->set_layer(cmd.layer);
+                *dbg->mutable_center() = pts[0];
+                dbg->set_radius(cmd.radius);
+                dbg->set_color(cmd.color);
+                break;
+            }
+
+            case DebugDrawCommand::Arc: {
+                DebugArc* dbg = frame->add_debug_arcs();
+                dbg->set_layer(cmd.layer);
+                *dbg->mutable_center() = pts[0];
+                dbg->set_radius(cmd.radius);
+                dbg->set_start(cmd.start);
+                dbg->set_end(cmd.end);
+                dbg->set_color(cmd.color);
+                break;
+            }
+
+            case DebugDrawCommand::Text: {
+                DebugText* dbg = frame->add_debug_texts();
+                dbg->set_layer(cmd.layer);
+                dbg->mutable_text()->swap(_debugTexts[cmd.text]);
+                *dbg->mutable_pos() = pts[0];
+                dbg->set_color(cmd.color);
+                break;
+            }
+        }
+    }
+
+    // clear() keeps the capacity, so after the first few frames drawing does
+    // not allocate.
+    _debugCommands.clear();
+    _debugPoints.clear();
+    _debugTexts.clear();
 }
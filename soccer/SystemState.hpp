@@ -4,7 +4,7 @@
 #include <string>
 #include <memory>
 
-#include <QMap>
+#include <QHash>
 #include <QColor>
 
 #include <Geometry2d/CompositeShape.hpp>
@@ -72,46 +72,98 @@ public:
     /** @ingroup drawing_functions */
     void drawLine(const Geometry2d::Segment& line,
                   const QColor& color = Qt::black,
-                  const QString& layer = QString());
+                  const QString& layer = QString()) {
+        drawLine(line, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawLine(const Geometry2d::Segment& line, const QColor& color,
+                  int layer);
     /** @ingroup drawing_functions */
     void drawSegment(const Geometry2d::Segment& line,
                      const QColor& color = Qt::black,
-                     const QString& layer = QString());
+                     const QString& layer = QString()) {
+        drawLine(line, color, findDebugLayer(layer));
+    }
     /** @ingroup drawing_functions */
     void drawLine(Geometry2d::Point p0, Geometry2d::Point p1,
                   const QColor& color = Qt::black,
-                  const QString& layer = QString());
+                  const QString& layer = QString()) {
+        drawLine(Geometry2d::Segment(p0, p1), color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawLine(Geometry2d::Point p0, Geometry2d::Point p1,
+                  const QColor& color, int layer) {
+        drawLine(Geometry2d::Segment(p0, p1), color, layer);
+    }
     /** @ingroup drawing_functions */
     void drawCircle(Geometry2d::Point center, float radius,
                     const QColor& color = Qt::black,
-                    const QString& layer = QString());
+                    const QString& layer = QString()) {
+        drawCircle(center, radius, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawCircle(Geometry2d::Point center, float radius,
+                    const QColor& color, int layer);
     /** @ingroup drawing_functions */
     void drawPolygon(const Geometry2d::Polygon& pts,
                      const QColor& color = Qt::black,
-                     const QString& layer = QString());
+                     const QString& layer = QString()) {
+        drawPolygon(pts.vertices, color, layer);
+    }
     /** @ingroup drawing_functions */
     void drawArc(const Geometry2d::Arc& arc, const QColor& color = Qt::black,
-                 const QString& layer = QString());
+                 const QString& layer = QString()) {
+        drawArc(arc, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawArc(const Geometry2d::Arc& arc, const QColor& color, int layer);
     /** @ingroup drawing_functions */
     void drawPolygon(const Geometry2d::Point* pts, int n,
                      const QColor& color = Qt::black,
-                     const QString& layer = QString());
+                     const QString& layer = QString()) {
+        drawPolygon(pts, n, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawPolygon(const Geometry2d::Point* pts, int n, const QColor& color,
+                     int layer);
     /** @ingroup drawing_functions */
     void drawPolygon(const std::vector<Geometry2d::Point>& pts,
                      const QColor& color = Qt::black,
-                     const QString& layer = QString());
+                     const QString& layer = QString()) {
+        drawPolygon(pts.data(), pts.size(), color, findDebugLayer(layer));
+    }
     /** @ingroup drawing_functions */
     void drawText(const QString& text, Geometry2d::Point pos,
                   const QColor& color = Qt::black,
-                  const QString& layer = QString());
+                  const QString& layer = QString()) {
+        drawText(text, pos, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawText(const QString& text, Geometry2d::Point pos,
+                  const QColor& color, int layer);
     /** @ingroup drawing_functions */
     void drawShape(const std::shared_ptr<Geometry2d::Shape>& obs,
                    const QColor& color = Qt::black,
-                   const QString& layer = QString());
+                   const QString& layer = QString()) {
+        drawShape(obs, color, findDebugLayer(layer));
+    }
+    /** @ingroup drawing_functions */
+    void drawShape(const std::shared_ptr<Geometry2d::Shape>& obs,
+                   const QColor& color, int layer);
     /** @ingroup drawing_functions */
     void drawShapeSet(const Geometry2d::ShapeSet& shapes,
                       const QColor& color = Qt::black,
                       const QString& layer = QString());
+
+    /**
+     * Writes all drawing commands buffered since the last call into the
+     * debug_* fields of @frame and clears the buffer.
+     *
+     * The drawing functions only record into a flat array so that the
+     * protobuf messages are built once per frame, just before it is logged.
+     */
+    void flushDebugDrawing(Packet::LogFrame* frame);
+
     RJ::Time timestamp;
     GameState gameState;
 
@@ -134,16 +186,74 @@ public:
 
     const QStringList& debugLayers() const { return _debugLayers; }
 
-    /// Returns the number of a debug layer given its name
-    int findDebugLayer(QString layer);
+    /// Returns the number of a debug layer given its name.
+    ///
+    /// Layer numbers never change once assigned, so code that draws every
+    /// frame should look its layers up once and pass the number to the
+    /// drawing functions instead of the name.
+    int findDebugLayer(const QString& layer);
+
+    /// Returns true if drawings on the given layer are being recorded
+    bool debugLayerEnabled(int layer) const {
+        return _recordAllDebugLayers || layer < 0 ||
+               layer >= (int)_debugLayerEnabled.size() ||
+               _debugLayerEnabled[layer];
+    }
+
+    /// Turns recording of a debug layer on or off.  Drawing on a disabled
+    /// layer returns immediately without touching the LogFrame.  This is called
+    /// from the GUI thread, so the caller must hold the processor's loop mutex.
+    void setDebugLayerEnabled(int layer, bool enabled);
+
+    /// When set, layers are recorded even if they are disabled.  The processor
+    /// sets this while writing a log file so saved logs are complete.
+    void recordAllDebugLayers(bool value) { _recordAllDebugLayers = value; }
 
 private:
+    /// A single buffered drawing command.  Variable-length data (points and
+    /// text) lives in _debugPoints and _debugTexts and is referenced by index.
+    struct DebugDrawCommand {
+        enum Type : uint8_t { Path, Polygon, Circle, Arc, Text };
+
+        Type type;
+        int layer;
+        uint32_t color;
+
+        /// Index of the first point in _debugPoints.  For circles, arcs, and
+        /// text this is the center/position.
+        uint32_t firstPoint;
+        uint32_t numPoints;
+
+        /// Radius for circles and arcs, index into _debugTexts for text
+        float radius;
+        uint32_t text;
+
+        float start, end;
+    };
+
+    /// Appends a command and returns it for the caller to fill in
+    DebugDrawCommand& addDebugCommand(DebugDrawCommand::Type type, int layer,
+                                      const QColor& qc, uint32_t numPoints);
+
     /// Map from debug layer name to ID
-    QMap<QString, int> _debugLayerMap;
+    QHash<QString, int> _debugLayerMap;
 
     /// Debug layers in order by ID
     QStringList _debugLayers;
 
     /// Number of debug layers
     int _numDebugLayers;
+
+    /// ID of the layer used when no layer name is given
+    int _defaultDebugLayer;
+
+    /// Recording state of each debug layer, indexed by ID
+    std::vector<bool> _debugLayerEnabled;
+
+    bool _recordAllDebugLayers;
+
+    /// Drawing commands for the current frame
+    std::vector<DebugDrawCommand> _debugCommands;
+    std::vector<Geometry2d::Point> _debugPoints;
+    std::vector<std::string> _debugTexts;
 };
@@ -1,6 +1,7 @@
 #include "VisionReceiver.hpp"
 
 #include <multicast.hpp>
+#include <ShmRing.hpp>
 #include <Utils.hpp>
 #include <unistd.h>
 #include <QMutexLocker>
@@ -13,6 +14,8 @@ VisionReceiver::VisionReceiver(bool sim, int port) {
     simulation = sim;
     _running = false;
     this->port = port;
+    portOffset = 0;
+    sharedMemory = false;
 }
 
 void VisionReceiver::stop() {
@@ -27,7 +30,60 @@ void VisionReceiver::getPackets(std::vector<VisionPacket*>& packets) {
     _mutex.unlock();
 }
 
+void VisionReceiver::addPacket(const char* data, int size) {
+    VisionPacket* packet = new VisionPacket;
+    packet->receivedTime = RJ::timestamp();
+    if (!packet->wrapper.ParseFromArray(data, size)) {
+        fprintf(stderr, "VisionReceiver: got bad packet of %d bytes\n", size);
+        delete packet;
+        return;
+    }
+
+    // Add to the vector of packets
+    _mutex.lock();
+    _packets.push_back(packet);
+    _mutex.unlock();
+}
+
+void VisionReceiver::runSharedMemory() {
+    ShmRing ring;
+    string buf;
+
+    _packets.reserve(4);
+
+    _running = true;
+    while (_running) {
+        // Like the two simulator ports, use whichever ring isn't taken yet.
+        // The rings are recreated if the simulator restarts.
+        if (!ring.isOpen() || ring.abandoned()) {
+            ring.close();
+            for (int i = 0; i < 2 && !ring.isOpen(); ++i) {
+                if (ring.open(ShmRing::name(ShmVisionChannel, i, portOffset)) &&
+                    !ring.claim()) {
+                    ring.close();
+                }
+            }
+
+            if (!ring.isOpen()) {
+                // The simulator isn't running yet
+                ::usleep(100 * 1000);
+                continue;
+            }
+        }
+
+        // Time out once in a while so the thread has a chance to exit
+        if (ring.read(buf, 500)) {
+            addPacket(buf.data(), buf.size());
+        }
+    }
+}
+
 void VisionReceiver::run() {
+    if (simulation && sharedMemory) {
+        runSharedMemory();
+        return;
+    }
+
     QUdpSocket socket;
 
     // Create vision socket
@@ -35,8 +91,8 @@ void VisionReceiver::run() {
         // The simulator doesn't multicast its vision.  Instead, it sends to two
         // different ports.
         // Try to bind to the first one and, if that fails, use the second one.
-        if (!socket.bind(SimVisionPort)) {
-            if (!socket.bind(SimVisionPort + 1)) {
+        if (!socket.bind(SimVisionPort + portOffset)) {
+            if (!socket.bind(SimVisionPort + portOffset + 1)) {
                 throw runtime_error(
                     "Can't bind to either simulated vision port");
             }
@@ -79,20 +135,6 @@ void VisionReceiver::run() {
         // FIXME - Verify that it is from the right host, in case there are
         // multiple visions on the network
 
-        // Parse the protobuf message
-        VisionPacket* packet = new VisionPacket;
-        packet->receivedTime = RJ::timestamp();
-        if (!packet->wrapper.ParseFromArray(buf, size)) {
-            fprintf(stderr,
-                    "VisionReceiver: got bad packet of %d bytes from %s:%d\n",
-                    (int)size, (const char*)host.toString().toLatin1(),
-                    portNumber);
-            continue;
-        }
-
-        // Add to the vector of packets
-        _mutex.lock();
-        _packets.push_back(packet);
-        _mutex.unlock();
+        addPacket(buf, size);
     }
 }
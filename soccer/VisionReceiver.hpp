@@ -27,6 +27,8 @@ public:
  * @details When start() is called, a new thread is spawned that listens on a
  * UDP port for packets. If sim = true, it tries both simulator ports until one
  * works. Otherwise, it connects to the port specified in the constructor.
+ * With sharedMemory also set, the simulator's shared memory rings are used
+ * instead of its ports.
  *
  * Whenever a new packet comes in (encoded as Google Protobuf), it is parsed
  * into an SSL_WrapperPacket and placed onto the circular buffer @_packets.
@@ -49,9 +51,21 @@ public:
     bool simulation;
     int port;
 
+    /// Added to the simulated vision ports
+    int portOffset;
+
+    /// Read simulated vision from shared memory instead of UDP
+    bool sharedMemory;
+
 protected:
     virtual void run() override;
 
+    // Reads packets from the simulator's shared memory rings
+    void runSharedMemory();
+
+    // Parses a packet and adds it to the buffer
+    void addPacket(const char* data, int size);
+
     volatile bool _running;
 
     /// This mutex protects the vector of packets
@@ -324,6 +324,13 @@ void State_draw_raw_polygon(SystemState* self, Geometry2d::Polygon points,
                       QString::fromStdString(layer));
 }
 
+void State_draw_shape(SystemState* self,
+                      const std::shared_ptr<Geometry2d::Shape>& shape,
+                      boost::python::tuple rgb, const std::string& layer) {
+    self->drawShape(shape, Color_from_tuple(rgb),
+                    QString::fromStdString(layer));
+}
+
 boost::python::list Circle_intersects_line(Geometry2d::Circle* self,
                                            const Geometry2d::Line* line) {
     if (line == nullptr) throw NullArgumentException("line");
@@ -672,7 +679,7 @@ BOOST_PYTHON_MODULE(robocup) {
         // debug drawing methods
         .def("draw_circle", &State_draw_circle)
         .def("draw_text", &State_draw_text)
-        .def("draw_shape", &SystemState::drawShape)
+        .def("draw_shape", &State_draw_shape)
         .def("draw_line", &State_draw_line)
         .def("draw_line", &State_draw_segment)
         .def("draw_segment", &State_draw_segment)
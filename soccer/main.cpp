@@ -34,8 +34,20 @@ void usage(const char* prog) {
             "'soccer/gameplay/playbooks/'\n");
     fprintf(stderr, "\t-ng:         no goalie\n");
     fprintf(stderr, "\t-sim:        use simulator\n");
+    fprintf(stderr,
+            "\t-lockstep:   step the simulator once per frame (needs a "
+            "simulator started with --lockstep)\n");
+    fprintf(stderr,
+            "\t-shm:        talk to the simulator through shared memory (needs "
+            "a simulator started with --shm)\n");
+    fprintf(stderr,
+            "\t-port-offset <n>: add n to the simulator and referee ports\n");
+    fprintf(stderr, "\t-frames <n>: exit after n frames\n");
     fprintf(stderr, "\t-freq:       specify radio frequency (906 or 904)\n");
     fprintf(stderr, "\t-nolog:      don't write log files\n");
+    fprintf(stderr,
+            "\t-logmem <MiB>: memory limit for log history (default %d)\n",
+            (int)(Logger::DefaultMaxSpace / (1024 * 1024)));
     fprintf(stderr, "\t-noref:      don't use external referee commands\n");
     exit(1);
 }
@@ -64,10 +76,15 @@ int main(int argc, char* argv[]) {
     QString cfgFile;
     vector<const char*> playDirs;
     bool sim = false;
+    bool lockstep = false;
+    bool sharedMemory = false;
     bool log = true;
     QString radioFreq;
     string playbookFile;
     bool noref = false;
+    size_t logMemory = Logger::DefaultMaxSpace;
+    int portOffset = 0;
+    int frameLimit = 0;
 
     for (int i = 1; i < argc; ++i) {
         const char* var = argv[i];
@@ -80,8 +97,36 @@ int main(int argc, char* argv[]) {
             blueTeam = true;
         } else if (strcmp(var, "-sim") == 0) {
             sim = true;
+        } else if (strcmp(var, "-lockstep") == 0) {
+            lockstep = true;
+        } else if (strcmp(var, "-shm") == 0) {
+            sharedMemory = true;
         } else if (strcmp(var, "-nolog") == 0) {
             log = false;
+        } else if (strcmp(var, "-logmem") == 0) {
+            if (i + 1 >= argc) {
+                printf("no memory limit specified after -logmem\n");
+                usage(argv[0]);
+            }
+
+            i++;
+            logMemory = (size_t)atoi(argv[i]) * 1024 * 1024;
+        } else if (strcmp(var, "-port-offset") == 0) {
+            if (i + 1 >= argc) {
+                printf("no offset specified after -port-offset\n");
+                usage(argv[0]);
+            }
+
+            i++;
+            portOffset = atoi(argv[i]);
+        } else if (strcmp(var, "-frames") == 0) {
+            if (i + 1 >= argc) {
+                printf("no frame count specified after -frames\n");
+                usage(argv[0]);
+            }
+
+            i++;
+            frameLimit = atoi(argv[i]);
         } else if (strcmp(var, "-freq") == 0) {
             if (i + 1 >= argc) {
                 printf("No radio frequency specified after -freq\n");
@@ -121,6 +166,16 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (lockstep && !sim) {
+        printf("-lockstep only works with -sim\n");
+        usage(argv[0]);
+    }
+
+    if (sharedMemory && !sim) {
+        printf("-shm only works with -sim\n");
+        usage(argv[0]);
+    }
+
     printf("Running on %s\n", sim ? "simulation" : "real hardware\n");
 
     printf("seed %016lx\n", seed);
@@ -135,9 +190,16 @@ int main(int argc, char* argv[]) {
     std::shared_ptr<Configuration> config =
         Configuration::FromRegisteredConfigurables();
 
-    Processor* processor = new Processor(sim);
+    Processor* processor = new Processor(sim, portOffset);
     processor->blueTeam(blueTeam);
     processor->refereeModule()->useExternalReferee(!noref);
+    processor->logMemoryLimit(logMemory);
+    processor->lockstep(lockstep);
+    processor->sharedMemory(sharedMemory);
+    processor->frameLimit(frameLimit);
+
+    // Exit once the processor is done with its frames
+    QObject::connect(processor, SIGNAL(finished()), &app, SLOT(quit()));
 
     // Load config file
     QString error;
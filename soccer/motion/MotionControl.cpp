@@ -6,6 +6,7 @@
 #include "TrapezoidalMotion.hpp"
 #include <Geometry2d/Util.hpp>
 #include <planning/MotionInstant.hpp>
+#include <radio/ForwardEncoder.hpp>
 
 #include <cmath>
 #include <stdio.h>
@@ -21,11 +22,16 @@ REGISTER_CONFIGURABLE(MotionControl);
 
 ConfigDouble* MotionControl::_max_acceleration;
 ConfigDouble* MotionControl::_max_velocity;
+ConfigDouble* MotionControl::_segment_length;
 
 void MotionControl::createConfiguration(Configuration* cfg) {
     _max_acceleration =
         new ConfigDouble(cfg, "MotionControl/Max Acceleration", 1.5);
     _max_velocity = new ConfigDouble(cfg, "MotionControl/Max Velocity", 2.0);
+    _segment_length = new ConfigDouble(
+        cfg, "MotionControl/Segment Length", 0.1,
+        "Seconds of the path sent for the robot to follow between commands "
+        "when Radio/Trajectories is on, or zero to send only velocities");
 }
 
 #pragma mark MotionControl
@@ -35,6 +41,11 @@ MotionControl::MotionControl(OurRobot* robot) : _angleController(0, 0, 0, 50) {
 
     _robot->robotPacket.set_uid(_robot->shell());
     _lastCmdTime = -1;
+    _configGeneration = 0;
+    _config = nullptr;
+
+    _planningLayer = _robot->state()->findDebugLayer("Planning");
+    _motionControlLayer = _robot->state()->findDebugLayer("MotionControl");
 }
 
 void MotionControl::run() {
@@ -42,18 +53,24 @@ void MotionControl::run() {
 
     const MotionConstraints& constraints = _robot->motionConstraints();
 
-    // update PID parameters
-    _positionXController.kp = *_robot->config->translation.p;
-    _positionXController.ki = *_robot->config->translation.i;
-    _positionXController.setWindup(*_robot->config->translation.i_windup);
-    _positionXController.kd = *_robot->config->translation.d;
-    _positionYController.kp = *_robot->config->translation.p;
-    _positionYController.ki = *_robot->config->translation.i;
-    _positionYController.setWindup(*_robot->config->translation.i_windup);
-    _positionYController.kd = *_robot->config->translation.d;
-    _angleController.kp = *_robot->config->rotation.p;
-    _angleController.ki = *_robot->config->rotation.i;
-    _angleController.kd = *_robot->config->rotation.d;
+    // update PID parameters if the configuration changed, or if the robot
+    // now uses another revision's configuration
+    uint32_t generation = Configuration::generation();
+    if (generation != _configGeneration || _robot->config != _config) {
+        _configGeneration = generation;
+        _config = _robot->config;
+        _positionXController.kp = *_robot->config->translation.p;
+        _positionXController.ki = *_robot->config->translation.i;
+        _positionXController.setWindup(*_robot->config->translation.i_windup);
+        _positionXController.kd = *_robot->config->translation.d;
+        _positionYController.kp = *_robot->config->translation.p;
+        _positionYController.ki = *_robot->config->translation.i;
+        _positionYController.setWindup(*_robot->config->translation.i_windup);
+        _positionYController.kd = *_robot->config->translation.d;
+        _angleController.kp = *_robot->config->rotation.p;
+        _angleController.ki = *_robot->config->rotation.i;
+        _angleController.kd = *_robot->config->rotation.d;
+    }
 
     float timeIntoPath =
         RJ::TimestampToSecs(RJ::timestamp() - _robot->path().startTime()) +
@@ -66,11 +83,11 @@ void MotionControl::run() {
     if (!optTarget) {
         optTarget = _robot->path().end();
         _robot->state()->drawCircle(optTarget->motion.pos, .15, Qt::red,
-                                    "Planning");
+                                    _planningLayer);
     } else {
         Point start = _robot->pos;
         _robot->state()->drawCircle(optTarget->motion.pos, .15, Qt::green,
-                                    "Planning");
+                                    _planningLayer);
     }
 
     // Angle control //////////////////////////////////////////////////
@@ -135,6 +152,7 @@ void MotionControl::run() {
         vel.rotate(-M_PI_2);
 
         _targetBodyVel(vel);
+        _robot->control->clear_segment();
 
         return;  // pivot handles both angle and position
     }
@@ -165,19 +183,22 @@ void MotionControl::run() {
     target.vel.y += _positionYController.run(posError.y);
 
     // draw target pt
-    _robot->state()->drawCircle(target.pos, .04, Qt::red, "MotionControl");
+    _robot->state()->drawCircle(target.pos, .04, Qt::red,
+                                _motionControlLayer);
     _robot->state()->drawLine(target.pos, target.pos + target.vel, Qt::blue,
-                              "MotionControl");
+                              _motionControlLayer);
 
     // convert from world to body coordinates
     target.vel = target.vel.rotated(-_robot->angle);
 
     this->_targetBodyVel(target.vel);
+    _targetSegment(timeIntoPath, targetW);
 }
 
 void MotionControl::stopped() {
     _targetBodyVel(Point(0, 0));
     _targetAngleVel(0);
+    _robot->control->clear_segment();
 }
 
 void MotionControl::_targetAngleVel(float angleVel) {
@@ -200,41 +221,93 @@ void MotionControl::_targetAngleVel(float angleVel) {
     _robot->control->set_avelocity(angleVel);
 }
 
+void MotionControl::_targetSegment(float timeIntoPath, float angleVel) {
+    float length = *_segment_length;
+    if (length <= 0 || !ForwardEncoder::sendsTrajectories()) {
+        _robot->control->clear_segment();
+        return;
+    }
+
+    // velocities halfway through and at the end, without the feedback that
+    // only applies now.  Each is limited like the command, accelerating from
+    // the one before it.
+    Point vel[2];
+    Point lastVel = _lastVelCmd;
+    for (int i = 0; i < 2; ++i) {
+        float t = length * (i + 1) / 2;
+        boost::optional<RobotInstant> instant =
+            _robot->path().evaluate(timeIntoPath + t);
+        if (instant) {
+            vel[i] = instant->motion.vel;
+        }
+
+        vel[i] = vel[i].rotated(-(_robot->angle + angleVel * t));
+        vel[i] = _limitBodyVel(vel[i], lastVel, length / 2);
+        lastVel = vel[i];
+        vel[i] = _robotBodyVel(vel[i]);
+    }
+
+    // the turn rate is held, since the angle controller decides it each
+    // frame
+    float w = _robot->control->avelocity();
+
+    Packet::Control::Segment* segment = _robot->control->mutable_segment();
+    segment->set_duration(length);
+    segment->set_xmiddle(vel[0].x);
+    segment->set_ymiddle(vel[0].y);
+    segment->set_amiddle(w);
+    segment->set_xend(vel[1].x);
+    segment->set_yend(vel[1].y);
+    segment->set_aend(w);
+}
+
 void MotionControl::_targetBodyVel(Point targetVel) {
+    // the first command is limited as if the robot were stopped a second ago
+    float dt = 1;
+    if (_lastCmdTime != -1) {
+        dt = (float)((RJ::timestamp() - _lastCmdTime) / 1000000.0f);
+    }
+    targetVel = _limitBodyVel(targetVel, _lastVelCmd, dt);
+
+    // track these values so we can limit acceleration
+    _lastVelCmd = targetVel;
+    _lastCmdTime = RJ::timestamp();
+
+    targetVel = _robotBodyVel(targetVel);
+
+    // set control values
+    _robot->control->set_xvelocity(targetVel.x);
+    _robot->control->set_yvelocity(targetVel.y);
+}
+
+Point MotionControl::_limitBodyVel(Point targetVel, Point lastVel,
+                                   float dt) const {
     // Limit Velocity
     targetVel.clamp(*_max_velocity);
 
     // Limit Acceleration
-    if (_lastCmdTime == -1) {
-        targetVel.clamp(*_max_acceleration);
-    } else {
-        float dt = (float)((RJ::timestamp() - _lastCmdTime) / 1000000.0f);
-        Point targetAccel = (targetVel - _lastVelCmd) / dt;
-        targetAccel.clamp(*_max_acceleration);
-
-        targetVel = _lastVelCmd + targetAccel * dt;
-    }
+    Point targetAccel = (targetVel - lastVel) / dt;
+    targetAccel.clamp(*_max_acceleration);
+    targetVel = lastVel + targetAccel * dt;
 
     // make sure we don't send any bad values
     if (isnan(targetVel.x) || isnan(targetVel.y)) {
         targetVel = Point(0, 0);
     }
 
-    // track these values so we can limit acceleration
-    _lastVelCmd = targetVel;
-    _lastCmdTime = RJ::timestamp();
+    return targetVel;
+}
 
+Point MotionControl::_robotBodyVel(Point vel) const {
     // velocity multiplier
-    targetVel *= *_robot->config->velMultiplier;
+    vel *= *_robot->config->velMultiplier;
 
     // if the velocity is nonzero, make sure it's not so small that the robot
     // doesn't even move
     float minEffectiveVelocity = *_robot->config->minEffectiveVelocity;
-    if (targetVel.mag() < minEffectiveVelocity && targetVel.mag() > 0.05) {
-        targetVel = targetVel.normalized() * minEffectiveVelocity;
+    if (vel.mag() < minEffectiveVelocity && vel.mag() > 0.05) {
+        vel = vel.normalized() * minEffectiveVelocity;
     }
 
-    // set control values
-    _robot->control->set_xvelocity(targetVel.x);
-    _robot->control->set_yvelocity(targetVel.y);
+    return vel;
 }
@@ -5,6 +5,7 @@
 #include <Pid.hpp>
 
 class OurRobot;
+class RobotConfig;
 
 /**
  * @brief Handles computer-side motion control
@@ -40,10 +41,24 @@ private:
     //"units"
     void _targetBodyVel(Geometry2d::Point targetVel);
 
+    /// limits a body velocity to the max velocity and to the max
+    /// acceleration from <lastVel> over <dt> seconds.  NaN becomes zero.
+    Geometry2d::Point _limitBodyVel(Geometry2d::Point targetVel,
+                                    Geometry2d::Point lastVel, float dt) const;
+
+    /// applies the robot's velocity multiplier and minimum effective velocity
+    /// to a limited body velocity
+    Geometry2d::Point _robotBodyVel(Geometry2d::Point vel) const;
+
     /// sets the target angle velocity in the robot's radio packet
     /// does velocity limiting and conversion to robot velocity "units"
     void _targetAngleVel(float angleVel);
 
+    /// sets the trajectory segment in the robot's radio packet from the
+    /// path's velocities after <timeIntoPath>, in body coordinates at the
+    /// heading the robot will have turning at <angleVel>
+    void _targetSegment(float timeIntoPath, float angleVel);
+
     OurRobot* _robot;
 
     /// The last velocity (in m/s, not the radioTx value) command that we sent
@@ -57,6 +72,16 @@ private:
     Pid _positionYController;
     Pid _angleController;
 
+    /// Configuration::generation() and the robot's config when the PID gains
+    /// were last copied
+    uint32_t _configGeneration;
+    const RobotConfig* _config;
+
+    /// Debug layers, looked up once since we draw on every frame
+    int _planningLayer;
+    int _motionControlLayer;
+
     static ConfigDouble* _max_acceleration;
     static ConfigDouble* _max_velocity;
+    static ConfigDouble* _segment_length;
 };
@@ -175,8 +175,11 @@ float InterpolatedPath::length(Point pt) const {
 void InterpolatedPath::draw(SystemState* const state,
                             const QColor& col = Qt::black,
                             const QString& layer = "Motion") const {
+    int layerID = state->findDebugLayer(layer);
+    if (!state->debugLayerEnabled(layerID)) return;
+
     Packet::DebugRobotPath* dbg = state->logFrame->add_debug_robot_paths();
-    dbg->set_layer(state->findDebugLayer(layer));
+    dbg->set_layer(layerID);
 
     for (const Entry& entry : waypoints) {
         Packet::DebugRobotPath::DebugRobotPathPoint* pt = dbg->add_points();
@@ -5,8 +5,11 @@ namespace Planning {
 // the path at fixed time intervals form t = 0 to t = duration.
 void Path::draw(SystemState* const state, const QColor& color,
                 const QString& layer) const {
+    int layerID = state->findDebugLayer(layer);
+    if (!state->debugLayerEnabled(layerID)) return;
+
     Packet::DebugRobotPath* dbg = state->logFrame->add_debug_robot_paths();
-    dbg->set_layer(state->findDebugLayer(layer));
+    dbg->set_layer(layerID);
 
     auto addPoint = [dbg](MotionInstant instant) {
         Packet::DebugRobotPath::DebugRobotPathPoint* pt = dbg->add_points();
@@ -0,0 +1,102 @@
+#include "ChannelRadio.hpp"
+
+#include <Configuration.hpp>
+
+using namespace std;
+using namespace Packet;
+
+REGISTER_CONFIGURABLE(ChannelRadio)
+
+ConfigDouble* ChannelRadio::_loss;
+ConfigDouble* ChannelRadio::_burstLength;
+ConfigDouble* ChannelRadio::_latency;
+ConfigDouble* ChannelRadio::_jitter;
+ConfigBool* ChannelRadio::_reorder;
+ConfigDouble* ChannelRadio::_bandwidth;
+
+void ChannelRadio::createConfiguration(Configuration* cfg) {
+    _loss = new ConfigDouble(cfg, "Radio/Simulated Channel/Loss", 0,
+                             "Percent of packets lost");
+    _burstLength =
+        new ConfigDouble(cfg, "Radio/Simulated Channel/Burst Length", 1,
+                         "Average number of packets lost in a row");
+    _latency = new ConfigDouble(cfg, "Radio/Simulated Channel/Latency", 0,
+                                "Mean latency in milliseconds");
+    _jitter =
+        new ConfigDouble(cfg, "Radio/Simulated Channel/Jitter", 0,
+                         "Standard deviation of the latency in milliseconds");
+    _reorder = new ConfigBool(cfg, "Radio/Simulated Channel/Reorder", true,
+                              "Let packets with less latency arrive first");
+    _bandwidth =
+        new ConfigDouble(cfg, "Radio/Simulated Channel/Bandwidth", 0,
+                         "Kilobits per second in each direction, or 0 for no "
+                         "limit");
+}
+
+ChannelRadio::ChannelRadio(Radio* radio, uint32_t seed)
+    : _radio(radio), _forward(seed), _reverse(seed + 1) {
+    _channel = radio->channel();
+    _now = 0;
+}
+
+bool ChannelRadio::isOpen() const { return _radio->isOpen(); }
+
+void ChannelRadio::configure() {
+    RadioChannel<RadioTx>::Parameters p;
+    p.loss = *_loss / 100;
+    p.burstLength = *_burstLength;
+    p.latency = *_latency * 1000;
+    p.jitter = *_jitter * 1000;
+    p.reorder = *_reorder;
+    p.bandwidth = *_bandwidth * 1000 / 8;
+
+    _forward.parameters = p;
+
+    // The parameters don't depend on the packet type
+    RadioChannel<RadioRx>::Parameters& r = _reverse.parameters;
+    r.loss = p.loss;
+    r.burstLength = p.burstLength;
+    r.latency = p.latency;
+    r.jitter = p.jitter;
+    r.reorder = p.reorder;
+    r.bandwidth = p.bandwidth;
+    r.maxQueue = p.maxQueue;
+}
+
+void ChannelRadio::deliver() {
+    RadioTx packet;
+    while (_forward.receive(packet, _now)) {
+        _radio->send(packet);
+    }
+}
+
+void ChannelRadio::send(Packet::RadioTx& packet) {
+    configure();
+    _forward.send(packet, packet.ByteSize(), _now);
+    deliver();
+}
+
+void ChannelRadio::receive() {
+    configure();
+    deliver();
+
+    _radio->receive();
+    for (const RadioRx& rx : _radio->reversePackets()) {
+        _reverse.send(rx, rx.ByteSize(), _now);
+    }
+    _radio->clear();
+
+    RadioRx rx;
+    while (_reverse.receive(rx, _now)) {
+        _reversePackets.push_back(rx);
+    }
+}
+
+void ChannelRadio::switchTeam(bool blueTeam) { _radio->switchTeam(blueTeam); }
+
+void ChannelRadio::channel(int n) {
+    _radio->channel(n);
+    Radio::channel(n);
+}
+
+Radio::Stats ChannelRadio::stats() const { return _radio->stats(); }
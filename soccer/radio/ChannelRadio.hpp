@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+
+#include "Radio.hpp"
+#include "RadioChannel.hpp"
+
+class Configuration;
+class ConfigBool;
+class ConfigDouble;
+
+/**
+ * @brief Passes another radio's packets through a simulated radio channel
+ *
+ * @details This is used with the simulator so soccer sees the packet loss and
+ * latency of a real radio.  Forward and reverse packets each go through a
+ * RadioChannel set up from the configuration.  With the default settings,
+ * packets pass straight through.
+ *
+ * Delayed packets are only delivered when send() or receive() is called, so
+ * the latency is rounded up to the processing loop's period.
+ */
+class ChannelRadio : public Radio {
+public:
+    /// Takes ownership of <radio>.  <seed> makes runs repeatable.
+    ChannelRadio(Radio* radio, uint32_t seed);
+
+    virtual bool isOpen() const override;
+    virtual void send(Packet::RadioTx& packet) override;
+    virtual void receive() override;
+    virtual void switchTeam(bool blueTeam) override;
+    virtual void channel(int n) override;
+    virtual Stats stats() const override;
+
+    /// Sets the current time.  In lockstep mode this is the simulated time.
+    void time(RJ::Time now) { _now = now; }
+
+    const RadioChannel<Packet::RadioTx>& forward() const { return _forward; }
+    const RadioChannel<Packet::RadioRx>& reverse() const { return _reverse; }
+
+    static void createConfiguration(Configuration* cfg);
+
+private:
+    // Copies the configuration to both channels
+    void configure();
+
+    // Sends forward packets that have arrived
+    void deliver();
+
+    std::unique_ptr<Radio> _radio;
+    RadioChannel<Packet::RadioTx> _forward;
+    RadioChannel<Packet::RadioRx> _reverse;
+    RJ::Time _now;
+
+    static ConfigDouble* _loss;
+    static ConfigDouble* _burstLength;
+    static ConfigDouble* _latency;
+    static ConfigDouble* _jitter;
+    static ConfigBool* _reorder;
+    static ConfigDouble* _bandwidth;
+};
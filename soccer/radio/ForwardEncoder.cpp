@@ -0,0 +1,255 @@
+#include "ForwardEncoder.hpp"
+
+#include <Configuration.hpp>
+#include <RadioCommand.hpp>
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace Packet;
+using namespace RadioProtocol;
+
+REGISTER_CONFIGURABLE(ForwardEncoder)
+
+ConfigBool* ForwardEncoder::compactPackets;
+ConfigBool* ForwardEncoder::trajectories;
+ConfigInt* ForwardEncoder::deltaThreshold;
+ConfigInt* ForwardEncoder::refreshPeriod;
+
+void ForwardEncoder::createConfiguration(Configuration* cfg) {
+    compactPackets = new ConfigBool(
+        cfg, "Radio/Compact Packets", false,
+        "Only send robots whose commands changed.  The robots' firmware must "
+        "support this.");
+    trajectories = new ConfigBool(
+        cfg, "Radio/Trajectories", false,
+        "Send robots a piece of their path to follow between packets instead "
+        "of only a velocity.  Needs compact packets.");
+    deltaThreshold = new ConfigInt(
+        cfg, "Radio/Compact Threshold", 4,
+        "Velocity change, in radio units, that makes a robot be sent");
+    refreshPeriod = new ConfigInt(
+        cfg, "Radio/Compact Refresh", 100,
+        "Milliseconds after which an unchanged robot is sent again");
+}
+
+bool ForwardEncoder::sendsTrajectories() {
+    return *compactPackets && *trajectories;
+}
+
+// Length of the robots' control cycle in microseconds
+static const RJ::Time CycleTime = lroundf(SecondsPerCycle * 1000000);
+
+RobotCommand ForwardEncoder::command(const Packet::Robot& robot) {
+    return radioCommand(robot.control(), robot.uid());
+}
+
+TrajectorySegment ForwardEncoder::segment(const Packet::Robot& robot) {
+    return radioSegment(robot.control(), robot.uid());
+}
+
+size_t FullEncoder::encode(const Packet::RadioTx& tx, RJ::Time now,
+                           uint8_t* forward_packet) {
+    forward_packet[0] = _sequence;
+    _sequence = (_sequence + 1) & 7;
+
+    int offset = 1;
+    int slot;
+    for (slot = 0; slot < 6 && slot < tx.robots_size(); ++slot) {
+        RobotCommand cmd = command(tx.robots(slot));
+
+        forward_packet[offset++] = cmd.bodyX & 0xff;
+        forward_packet[offset++] = cmd.bodyY & 0xff;
+        forward_packet[offset++] = cmd.bodyW & 0xff;
+        forward_packet[offset++] = ((cmd.bodyX & 0x300) >> 8) |
+                                   ((cmd.bodyY & 0x300) >> 6) |
+                                   ((cmd.bodyW & 0x300) >> 4);
+
+        forward_packet[offset++] = (cmd.dribbler & 0xf0) | cmd.shell;
+        forward_packet[offset++] = cmd.kickStrength;
+        forward_packet[offset++] =
+            cmd.chip | (cmd.immediate << 1) |
+            (tx.robots(slot).control().song() << 2) |
+            (0 /*robot.anthem()*/ << 3);
+        // TODO remove, no longer used
+        forward_packet[offset++] = 10;  // robot.accel();
+        forward_packet[offset++] = 10;  // robot.decel();
+    }
+
+    // Unused slots
+    for (; slot < 6; ++slot) {
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0x0f;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+        forward_packet[offset++] = 0;
+    }
+
+    return Forward_Size;
+}
+
+SelectiveEncoder::SelectiveEncoder(int threshold, RJ::Time refreshPeriod)
+    : threshold(threshold), refreshPeriod(refreshPeriod) {}
+
+DeltaEncoder::DeltaEncoder(int threshold, RJ::Time refreshPeriod)
+    : SelectiveEncoder(threshold, refreshPeriod) {}
+
+bool DeltaEncoder::changed(const RobotCommand& a,
+                           const RobotCommand& b) const {
+    if (abs(a.bodyX - b.bodyX) > threshold ||
+        abs(a.bodyY - b.bodyY) > threshold ||
+        abs(a.bodyW - b.bodyW) > threshold) {
+        return true;
+    }
+
+    // Everything else must match exactly
+    RobotCommand other = b;
+    other.bodyX = a.bodyX;
+    other.bodyY = a.bodyY;
+    other.bodyW = a.bodyW;
+    return a != other;
+}
+
+size_t DeltaEncoder::encode(const Packet::RadioTx& tx, RJ::Time now,
+                            uint8_t* buf) {
+    // Robots that need to be sent and when they were last sent
+    struct Candidate {
+        RobotCommand command;
+        RJ::Time lastSent;
+    };
+    Candidate candidates[Num_Shells];
+    size_t count = 0;
+
+    for (const Packet::Robot& robot : tx.robots()) {
+        RobotCommand cmd = command(robot);
+        const Sent& sent = _sent[cmd.shell];
+        if (!sent.valid || now - sent.time >= refreshPeriod ||
+            changed(cmd, sent.command)) {
+            if (count < Num_Shells) {
+                candidates[count++] = {cmd, sent.valid ? sent.time : 0};
+            }
+        }
+    }
+
+    if (!count) {
+        return 0;
+    }
+
+    // Longest wait first, and by shell for ties so the order is repeatable
+    sort(candidates, candidates + count,
+         [](const Candidate& a, const Candidate& b) {
+             if (a.lastSent != b.lastSent) {
+                 return a.lastSent < b.lastSent;
+             }
+             return a.command.shell < b.command.shell;
+         });
+
+    ForwardPacket packet;
+    packet.sequence = _sequence;
+    _sequence = (_sequence + 1) & 7;
+    packet.count = min(count, MaxCommands);
+    for (size_t i = 0; i < packet.count; ++i) {
+        const RobotCommand& cmd = candidates[i].command;
+        packet.commands[i] = cmd;
+
+        Sent& sent = _sent[cmd.shell];
+        sent.valid = true;
+        sent.command = cmd;
+        sent.time = now;
+    }
+
+    return packet.pack(buf, Forward_Size);
+}
+
+TrajectoryEncoder::TrajectoryEncoder(int threshold, RJ::Time refreshPeriod)
+    : SelectiveEncoder(threshold, refreshPeriod) {}
+
+bool TrajectoryEncoder::resend(const TrajectorySegment& segment,
+                               RJ::Time now) const {
+    const RobotCommand& cmd = segment.command;
+    const Sent& sent = _sent[cmd.shell];
+    if (!sent.valid) {
+        return true;
+    }
+
+    // Everything but the velocities must match exactly
+    RobotCommand other = sent.segment.command;
+    other.bodyX = cmd.bodyX;
+    other.bodyY = cmd.bodyY;
+    other.bodyW = cmd.bodyW;
+    if (cmd != other) {
+        return true;
+    }
+
+    // Send the rest of the path before the robot runs out of it
+    RJ::Time elapsed = now - sent.time;
+    RJ::Time period = refreshPeriod;
+    if (sent.segment.length) {
+        period = min(period, sent.segment.length * CycleTime / 2);
+    }
+    if (elapsed >= period) {
+        return true;
+    }
+
+    // Where the robot is on the old segment should be where the new one
+    // starts
+    uint32_t cycle = elapsed / CycleTime;
+    Velocity v = sent.segment.at(cycle);
+    return abs(v.x - cmd.bodyX) > threshold ||
+           abs(v.y - cmd.bodyY) > threshold || abs(v.w - cmd.bodyW) > threshold;
+}
+
+size_t TrajectoryEncoder::encode(const Packet::RadioTx& tx, RJ::Time now,
+                                 uint8_t* buf) {
+    // Robots that need to be sent and when they were last sent
+    struct Candidate {
+        TrajectorySegment segment;
+        RJ::Time lastSent;
+    };
+    Candidate candidates[Num_Shells];
+    size_t count = 0;
+
+    for (const Packet::Robot& robot : tx.robots()) {
+        TrajectorySegment s = segment(robot);
+        const Sent& sent = _sent[s.command.shell];
+        if (resend(s, now) && count < Num_Shells) {
+            candidates[count++] = {s, sent.valid ? sent.time : 0};
+        }
+    }
+
+    if (!count) {
+        return 0;
+    }
+
+    // Longest wait first, and by shell for ties so the order is repeatable
+    sort(candidates, candidates + count,
+         [](const Candidate& a, const Candidate& b) {
+             if (a.lastSent != b.lastSent) {
+                 return a.lastSent < b.lastSent;
+             }
+             return a.segment.command.shell < b.segment.command.shell;
+         });
+
+    TrajectoryPacket packet;
+    packet.sequence = _sequence;
+    _sequence = (_sequence + 1) & 7;
+    packet.count = min(count, MaxSegments);
+    for (size_t i = 0; i < packet.count; ++i) {
+        const TrajectorySegment& s = candidates[i].segment;
+        packet.segments[i] = s;
+
+        Sent& sent = _sent[s.command.shell];
+        sent.valid = true;
+        sent.segment = s;
+        sent.time = now;
+    }
+
+    return packet.pack(buf, Forward_Size);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Constants.hpp>
+#include <protobuf/RadioTx.pb.h>
+#include <time.hpp>
+#include <stdint.h>
+
+#include "../firmware/common2015/utils/radio-protocol.hpp"
+
+class Configuration;
+class ConfigBool;
+class ConfigInt;
+
+// FIXME - This needs to go somewhere common to this code, the robot firmware,
+// and the base station test code.
+const unsigned int Forward_Size = 55;
+
+/**
+ * @brief Builds the forward packets that USBRadio sends to the base station
+ */
+class ForwardEncoder {
+public:
+    virtual ~ForwardEncoder() {}
+
+    /// Writes a forward packet for <tx> to <buf>, which holds at least
+    /// Forward_Size bytes.  Returns the packet's size, or zero if nothing
+    /// needs to be sent.
+    virtual size_t encode(const Packet::RadioTx& tx, RJ::Time now,
+                          uint8_t* buf) = 0;
+
+    /// Converts a robot's command to the radio's units
+    static RadioProtocol::RobotCommand command(const Packet::Robot& robot);
+
+    /// Converts a robot's command and trajectory segment to the radio's
+    /// units.  Without a segment, the command's velocities are held.
+    static RadioProtocol::TrajectorySegment segment(
+        const Packet::Robot& robot);
+
+    /// True if the robots are sent trajectory segments, which needs both
+    /// Radio/Compact Packets and Radio/Trajectories.  The simulator follows
+    /// segments whenever it gets them, so soccer only plans them then.
+    static bool sendsTrajectories();
+
+    static void createConfiguration(Configuration* cfg);
+
+    // Used by USBRadio to pick and set up its encoder
+    static ConfigBool* compactPackets;
+    static ConfigBool* trajectories;
+    static ConfigInt* deltaThreshold;
+    static ConfigInt* refreshPeriod;
+
+protected:
+    uint8_t _sequence = 0;
+};
+
+/**
+ * @brief Sends every robot in every packet
+ *
+ * @details This is the original format: one 9-byte slot for each of up to six
+ * robots, with unused slots padded.
+ */
+class FullEncoder : public ForwardEncoder {
+public:
+    virtual size_t encode(const Packet::RadioTx& tx, RJ::Time now,
+                          uint8_t* buf) override;
+};
+
+/**
+ * @brief Base for encoders that only send the robots that need it
+ */
+class SelectiveEncoder : public ForwardEncoder {
+public:
+    /// <threshold> is in radio velocity units and <refreshPeriod> is in
+    /// microseconds
+    SelectiveEncoder(int threshold, RJ::Time refreshPeriod);
+
+    /// Velocity change that makes a robot be sent
+    int threshold;
+
+    /// Time after which a robot is sent even if nothing changed
+    RJ::Time refreshPeriod;
+};
+
+/**
+ * @brief Sends compact packets (see radio-protocol.hpp) with only the robots
+ * whose commands changed
+ *
+ * @details A robot is sent when a velocity changed by more than the threshold,
+ * when anything else in its command changed, or when it hasn't been sent for
+ * the refresh period.  If more robots need to be sent than fit in a packet,
+ * the ones that have waited longest go first and the rest are sent in the
+ * following frames.
+ */
+class DeltaEncoder : public SelectiveEncoder {
+public:
+    DeltaEncoder(int threshold = 4, RJ::Time refreshPeriod = 100 * 1000);
+
+    virtual size_t encode(const Packet::RadioTx& tx, RJ::Time now,
+                          uint8_t* buf) override;
+
+private:
+    bool changed(const RadioProtocol::RobotCommand& a,
+                 const RadioProtocol::RobotCommand& b) const;
+
+    // The last command sent to each shell
+    struct Sent {
+        bool valid = false;
+        RadioProtocol::RobotCommand command;
+        RJ::Time time = 0;
+    };
+    Sent _sent[Num_Shells];
+};
+
+/**
+ * @brief Sends trajectory packets (see radio-protocol.hpp), so the robots keep
+ * following their paths between packets
+ *
+ * @details The robot follows a segment from when it gets it, which is taken
+ * to be when it is sent.  A robot is sent again when the segment it is
+ * following has drifted from its new command by more than the threshold, when
+ * anything but its velocities changed, or when half of its segment is over
+ * (the refresh period for segments that only hold a velocity).  As with
+ * DeltaEncoder, the robots that have waited longest go first.
+ */
+class TrajectoryEncoder : public SelectiveEncoder {
+public:
+    TrajectoryEncoder(int threshold = 4, RJ::Time refreshPeriod = 100 * 1000);
+
+    virtual size_t encode(const Packet::RadioTx& tx, RJ::Time now,
+                          uint8_t* buf) override;
+
+private:
+    // True if the robot should be sent <segment> instead of following what
+    // it was last sent
+    bool resend(const RadioProtocol::TrajectorySegment& segment,
+                RJ::Time now) const;
+
+    // The last segment sent to each shell
+    struct Sent {
+        bool valid = false;
+        RadioProtocol::TrajectorySegment segment;
+        RJ::Time time = 0;
+    };
+    Sent _sent[Num_Shells];
+};
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "ForwardEncoder.hpp"
+
+using namespace Packet;
+using namespace RadioProtocol;
+
+static void addRobot(RadioTx& tx, int shell, float xVelocity) {
+    Packet::Robot* robot = tx.add_robots();
+    robot->set_uid(shell);
+    Packet::Control* control = robot->mutable_control();
+    control->set_xvelocity(xVelocity);
+    control->set_yvelocity(0);
+    control->set_avelocity(0);
+    control->set_dvelocity(0);
+    control->set_kcstrength(0);
+    control->set_shootmode(Packet::Control::KICK);
+    control->set_triggermode(Packet::Control::STAND_DOWN);
+    control->set_song(Packet::Control::STOP);
+}
+
+static ForwardPacket decode(const uint8_t* buf, size_t size) {
+    ForwardPacket packet;
+    EXPECT_TRUE(packet.unpack(buf, size));
+    return packet;
+}
+
+TEST(ForwardEncoder, full) {
+    RadioTx tx;
+    addRobot(tx, 2, 1);
+
+    FullEncoder encoder;
+    uint8_t buf[Forward_Size];
+    ASSERT_EQ(Forward_Size, encoder.encode(tx, 0, buf));
+    EXPECT_FALSE(isCompact(buf, Forward_Size));
+    EXPECT_EQ(2, buf[5] & 0x0f);
+
+    // Unused slots have shell 15
+    EXPECT_EQ(0x0f, buf[1 + 9 + 4]);
+
+    // The sequence counts up
+    encoder.encode(tx, 0, buf);
+    EXPECT_EQ(1, buf[0]);
+}
+
+TEST(ForwardEncoder, deltaChanges) {
+    DeltaEncoder encoder(4, 100 * 1000);
+    uint8_t buf[Forward_Size];
+
+    RadioTx tx;
+    addRobot(tx, 1, 0);
+    addRobot(tx, 2, 0);
+
+    // Everything is sent the first time
+    size_t size = encoder.encode(tx, 1000, buf);
+    ASSERT_EQ(HeaderSize + 2 * CommandSize, size);
+    EXPECT_EQ(2, decode(buf, size).count);
+
+    // Nothing changed
+    EXPECT_EQ(0u, encoder.encode(tx, 2000, buf));
+
+    // A small change is ignored, but a large one is sent
+    RadioTx small;
+    addRobot(small, 1, 0.01);
+    addRobot(small, 2, 0);
+    EXPECT_EQ(0u, encoder.encode(small, 3000, buf));
+
+    RadioTx large;
+    addRobot(large, 1, 0);
+    addRobot(large, 2, 1);
+    size = encoder.encode(large, 4000, buf);
+    ForwardPacket packet = decode(buf, size);
+    ASSERT_EQ(1, packet.count);
+    EXPECT_EQ(2, packet.commands[0].shell);
+    EXPECT_EQ(ForwardEncoder::command(large.robots(1)), packet.commands[0]);
+
+    // Unchanged robots are sent again after the refresh period
+    size = encoder.encode(large, 101 * 1000, buf);
+    packet = decode(buf, size);
+    ASSERT_EQ(1, packet.count);
+    EXPECT_EQ(1, packet.commands[0].shell);
+}
+
+TEST(ForwardEncoder, deltaTimeSlots) {
+    DeltaEncoder encoder(4, 100 * 1000);
+    uint8_t buf[Forward_Size];
+
+    // More robots than fit in one packet
+    RadioTx tx;
+    for (int shell = 0; shell < 8; ++shell) {
+        addRobot(tx, shell, 0);
+    }
+
+    size_t size = encoder.encode(tx, 1000, buf);
+    ForwardPacket packet = decode(buf, size);
+    ASSERT_EQ(MaxCommands, packet.count);
+    EXPECT_EQ(0, packet.commands[0].shell);
+
+    // The rest go in the next frame
+    size = encoder.encode(tx, 2000, buf);
+    packet = decode(buf, size);
+    ASSERT_EQ(2, packet.count);
+    EXPECT_EQ(6, packet.commands[0].shell);
+    EXPECT_EQ(7, packet.commands[1].shell);
+    EXPECT_EQ(1, packet.sequence);
+}
+
+// Gives the last robot in <tx> a segment that speeds up from its velocity
+static void addSegment(RadioTx& tx, float duration, float xMiddle,
+                       float xEnd) {
+    Packet::Control::Segment* segment =
+        tx.mutable_robots(tx.robots_size() - 1)
+            ->mutable_control()
+            ->mutable_segment();
+    segment->set_duration(duration);
+    segment->set_xmiddle(xMiddle);
+    segment->set_ymiddle(0);
+    segment->set_amiddle(0);
+    segment->set_xend(xEnd);
+    segment->set_yend(0);
+    segment->set_aend(0);
+}
+
+static TrajectoryPacket decodeTrajectory(const uint8_t* buf, size_t size) {
+    TrajectoryPacket packet;
+    EXPECT_TRUE(packet.unpack(buf, size));
+    return packet;
+}
+
+TEST(ForwardEncoder, segment) {
+    RadioTx tx;
+    addRobot(tx, 3, 0.5);
+
+    // Without a segment the velocity is held
+    TrajectorySegment held = ForwardEncoder::segment(tx.robots(0));
+    EXPECT_EQ(0, held.length);
+    EXPECT_TRUE(held.end == held.start());
+
+    addSegment(tx, 0.1, 1, 1.5);
+    TrajectorySegment segment = ForwardEncoder::segment(tx.robots(0));
+    EXPECT_EQ(ForwardEncoder::command(tx.robots(0)), segment.command);
+    EXPECT_EQ(20, segment.length);
+    EXPECT_EQ(2 * segment.command.bodyX, segment.middle.x);
+    EXPECT_EQ(3 * segment.command.bodyX, segment.end.x);
+}
+
+TEST(ForwardEncoder, trajectory) {
+    TrajectoryEncoder encoder(4, 100 * 1000);
+    uint8_t buf[Forward_Size];
+
+    // Speeding up from 0.5 m/s to 1.5 m/s over 100 ms
+    RadioTx tx;
+    addRobot(tx, 1, 0.5);
+    addSegment(tx, 0.1, 1, 1.5);
+
+    size_t size = encoder.encode(tx, 0, buf);
+    ASSERT_EQ(HeaderSize + SegmentSize, size);
+    EXPECT_TRUE(isTrajectory(buf, size));
+    TrajectoryPacket packet = decodeTrajectory(buf, size);
+    ASSERT_EQ(1, packet.count);
+    EXPECT_TRUE(ForwardEncoder::segment(tx.robots(0)).end ==
+                packet.segments[0].end);
+
+    // The robot is where the segment said it would be, so nothing is sent
+    RadioTx along;
+    addRobot(along, 1, 0.75);
+    addSegment(along, 0.1, 1.25, 1.5);
+    EXPECT_EQ(0u, encoder.encode(along, 25 * 1000, buf));
+
+    // A new command away from the segment is sent
+    RadioTx away;
+    addRobot(away, 1, 0);
+    addSegment(away, 0.1, 0, 0);
+    EXPECT_NE(0u, encoder.encode(away, 30 * 1000, buf));
+
+    // Half of the segment is over
+    EXPECT_EQ(0u, encoder.encode(away, 79 * 1000, buf));
+    EXPECT_NE(0u, encoder.encode(away, 80 * 1000, buf));
+}
+
+TEST(ForwardEncoder, trajectoryTimeSlots) {
+    TrajectoryEncoder encoder(4, 100 * 1000);
+    uint8_t buf[Forward_Size];
+
+    RadioTx tx;
+    for (int shell = 0; shell < 5; ++shell) {
+        addRobot(tx, shell, 0);
+    }
+
+    TrajectoryPacket packet = decodeTrajectory(buf, encoder.encode(tx, 0, buf));
+    size_t count = MaxSegments;
+    ASSERT_EQ(count, packet.count);
+    EXPECT_EQ(0, packet.segments[0].command.shell);
+
+    packet = decodeTrajectory(buf, encoder.encode(tx, 1000, buf));
+    ASSERT_EQ(2, packet.count);
+    EXPECT_EQ(3, packet.segments[0].command.shell);
+}
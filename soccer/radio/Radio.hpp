@@ -2,6 +2,9 @@
 
 #include <protobuf/RadioRx.pb.h>
 #include <protobuf/RadioTx.pb.h>
+#include <time.hpp>
+
+#include "../firmware/common2015/utils/radio-schedule.hpp"
 
 /**
  * @brief Sends and receives information to/from our robots.
@@ -11,7 +14,32 @@
  */
 class Radio {
 public:
+    /// Counters for radios that send packets in the background
+    struct Stats {
+        /// Forward packets sent to the radio
+        uint32_t sent = 0;
+
+        /// Forward packets replaced by a newer one before they could be sent
+        uint32_t dropped = 0;
+
+        /// Transfers that failed
+        uint32_t failed = 0;
+
+        /// Number of times the radio was opened again after failing
+        uint32_t reconnects = 0;
+
+        /// Time from starting to send a forward packet until it was sent, in
+        /// microseconds
+        RJ::Time lastLatency = 0;
+        RJ::Time maxLatency = 0;
+
+        /// What the base station counted, if it can be asked
+        bool hasBase = false;
+        RadioSchedule::Counters base;
+    };
+
     Radio() { _channel = 0; }
+    virtual ~Radio() {}
 
     virtual bool isOpen() const = 0;
     virtual void send(Packet::RadioTx& packet) = 0;
@@ -21,6 +49,8 @@ public:
 
     virtual void channel(int n) { _channel = n; }
 
+    virtual Stats stats() const { return Stats(); }
+
     int channel() const { return _channel; }
 
     const std::vector<Packet::RadioRx>& reversePackets() const {
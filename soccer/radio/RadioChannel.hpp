@@ -0,0 +1,178 @@
+#pragma once
+
+#include <protobuf/LogFrame.pb.h>
+#include <time.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+/**
+ * @brief Model of an unreliable radio link
+ *
+ * @details Packets given to send() come out of receive() once their latency
+ * has passed, or not at all if they were lost.  Each packet's latency is drawn
+ * from a normal distribution, so packets can arrive out of order.  Losses come
+ * in bursts: the link alternates between a good state where nothing is lost
+ * and a bad state where everything is (a Gilbert-Elliott model).  With a
+ * bandwidth limit, packets also wait for the ones before them to be sent.
+ *
+ * The same seed, parameters and calls give the same results.
+ */
+template <class PACKET>
+class RadioChannel {
+public:
+    struct Parameters {
+        /// Fraction of packets lost, from 0 to 1
+        float loss = 0;
+
+        /// Average number of packets lost in a row
+        float burstLength = 1;
+
+        /// Mean and standard deviation of the latency, in microseconds
+        RJ::Time latency = 0;
+        RJ::Time jitter = 0;
+
+        /// If false, packets are held back so they arrive in order
+        bool reorder = true;
+
+        /// Bytes per second, or zero for no limit
+        float bandwidth = 0;
+
+        /// Packets that would wait longer than this for the bandwidth limit
+        /// are dropped, in microseconds
+        RJ::Time maxQueue = 100 * 1000;
+    };
+
+    RadioChannel(uint32_t seed = 1) : _random(seed) {}
+
+    Parameters parameters;
+
+    /// Sends a packet of <size> bytes at time <now>
+    void send(const PACKET& packet, size_t size, RJ::Time now) {
+        _stats.set_sent(_stats.sent() + 1);
+        uint32_t sequence = _nextSequence++;
+
+        if (lose()) {
+            _stats.set_lost(_stats.lost() + 1);
+            return;
+        }
+
+        // Wait for the link to be free
+        RJ::Time start = std::max(now, _linkFree);
+        if (parameters.bandwidth > 0) {
+            if (start - now > parameters.maxQueue) {
+                _stats.set_overflowed(_stats.overflowed() + 1);
+                return;
+            }
+            start += size * 1000000.0f / parameters.bandwidth;
+            _linkFree = start;
+        }
+
+        // normal_distribution needs a positive standard deviation
+        RJ::Time latency = parameters.latency;
+        if (parameters.jitter > 0) {
+            std::normal_distribution<float> dist(parameters.latency,
+                                                 parameters.jitter);
+            latency = std::max(0.0f, dist(_random));
+        }
+
+        RJ::Time arrival = start + latency;
+        if (!parameters.reorder) {
+            arrival = std::max(arrival, _lastArrival);
+        }
+        _lastArrival = std::max(_lastArrival, arrival);
+
+        // Keep the queue sorted by arrival time.  Packets that arrive at the
+        // same time stay in the order they were sent.
+        Entry entry{packet, now, arrival, sequence};
+        auto pos = std::upper_bound(_queue.begin(), _queue.end(), entry,
+                                    [](const Entry& a, const Entry& b) {
+                                        return a.arrival < b.arrival;
+                                    });
+        _queue.insert(pos, entry);
+    }
+
+    /// Gets the next packet that has arrived by <now>.  Returns false if there
+    /// are none.
+    bool receive(PACKET& packet, RJ::Time now) {
+        if (_queue.empty() || _queue.front().arrival > now) {
+            return false;
+        }
+
+        Entry& entry = _queue.front();
+        packet = entry.packet;
+
+        if (_delivered && entry.sequence < _lastSequence) {
+            _stats.set_reordered(_stats.reordered() + 1);
+        }
+        _lastSequence = std::max(_lastSequence, entry.sequence);
+        _delivered = true;
+
+        RJ::Time latency = now - entry.sent;
+        _stats.set_delivered(_stats.delivered() + 1);
+        _stats.set_total_latency(_stats.total_latency() + latency);
+        if (latency > _stats.max_latency()) {
+            _stats.set_max_latency(latency);
+        }
+
+        _queue.pop_front();
+        return true;
+    }
+
+    /// Number of packets that were sent and haven't arrived or been lost
+    size_t pending() const { return _queue.size(); }
+
+    const Packet::RadioChannelStats& stats() const { return _stats; }
+
+private:
+    struct Entry {
+        PACKET packet;
+        RJ::Time sent;
+        RJ::Time arrival;
+        uint32_t sequence;
+    };
+
+    // Decides if the next packet is lost and updates the burst state
+    bool lose() {
+        if (parameters.loss <= 0) {
+            _bad = false;
+            return false;
+        }
+        if (parameters.loss >= 1) {
+            return true;
+        }
+
+        // Chances of leaving each state that give the requested loss and
+        // burst length on average
+        float leaveBad = 1.0f / std::max(1.0f, parameters.burstLength);
+        float leaveGood =
+            std::min(1.0f, parameters.loss * leaveBad / (1 - parameters.loss));
+
+        std::uniform_real_distribution<float> uniform(0, 1);
+        if (uniform(_random) < (_bad ? leaveBad : leaveGood)) {
+            _bad = !_bad;
+        }
+        return _bad;
+    }
+
+    std::mt19937 _random;
+    std::deque<Entry> _queue;
+
+    // True while losing packets
+    bool _bad = false;
+
+    // When the last packet finishes being sent with a bandwidth limit
+    RJ::Time _linkFree = 0;
+
+    // Latest arrival time so far, for keeping packets in order
+    RJ::Time _lastArrival = 0;
+
+    uint32_t _nextSequence = 0;
+
+    // Highest sequence number delivered so far
+    uint32_t _lastSequence = 0;
+    bool _delivered = false;
+
+    Packet::RadioChannelStats _stats;
+};
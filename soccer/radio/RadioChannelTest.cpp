@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "RadioChannel.hpp"
+
+typedef RadioChannel<int> Channel;
+
+TEST(RadioChannel, passThrough) {
+    Channel channel;
+    for (int i = 0; i < 10; ++i) {
+        channel.send(i, 10, 1000);
+    }
+
+    int packet;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(channel.receive(packet, 1000));
+        EXPECT_EQ(i, packet);
+    }
+    EXPECT_FALSE(channel.receive(packet, 1000));
+
+    EXPECT_EQ(10u, channel.stats().sent());
+    EXPECT_EQ(10u, channel.stats().delivered());
+    EXPECT_EQ(0u, channel.stats().lost());
+    EXPECT_EQ(0u, channel.stats().max_latency());
+}
+
+TEST(RadioChannel, loss) {
+    Channel channel(42);
+    channel.parameters.loss = 0.2;
+    channel.parameters.burstLength = 3;
+
+    const int N = 20000;
+    for (int i = 0; i < N; ++i) {
+        channel.send(i, 10, 0);
+    }
+    EXPECT_NEAR(0.2, channel.stats().lost() / float(N), 0.03);
+    EXPECT_EQ(N - channel.stats().lost(), channel.pending());
+
+    // The same seed gives the same losses
+    Channel other(42);
+    other.parameters = channel.parameters;
+    for (int i = 0; i < N; ++i) {
+        other.send(i, 10, 0);
+    }
+    EXPECT_EQ(channel.stats().lost(), other.stats().lost());
+}
+
+TEST(RadioChannel, latency) {
+    Channel channel;
+    channel.parameters.latency = 5000;
+    channel.send(1, 10, 1000);
+
+    int packet;
+    EXPECT_FALSE(channel.receive(packet, 5999));
+    ASSERT_TRUE(channel.receive(packet, 6000));
+    EXPECT_EQ(1, packet);
+    EXPECT_EQ(5000u, channel.stats().max_latency());
+}
+
+TEST(RadioChannel, reorder) {
+    Channel channel(7);
+    channel.parameters.latency = 10000;
+    channel.parameters.jitter = 5000;
+    channel.parameters.reorder = false;
+
+    for (int i = 0; i < 100; ++i) {
+        channel.send(i, 10, i * 1000);
+    }
+
+    int packet;
+    int last = -1;
+    while (channel.receive(packet, 1000000)) {
+        EXPECT_GT(packet, last);
+        last = packet;
+    }
+    EXPECT_EQ(99, last);
+    EXPECT_EQ(0u, channel.stats().reordered());
+}
+
+TEST(RadioChannel, bandwidth) {
+    Channel channel;
+    channel.parameters.bandwidth = 1000;
+    channel.parameters.maxQueue = 50000;
+
+    // Each packet takes 10ms to send, so the sixth and later wait too long
+    for (int i = 0; i < 10; ++i) {
+        channel.send(i, 10, 0);
+    }
+    EXPECT_EQ(6u, channel.pending());
+    EXPECT_EQ(4u, channel.stats().overflowed());
+
+    int packet;
+    EXPECT_FALSE(channel.receive(packet, 9999));
+    ASSERT_TRUE(channel.receive(packet, 10000));
+    EXPECT_EQ(0, packet);
+}
@@ -0,0 +1,72 @@
+#include "ShmRadio.hpp"
+
+#include <Network.hpp>
+
+using namespace std;
+using namespace Packet;
+
+ShmRadio::ShmRadio(bool blueTeam, int portOffset) {
+    _channel = blueTeam ? 1 : 0;
+    _portOffset = portOffset;
+    connect();
+}
+
+bool ShmRadio::connect() {
+    if (_tx.isOpen() && !_tx.abandoned() && _rx.isOpen() &&
+        !_rx.abandoned()) {
+        return true;
+    }
+
+    if (!_tx.open(ShmRing::name(ShmRadioTxChannel, _channel, _portOffset)) ||
+        !_rx.open(ShmRing::name(ShmRadioRxChannel, _channel, _portOffset))) {
+        _tx.close();
+        _rx.close();
+        return false;
+    }
+
+    if (!_rx.claim()) {
+        fprintf(stderr, "ShmRadio: another soccer is using the %s radio\n",
+                _channel ? "blue" : "yellow");
+        _tx.close();
+        _rx.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool ShmRadio::isOpen() const { return _tx.isOpen() && !_tx.abandoned(); }
+
+void ShmRadio::send(Packet::RadioTx& packet) {
+    if (!connect()) {
+        return;
+    }
+
+    packet.SerializeToString(&_buffer);
+    _tx.write(_buffer);
+}
+
+void ShmRadio::receive() {
+    if (!connect()) {
+        return;
+    }
+
+    while (_rx.read(_buffer)) {
+        // The simulator sends all of a frame's packets at once
+        if (!_batch.ParseFromString(_buffer)) {
+            printf("Bad radio packet of %d bytes\n", (int)_buffer.size());
+            continue;
+        }
+
+        for (const RadioRx& packet : _batch.packets()) {
+            _reversePackets.push_back(packet);
+        }
+    }
+}
+
+void ShmRadio::switchTeam(bool blueTeam) {
+    _tx.close();
+    _rx.close();
+    _channel = blueTeam ? 1 : 0;
+    connect();
+}
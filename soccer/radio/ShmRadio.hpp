@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ShmRing.hpp>
+
+#include "Radio.hpp"
+
+/**
+ * @brief Radio IO with robots in the simulator through shared memory
+ *
+ * @details This does the same thing as SimRadio, but with the simulator's
+ * shared memory rings instead of UDP (see Network.hpp).  The rings are opened
+ * when they are first used, so soccer can be started before the simulator.
+ */
+class ShmRadio : public Radio {
+public:
+    /// <portOffset> selects the simulator's port block (see Network.hpp)
+    ShmRadio(bool blueTeam = false, int portOffset = 0);
+
+    virtual bool isOpen() const override;
+    virtual void send(Packet::RadioTx& packet) override;
+    virtual void receive() override;
+    virtual void switchTeam(bool blueTeam) override;
+
+private:
+    // Opens the rings if the simulator has (re)created them.
+    // Returns true if they are open.
+    bool connect();
+
+    ShmRing _tx;
+    ShmRing _rx;
+    int _portOffset;
+
+    // Reused to avoid allocating for every packet
+    std::string _buffer;
+    Packet::RadioRxBatch _batch;
+};
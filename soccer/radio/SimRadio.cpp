@@ -8,9 +8,10 @@ using namespace Packet;
 
 static QHostAddress LocalAddress(QHostAddress::LocalHost);
 
-SimRadio::SimRadio(bool blueTeam) {
+SimRadio::SimRadio(bool blueTeam, int portOffset) {
     _channel = blueTeam ? 1 : 0;
-    if (!_socket.bind(RadioRxPort + _channel)) {
+    _portOffset = portOffset;
+    if (!_socket.bind(RadioRxPort + _portOffset + _channel)) {
         throw runtime_error(QString("Can't bind to the %1 team's radio port.")
                                 .arg(blueTeam ? "blue" : "yellow")
                                 .toStdString());
@@ -26,7 +27,7 @@ void SimRadio::send(Packet::RadioTx& packet) {
     std::string out;
     packet.SerializeToString(&out);
     _socket.writeDatagram(&out[0], out.size(), LocalAddress,
-                          RadioTxPort + _channel);
+                          RadioTxPort + _portOffset + _channel);
 }
 
 void SimRadio::receive() {
@@ -36,20 +37,22 @@ void SimRadio::receive() {
         buf.resize(n);
         _socket.readDatagram(&buf[0], n);
 
-        _reversePackets.push_back(RadioRx());
-        RadioRx& packet = _reversePackets.back();
-
-        if (!packet.ParseFromString(buf)) {
+        // The simulator sends all of a frame's packets at once
+        if (!_batch.ParseFromString(buf)) {
             printf("Bad radio packet of %d bytes\n", n);
             continue;
         }
+
+        for (const RadioRx& packet : _batch.packets()) {
+            _reversePackets.push_back(packet);
+        }
     }
 }
 
 void SimRadio::switchTeam(bool blueTeam) {
     _socket.close();
     _channel = blueTeam ? 1 : 0;
-    if (!_socket.bind(RadioRxPort + _channel)) {
+    if (!_socket.bind(RadioRxPort + _portOffset + _channel)) {
         throw runtime_error(QString("Can't bind to the %1 team's radio port.")
                                 .arg(blueTeam ? "blue" : "yellow")
                                 .toStdString());
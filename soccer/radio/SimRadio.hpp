@@ -9,7 +9,8 @@
  */
 class SimRadio : public Radio {
 public:
-    SimRadio(bool blueTeam = false);
+    /// <portOffset> is added to the radio ports (see Network.hpp)
+    SimRadio(bool blueTeam = false, int portOffset = 0);
 
     virtual bool isOpen() const override;
     virtual void send(Packet::RadioTx& packet) override;
@@ -19,4 +20,8 @@ public:
 private:
     QUdpSocket _socket;
     int _channel;
+    int _portOffset;
+
+    // Reused for each packet from the simulator
+    Packet::RadioRxBatch _batch;
 };
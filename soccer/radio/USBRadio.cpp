@@ -2,10 +2,13 @@
 // variable-length packets are in use.
 
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdexcept>
 
 #include <QMutexLocker>
 
+#include <Configuration.hpp>
 #include <Utils.hpp>
 #include "USBRadio.hpp"
 #include "../firmware/common2015/drivers/cc1201/ti/defines.hpp"
@@ -19,31 +22,113 @@ using namespace Packet;
 // Timeout for control transfers, in milliseconds
 static const int Control_Timeout = 1000;
 
+// Time between attempts to open the radio, in microseconds
+static const int Reopen_Interval = 500 * 1000;
+
+// Time between reading the base station's counters, in microseconds
+static const RJ::Time Counters_Interval = 1000 * 1000;
+
+// Size of each reverse packet in a bulk transfer
+static const int Reverse_Packet_Size = Reverse_Size + 2;
+static_assert(Reverse_Packet_Size == RadioSchedule::ReversePacketSize,
+              "The base station sends reverse packets of a different size");
+
 USBRadio::USBRadio() : _mutex(QMutex::Recursive) {
-    _sequence = 0;
+    _compactPackets = false;
+    _trajectories = false;
     _printedError = false;
     _device = nullptr;
     _usb_context = nullptr;
+    _hasPending = false;
+    _hasCounters = false;
+    _open = false;
+    _failed = false;
+    _inFlight = 0;
     libusb_init(&_usb_context);
 
     for (int i = 0; i < NumRXTransfers; ++i) {
         _rxTransfers[i] = libusb_alloc_transfer(0);
     }
+
+    for (int i = 0; i < NumTXTransfers; ++i) {
+        _txTransfers[i] = libusb_alloc_transfer(0);
+        _txBusy[i] = false;
+        _txStartTime[i] = 0;
+    }
+
+    _running = true;
+    _eventThread = std::thread(&USBRadio::eventLoop, this);
 }
 
 USBRadio::~USBRadio() {
-    if (_device) {
-        libusb_close(_device);
-    }
+    // The event thread closes the device when it exits
+    _running = false;
+    _eventThread.join();
 
     for (int i = 0; i < NumRXTransfers; ++i) {
         libusb_free_transfer(_rxTransfers[i]);
     }
 
+    for (int i = 0; i < NumTXTransfers; ++i) {
+        libusb_free_transfer(_txTransfers[i]);
+    }
+
     libusb_exit(_usb_context);
 }
 
+void USBRadio::eventLoop() {
+    bool wasOpen = false;
+    RJ::Time lastCounters = 0;
+    while (_running) {
+        if (!_open) {
+            if (!open()) {
+                ::usleep(Reopen_Interval);
+                continue;
+            }
+
+            if (wasOpen) {
+                QMutexLocker lock(&_queueMutex);
+                ++_stats.reconnects;
+            }
+            wasOpen = true;
+        }
+
+        // Time out once in a while so the thread has a chance to exit
+        struct timeval tv = {0, 100 * 1000};
+        libusb_handle_events_timeout_completed(_usb_context, &tv, nullptr);
+
+        bool failed;
+        {
+            QMutexLocker lock(&_queueMutex);
+            failed = _failed;
+        }
+        if (failed) {
+            fprintf(stderr, "USBRadio: Transfer failed, reopening the radio\n");
+            close();
+            continue;
+        }
+
+        RJ::Time now = RJ::timestamp();
+        if (_hasCounters && now - lastCounters >= Counters_Interval) {
+            lastCounters = now;
+
+            RadioSchedule::Counters counters;
+            bool read = readCounters(counters);
+
+            QMutexLocker lock(&_queueMutex);
+            _stats.hasBase = read;
+            if (read) {
+                _stats.base = counters;
+            }
+        }
+    }
+
+    close();
+}
+
 bool USBRadio::open() {
+    QMutexLocker lock(&_mutex);
+
     libusb_device** devices = nullptr;
     ssize_t numDevices = libusb_get_device_list(_usb_context, &devices);
 
@@ -89,6 +174,8 @@ bool USBRadio::open() {
             fprintf(stderr, "USBRadio: Can't set configuration\n");
             _printedError = true;
         }
+        libusb_close(_device);
+        _device = nullptr;
         return false;
     }
 
@@ -97,12 +184,25 @@ bool USBRadio::open() {
             fprintf(stderr, "USBRadio: Can't claim interface\n");
             _printedError = true;
         }
+        libusb_close(_device);
+        _device = nullptr;
         return false;
     }
 
-    channel(_channel);
+    try {
+        channel(_channel);
+    } catch (const runtime_error& e) {
+        if (!_printedError) {
+            fprintf(stderr, "USBRadio: %s\n", e.what());
+            _printedError = true;
+        }
+        libusb_close(_device);
+        _device = nullptr;
+        return false;
+    }
 
     // Start the receive transfers
+    QMutexLocker queueLock(&_queueMutex);
     for (int i = 0; i < NumRXTransfers; ++i) {
         // Populate the required libusb_transfer fields for a bulk transfer.
         libusb_fill_bulk_transfer(
@@ -110,31 +210,145 @@ bool USBRadio::open() {
             _device,  // handle of the device that will handle the transfer
             LIBUSB_ENDPOINT_IN |
                 2,  // address of the endpoint where this transfer will be sent
-            _rxBuffers[i],     // data buffer
-            Reverse_Size + 2,  // length of data buffer
-            rxCompleted,       // callback function to be invoked on transfer
-                               // completion
-            this,              // user data to pass to callback function
-            0);                // timeout for the transfer in milliseconds
-        libusb_submit_transfer(_rxTransfers[i]);
+            _rxBuffers[i],          // data buffer
+            sizeof(_rxBuffers[i]),  // length of data buffer
+            rxCompleted,            // callback function to be invoked on
+                                    // transfer completion
+            this,                   // user data to pass to callback function
+            0);                     // timeout for the transfer in milliseconds
+        if (libusb_submit_transfer(_rxTransfers[i]) == 0) {
+            ++_inFlight;
+        }
+    }
+
+    for (int i = 0; i < NumTXTransfers; ++i) {
+        libusb_fill_bulk_transfer(_txTransfers[i], _device,
+                                  LIBUSB_ENDPOINT_OUT | 2, _txBuffers[i],
+                                  Forward_Size, txCompleted, this,
+                                  Control_Timeout);
+        _txBusy[i] = false;
     }
 
     _printedError = false;
+    _hasCounters = true;
+    _failed = false;
+    _open = true;
 
     return true;
 }
 
+void USBRadio::close() {
+    QMutexLocker lock(&_mutex);
+    if (!_device) {
+        return;
+    }
+
+    // Stop sending and restarting transfers
+    {
+        QMutexLocker queueLock(&_queueMutex);
+        _open = false;
+        _hasPending = false;
+
+        // Transfers that already finished just return an error here
+        for (int i = 0; i < NumRXTransfers; ++i) {
+            libusb_cancel_transfer(_rxTransfers[i]);
+        }
+        for (int i = 0; i < NumTXTransfers; ++i) {
+            if (_txBusy[i]) {
+                libusb_cancel_transfer(_txTransfers[i]);
+            }
+        }
+    }
+
+    // Wait for the cancelled transfers' callbacks
+    for (int i = 0; i < 100; ++i) {
+        {
+            QMutexLocker queueLock(&_queueMutex);
+            if (!_inFlight) {
+                break;
+            }
+        }
+
+        struct timeval tv = {0, 10 * 1000};
+        libusb_handle_events_timeout_completed(_usb_context, &tv, nullptr);
+    }
+
+    libusb_close(_device);
+    _device = nullptr;
+
+    QMutexLocker queueLock(&_queueMutex);
+    _inFlight = 0;
+    _failed = false;
+}
+
 void USBRadio::rxCompleted(libusb_transfer* transfer) {
     USBRadio* radio = (USBRadio*)transfer->user_data;
+    QMutexLocker lock(&radio->_queueMutex);
 
     if (transfer->status == LIBUSB_TRANSFER_COMPLETED &&
-        transfer->actual_length == Reverse_Size + 2) {
-        // Parse the packet and add to the list of RadioRx's
-        radio->handleRxData(transfer->buffer);
+        transfer->actual_length % Reverse_Packet_Size == 0) {
+        // Parse the packets and add them to the list of RadioRx's
+        for (int i = 0; i < transfer->actual_length;
+             i += Reverse_Packet_Size) {
+            radio->handleRxData(transfer->buffer + i);
+        }
+    } else if (transfer->status != LIBUSB_TRANSFER_COMPLETED &&
+               transfer->status != LIBUSB_TRANSFER_CANCELLED &&
+               transfer->status != LIBUSB_TRANSFER_TIMED_OUT) {
+        radio->_failed = true;
     }
 
-    // Restart the transfer
-    libusb_submit_transfer(transfer);
+    // Restart the transfer unless the device is being closed
+    bool restart = radio->_open && !radio->_failed;
+    if (!restart || libusb_submit_transfer(transfer) != 0) {
+        --radio->_inFlight;
+        if (restart) {
+            radio->_failed = true;
+        }
+    }
+}
+
+void USBRadio::txCompleted(libusb_transfer* transfer) {
+    USBRadio* radio = (USBRadio*)transfer->user_data;
+    QMutexLocker lock(&radio->_queueMutex);
+
+    int i = 0;
+    while (radio->_txTransfers[i] != transfer) {
+        ++i;
+    }
+    radio->_txBusy[i] = false;
+    --radio->_inFlight;
+
+    Stats& stats = radio->_stats;
+    if (transfer->status == LIBUSB_TRANSFER_COMPLETED &&
+        transfer->actual_length == transfer->length) {
+        ++stats.sent;
+        stats.lastLatency = RJ::timestamp() - radio->_txStartTime[i];
+        stats.maxLatency = max(stats.maxLatency, stats.lastLatency);
+    } else if (transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+        ++stats.failed;
+        radio->_failed = true;
+    }
+
+    // Send the packet that was waiting for this transfer
+    if (radio->_hasPending && radio->_open && !radio->_failed) {
+        const rtp::payload_buffer& pending = radio->_pending.payload;
+        memcpy(radio->_txBuffers[i], pending.data(), pending.size());
+        radio->_hasPending = false;
+        radio->submitTx(i, pending.size());
+    }
+}
+
+void USBRadio::submitTx(int i, size_t size) {
+    _txTransfers[i]->length = size;
+    _txStartTime[i] = RJ::timestamp();
+    if (libusb_submit_transfer(_txTransfers[i]) == 0) {
+        _txBusy[i] = true;
+        ++_inFlight;
+    } else {
+        ++_stats.failed;
+        _failed = true;
+    }
 }
 
 void USBRadio::command(uint8_t cmd) {
@@ -167,114 +381,106 @@ uint8_t USBRadio::read(uint8_t reg) {
     return value;
 }
 
-bool USBRadio::isOpen() const { return _device; }
-
-void USBRadio::send(Packet::RadioTx& packet) {
+bool USBRadio::readCounters(RadioSchedule::Counters& counters) {
     QMutexLocker lock(&_mutex);
     if (!_device) {
-        if (!open()) {
-            return;
-        }
+        return false;
     }
 
-    uint8_t forward_packet[Forward_Size];
+    int size = libusb_control_transfer(
+        _device, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR,
+        Base2015ControlCommand::ReadCounters, 0, 0, (uint8_t*)&counters,
+        sizeof(counters), Control_Timeout);
+    if (size != sizeof(counters)) {
+        _hasCounters = false;
+        return false;
+    }
+    return true;
+}
 
-    // Build a forward packet
-    forward_packet[0] = _sequence;
-
-    // Unit conversions
-    static const float Seconds_Per_Cycle = 0.005f;
-    static const float Meters_Per_Tick = 0.026f * 2 * M_PI / 6480.0f;
-    static const float Radians_Per_Tick = 0.026f * M_PI / (0.0812f * 3240.0f);
-
-    int offset = 1;
-    int slot;
-    for (slot = 0; slot < 6 && slot < packet.robots_size(); ++slot) {
-        const Packet::Control& robot = packet.robots(slot).control();
-        int robot_id = packet.robots(slot).uid();
-
-        float bodyVelX =
-            robot.xvelocity() * Seconds_Per_Cycle / Meters_Per_Tick / sqrtf(2);
-        float bodyVelY =
-            robot.yvelocity() * Seconds_Per_Cycle / Meters_Per_Tick / sqrtf(2);
-        float bodyVelW =
-            robot.avelocity() * Seconds_Per_Cycle / Radians_Per_Tick;
-
-        int outX = clamp((int)roundf(bodyVelX), -511, 511);
-        int outY = clamp((int)roundf(bodyVelY), -511, 511);
-        int outW = clamp((int)roundf(bodyVelW), -511, 511);
-
-        uint8_t dribbler =
-            max(0, min(255, static_cast<uint16_t>(robot.dvelocity()) * 2));
-
-        forward_packet[offset++] = outX & 0xff;
-        forward_packet[offset++] = outY & 0xff;
-        forward_packet[offset++] = outW & 0xff;
-        forward_packet[offset++] = ((outX & 0x300) >> 8) |
-                                   ((outY & 0x300) >> 6) |
-                                   ((outW & 0x300) >> 4);
-
-        forward_packet[offset++] = (dribbler & 0xf0) | (robot_id & 0x0f);
-        forward_packet[offset++] = static_cast<uint8_t>(robot.kcstrength());
-        forward_packet[offset++] =
-            (robot.shootmode() == Packet::Control::CHIP) |
-            ((robot.triggermode() == Packet::Control::IMMEDIATE) << 1) |
-            (robot.song() << 2) | (0 /*robot.anthem()*/ << 3);
-        // TODO remove, no longer used
-        forward_packet[offset++] = 10;  // robot.accel();
-        forward_packet[offset++] = 10;  // robot.decel();
-    }
-
-    // Unused slots
-    for (; slot < 6; ++slot) {
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0x0f;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-        forward_packet[offset++] = 0;
-    }
-
-    // Send the forward packet
-    int sent = 0;
-    int transferRetCode =
-        libusb_bulk_transfer(_device, LIBUSB_ENDPOINT_OUT | 2, forward_packet,
-                             sizeof(forward_packet), &sent, Control_Timeout);
-    if (transferRetCode != LIBUSB_SUCCESS || sent != sizeof(forward_packet)) {
-        fprintf(stderr, "USBRadio: Bulk write failed\n");
-        if (transferRetCode != LIBUSB_SUCCESS)
-            fprintf(stderr, "  Error: '%s'\n",
-                    libusb_error_name(transferRetCode));
+bool USBRadio::isOpen() const { return _open; }
 
-        libusb_close(_device);
-        _device = nullptr;
+Radio::Stats USBRadio::stats() const {
+    QMutexLocker lock(&_queueMutex);
+    return _stats;
+}
+
+void USBRadio::send(Packet::RadioTx& packet) {
+    // Packets are dropped while the event thread opens the radio
+    if (!_open) {
+        return;
     }
 
-    _sequence = (_sequence + 1) & 7;
-}
+    updateEncoder();
 
-void USBRadio::receive() {
-    QMutexLocker lock(&_mutex);
+    uint8_t forward_packet[Forward_Size];
+    size_t size = _encoder->encode(packet, RJ::timestamp(), forward_packet);
+    if (!size) {
+        // Nothing changed
+        return;
+    }
 
-    if (!_device) {
-        if (!open()) {
+    // Start sending it now if a transfer is free.  Otherwise it waits for one
+    // and replaces any older packet that is still waiting.
+    QMutexLocker lock(&_queueMutex);
+    if (!_open || _failed) {
+        return;
+    }
+
+    for (int i = 0; i < NumTXTransfers; ++i) {
+        if (!_txBusy[i]) {
+            memcpy(_txBuffers[i], forward_packet, size);
+            submitTx(i, size);
             return;
         }
     }
 
-    // Handle USB events.  This will call callbacks.
-    struct timeval tv = {0, 0};
-    libusb_handle_events_timeout(_usb_context, &tv);
+    // With compact packets, robots in a replaced packet are sent again when
+    // their refresh period runs out.
+    if (_hasPending) {
+        ++_stats.dropped;
+    }
+    _pending.payload.assign(forward_packet, size);
+    _hasPending = true;
+}
+
+void USBRadio::updateEncoder() {
+    bool compact = *ForwardEncoder::compactPackets;
+    bool trajectories = ForwardEncoder::sendsTrajectories();
+    if (!_encoder || compact != _compactPackets ||
+        trajectories != _trajectories) {
+        if (trajectories) {
+            _encoder.reset(new TrajectoryEncoder());
+        } else if (compact) {
+            _encoder.reset(new DeltaEncoder());
+        } else {
+            _encoder.reset(new FullEncoder());
+        }
+        _compactPackets = compact;
+        _trajectories = trajectories;
+    }
+
+    if (compact) {
+        SelectiveEncoder* selective =
+            static_cast<SelectiveEncoder*>(_encoder.get());
+        selective->threshold = *ForwardEncoder::deltaThreshold;
+        selective->refreshPeriod = *ForwardEncoder::refreshPeriod * 1000;
+    }
+}
+
+void USBRadio::receive() {
+    // Reverse packets are collected by the event thread
+    QMutexLocker lock(&_queueMutex);
+    _reversePackets.insert(_reversePackets.end(), _received.begin(),
+                           _received.end());
+    _received.clear();
 }
 
 void USBRadio::handleRxData(uint8_t* buf) {
     RJ::Time rx_time = RJ::timestamp();
 
-    _reversePackets.push_back(RadioRx());
-    RadioRx& packet = _reversePackets.back();
+    _received.push_back(RadioRx());
+    RadioRx& packet = _received.back();
 
     packet.set_timestamp(rx_time);
     packet.set_sequence((buf[0] >> 4) & 7);
@@ -3,12 +3,21 @@
 #include <stdint.h>
 #include <libusb.h>
 #include <QMutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "ForwardEncoder.hpp"
 #include "Radio.hpp"
+#include "../firmware/common2015/utils/rtp.hpp"
+
+// The base station puts each forward packet in the payload of an rtp::packet
+static_assert(Forward_Size <= rtp::payload_buffer::CAPACITY,
+              "Forward packets don't fit in an rtp::packet");
 
 // FIXME - This needs to go somewhere common to this code, the robot firmware,
 // and the base station test code.
-const unsigned int Forward_Size = 55;
 const unsigned int Reverse_Size = 7;
 
 /**
@@ -22,6 +31,11 @@ const unsigned int Reverse_Size = 7;
  *     order of their shell numbers in a set time slot.  The bot with the lowest
  *     shell number replies in the first time slot, and so on.  This ensures
  *     that robots don't jam each other's communication.
+ *
+ *     All USB transfers are handled by a separate thread so the processing
+ *     loop never waits for the radio.  send() only queues a forward packet.
+ *     If the radio falls behind, the newest packet replaces any that haven't
+ *     been sent yet.
  */
 class USBRadio : public Radio {
 public:
@@ -35,6 +49,8 @@ public:
     virtual void channel(int n) override;
     void switchTeam(bool) override {}
 
+    virtual Stats stats() const override;
+
 protected:
     libusb_context* _usb_context;
     libusb_device_handle* _device;
@@ -43,19 +59,81 @@ protected:
     // Try increasing this constant for larger RX packet throughput.
     static const int NumRXTransfers = 4;
     libusb_transfer* _rxTransfers[NumRXTransfers];
-    uint8_t _rxBuffers[NumRXTransfers][Reverse_Size + 2];
+    // The base station sends several reverse packets in each transfer
+    uint8_t _rxBuffers[NumRXTransfers][RadioSchedule::MaxTransferSize];
+
+    // These transfers send forward packets.  With more than one, the next
+    // packet can be queued while the last one is still being sent.
+    static const int NumTXTransfers = 2;
+    libusb_transfer* _txTransfers[NumTXTransfers];
+    uint8_t _txBuffers[NumTXTransfers][Forward_Size];
+    bool _txBusy[NumTXTransfers];
+    RJ::Time _txStartTime[NumTXTransfers];
+
+    // The newest forward packet, waiting for a transfer to finish.  Only the
+    // payload is used.
+    rtp::packet _pending;
+    bool _hasPending;
 
+    // Protects the device handle while it is opened, closed, or used for
+    // control transfers
     QMutex _mutex;
-    int _sequence;
+
+    // Cleared when the base station doesn't answer a ReadCounters request,
+    // so it isn't asked again until the radio is reopened.  Only the event
+    // thread uses this.
+    bool _hasCounters;
+
+    // Protects everything below, which is shared with the transfer callbacks
+    mutable QMutex _queueMutex;
+
+    // Set by the event thread.  Packets are only sent while this is true.
+    std::atomic<bool> _open;
+
+    // Set when a transfer fails so the event thread reopens the radio
+    bool _failed;
+
+    // Transfers that have been submitted and haven't finished
+    int _inFlight;
+
+    // Reverse packets received since the last call to receive()
+    std::vector<Packet::RadioRx> _received;
+
+    Stats _stats;
+
+    // Builds forward packets.  This is replaced when the configuration
+    // changes.
+    std::unique_ptr<ForwardEncoder> _encoder;
+    bool _compactPackets;
+    bool _trajectories;
+    void updateEncoder();
+
     bool _printedError;
 
+    // Handles USB events and reopens the radio when needed
+    std::thread _eventThread;
+    std::atomic<bool> _running;
+    void eventLoop();
+
     static void rxCompleted(struct libusb_transfer* transfer);
+    static void txCompleted(struct libusb_transfer* transfer);
     void handleRxData(uint8_t* buf);
 
+    // Starts sending the first <size> bytes of _txBuffers[i].
+    // _queueMutex must be locked.
+    void submitTx(int i, size_t size);
+
     bool open();
 
+    // Cancels all transfers and closes the device
+    void close();
+
     // Low level operations
     void command(uint8_t cmd);
     void write(uint8_t reg, uint8_t value);
     uint8_t read(uint8_t reg);
+
+    // Asks the base station for its counters.  Returns false if it didn't
+    // answer, as older firmware doesn't.
+    bool readCounters(RadioSchedule::Counters& counters);
 };